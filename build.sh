@@ -82,7 +82,7 @@ EOF
     echo "BML_OFFLOAD_ARCH       {NVIDIA, AMD}               (default is ${BML_OFFLOAD_ARCH})"
     echo "GPU_ARCH               GPU architecture            (default is ${GPU_ARCH})"
     echo "BML_CUDA               Build with CUDA             (default is ${BML_CUDA})"
-    echo "BML_MPTC               Build with Tensor Core multiply (default is ${BML_MPTC})"
+    echo "BML_MPTC               Build with Tensor Core (CPU: split) matrix square (default is ${BML_MPTC})"
     echo "BML_MAGMA              Build with MAGMA            (default is ${BML_MAGMA})"
     echo "BML_CUSOLVER           Build with cuSOLVER         (default is ${BML_CUSOLVER})"
     echo "BML_CUSPARSE           Build with cuSPARSE         (default is ${BML_CUSPARSE})"
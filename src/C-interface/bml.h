@@ -195,6 +195,7 @@
 
 #include "bml_add.h"
 #include "bml_allocate.h"
+#include "bml_compress.h"
 #include "bml_convert.h"
 #include "bml_copy.h"
 #include "bml_diagonalize.h"
@@ -211,6 +212,7 @@
 #include "bml_normalize.h"
 #include "bml_norm.h"
 #include "bml_parallel.h"
+#include "bml_partition.h"
 #include "bml_scale.h"
 #include "bml_setters.h"
 #include "bml_shutdown.h"
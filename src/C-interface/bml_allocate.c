@@ -1,4 +1,6 @@
+#include "../macros.h"
 #include "bml_allocate.h"
+#include "bml_copy.h"
 #include "bml_introspection.h"
 #include "bml_logger.h"
 #include "bml_parallel.h"
@@ -733,6 +735,193 @@ bml_default_domain(
     return domain;
 }
 
+/** Build a domain decomposition balancing the cost of the rows.
+ *
+ * Every rank gets a contiguous block of rows. Rank r ends its block
+ * at the first row where the running cost reaches (r + 1) / nRanks of
+ * the total cost, so no rank exceeds its share by more than one row.
+ *
+ * \ingroup allocate_group_C
+ *
+ * \param N Number of rows
+ * \param M Number of columns
+ * \param row_cost The cost of each row, see bml_get_row_costs
+ * \return The domain decomposition
+ */
+bml_domain_t *
+bml_balanced_domain(
+    int N,
+    int M,
+    const double *row_cost)
+{
+    int nRanks = bml_getNRanks();
+
+    bml_domain_t *domain = bml_default_domain(N, M, distributed);
+
+    double total = 0.;
+    for (int i = 0; i < N; i++)
+        total += row_cost[i];
+
+    int row = 0;
+    double sum = 0.;
+    for (int r = 0; r < nRanks; r++)
+    {
+        double target = total * (r + 1) / nRanks;
+        domain->localRowMin[r] = row;
+        if (r == nRanks - 1)
+        {
+            row = N;
+        }
+        else
+        {
+            while (row < N && sum + 0.5 * row_cost[row] < target)
+            {
+                sum += row_cost[row];
+                row++;
+            }
+        }
+        domain->localRowMax[r] = row;
+    }
+    bml_set_domain_extents(domain);
+
+    return domain;
+}
+
+/** Fill extents, elements and displacements of a domain from its rows.
+ *
+ * \ingroup allocate_group_C
+ *
+ * \param D The domain decomposition, localRowMin/Max set
+ */
+void
+bml_set_domain_extents(
+    bml_domain_t * D)
+{
+    for (int r = 0; r < D->totalProcs; r++)
+    {
+        D->localRowExtent[r] = D->localRowMax[r] - D->localRowMin[r];
+        D->localElements[r] = D->localRowExtent[r] * D->totalCols;
+        D->localDispl[r] =
+            (r == 0) ? 0 : D->localDispl[r - 1] + D->localElements[r - 1];
+    }
+    D->minLocalExtent = D->localRowExtent[0];
+    D->maxLocalExtent = D->localRowExtent[0];
+    for (int r = 1; r < D->totalProcs; r++)
+    {
+        D->minLocalExtent = MIN(D->minLocalExtent, D->localRowExtent[r]);
+        D->maxLocalExtent = MAX(D->maxLocalExtent, D->localRowExtent[r]);
+    }
+}
+
+/** Return the imbalance of a domain decomposition.
+ *
+ * \ingroup allocate_group_C
+ *
+ * \param D The domain decomposition
+ * \param row_cost The cost of each row
+ * \return The largest cost of a rank over the average cost per rank
+ */
+double
+bml_domain_imbalance(
+    bml_domain_t * D,
+    const double *row_cost)
+{
+    double total = 0.;
+    double max_cost = 0.;
+    for (int r = 0; r < D->totalProcs; r++)
+    {
+        double rank_cost = 0.;
+        for (int i = D->localRowMin[r]; i < D->localRowMax[r]; i++)
+            rank_cost += row_cost[i];
+        total += rank_cost;
+        max_cost = MAX(max_cost, rank_cost);
+    }
+    if (total == 0.)
+        return 1.;
+    return max_cost * D->totalProcs / total;
+}
+
+/* Return the address of the domain pointer of a matrix.
+ */
+static bml_domain_t **
+bml_domain_address(
+    bml_matrix_t * A)
+{
+    switch (bml_get_type(A))
+    {
+        case dense:
+            return &((bml_matrix_dense_t *) A)->domain;
+        case ellpack:
+            return &((bml_matrix_ellpack_t *) A)->domain;
+        case ellsort:
+            return &((bml_matrix_ellsort_t *) A)->domain;
+        case csr:
+            return &((bml_matrix_csr_t *) A)->domain;
+        default:
+            LOG_ERROR("unknown matrix type (%d)\n", bml_get_type(A));
+            break;
+    }
+    return NULL;
+}
+
+/** Rebalance the domain decomposition of a row distributed matrix.
+ *
+ * Each rank computes the costs of the rows it owns, the other rows may
+ * be stale in its copy, and the costs are gathered on all ranks so
+ * that they all take the same decision. When the rank with the most
+ * expensive rows exceeds the average by more than the tolerance, the
+ * matrix is first gathered on all ranks with its current domain, so
+ * every rank holds the rows it is about to own, and then gets a
+ * balanced domain. Matrices computed into from A (e.g. X2 of
+ * bml_multiply_x2) need the same domain, see bml_copy_domain.
+ *
+ * \ingroup allocate_group_C
+ *
+ * \param A The matrix
+ * \param balance What a row costs
+ * \param tolerance The acceptable relative imbalance, e.g. 0.1
+ * \return 1 if the rows were redistributed, 0 otherwise
+ */
+int
+bml_rebalance_domain(
+    bml_matrix_t * A,
+    bml_balance_t balance,
+    double tolerance)
+{
+    int N = bml_get_N(A);
+    bml_domain_t **domain = bml_domain_address(A);
+
+    if (*domain == NULL)
+        *domain = bml_default_domain(N, bml_get_M(A), distributed);
+
+    double *row_cost = bml_allocate_memory(N * sizeof(double));
+    bml_get_row_costs(A, balance, row_cost);
+#ifdef DO_MPI
+    if (bml_getNRanks() > 1)
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL, row_cost,
+                       (*domain)->localRowExtent, (*domain)->localRowMin,
+                       MPI_DOUBLE, ccomm);
+#endif
+
+    int rebalanced = 0;
+    if (bml_domain_imbalance(*domain, row_cost) > 1. + tolerance)
+    {
+#ifdef DO_MPI
+        if (bml_getNRanks() > 1)
+            bml_allGatherVParallel(A);
+#endif
+        bml_domain_t *balanced =
+            bml_balanced_domain(N, bml_get_M(A), row_cost);
+        bml_copy_domain(balanced, *domain);
+        bml_set_domain_extents(*domain);
+        bml_deallocate_domain(balanced);
+        rebalanced = 1;
+    }
+
+    bml_free_memory(row_cost);
+    return rebalanced;
+}
+
 /** Update a domain for a bml matrix.
  *
  * \ingroup allocate_group_C
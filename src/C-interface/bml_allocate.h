@@ -81,6 +81,23 @@ bml_domain_t *bml_default_domain(
     int M,
     bml_distribution_mode_t distrib_mode);
 
+bml_domain_t *bml_balanced_domain(
+    int N,
+    int M,
+    const double *row_cost);
+
+void bml_set_domain_extents(
+    bml_domain_t * D);
+
+double bml_domain_imbalance(
+    bml_domain_t * D,
+    const double *row_cost);
+
+int bml_rebalance_domain(
+    bml_matrix_t * A,
+    bml_balance_t balance,
+    double tolerance);
+
 void bml_update_domain(
     bml_matrix_t * A,
     int *localPartMin,
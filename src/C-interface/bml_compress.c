@@ -0,0 +1,399 @@
+#include "../macros.h"
+#include "bml_allocate.h"
+#include "bml_compress.h"
+
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+/** Number of rows per independently decodable chunk of a stream. */
+#define INDEX_CHUNK 256
+
+/** Row tag of variable-byte encoded rows, smaller tags are bit widths. */
+#define TAG_VBYTE 255
+
+/* An encoded index stream starts with the end offset of each chunk of
+ * INDEX_CHUNK rows, as uint64_t relative to the end of the table,
+ * followed by the chunks. Each non-empty row is a tag byte, the zigzag
+ * encoded difference between its first column and the row number as a
+ * variable-byte number, and the zigzag encoded differences between its
+ * consecutive columns. The tag is either the bit width of the
+ * bit-packed differences or TAG_VBYTE for 7 bits per byte
+ * variable-byte differences, whichever is shorter for the row. Bits
+ * are packed starting from the least significant bit of each byte.
+ */
+
+static uint32_t
+zigzag(
+    int32_t d)
+{
+    return ((uint32_t) d << 1) ^ (uint32_t) (d >> 31);
+}
+
+static int32_t
+unzigzag(
+    uint32_t z)
+{
+    return (int32_t) (z >> 1) ^ -(int32_t) (z & 1);
+}
+
+static size_t
+vbyte_size(
+    uint32_t z)
+{
+    return z < (1u << 7) ? 1 : z < (1u << 14) ? 2 : z < (1u << 21) ? 3 :
+        z < (1u << 28) ? 4 : 5;
+}
+
+static unsigned char *
+vbyte_encode(
+    uint32_t z,
+    unsigned char *out)
+{
+    while (z >= 0x80)
+    {
+        *out++ = (unsigned char) (z | 0x80);
+        z >>= 7;
+    }
+    *out++ = (unsigned char) z;
+    return out;
+}
+
+static const unsigned char *
+vbyte_decode(
+    const unsigned char *in,
+    uint32_t * z)
+{
+    uint32_t value = 0;
+    int shift = 0;
+    unsigned char c;
+    do
+    {
+        c = *in++;
+        value |= (uint32_t) (c & 0x7f) << shift;
+        shift += 7;
+    }
+    while (c & 0x80);
+    *z = value;
+    return in;
+}
+
+static int
+is_little_endian(
+    void)
+{
+    const uint16_t one = 1;
+    return *(const unsigned char *) &one == 1;
+}
+
+/* Return the encoded size of a row and pick its tag. */
+static size_t
+encode_row_size(
+    int nnz,
+    const int *cols,
+    int ref,
+    unsigned char *tag)
+{
+    if (nnz == 0)
+    {
+        return 0;
+    }
+
+    uint32_t all = 0;
+    size_t vsize = 0;
+    for (int k = 1; k < nnz; k++)
+    {
+        uint32_t z = zigzag(cols[k] - cols[k - 1]);
+        all |= z;
+        vsize += vbyte_size(z);
+    }
+    int width = 0;
+    while (all != 0)
+    {
+        width++;
+        all >>= 1;
+    }
+    size_t bsize = ((size_t) (nnz - 1) * width + 7) / 8;
+    size_t head = 1 + vbyte_size(zigzag(cols[0] - ref));
+    if (bsize <= vsize)
+    {
+        *tag = width;
+        return head + bsize;
+    }
+    *tag = TAG_VBYTE;
+    return head + vsize;
+}
+
+static unsigned char *
+encode_row(
+    int nnz,
+    const int *cols,
+    int ref,
+    unsigned char tag,
+    unsigned char *out)
+{
+    if (nnz == 0)
+    {
+        return out;
+    }
+
+    *out++ = tag;
+    out = vbyte_encode(zigzag(cols[0] - ref), out);
+    if (tag == TAG_VBYTE)
+    {
+        for (int k = 1; k < nnz; k++)
+        {
+            out = vbyte_encode(zigzag(cols[k] - cols[k - 1]), out);
+        }
+    }
+    else
+    {
+        uint64_t bits = 0;
+        int nbits = 0;
+        for (int k = 1; k < nnz; k++)
+        {
+            bits |= (uint64_t) zigzag(cols[k] - cols[k - 1]) << nbits;
+            nbits += tag;
+            while (nbits >= 8)
+            {
+                *out++ = (unsigned char) bits;
+                bits >>= 8;
+                nbits -= 8;
+            }
+        }
+        if (nbits > 0)
+        {
+            *out++ = (unsigned char) bits;
+        }
+    }
+    return out;
+}
+
+static const unsigned char *
+decode_row(
+    int nnz,
+    const unsigned char *in,
+    int ref,
+    int *cols)
+{
+    if (nnz == 0)
+    {
+        return in;
+    }
+
+    int tag = *in++;
+    uint32_t z;
+    in = vbyte_decode(in, &z);
+    int prev = ref + unzigzag(z);
+    cols[0] = prev;
+    if (tag == TAG_VBYTE)
+    {
+        for (int k = 1; k < nnz; k++)
+        {
+            in = vbyte_decode(in, &z);
+            prev += unzigzag(z);
+            cols[k] = prev;
+        }
+        return in;
+    }
+
+    // Refill 32 bits at a time away from the end of the row
+    int little_endian = is_little_endian();
+    uint64_t mask = ((uint64_t) 1 << tag) - 1;
+    size_t nbytes = ((size_t) (nnz - 1) * tag + 7) / 8;
+    const unsigned char *p = in;
+    const unsigned char *end = in + nbytes;
+    uint64_t bits = 0;
+    int nbits = 0;
+    for (int k = 1; k < nnz; k++)
+    {
+        if (nbits < tag)
+        {
+            if (little_endian && end - p >= 4)
+            {
+                uint32_t word;
+                memcpy(&word, p, sizeof(word));
+                bits |= (uint64_t) word << nbits;
+                nbits += 32;
+                p += 4;
+            }
+            else
+            {
+                while (nbits < tag)
+                {
+                    bits |= (uint64_t) (*p++) << nbits;
+                    nbits += 8;
+                }
+            }
+        }
+        prev += unzigzag((uint32_t) (bits & mask));
+        bits >>= tag;
+        nbits -= tag;
+        cols[k] = prev;
+    }
+    return in + nbytes;
+}
+
+/* Return the position in index of the first row of each chunk. */
+static size_t *
+chunk_positions(
+    int nrows,
+    int *nnz,
+    int ld)
+{
+    int nchunks = (nrows + INDEX_CHUNK - 1) / INDEX_CHUNK;
+    size_t *pos = bml_noinit_allocate_memory(sizeof(size_t) * (nchunks + 1));
+    size_t p = 0;
+    for (int i = 0; i < nrows; i++)
+    {
+        if (i % INDEX_CHUNK == 0)
+        {
+            pos[i / INDEX_CHUNK] = p;
+        }
+        p += ld > 0 ? (size_t) ld : (size_t) nnz[i];
+    }
+    pos[nchunks] = p;
+    return pos;
+}
+
+/** Return the largest size of an encoded index stream.
+ *
+ * \param nrows The number of rows
+ * \param nnz The total number of column indices
+ * \return The size in bytes
+ */
+size_t
+bml_encode_index_bound(
+    int nrows,
+    size_t nnz)
+{
+    int nchunks = (nrows + INDEX_CHUNK - 1) / INDEX_CHUNK;
+    return sizeof(uint64_t) * nchunks + nrows + 5 * nnz;
+}
+
+/** Encode the column indices of a set of rows.
+ *
+ * Row i holds the nnz[i] columns at index + i * ld, or directly after
+ * row i - 1 if ld is 0. Sorted indices that cluster around the
+ * diagonal encode into a few bits each. The rows are encoded in
+ * parallel.
+ *
+ * \param nrows The number of rows
+ * \param first_row The row number of the first row
+ * \param nnz The number of columns of each row
+ * \param index The column indices
+ * \param ld The distance between rows in index, 0 for packed rows
+ * \param buffer The stream, at least bml_encode_index_bound bytes
+ * \return The size of the stream in bytes
+ */
+size_t
+bml_encode_index(
+    int nrows,
+    int first_row,
+    int *nnz,
+    int *index,
+    int ld,
+    void *buffer)
+{
+    int nchunks = (nrows + INDEX_CHUNK - 1) / INDEX_CHUNK;
+    unsigned char *data = (unsigned char *) buffer
+        + sizeof(uint64_t) * nchunks;
+    size_t *pos = chunk_positions(nrows, nnz, ld);
+    size_t *chunk_ptr = bml_allocate_memory(sizeof(size_t) * (nchunks + 1));
+    unsigned char *tag = bml_noinit_allocate_memory(MAX(nrows, 1));
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < nchunks; c++)
+    {
+        const int *cols = index + pos[c];
+        size_t size = 0;
+        for (int i = c * INDEX_CHUNK; i < MIN((c + 1) * INDEX_CHUNK, nrows);
+             i++)
+        {
+            size += encode_row_size(nnz[i], cols, first_row + i, &tag[i]);
+            cols += ld > 0 ? ld : nnz[i];
+        }
+        chunk_ptr[c + 1] = size;
+    }
+    for (int c = 0; c < nchunks; c++)
+    {
+        chunk_ptr[c + 1] += chunk_ptr[c];
+        uint64_t end = chunk_ptr[c + 1];
+        memcpy((char *) buffer + sizeof(uint64_t) * c, &end, sizeof(end));
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < nchunks; c++)
+    {
+        const int *cols = index + pos[c];
+        unsigned char *out = data + chunk_ptr[c];
+        for (int i = c * INDEX_CHUNK; i < MIN((c + 1) * INDEX_CHUNK, nrows);
+             i++)
+        {
+            out = encode_row(nnz[i], cols, first_row + i, tag[i], out);
+            cols += ld > 0 ? ld : nnz[i];
+        }
+    }
+
+    size_t size = sizeof(uint64_t) * nchunks + chunk_ptr[nchunks];
+    bml_free_memory(pos);
+    bml_free_memory(chunk_ptr);
+    bml_free_memory(tag);
+    return size;
+}
+
+/** Decode the column indices of a set of rows.
+ *
+ * The inverse of bml_encode_index, with the same row layout. The
+ * chunks of the stream are decoded in parallel.
+ *
+ * \param nrows The number of rows
+ * \param first_row The row number of the first row
+ * \param nnz The number of columns of each row
+ * \param buffer The stream
+ * \param index The column indices
+ * \param ld The distance between rows in index, 0 for packed rows
+ * \return The size of the stream in bytes
+ */
+size_t
+bml_decode_index(
+    int nrows,
+    int first_row,
+    int *nnz,
+    void *buffer,
+    int *index,
+    int ld)
+{
+    int nchunks = (nrows + INDEX_CHUNK - 1) / INDEX_CHUNK;
+    const unsigned char *data = (const unsigned char *) buffer
+        + sizeof(uint64_t) * nchunks;
+    size_t *pos = chunk_positions(nrows, nnz, ld);
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < nchunks; c++)
+    {
+        uint64_t start = 0;
+        if (c > 0)
+        {
+            memcpy(&start, (char *) buffer + sizeof(uint64_t) * (c - 1),
+                   sizeof(start));
+        }
+        int *cols = index + pos[c];
+        const unsigned char *in = data + start;
+        for (int i = c * INDEX_CHUNK; i < MIN((c + 1) * INDEX_CHUNK, nrows);
+             i++)
+        {
+            in = decode_row(nnz[i], in, first_row + i, cols);
+            cols += ld > 0 ? ld : nnz[i];
+        }
+    }
+
+    uint64_t end = 0;
+    if (nchunks > 0)
+    {
+        memcpy(&end, (char *) buffer + sizeof(uint64_t) * (nchunks - 1),
+               sizeof(end));
+    }
+    bml_free_memory(pos);
+    return sizeof(uint64_t) * nchunks + end;
+}
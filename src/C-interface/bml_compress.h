@@ -0,0 +1,31 @@
+/** \file */
+
+#ifndef __BML_COMPRESS_H
+#define __BML_COMPRESS_H
+
+#include "bml_types.h"
+
+// Return the largest size of an encoded index stream.
+size_t bml_encode_index_bound(
+    int nrows,
+    size_t nnz);
+
+// Encode the column indices of a set of rows.
+size_t bml_encode_index(
+    int nrows,
+    int first_row,
+    int *nnz,
+    int *index,
+    int ld,
+    void *buffer);
+
+// Decode the column indices of a set of rows.
+size_t bml_decode_index(
+    int nrows,
+    int first_row,
+    int *nnz,
+    void *buffer,
+    int *index,
+    int ld);
+
+#endif
@@ -1,4 +1,8 @@
+#include "bml_allocate.h"
 #include "bml_convert.h"
+#include "bml_export.h"
+#include "bml_import.h"
+#include "bml_introspection.h"
 #include "bml_logger.h"
 #include "dense/bml_convert_dense.h"
 #include "ellpack/bml_convert_ellpack.h"
@@ -15,6 +19,9 @@
  *
  * \f$ A \rightarrow B \f$
  *
+ * Conversions that keep the precision go through compressed rows in
+ * O(nnz), other conversions copy element by element.
+ *
  * \param A The input matrix.
  * \return The converted matrix \f$ B \f$.
  */
@@ -31,6 +38,23 @@ bml_convert(
         return bml_convert_distributed2d(A, matrix_type, matrix_precision, M);
     else
 #endif
+    if (bml_get_precision(A) == matrix_precision
+        && bml_get_type(A) != distributed2d)
+    {
+        int *row_ptr = NULL;
+        int *cols = NULL;
+        void *vals = NULL;
+        bml_export_to_compressed_rows(A, &row_ptr, &cols, &vals);
+        bml_matrix_t *B =
+            bml_import_from_compressed_rows(matrix_type, matrix_precision,
+                                            bml_get_N(A), M, row_ptr, cols,
+                                            vals, distrib_mode);
+        bml_free_memory(row_ptr);
+        bml_free_memory(cols);
+        bml_free_memory(vals);
+        return B;
+    }
+    else
         switch (matrix_type)
         {
             case dense:
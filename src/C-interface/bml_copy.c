@@ -117,6 +117,68 @@ bml_copy(
     }
 }
 
+/** Copy a panel of a matrix.
+ *
+ * \f$ B_{l_0 + i, j} \leftarrow A_{i_0 + i, j} \f$ for
+ * \f$ 0 \le i < nrows \f$ and \f$ j_0 \le j < j_0 + ncols \f$, the
+ * other elements of B are zero. The sparse formats only go through the
+ * stored elements of the rows of the panel.
+ *
+ * \ingroup copy_group_C
+ *
+ * \param A Matrix to copy from
+ * \param B The panel
+ * \param i0 The first row of the panel in A
+ * \param nrows The number of rows of the panel
+ * \param j0 The first column of the panel
+ * \param ncols The number of columns of the panel
+ * \param l0 The first row of the panel in B
+ */
+void
+bml_copy_panel(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0)
+{
+    if (bml_get_type(A) != bml_get_type(B))
+    {
+        LOG_ERROR("type mismatch\n");
+    }
+    if (bml_get_N(A) != bml_get_N(B))
+    {
+        LOG_ERROR("matrix size mismatch\n");
+    }
+    if (bml_get_M(A) > bml_get_M(B) && bml_get_type(A) != csr)
+    {
+        LOG_ERROR("matrix parameter mismatch\n");
+    }
+    switch (bml_get_type(A))
+    {
+        case dense:
+            bml_copy_panel_dense(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        case ellpack:
+            bml_copy_panel_ellpack(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        case ellsort:
+            bml_copy_panel_ellsort(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        case ellblock:
+            bml_copy_panel_ellblock(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        case csr:
+            bml_copy_panel_csr(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+            break;
+    }
+}
+
 /** Reorder a matrix in place.
  *
  * \ingroup copy_group_C
@@ -12,6 +12,15 @@ void bml_copy(
     bml_matrix_t * A,
     bml_matrix_t * B);
 
+void bml_copy_panel(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
 void bml_reorder(
     bml_matrix_t * A,
     int *perm);
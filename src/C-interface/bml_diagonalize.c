@@ -11,6 +11,22 @@
 #include "distributed2d/bml_diagonalize_distributed2d.h"
 #endif
 
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** Default size above which a batched matrix uses all threads. */
+#ifndef BML_DIAGONALIZE_BATCHED_CUTOFF
+#define BML_DIAGONALIZE_BATCHED_CUTOFF 1000
+#endif
+
+/*
+ * variables visible only in that file
+ */
+static int s_diagonalize_batched_cutoff = BML_DIAGONALIZE_BATCHED_CUTOFF;
+
 void
 bml_diagonalize(
     bml_matrix_t * A,
@@ -45,3 +61,86 @@ bml_diagonalize(
     }
 
 }
+
+/** Diagonalize many dense matrices.
+ *
+ * Meant for the many small eigenproblems of the submatrix method:
+ * the matrices are grouped by size and spread over the threads, one
+ * matrix per thread with a workspace allocated once per thread. The
+ * matrices larger than the batched cutoff are diagonalized one at a
+ * time by all threads.
+ *
+ * \ingroup diag_group
+ *
+ * \param nmatrices Number of matrices
+ * \param A The dense matrices, all of the same precision
+ * \param eigenvalues The eigenvalues of each matrix
+ * \param eigenvectors The eigenvectors of each matrix
+ * \return The throughput in matrices per second
+ */
+double
+bml_diagonalize_batched(
+    int nmatrices,
+    bml_matrix_t ** A,
+    void **eigenvalues,
+    bml_matrix_t ** eigenvectors)
+{
+#ifdef _OPENMP
+    double start = omp_get_wtime();
+#else
+    double start = (double) clock() / CLOCKS_PER_SEC;
+#endif
+    double elapsed;
+
+    for (int k = 0; k < nmatrices; k++)
+    {
+        if (bml_get_type(A[k]) != dense
+            || bml_get_type(eigenvectors[k]) != dense)
+        {
+            LOG_ERROR("bml_diagonalize_batched needs dense matrices\n");
+        }
+    }
+    if (nmatrices > 0)
+    {
+        bml_diagonalize_batched_dense(nmatrices,
+                                      (bml_matrix_dense_t **) A,
+                                      eigenvalues,
+                                      (bml_matrix_dense_t **) eigenvectors,
+                                      s_diagonalize_batched_cutoff);
+    }
+
+#ifdef _OPENMP
+    elapsed = omp_get_wtime() - start;
+#else
+    elapsed = (double) clock() / CLOCKS_PER_SEC - start;
+#endif
+    LOG_DEBUG("diagonalized %d matrices in %e s\n", nmatrices, elapsed);
+
+    return elapsed > 0 ? nmatrices / elapsed : 0;
+}
+
+/** Set the size above which a batched matrix uses all threads.
+ *
+ * \ingroup diag_group
+ *
+ * \param N The matrix size
+ */
+void
+bml_set_diagonalize_batched_cutoff(
+    int N)
+{
+    s_diagonalize_batched_cutoff = N;
+}
+
+/** Get the size above which a batched matrix uses all threads.
+ *
+ * \ingroup diag_group
+ *
+ * \return The matrix size
+ */
+int
+bml_get_diagonalize_batched_cutoff(
+    void)
+{
+    return s_diagonalize_batched_cutoff;
+}
@@ -8,4 +8,19 @@ void bml_diagonalize(
     void *eigenvalues,
     bml_matrix_t * eigenvectors);
 
+// Diagonalize many dense matrices, return the matrices per second
+double bml_diagonalize_batched(
+    int nmatrices,
+    bml_matrix_t ** A,
+    void **eigenvalues,
+    bml_matrix_t ** eigenvectors);
+
+// Set the size above which a batched matrix uses all threads
+void bml_set_diagonalize_batched_cutoff(
+    int N);
+
+// Get the size above which a batched matrix uses all threads
+int bml_get_diagonalize_batched_cutoff(
+    void);
+
 #endif
@@ -63,3 +63,46 @@ bml_export_to_dense(
     }
     return NULL;
 }
+
+/** Export a bml matrix into compressed rows.
+ *
+ * The arrays are allocated here and have to be freed by the caller
+ * with bml_free_memory(). The entries of row i are cols[k] and
+ * vals[k] for row_ptr[i] <= k < row_ptr[i + 1], with the values in
+ * the precision of A.
+ *
+ * \ingroup convert_group_C
+ *
+ * \param A The bml matrix
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ */
+void
+bml_export_to_compressed_rows(
+    bml_matrix_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    switch (bml_get_type(A))
+    {
+        case dense:
+            bml_export_to_compressed_rows_dense(A, row_ptr, cols, vals);
+            break;
+        case ellpack:
+            bml_export_to_compressed_rows_ellpack(A, row_ptr, cols, vals);
+            break;
+        case ellsort:
+            bml_export_to_compressed_rows_ellsort(A, row_ptr, cols, vals);
+            break;
+        case ellblock:
+            bml_export_to_compressed_rows_ellblock(A, row_ptr, cols, vals);
+            break;
+        case csr:
+            bml_export_to_compressed_rows_csr(A, row_ptr, cols, vals);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+    }
+}
@@ -9,4 +9,10 @@ void *bml_export_to_dense(
     bml_matrix_t * A,
     bml_dense_order_t order);
 
+void bml_export_to_compressed_rows(
+    bml_matrix_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
 #endif
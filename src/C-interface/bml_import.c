@@ -71,3 +71,59 @@ bml_import_from_dense(
         }
     return NULL;
 }
+
+/** Import compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group_C
+ *
+ * \param matrix_type The matrix type
+ * \param matrix_precision The real precision of the values
+ * \param N The number of rows/columns
+ * \param M The number of non-zeroes per row
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ * \param distrib_mode The distribution mode
+ * \return The bml matrix
+ */
+bml_matrix_t *
+bml_import_from_compressed_rows(
+    bml_matrix_type_t matrix_type,
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int M,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode)
+{
+    switch (matrix_type)
+    {
+        case dense:
+            return bml_import_from_compressed_rows_dense(matrix_precision, N,
+                                                         row_ptr, cols, vals,
+                                                         distrib_mode);
+        case ellpack:
+            return bml_import_from_compressed_rows_ellpack(matrix_precision,
+                                                           N, row_ptr, cols,
+                                                           vals, M,
+                                                           distrib_mode);
+        case ellsort:
+            return bml_import_from_compressed_rows_ellsort(matrix_precision,
+                                                           N, row_ptr, cols,
+                                                           vals, M,
+                                                           distrib_mode);
+        case ellblock:
+            return bml_import_from_compressed_rows_ellblock(matrix_precision,
+                                                            N, row_ptr, cols,
+                                                            vals, M,
+                                                            distrib_mode);
+        case csr:
+            return bml_import_from_compressed_rows_csr(matrix_precision, N,
+                                                       row_ptr, cols, vals, M,
+                                                       distrib_mode);
+        default:
+            LOG_ERROR("unknown matrix type\n");
+    }
+    return NULL;
+}
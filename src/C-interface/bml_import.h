@@ -15,4 +15,14 @@ bml_matrix_t *bml_import_from_dense(
     double threshold,
     bml_distribution_mode_t distrib_mode);
 
+bml_matrix_t *bml_import_from_compressed_rows(
+    bml_matrix_type_t matrix_type,
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int M,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode);
+
 #endif
@@ -241,6 +241,9 @@ bml_get_row_bandwidth(
         case ellsort:
             return bml_get_row_bandwidth_ellsort(A, i);
             break;
+        case ellblock:
+            return bml_get_row_bandwidth_ellblock(A, i);
+            break;
         case csr:
             return bml_get_row_bandwidth_csr(A, i);
             break;
@@ -251,6 +254,42 @@ bml_get_row_bandwidth(
     return -1;
 }
 
+/** Return the cost of every row of a matrix.
+ *
+ * The costs feed bml_balanced_domain.
+ *
+ * \ingroup introspection_group_C
+ *
+ * \param A The bml matrix.
+ * \param balance What a row costs.
+ * \param cost The cost of each row (length N).
+ */
+void
+bml_get_row_costs(
+    bml_matrix_t * A,
+    bml_balance_t balance,
+    double *cost)
+{
+    switch (bml_get_type(A))
+    {
+        case dense:
+            bml_get_row_costs_dense(A, balance, cost);
+            break;
+        case ellpack:
+            bml_get_row_costs_ellpack(A, balance, cost);
+            break;
+        case ellsort:
+            bml_get_row_costs_ellsort(A, balance, cost);
+            break;
+        case csr:
+            bml_get_row_costs_csr(A, balance, cost);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+            break;
+    }
+}
+
 /** Return the bandwidth of a matrix.
  *
  * \param A The bml matrix.
@@ -271,6 +310,9 @@ bml_get_bandwidth(
         case ellsort:
             return bml_get_bandwidth_ellsort(A);
             break;
+        case ellblock:
+            return bml_get_bandwidth_ellblock(A);
+            break;
         case csr:
             return bml_get_bandwidth_csr(A);
             break;
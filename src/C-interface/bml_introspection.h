@@ -27,6 +27,11 @@ int bml_get_row_bandwidth(
     bml_matrix_t * A,
     int i);
 
+void bml_get_row_costs(
+    bml_matrix_t * A,
+    bml_balance_t balance,
+    double *cost);
+
 int bml_get_bandwidth(
     bml_matrix_t * A);
 
@@ -1,4 +1,6 @@
+#include "../macros.h"
 #include "bml_multiply.h"
+#include "bml_allocate.h"
 #include "bml_introspection.h"
 #include "bml_logger.h"
 #include "dense/bml_multiply_dense.h"
@@ -12,6 +14,28 @@
 
 #include <stdlib.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** Number of row chunks per thread in the schedule of a multiply plan. */
+#define MULTIPLY_PLAN_CHUNKS_PER_THREAD 8
+
+/** Default number of slices of the split precision matrix square. */
+#ifndef BML_MPTC_DEFAULT_SLICES
+#define BML_MPTC_DEFAULT_SLICES 3
+#endif
+
+/*
+ * variables visible only in that file
+ */
+static bml_accumulator_type_t s_accumulator_type = accumulator_auto;
+static int s_mptc_slices = BML_MPTC_DEFAULT_SLICES;
+static int s_progress_thread = 0;
+static bml_distributed_multiply_t s_distributed_multiply =
+    distributed_multiply_cannon;
+static int s_summa_panel_width = 0;
+
 /** Matrix multiply.
  *
  * \f$ C \leftarrow \alpha \, A \, B + \beta C \f$
@@ -193,3 +217,442 @@ bml_multiply_adjust_AB(
             break;
     }
 }
+
+/** Norm screened matrix multiply.
+ *
+ * \f$ C \leftarrow \alpha \, A \, B + \beta C \f$
+ *
+ * Block products whose Frobenius norm bound
+ * \f$ \| A_{ij} \|_F \| B_{jk} \|_F \f$ is below
+ * screening * threshold are skipped (SpAMM). The Frobenius norm of
+ * each skipped product is below screening * threshold, so the error of
+ * an output block \f$ C_{ik} \f$ is bounded by |alpha| times the
+ * number of products skipped for it times screening * threshold, not
+ * by the threshold alone.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param A Matrix A
+ * \param B Matrix B
+ * \param C Matrix C
+ * \param alpha Scalar factor that multiplies A * B
+ * \param beta Scalar factor that multiplies C
+ * \param threshold Threshold for multiplication
+ * \param screening Screening tolerance relative to threshold
+ * \param stats Statistics of the skipped products (can be NULL)
+ */
+void
+bml_multiply_screened(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    bml_matrix_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats)
+{
+    switch (bml_get_type(A))
+    {
+        case ellblock:
+            bml_multiply_screened_ellblock(A, B, C, alpha, beta, threshold,
+                                           screening, stats);
+            break;
+        default:
+            LOG_ERROR("screened multiply is only implemented for ellblock\n");
+            break;
+    }
+}
+
+/** Select the row accumulator used by the sparse matrix multiplies.
+ *
+ * The dense accumulator scatters each row into a length N vector per
+ * thread and is fastest for small N. The hash accumulator only needs
+ * memory proportional to the row fill and is meant for large N.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param accumulator_type The accumulator type
+ */
+void
+bml_set_multiply_accumulator(
+    bml_accumulator_type_t accumulator_type)
+{
+    s_accumulator_type = accumulator_type;
+}
+
+/** Get the row accumulator used by the sparse matrix multiplies.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \return The accumulator type
+ */
+bml_accumulator_type_t
+bml_get_multiply_accumulator(
+    void)
+{
+    return s_accumulator_type;
+}
+
+/** Select the algorithm of the distributed2d matrix multiply.
+ *
+ * Cannon's algorithm shifts the blocks of A and B between neighbours
+ * and overlaps the shifts with the local products. SUMMA broadcasts
+ * them along the process rows and columns instead, which maps onto
+ * collectives tuned by the MPI library. Cannon's algorithm needs a
+ * square process grid, a non-square grid always uses SUMMA.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param algorithm The multiply algorithm
+ */
+void
+bml_set_distributed_multiply(
+    bml_distributed_multiply_t algorithm)
+{
+    s_distributed_multiply = algorithm;
+}
+
+/** Get the algorithm of the distributed2d matrix multiply.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \return The multiply algorithm
+ */
+bml_distributed_multiply_t
+bml_get_distributed_multiply(
+    void)
+{
+    return s_distributed_multiply;
+}
+
+/** Set the panel width of the SUMMA distributed2d multiply.
+ *
+ * SUMMA broadcasts panels of at most width columns of A and rows of B.
+ * Panels never straddle the blocks of two tasks, so on a non-square
+ * grid they end at least at every multiple of N / nprows and of
+ * N / npcols. The local products of the sparse formats scale with the
+ * non-zeros of the panels, the broadcasts with the submatrices.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param width The panel width, 0 for panels ending only at block edges
+ */
+void
+bml_set_summa_panel_width(
+    int width)
+{
+    s_summa_panel_width = width;
+}
+
+/** Get the panel width of the SUMMA distributed2d multiply.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \return The panel width, 0 for panels ending only at block edges
+ */
+int
+bml_get_summa_panel_width(
+    void)
+{
+    return s_summa_panel_width;
+}
+
+/** Set the number of slices of the split precision matrix square.
+ *
+ * With BML_MPTC the dense X^2 of double precision matrices splits each
+ * operand into nslices single precision slices. Every slice adds about
+ * 8 bits of accuracy at the cost of nslices more single precision
+ * gemms; 3 slices give about 1e-8. Less than 1 slice selects the
+ * regular double precision multiply.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param nslices The number of slices per operand
+ */
+void
+bml_set_mptc_slices(
+    int nslices)
+{
+    s_mptc_slices = nslices;
+}
+
+/** Get the number of slices of the split precision matrix square.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \return The number of slices per operand
+ */
+int
+bml_get_mptc_slices(
+    void)
+{
+    return s_mptc_slices;
+}
+
+/** Drive the shifts of the distributed2d multiply from a thread.
+ *
+ * The shifts of the next blocks are in flight while the local product
+ * runs. Without a progress thread they are polled before and after the
+ * product only, and most MPI libraries then move large messages when
+ * they are waited for. A progress thread polls them all along, it
+ * takes a core from the local product and needs MPI initialized with
+ * at least MPI_THREAD_SERIALIZED, otherwise it is not started.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param enable 1 to start a progress thread, 0 to poll
+ */
+void
+bml_set_multiply_progress_thread(
+    int enable)
+{
+    s_progress_thread = enable;
+}
+
+/** Check whether the distributed2d multiply uses a progress thread.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \return 1 if a progress thread drives the shifts, 0 otherwise
+ */
+int
+bml_get_multiply_progress_thread(
+    void)
+{
+    return s_progress_thread;
+}
+
+/** Accuracy report of the split precision matrix square.
+ *
+ * Computes X * X with nslices slices and with the regular multiply, to
+ * choose the number of slices for the accuracy a calculation needs.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param X Matrix X
+ * \param nslices The number of slices per operand
+ * \return The largest error of X * X relative to its largest element
+ */
+double
+bml_multiply_x2_split_error(
+    bml_matrix_t * X,
+    int nslices)
+{
+    switch (bml_get_type(X))
+    {
+        case dense:
+            return bml_multiply_x2_split_error_dense(X, nslices);
+            break;
+        default:
+            LOG_ERROR("split precision X^2 is only implemented for dense\n");
+            break;
+    }
+    return 0;
+}
+
+/** Build the sparsity plan of a matrix square.
+ *
+ * The symbolic pass records the output columns of every row of
+ * \f$ X \, X \f$, a histogram of the output row lengths and a
+ * row schedule balanced by the number of multiply-adds per row.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param X Matrix X
+ * \return The plan (NULL for matrix types without plan support)
+ */
+bml_multiply_plan_t *
+bml_multiply_plan_x2(
+    bml_matrix_t * X)
+{
+    switch (bml_get_type(X))
+    {
+        case ellpack:
+            return bml_multiply_plan_x2_ellpack(X);
+            break;
+        case ellsort:
+            return bml_multiply_plan_x2_ellsort(X);
+            break;
+        default:
+            break;
+    }
+    return NULL;
+}
+
+/** Check whether a sparsity plan can be reused for X.
+ *
+ * A plan stays valid as long as every non-zero of X lies in the pattern
+ * the plan was built for, i.e. elements dropped by thresholding do not
+ * invalidate it.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param plan The plan
+ * \param X Matrix X
+ * \return 1 if the plan is valid, 0 otherwise
+ */
+int
+bml_multiply_plan_is_valid(
+    bml_multiply_plan_t * plan,
+    bml_matrix_t * X)
+{
+    if (plan == NULL)
+    {
+        return 0;
+    }
+    switch (bml_get_type(X))
+    {
+        case ellpack:
+            return bml_multiply_plan_is_valid_ellpack(plan, X);
+            break;
+        case ellsort:
+            return bml_multiply_plan_is_valid_ellsort(plan, X);
+            break;
+        default:
+            break;
+    }
+    return 0;
+}
+
+/** Matrix multiply with a sparsity plan.
+ *
+ * \f$ X^2 \leftarrow X \, X \f$
+ *
+ * The plan is (re)built if it is NULL or no longer valid for X, so the
+ * same plan pointer can be passed through all iterations of a
+ * purification loop. Matrix types without plan support fall back to
+ * bml_multiply_x2() and leave the plan untouched.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param plan Pointer to the plan
+ * \param X Matrix X
+ * \param X2 Matrix X2
+ * \param threshold Threshold for multiplication
+ * \return The traces of X and X2
+ */
+void *
+bml_multiply_x2_planned(
+    bml_multiply_plan_t ** plan,
+    bml_matrix_t * X,
+    bml_matrix_t * X2,
+    double threshold)
+{
+    bml_matrix_type_t matrix_type = bml_get_type(X);
+
+    if (matrix_type != ellpack && matrix_type != ellsort)
+    {
+        return bml_multiply_x2(X, X2, threshold);
+    }
+
+    if (!bml_multiply_plan_is_valid(*plan, X))
+    {
+        bml_deallocate_multiply_plan(plan);
+        *plan = bml_multiply_plan_x2(X);
+    }
+
+    switch (matrix_type)
+    {
+        case ellpack:
+            return bml_multiply_x2_planned_ellpack(*plan, X, X2, threshold);
+            break;
+        case ellsort:
+            return bml_multiply_x2_planned_ellsort(*plan, X, X2, threshold);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+            break;
+    }
+    return NULL;
+}
+
+/** Build the row-length histogram and the row schedule of a plan.
+ *
+ * Called by the format specific symbolic passes once row_ptr is set.
+ * The rows are split into contiguous chunks with about the same number
+ * of multiply-adds, a few chunks per thread.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param plan The plan
+ * \param row_flops The number of multiply-adds of each row
+ */
+void
+bml_multiply_plan_schedule(
+    bml_multiply_plan_t * plan,
+    const int *row_flops)
+{
+    int rowMin = plan->rowMin;
+    int rowMax = plan->rowMax;
+
+    plan->max_row_nnz = 0;
+    for (int i = rowMin; i < rowMax; i++)
+    {
+        plan->max_row_nnz =
+            MAX(plan->max_row_nnz, plan->row_ptr[i + 1] - plan->row_ptr[i]);
+    }
+    plan->row_nnz_histogram =
+        bml_allocate_memory(sizeof(int) * (plan->max_row_nnz + 1));
+    for (int i = rowMin; i < rowMax; i++)
+    {
+        plan->row_nnz_histogram[plan->row_ptr[i + 1] - plan->row_ptr[i]]++;
+    }
+
+    int nthreads = 1;
+#ifdef _OPENMP
+    nthreads = omp_get_max_threads();
+#endif
+    plan->nchunks = MIN(MULTIPLY_PLAN_CHUNKS_PER_THREAD * nthreads,
+                        rowMax - rowMin);
+    plan->chunk_ptr = bml_allocate_memory(sizeof(int) * (plan->nchunks + 1));
+
+    // every row counts one extra unit for its extraction
+    double total = 0.0;
+    for (int i = rowMin; i < rowMax; i++)
+    {
+        total += row_flops[i] + 1;
+    }
+
+    double sum = 0.0;
+    int c = 1;
+    plan->chunk_ptr[0] = rowMin;
+    for (int i = rowMin; i < rowMax && c < plan->nchunks; i++)
+    {
+        sum += row_flops[i] + 1;
+        while (c < plan->nchunks && sum * plan->nchunks >= total * c)
+        {
+            plan->chunk_ptr[c] = i + 1;
+            c++;
+        }
+    }
+    for (; c <= plan->nchunks; c++)
+    {
+        plan->chunk_ptr[c] = rowMax;
+    }
+}
+
+/** Deallocate a sparsity plan.
+ *
+ * \ingroup multiply_group_C
+ *
+ * \param plan Pointer to the plan (set to NULL)
+ */
+void
+bml_deallocate_multiply_plan(
+    bml_multiply_plan_t ** plan)
+{
+    if (*plan == NULL)
+    {
+        return;
+    }
+    bml_free_memory((*plan)->in_ptr);
+    bml_free_memory((*plan)->in_cols);
+    bml_free_memory((*plan)->read_rows);
+    bml_free_memory((*plan)->row_ptr);
+    bml_free_memory((*plan)->cols);
+    bml_free_memory((*plan)->row_nnz_histogram);
+    bml_free_memory((*plan)->chunk_ptr);
+    bml_free_memory(*plan);
+    *plan = NULL;
+}
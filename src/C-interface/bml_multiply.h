@@ -34,4 +34,85 @@ void bml_multiply_adjust_AB(
     bml_matrix_t * C,
     double threshold);
 
+// Norm screened multiply - C = alpha * A * B + beta * C
+void bml_multiply_screened(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    bml_matrix_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats);
+
+// Select the row accumulator of the sparse multiplies
+void bml_set_multiply_accumulator(
+    bml_accumulator_type_t accumulator_type);
+
+// Get the row accumulator of the sparse multiplies
+bml_accumulator_type_t bml_get_multiply_accumulator(
+    void);
+
+// Select the algorithm of the distributed2d multiply
+void bml_set_distributed_multiply(
+    bml_distributed_multiply_t algorithm);
+
+// Get the algorithm of the distributed2d multiply
+bml_distributed_multiply_t bml_get_distributed_multiply(
+    void);
+
+// Set the panel width of the SUMMA distributed2d multiply
+void bml_set_summa_panel_width(
+    int width);
+
+// Get the panel width of the SUMMA distributed2d multiply
+int bml_get_summa_panel_width(
+    void);
+
+// Set the number of single precision slices of the split precision X^2
+void bml_set_mptc_slices(
+    int nslices);
+
+// Get the number of single precision slices of the split precision X^2
+int bml_get_mptc_slices(
+    void);
+
+// Drive the shifts of the distributed2d multiply from a thread
+void bml_set_multiply_progress_thread(
+    int enable);
+
+// Check whether the distributed2d multiply uses a progress thread
+int bml_get_multiply_progress_thread(
+    void);
+
+// Error of the split precision X^2 relative to its largest element
+double bml_multiply_x2_split_error(
+    bml_matrix_t * X,
+    int nslices);
+
+// Build the sparsity plan of X * X (symbolic pass)
+bml_multiply_plan_t *bml_multiply_plan_x2(
+    bml_matrix_t * X);
+
+// Check whether the pattern of X is still covered by the plan
+int bml_multiply_plan_is_valid(
+    bml_multiply_plan_t * plan,
+    bml_matrix_t * X);
+
+// Multiply X^2 - X2 = X * X, reusing and refreshing a sparsity plan
+void *bml_multiply_x2_planned(
+    bml_multiply_plan_t ** plan,
+    bml_matrix_t * X,
+    bml_matrix_t * X2,
+    double threshold);
+
+// Build the row-length histogram and row schedule of a plan
+void bml_multiply_plan_schedule(
+    bml_multiply_plan_t * plan,
+    const int *row_flops);
+
+// Deallocate a sparsity plan
+void bml_deallocate_multiply_plan(
+    bml_multiply_plan_t ** plan);
+
 #endif
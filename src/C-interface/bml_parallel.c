@@ -22,6 +22,8 @@
 
 static int myRank = 0;
 static int nRanks = 1;
+static bml_gather_mode_t s_gather_mode = gather_compressed;
+static bml_index_encoding_t s_mpi_index_encoding = index_encoding_none;
 #ifdef DO_MPI
 static MPI_Request *requestList;
 MPI_Comm ccomm;
@@ -187,14 +189,107 @@ bml_allGatherVParallel(
             bml_allGatherVParallel_ellsort(A);
             break;
         case ellblock:
-            LOG_ERROR
-                ("bml_allGatherVParallel function not implemented for ellblock\n");
+            bml_allGatherVParallel_ellblock(A);
+            break;
+        case csr:
+            bml_allGatherVParallel_csr(A);
+            break;
         default:
             LOG_ERROR("unknown matrix type\n");
             break;
     }
 }
 
+/** Select the message layout of bml_allGatherVParallel.
+ *
+ * The padded layout ships every ELLPACK and ELLSORT row with all M
+ * slots. The compressed layout only ships the stored elements of each
+ * row and unpacks them on the receiving ranks. Dense matrices are
+ * always gathered whole, ELLBLOCK and CSR matrices always compressed.
+ *
+ * \param gather_mode The gather mode
+ */
+void
+bml_set_gather_mode(
+    bml_gather_mode_t gather_mode)
+{
+    s_gather_mode = gather_mode;
+}
+
+/** Get the message layout of bml_allGatherVParallel.
+ *
+ * \return The gather mode
+ */
+bml_gather_mode_t
+bml_get_gather_mode(
+    void)
+{
+    return s_gather_mode;
+}
+
+/** Select the encoding of the column indices of point to point messages.
+ *
+ * With index_encoding_delta, bml_mpi_send and bml_mpi_isend of ELLPACK
+ * and ELLSORT matrices ship the column indices compressed by
+ * bml_encode_index, which pays off when the link is slower than the
+ * encoder. All ranks have to use the same encoding.
+ *
+ * \param index_encoding The index encoding
+ */
+void
+bml_set_mpi_index_encoding(
+    bml_index_encoding_t index_encoding)
+{
+    s_mpi_index_encoding = index_encoding;
+}
+
+/** Get the encoding of the column indices of point to point messages.
+ *
+ * \return The index encoding
+ */
+bml_index_encoding_t
+bml_get_mpi_index_encoding(
+    void)
+{
+    return s_mpi_index_encoding;
+}
+
+/** Layout of a gather of variable length rows.
+ *
+ * Rank r owns rows [localRowMin[r], localRowMax[r]). The rows are
+ * stored back to back in row order, so that row i starts at
+ * row_ptr[i] and rank r sends counts[r] elements from displs[r].
+ *
+ * \param localRowMin First row of each rank
+ * \param localRowMax One past the last row of each rank
+ * \param nrows The number of rows
+ * \param row_size The number of elements of each row
+ * \param row_ptr The row offsets (nrows + 1)
+ * \param counts The number of elements of each rank
+ * \param displs The offset of the elements of each rank
+ */
+void
+bml_gather_row_layout(
+    const int *localRowMin,
+    const int *localRowMax,
+    int nrows,
+    const int *row_size,
+    int *row_ptr,
+    int *counts,
+    int *displs)
+{
+    row_ptr[0] = 0;
+    for (int i = 0; i < nrows; i++)
+    {
+        row_ptr[i + 1] = row_ptr[i] + row_size[i];
+    }
+    for (int r = 0; r < nRanks; r++)
+    {
+        displs[r] = row_ptr[localRowMin[r]];
+        counts[r] = row_ptr[localRowMax[r]] - displs[r];
+    }
+}
+
 #ifdef DO_MPI
 void
 bml_mpi_send(
@@ -254,6 +349,62 @@ bml_mpi_recv(
     }
 }
 
+void
+bml_mpi_isend(
+    bml_matrix_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    switch (bml_get_type(A))
+    {
+        case dense:
+            bml_mpi_isend_dense(A, dst, comm);
+            break;
+        case ellpack:
+            bml_mpi_isend_ellpack(A, dst, comm);
+            break;
+        case ellsort:
+            bml_mpi_isend_ellsort(A, dst, comm);
+            break;
+        case ellblock:
+            bml_mpi_isend_ellblock(A, dst, comm);
+            break;
+        case csr:
+            bml_mpi_isend_csr(A, dst, comm);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+            break;
+    }
+}
+
+void
+bml_mpi_isend_complete(
+    bml_matrix_t * A)
+{
+    switch (bml_get_type(A))
+    {
+        case dense:
+            bml_mpi_isend_complete_dense(A);
+            break;
+        case ellpack:
+            bml_mpi_isend_complete_ellpack(A);
+            break;
+        case ellsort:
+            bml_mpi_isend_complete_ellsort(A);
+            break;
+        case ellblock:
+            bml_mpi_isend_complete_ellblock(A);
+            break;
+        case csr:
+            bml_mpi_isend_complete_csr(A);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+            break;
+    }
+}
+
 void
 bml_mpi_irecv(
     bml_matrix_t * A,
@@ -310,6 +461,43 @@ bml_mpi_irecv_complete(
     }
 }
 
+/** Make progress on the nonblocking sends or receives of A.
+ *
+ * Polling lets the MPI library move messages while the caller
+ * computes, bml_mpi_isend_complete or bml_mpi_irecv_complete is still
+ * needed afterwards.
+ *
+ * \param A The matrix
+ * \return Non-zero if they are done
+ */
+int
+bml_mpi_test(
+    bml_matrix_t * A)
+{
+    switch (bml_get_type(A))
+    {
+        case dense:
+            return bml_mpi_test_dense(A);
+            break;
+        case ellpack:
+            return bml_mpi_test_ellpack(A);
+            break;
+        case ellsort:
+            return bml_mpi_test_ellsort(A);
+            break;
+        case ellblock:
+            return bml_mpi_test_ellblock(A);
+            break;
+        case csr:
+            return bml_mpi_test_csr(A);
+            break;
+        default:
+            LOG_ERROR("unknown matrix type\n");
+            break;
+    }
+    return 1;
+}
+
 bml_matrix_t *
 bml_mpi_recv_matrix(
     bml_matrix_type_t matrix_type,
@@ -68,6 +68,30 @@ void bml_maxRealReduce(
 void bml_allGatherVParallel(
     bml_matrix_t * A);
 
+// Select the message layout of bml_allGatherVParallel
+void bml_set_gather_mode(
+    bml_gather_mode_t gather_mode);
+
+bml_gather_mode_t bml_get_gather_mode(
+    void);
+
+// Select the encoding of the column indices of point to point messages
+void bml_set_mpi_index_encoding(
+    bml_index_encoding_t index_encoding);
+
+bml_index_encoding_t bml_get_mpi_index_encoding(
+    void);
+
+// Counts and displacements of a gather of variable length rows
+void bml_gather_row_layout(
+    const int *localRowMin,
+    const int *localRowMax,
+    int nrows,
+    const int *row_size,
+    int *row_ptr,
+    int *counts,
+    int *displs);
+
 #ifdef DO_MPI
 void bml_mpi_send(
     bml_matrix_t * A,
@@ -77,12 +101,20 @@ void bml_mpi_recv(
     bml_matrix_t * A,
     const int dst,
     MPI_Comm comm);
+void bml_mpi_isend(
+    bml_matrix_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_complete(
+    bml_matrix_t * A);
 void bml_mpi_irecv(
     bml_matrix_t * A,
     const int dst,
     MPI_Comm comm);
 void bml_mpi_irecv_complete(
     bml_matrix_t * A);
+int bml_mpi_test(
+    bml_matrix_t * A);
 bml_matrix_t *bml_mpi_recv_matrix(
     bml_matrix_type_t matrix_type,
     bml_matrix_precision_t matrix_precision,
@@ -0,0 +1,1302 @@
+#include "../macros.h"
+#include "bml_allocate.h"
+#include "bml_logger.h"
+#include "bml_partition.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Coarsen until the graph has this many vertices per part. */
+#define COARSEN_PER_PART 20
+
+/** Stop coarsening when a level shrinks the graph by less than this. */
+#define COARSEN_MIN_SHRINK 0.95
+
+/** Largest part weight over the average part weight. */
+#define UNBALANCE 1.03
+
+/** Number of greedy bisections tried on the coarsest graph. */
+#define NTRIALS 8
+
+/** Maximum number of FM passes per level. */
+#define NPASSES 8
+
+/** Number of moves without improvement after which an FM pass stops. */
+#define FM_LIMIT 64
+
+/** A level of the multilevel hierarchy. */
+typedef struct
+{
+    /** The number of vertices. */
+    int nvtxs;
+    /** Index of the first neighbour of each vertex in adjncy. */
+    int *xadj;
+    /** The neighbours. */
+    int *adjncy;
+    /** The edge weights. */
+    int *adjwgt;
+    /** The vertex weights. */
+    int *vwgt;
+    /** The sum of the vertex weights. */
+    int tvwgt;
+    /** The vertex of the next coarser level each vertex is merged into. */
+    int *cmap;
+} partition_graph_t;
+
+/** Indexed max-heap of vertices keyed by their move gain. */
+typedef struct
+{
+    /** The number of vertices in the heap. */
+    int size;
+    /** The vertices in heap order. */
+    int *heap;
+    /** The key of each vertex. */
+    int *key;
+    /** The position of each vertex in heap, -1 if absent. */
+    int *pos;
+} partition_queue_t;
+
+static unsigned int
+partition_random(
+    unsigned int *seed)
+{
+    *seed = *seed * 1103515245u + 12345u;
+    return *seed >> 1;
+}
+
+static int
+partition_compare_index(
+    const void *a,
+    const void *b)
+{
+    int aId = *((int *) a);
+    int bId = *((int *) b);
+
+    return (aId > bId) - (aId < bId);
+}
+
+static void
+partition_free_graph(
+    partition_graph_t * g)
+{
+    bml_free_memory(g->xadj);
+    bml_free_memory(g->adjncy);
+    bml_free_memory(g->adjwgt);
+    bml_free_memory(g->vwgt);
+    bml_free_memory(g->cmap);
+    bml_free_memory(g);
+}
+
+/** Build the finest level from an adjacency structure.
+ *
+ * The graph is symmetrized, self loops and duplicate edges are
+ * dropped, and every vertex and edge gets weight 1.
+ */
+static partition_graph_t *
+partition_build_graph(
+    int N,
+    int *xadj,
+    int *adjncy)
+{
+    int *offset = bml_allocate_memory(sizeof(int) * (N + 1));
+    for (int i = 0; i < N; i++)
+    {
+        for (int jp = xadj[i]; jp < xadj[i + 1]; jp++)
+        {
+            int j = adjncy[jp];
+            if (j != i && j >= 0 && j < N)
+            {
+                offset[i + 1]++;
+                offset[j + 1]++;
+            }
+        }
+    }
+    for (int i = 0; i < N; i++)
+    {
+        offset[i + 1] += offset[i];
+    }
+
+    int *edges = bml_noinit_allocate_memory(sizeof(int) *
+                                            MAX(offset[N], 1));
+    int *fill = bml_noinit_allocate_memory(sizeof(int) * N);
+    memcpy(fill, offset, sizeof(int) * N);
+    for (int i = 0; i < N; i++)
+    {
+        for (int jp = xadj[i]; jp < xadj[i + 1]; jp++)
+        {
+            int j = adjncy[jp];
+            if (j != i && j >= 0 && j < N)
+            {
+                edges[fill[i]++] = j;
+                edges[fill[j]++] = i;
+            }
+        }
+    }
+
+    // fill now holds the number of distinct neighbours of each vertex
+#pragma omp parallel for                        \
+  shared(N, offset, edges, fill)
+    for (int i = 0; i < N; i++)
+    {
+        int *row = &edges[offset[i]];
+        int nrow = offset[i + 1] - offset[i];
+        int count = 0;
+        qsort(row, nrow, sizeof(int), partition_compare_index);
+        for (int k = 0; k < nrow; k++)
+        {
+            if (count == 0 || row[k] != row[count - 1])
+            {
+                row[count++] = row[k];
+            }
+        }
+        fill[i] = count;
+    }
+
+    partition_graph_t *g =
+        bml_noinit_allocate_memory(sizeof(partition_graph_t));
+    g->nvtxs = N;
+    g->tvwgt = N;
+    g->cmap = NULL;
+    g->xadj = bml_noinit_allocate_memory(sizeof(int) * (N + 1));
+    g->xadj[0] = 0;
+    for (int i = 0; i < N; i++)
+    {
+        g->xadj[i + 1] = g->xadj[i] + fill[i];
+    }
+    g->adjncy = bml_noinit_allocate_memory(sizeof(int) *
+                                           MAX(g->xadj[N], 1));
+    g->adjwgt = bml_noinit_allocate_memory(sizeof(int) *
+                                           MAX(g->xadj[N], 1));
+    g->vwgt = bml_noinit_allocate_memory(sizeof(int) * N);
+
+    int *g_xadj = g->xadj;
+    int *g_adjncy = g->adjncy;
+    int *g_adjwgt = g->adjwgt;
+    int *g_vwgt = g->vwgt;
+#pragma omp parallel for                                        \
+  shared(N, offset, edges, g_xadj, g_adjncy, g_adjwgt, g_vwgt)
+    for (int i = 0; i < N; i++)
+    {
+        for (int jp = g_xadj[i]; jp < g_xadj[i + 1]; jp++)
+        {
+            g_adjncy[jp] = edges[offset[i] + jp - g_xadj[i]];
+            g_adjwgt[jp] = 1;
+        }
+        g_vwgt[i] = 1;
+    }
+
+    bml_free_memory(offset);
+    bml_free_memory(edges);
+    bml_free_memory(fill);
+
+    return g;
+}
+
+/** Coarsen a graph by heavy-edge matching.
+ *
+ * The vertices are visited in random order and each unmatched vertex
+ * is merged with the unmatched neighbour it shares the heaviest edge
+ * with, as long as the merged vertex weighs at most maxvwgt. Sets
+ * g->cmap and returns the coarser graph.
+ */
+static partition_graph_t *
+partition_coarsen_graph(
+    partition_graph_t * g,
+    int maxvwgt,
+    unsigned int *seed)
+{
+    int n = g->nvtxs;
+    int *xadj = g->xadj;
+    int *adjncy = g->adjncy;
+    int *adjwgt = g->adjwgt;
+    int *vwgt = g->vwgt;
+
+    int *match = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *perm = bml_noinit_allocate_memory(sizeof(int) * n);
+    for (int v = 0; v < n; v++)
+    {
+        match[v] = -1;
+        perm[v] = v;
+    }
+    for (int k = n - 1; k > 0; k--)
+    {
+        int l = partition_random(seed) % (k + 1);
+        int tmp = perm[k];
+        perm[k] = perm[l];
+        perm[l] = tmp;
+    }
+
+    for (int k = 0; k < n; k++)
+    {
+        int v = perm[k];
+        if (match[v] != -1)
+        {
+            continue;
+        }
+        int best = v;
+        int best_wgt = 0;
+        for (int jp = xadj[v]; jp < xadj[v + 1]; jp++)
+        {
+            int u = adjncy[jp];
+            if (match[u] == -1 && adjwgt[jp] > best_wgt
+                && vwgt[v] + vwgt[u] <= maxvwgt)
+            {
+                best = u;
+                best_wgt = adjwgt[jp];
+            }
+        }
+        match[v] = best;
+        match[best] = v;
+    }
+
+    // Number the coarse vertices in the order of their first vertex
+    int *cmap = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *cvtx = bml_noinit_allocate_memory(sizeof(int) * n);
+    int cn = 0;
+    for (int v = 0; v < n; v++)
+    {
+        if (v <= match[v])
+        {
+            cmap[v] = cn;
+            cmap[match[v]] = cn;
+            cvtx[cn] = v;
+            cn++;
+        }
+    }
+    g->cmap = cmap;
+
+    partition_graph_t *cg =
+        bml_noinit_allocate_memory(sizeof(partition_graph_t));
+    cg->nvtxs = cn;
+    cg->tvwgt = g->tvwgt;
+    cg->cmap = NULL;
+    cg->vwgt = bml_noinit_allocate_memory(sizeof(int) * MAX(cn, 1));
+
+    // Upper bound of the adjacency of each coarse vertex
+    int *bound = bml_noinit_allocate_memory(sizeof(int) * (cn + 1));
+    bound[0] = 0;
+    for (int c = 0; c < cn; c++)
+    {
+        int v = cvtx[c];
+        int u = match[v];
+        bound[c + 1] = bound[c] + xadj[v + 1] - xadj[v];
+        if (u != v)
+        {
+            bound[c + 1] += xadj[u + 1] - xadj[u];
+        }
+    }
+    int *cadjncy = bml_noinit_allocate_memory(sizeof(int) *
+                                              MAX(bound[cn], 1));
+    int *cadjwgt = bml_noinit_allocate_memory(sizeof(int) *
+                                              MAX(bound[cn], 1));
+    int *count = bml_noinit_allocate_memory(sizeof(int) * MAX(cn, 1));
+    int *cvwgt = cg->vwgt;
+
+#pragma omp parallel                                                  \
+  shared(cn, cvtx, match, cmap, xadj, adjncy, adjwgt, vwgt, bound,    \
+         cadjncy, cadjwgt, count, cvwgt)
+    {
+        // Position of each coarse neighbour in the current row
+        int *marker = bml_noinit_allocate_memory(sizeof(int) * cn);
+        for (int c = 0; c < cn; c++)
+        {
+            marker[c] = -1;
+        }
+
+#pragma omp for
+        for (int c = 0; c < cn; c++)
+        {
+            int vertices[2] = { cvtx[c], match[cvtx[c]] };
+            int nvertices = vertices[0] == vertices[1] ? 1 : 2;
+            int p = bound[c];
+            cvwgt[c] = 0;
+            for (int k = 0; k < nvertices; k++)
+            {
+                int v = vertices[k];
+                cvwgt[c] += vwgt[v];
+                for (int jp = xadj[v]; jp < xadj[v + 1]; jp++)
+                {
+                    int cu = cmap[adjncy[jp]];
+                    if (cu == c)
+                    {
+                        continue;
+                    }
+                    if (marker[cu] < 0)
+                    {
+                        marker[cu] = p;
+                        cadjncy[p] = cu;
+                        cadjwgt[p] = adjwgt[jp];
+                        p++;
+                    }
+                    else
+                    {
+                        cadjwgt[marker[cu]] += adjwgt[jp];
+                    }
+                }
+            }
+            count[c] = p - bound[c];
+            for (int q = bound[c]; q < p; q++)
+            {
+                marker[cadjncy[q]] = -1;
+            }
+        }
+        bml_free_memory(marker);
+    }
+
+    // Squeeze out the unused slots, rows only move to lower addresses
+    cg->xadj = bml_noinit_allocate_memory(sizeof(int) * (cn + 1));
+    cg->xadj[0] = 0;
+    for (int c = 0; c < cn; c++)
+    {
+        cg->xadj[c + 1] = cg->xadj[c] + count[c];
+        memmove(&cadjncy[cg->xadj[c]], &cadjncy[bound[c]],
+                sizeof(int) * count[c]);
+        memmove(&cadjwgt[cg->xadj[c]], &cadjwgt[bound[c]],
+                sizeof(int) * count[c]);
+    }
+    cg->adjncy = cadjncy;
+    cg->adjwgt = cadjwgt;
+
+    bml_free_memory(match);
+    bml_free_memory(perm);
+    bml_free_memory(cvtx);
+    bml_free_memory(bound);
+    bml_free_memory(count);
+
+    return cg;
+}
+
+/** The weight of the edges between different parts. */
+static int
+partition_cut(
+    partition_graph_t * g,
+    int *part)
+{
+    int cut = 0;
+#pragma omp parallel for                        \
+  shared(g, part)                               \
+  reduction(+:cut)
+    for (int v = 0; v < g->nvtxs; v++)
+    {
+        for (int jp = g->xadj[v]; jp < g->xadj[v + 1]; jp++)
+        {
+            if (part[g->adjncy[jp]] != part[v])
+            {
+                cut += g->adjwgt[jp];
+            }
+        }
+    }
+    return cut / 2;
+}
+
+/** The part weights refinement allows on a level.
+ *
+ * Parts may deviate from their target weight by 3%, or by one vertex
+ * weight if that is more.
+ */
+static void
+partition_part_weight_limits(
+    partition_graph_t * g,
+    int nparts,
+    int *tpwgts,
+    int *minpwgts,
+    int *maxpwgts)
+{
+    int maxvwgt = 0;
+    for (int v = 0; v < g->nvtxs; v++)
+    {
+        maxvwgt = MAX(maxvwgt, g->vwgt[v]);
+    }
+    for (int p = 0; p < nparts; p++)
+    {
+        minpwgts[p] = MIN((int) (tpwgts[p] / UNBALANCE),
+                          tpwgts[p] - maxvwgt + 1);
+        maxpwgts[p] = MAX((int) (UNBALANCE * tpwgts[p] + 0.999),
+                          tpwgts[p] + maxvwgt - 1);
+    }
+}
+
+/** Bisect a graph by greedy graph growing.
+ *
+ * Part 0 is grown from a seed vertex, each time adding the frontier
+ * vertex with the heaviest connection to the part, until it reaches
+ * its target weight. Part 1 is the rest.
+ *
+ * \param conn Scratch of nvtxs zeros, zeros again on return
+ * \param frontier Scratch of nvtxs
+ */
+static void
+partition_grow(
+    partition_graph_t * g,
+    int target,
+    int start,
+    int *part,
+    int *conn,
+    int *frontier)
+{
+    int n = g->nvtxs;
+    int pwgt = 0;
+    int nfront = 0;
+
+    for (int v = 0; v < n; v++)
+    {
+        part[v] = 1;
+    }
+    int seed = start;
+    while (pwgt < target && seed >= 0)
+    {
+        int v = seed;
+        part[v] = 0;
+        pwgt += g->vwgt[v];
+        conn[v] = 0;
+        for (int jp = g->xadj[v]; jp < g->xadj[v + 1]; jp++)
+        {
+            int u = g->adjncy[jp];
+            if (part[u] == 1)
+            {
+                if (conn[u] == 0)
+                {
+                    frontier[nfront++] = u;
+                }
+                conn[u] += g->adjwgt[jp];
+            }
+        }
+
+        // Next vertex: the best connected one of the frontier, or any
+        // vertex of part 1 when the frontier ran dry
+        int best = -1;
+        for (int k = 0; k < nfront; k++)
+        {
+            if (best < 0 || conn[frontier[k]] > conn[frontier[best]])
+            {
+                best = k;
+            }
+        }
+        seed = -1;
+        if (best >= 0)
+        {
+            seed = frontier[best];
+            frontier[best] = frontier[--nfront];
+        }
+        else
+        {
+            for (int k = 0; k < n; k++)
+            {
+                if (part[(start + k) % n] == 1)
+                {
+                    seed = (start + k) % n;
+                    break;
+                }
+            }
+        }
+    }
+    for (int k = 0; k < nfront; k++)
+    {
+        conn[frontier[k]] = 0;
+    }
+    if (seed >= 0)
+    {
+        conn[seed] = 0;
+    }
+}
+
+static void
+partition_queue_swap(
+    partition_queue_t * q,
+    int i,
+    int j)
+{
+    int tmp = q->heap[i];
+    q->heap[i] = q->heap[j];
+    q->heap[j] = tmp;
+    q->pos[q->heap[i]] = i;
+    q->pos[q->heap[j]] = j;
+}
+
+static void
+partition_queue_sift(
+    partition_queue_t * q,
+    int i)
+{
+    while (i > 0 && q->key[q->heap[(i - 1) / 2]] < q->key[q->heap[i]])
+    {
+        partition_queue_swap(q, i, (i - 1) / 2);
+        i = (i - 1) / 2;
+    }
+    while (1)
+    {
+        int largest = i;
+        int l = 2 * i + 1;
+        int r = 2 * i + 2;
+        if (l < q->size && q->key[q->heap[l]] > q->key[q->heap[largest]])
+        {
+            largest = l;
+        }
+        if (r < q->size && q->key[q->heap[r]] > q->key[q->heap[largest]])
+        {
+            largest = r;
+        }
+        if (largest == i)
+        {
+            break;
+        }
+        partition_queue_swap(q, i, largest);
+        i = largest;
+    }
+}
+
+static void
+partition_queue_set(
+    partition_queue_t * q,
+    int v,
+    int key)
+{
+    q->key[v] = key;
+    if (q->pos[v] < 0)
+    {
+        q->heap[q->size] = v;
+        q->pos[v] = q->size;
+        q->size++;
+    }
+    partition_queue_sift(q, q->pos[v]);
+}
+
+static void
+partition_queue_remove(
+    partition_queue_t * q,
+    int v)
+{
+    int i = q->pos[v];
+    if (i < 0)
+    {
+        return;
+    }
+    q->size--;
+    if (i != q->size)
+    {
+        partition_queue_swap(q, i, q->size);
+        partition_queue_sift(q, i);
+    }
+    q->pos[v] = -1;
+}
+
+/** Find the best move of a vertex to a neighbouring part.
+ *
+ * The target is the part v is most heavily connected to among those
+ * that stay within their maximum weight with v, ties going to the
+ * lighter part. The part of v has to stay above its minimum weight
+ * without v.
+ *
+ * \param conn Scratch of nparts zeros, zeros again on return
+ * \param touched Scratch of nparts
+ * \param to The target part, -1 if v has no allowed move
+ * \return The decrease of the edge cut when v moves to its target
+ */
+static int
+partition_best_move(
+    partition_graph_t * g,
+    int *part,
+    int *pwgts,
+    int *minpwgts,
+    int *maxpwgts,
+    int v,
+    int *conn,
+    int *touched,
+    int *to)
+{
+    int from = part[v];
+    int id = 0;
+    int ntouched = 0;
+
+    for (int jp = g->xadj[v]; jp < g->xadj[v + 1]; jp++)
+    {
+        int p = part[g->adjncy[jp]];
+        if (p == from)
+        {
+            id += g->adjwgt[jp];
+        }
+        else
+        {
+            if (conn[p] == 0)
+            {
+                touched[ntouched++] = p;
+            }
+            conn[p] += g->adjwgt[jp];
+        }
+    }
+
+    int best = -1;
+    if (pwgts[from] - g->vwgt[v] >= minpwgts[from])
+    {
+        for (int k = 0; k < ntouched; k++)
+        {
+            int p = touched[k];
+            if (pwgts[p] + g->vwgt[v] > maxpwgts[p])
+            {
+                continue;
+            }
+            if (best < 0 || conn[p] > conn[best]
+                || (conn[p] == conn[best] && pwgts[p] < pwgts[best]))
+            {
+                best = p;
+            }
+        }
+    }
+    int gain = best >= 0 ? conn[best] - id : 0;
+
+    for (int k = 0; k < ntouched; k++)
+    {
+        conn[touched[k]] = 0;
+    }
+    *to = best;
+
+    return gain;
+}
+
+/** The decrease of the edge cut when v moves to part to. */
+static int
+partition_move_gain(
+    partition_graph_t * g,
+    int *part,
+    int v,
+    int to)
+{
+    int gain = 0;
+    for (int jp = g->xadj[v]; jp < g->xadj[v + 1]; jp++)
+    {
+        if (part[g->adjncy[jp]] == part[v])
+        {
+            gain -= g->adjwgt[jp];
+        }
+        else if (part[g->adjncy[jp]] == to)
+        {
+            gain += g->adjwgt[jp];
+        }
+    }
+    return gain;
+}
+
+/** Move vertices out of overweight parts and into underweight ones.
+ *
+ * Each move takes the vertex whose move costs the least cut, either
+ * out of the part furthest above its maximum weight, preferably into a
+ * neighbouring part, or into the part furthest below its minimum
+ * weight.
+ */
+static int
+partition_balance(
+    partition_graph_t * g,
+    int nparts,
+    int *part,
+    int *pwgts,
+    int *minpwgts,
+    int *maxpwgts,
+    int cut)
+{
+    int n = g->nvtxs;
+    int *nomin = bml_allocate_memory(sizeof(int) * nparts);
+    int *conn = bml_allocate_memory(sizeof(int) * nparts);
+    int *touched = bml_noinit_allocate_memory(sizeof(int) * nparts);
+
+    for (int iter = 0; iter < n; iter++)
+    {
+        int over = 0;
+        int under = 0;
+        int roomiest = 0;
+        for (int p = 1; p < nparts; p++)
+        {
+            if (pwgts[p] - maxpwgts[p] > pwgts[over] - maxpwgts[over])
+            {
+                over = p;
+            }
+            if (minpwgts[p] - pwgts[p] > minpwgts[under] - pwgts[under])
+            {
+                under = p;
+            }
+            if (maxpwgts[p] - pwgts[p] > maxpwgts[roomiest] - pwgts[roomiest])
+            {
+                roomiest = p;
+            }
+        }
+        int drain = pwgts[over] > maxpwgts[over];
+        if (!drain && pwgts[under] >= minpwgts[under])
+        {
+            break;
+        }
+
+        int best = -1;
+        int best_to = -1;
+        int best_gain = 0;
+        for (int v = 0; v < n; v++)
+        {
+            int from = part[v];
+            int to = -1;
+            int gain = 0;
+            if (drain && from == over)
+            {
+                gain = partition_best_move(g, part, pwgts, nomin, maxpwgts,
+                                           v, conn, touched, &to);
+                if (to < 0 && roomiest != from
+                    && pwgts[roomiest] + g->vwgt[v] <= maxpwgts[roomiest])
+                {
+                    to = roomiest;
+                    gain = partition_move_gain(g, part, v, to);
+                }
+            }
+            else if (!drain && from != under
+                     && pwgts[from] - g->vwgt[v] >= minpwgts[from]
+                     && pwgts[under] + g->vwgt[v] <= maxpwgts[under])
+            {
+                to = under;
+                gain = partition_move_gain(g, part, v, to);
+            }
+            if (to >= 0 && (best < 0 || gain > best_gain))
+            {
+                best = v;
+                best_to = to;
+                best_gain = gain;
+            }
+        }
+        if (best < 0)
+        {
+            break;
+        }
+        pwgts[part[best]] -= g->vwgt[best];
+        pwgts[best_to] += g->vwgt[best];
+        part[best] = best_to;
+        cut -= best_gain;
+    }
+
+    bml_free_memory(nomin);
+    bml_free_memory(conn);
+    bml_free_memory(touched);
+
+    return cut;
+}
+
+/** Refine a k-way partition by Fiduccia-Mattheyses passes.
+ *
+ * Each pass moves boundary vertices in order of decreasing gain, each
+ * at most once and accepting negative gains to climb out of local
+ * minima, and then rolls back to the best cut seen. The gains are
+ * recomputed in parallel at the start of every pass.
+ *
+ * \param tpwgts The target weight of each part
+ * \return The edge cut of the refined partition
+ */
+static int
+partition_refine(
+    partition_graph_t * g,
+    int nparts,
+    int *tpwgts,
+    int *part)
+{
+    int n = g->nvtxs;
+    int *minpwgts = bml_noinit_allocate_memory(sizeof(int) * nparts);
+    int *maxpwgts = bml_noinit_allocate_memory(sizeof(int) * nparts);
+    partition_part_weight_limits(g, nparts, tpwgts, minpwgts, maxpwgts);
+
+    int *pwgts = bml_allocate_memory(sizeof(int) * nparts);
+    for (int v = 0; v < n; v++)
+    {
+        pwgts[part[v]] += g->vwgt[v];
+    }
+    int cut = partition_cut(g, part);
+    cut = partition_balance(g, nparts, part, pwgts, minpwgts, maxpwgts, cut);
+
+    int *gain = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *target = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *locked = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *moved = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *moved_from = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *conn = bml_allocate_memory(sizeof(int) * nparts);
+    int *touched = bml_noinit_allocate_memory(sizeof(int) * nparts);
+    partition_queue_t q;
+    q.heap = bml_noinit_allocate_memory(sizeof(int) * n);
+    q.key = bml_noinit_allocate_memory(sizeof(int) * n);
+    q.pos = bml_noinit_allocate_memory(sizeof(int) * n);
+
+    for (int pass = 0; pass < NPASSES; pass++)
+    {
+#pragma omp parallel                                                    \
+  shared(g, nparts, part, pwgts, minpwgts, maxpwgts, gain, target)
+        {
+            int *tconn = bml_allocate_memory(sizeof(int) * nparts);
+            int *ttouched = bml_noinit_allocate_memory(sizeof(int) * nparts);
+#pragma omp for
+            for (int v = 0; v < n; v++)
+            {
+                gain[v] = partition_best_move(g, part, pwgts, minpwgts,
+                                              maxpwgts, v, tconn, ttouched,
+                                              &target[v]);
+            }
+            bml_free_memory(tconn);
+            bml_free_memory(ttouched);
+        }
+
+        q.size = 0;
+        for (int v = 0; v < n; v++)
+        {
+            locked[v] = 0;
+            q.pos[v] = -1;
+        }
+        for (int v = 0; v < n; v++)
+        {
+            if (target[v] >= 0)
+            {
+                partition_queue_set(&q, v, gain[v]);
+            }
+        }
+
+        int nmoves = 0;
+        int best_moves = 0;
+        int best_cut = cut;
+        while (q.size > 0)
+        {
+            int v = q.heap[0];
+            partition_queue_remove(&q, v);
+
+            int to;
+            int vgain = partition_best_move(g, part, pwgts, minpwgts,
+                                            maxpwgts, v, conn, touched, &to);
+            if (to < 0)
+            {
+                continue;
+            }
+            int from = part[v];
+            part[v] = to;
+            pwgts[from] -= g->vwgt[v];
+            pwgts[to] += g->vwgt[v];
+            cut -= vgain;
+            locked[v] = 1;
+            moved[nmoves] = v;
+            moved_from[nmoves] = from;
+            nmoves++;
+
+            if (cut < best_cut)
+            {
+                best_cut = cut;
+                best_moves = nmoves;
+            }
+            else if (nmoves - best_moves > FM_LIMIT)
+            {
+                break;
+            }
+
+            for (int jp = g->xadj[v]; jp < g->xadj[v + 1]; jp++)
+            {
+                int u = g->adjncy[jp];
+                if (locked[u])
+                {
+                    continue;
+                }
+                int ugain = partition_best_move(g, part, pwgts, minpwgts,
+                                                maxpwgts, u, conn, touched,
+                                                &to);
+                if (to >= 0)
+                {
+                    partition_queue_set(&q, u, ugain);
+                }
+                else
+                {
+                    partition_queue_remove(&q, u);
+                }
+            }
+        }
+
+        // Roll back the moves past the best cut
+        for (int k = nmoves - 1; k >= best_moves; k--)
+        {
+            int v = moved[k];
+            pwgts[part[v]] -= g->vwgt[v];
+            pwgts[moved_from[k]] += g->vwgt[v];
+            part[v] = moved_from[k];
+        }
+        cut = best_cut;
+
+        if (best_moves == 0)
+        {
+            break;
+        }
+    }
+
+    bml_free_memory(minpwgts);
+    bml_free_memory(maxpwgts);
+    bml_free_memory(pwgts);
+    bml_free_memory(gain);
+    bml_free_memory(target);
+    bml_free_memory(locked);
+    bml_free_memory(moved);
+    bml_free_memory(moved_from);
+    bml_free_memory(conn);
+    bml_free_memory(touched);
+    bml_free_memory(q.heap);
+    bml_free_memory(q.key);
+    bml_free_memory(q.pos);
+
+    return cut;
+}
+
+/** Extract the subgraph induced by the vertices of one part.
+ *
+ * \param map The vertex of g of each subgraph vertex (on return)
+ */
+static partition_graph_t *
+partition_subgraph(
+    partition_graph_t * g,
+    int *part,
+    int ipart,
+    int *map)
+{
+    int n = g->nvtxs;
+    int *index = bml_noinit_allocate_memory(sizeof(int) * n);
+    int sn = 0;
+    int snedges = 0;
+    for (int v = 0; v < n; v++)
+    {
+        index[v] = -1;
+        if (part[v] == ipart)
+        {
+            index[v] = sn;
+            map[sn++] = v;
+            snedges += g->xadj[v + 1] - g->xadj[v];
+        }
+    }
+
+    partition_graph_t *sg =
+        bml_noinit_allocate_memory(sizeof(partition_graph_t));
+    sg->nvtxs = sn;
+    sg->tvwgt = 0;
+    sg->cmap = NULL;
+    sg->xadj = bml_noinit_allocate_memory(sizeof(int) * (sn + 1));
+    sg->adjncy = bml_noinit_allocate_memory(sizeof(int) * MAX(snedges, 1));
+    sg->adjwgt = bml_noinit_allocate_memory(sizeof(int) * MAX(snedges, 1));
+    sg->vwgt = bml_noinit_allocate_memory(sizeof(int) * MAX(sn, 1));
+    sg->xadj[0] = 0;
+    for (int sv = 0; sv < sn; sv++)
+    {
+        int v = map[sv];
+        int jq = sg->xadj[sv];
+        for (int jp = g->xadj[v]; jp < g->xadj[v + 1]; jp++)
+        {
+            if (index[g->adjncy[jp]] >= 0)
+            {
+                sg->adjncy[jq] = index[g->adjncy[jp]];
+                sg->adjwgt[jq] = g->adjwgt[jp];
+                jq++;
+            }
+        }
+        sg->xadj[sv + 1] = jq;
+        sg->vwgt[sv] = g->vwgt[v];
+        sg->tvwgt += g->vwgt[v];
+    }
+    bml_free_memory(index);
+
+    return sg;
+}
+
+static void partition_multilevel(
+    partition_graph_t * g,
+    int nparts,
+    int *tpwgts,
+    int *part);
+
+/** Bisect the coarsest graph by greedy graph growing.
+ *
+ * Graph growing from several seeds is tried and refined in parallel,
+ * the bisection with the smallest edge cut is kept.
+ */
+static void
+partition_grow_best(
+    partition_graph_t * g,
+    int *tpwgts,
+    int *part)
+{
+    int n = g->nvtxs;
+    int ntrials = MIN(NTRIALS, n);
+    int *trial_part = bml_noinit_allocate_memory(sizeof(int) * n * ntrials);
+    int *trial_cut = bml_noinit_allocate_memory(sizeof(int) * ntrials);
+
+#pragma omp parallel                                    \
+  shared(g, n, tpwgts, ntrials, trial_part, trial_cut)
+    {
+        int *conn = bml_allocate_memory(sizeof(int) * n);
+        int *frontier = bml_noinit_allocate_memory(sizeof(int) * n);
+#pragma omp for
+        for (int t = 0; t < ntrials; t++)
+        {
+            int *tpart = &trial_part[t * n];
+            partition_grow(g, tpwgts[0], (int) ((long) t * n / ntrials),
+                           tpart, conn, frontier);
+            trial_cut[t] = partition_refine(g, 2, tpwgts, tpart);
+        }
+        bml_free_memory(conn);
+        bml_free_memory(frontier);
+    }
+
+    int best = 0;
+    for (int t = 1; t < ntrials; t++)
+    {
+        if (trial_cut[t] < trial_cut[best])
+        {
+            best = t;
+        }
+    }
+    memcpy(part, &trial_part[best * n], sizeof(int) * n);
+
+    bml_free_memory(trial_part);
+    bml_free_memory(trial_cut);
+}
+
+/** Partition a graph by recursive multilevel bisection.
+ *
+ * The first half of the bisection gets nparts / 2 parts and a
+ * matching share of the weight, both halves are then partitioned
+ * recursively.
+ *
+ * \param first The number of the first part
+ * \param part The part of each vertex (on return)
+ */
+static void
+partition_bisect(
+    partition_graph_t * g,
+    int nparts,
+    int first,
+    int *part)
+{
+    int n = g->nvtxs;
+    if (nparts == 1 || n <= nparts)
+    {
+        for (int v = 0; v < n; v++)
+        {
+            part[v] = first + (nparts == 1 ? 0 : v);
+        }
+        return;
+    }
+
+    int nparts0 = nparts / 2;
+    int tpwgts[2];
+    tpwgts[0] = (int) ((long) g->tvwgt * nparts0 / nparts);
+    tpwgts[1] = g->tvwgt - tpwgts[0];
+
+    int *side = bml_noinit_allocate_memory(sizeof(int) * n);
+    partition_multilevel(g, 2, tpwgts, side);
+
+    int *map = bml_noinit_allocate_memory(sizeof(int) * n);
+    int *spart = bml_noinit_allocate_memory(sizeof(int) * n);
+    for (int s = 0; s < 2; s++)
+    {
+        partition_graph_t *sg = partition_subgraph(g, side, s, map);
+        partition_bisect(sg, s == 0 ? nparts0 : nparts - nparts0,
+                         s == 0 ? first : first + nparts0, spart);
+        for (int sv = 0; sv < sg->nvtxs; sv++)
+        {
+            part[map[sv]] = spart[sv];
+        }
+        partition_free_graph(sg);
+    }
+
+    bml_free_memory(side);
+    bml_free_memory(map);
+    bml_free_memory(spart);
+}
+
+/** Partition a graph by coarsening, partitioning the coarsest graph,
+ * and refining while projecting back.
+ *
+ * The coarsest graph of a bisection is bisected by greedy graph
+ * growing, for more parts it is partitioned by recursive bisection.
+ *
+ * \param tpwgts The target weight of each part
+ * \param part The part of each vertex (on return)
+ */
+static void
+partition_multilevel(
+    partition_graph_t * g,
+    int nparts,
+    int *tpwgts,
+    int *part)
+{
+    int nlevels = 1;
+    int max_levels = 16;
+    partition_graph_t **graphs =
+        bml_noinit_allocate_memory(sizeof(partition_graph_t *) * max_levels);
+    graphs[0] = g;
+
+    int coarsen_to = COARSEN_PER_PART * nparts;
+    int maxvwgt = MAX(2, (int) (1.5 * g->tvwgt / coarsen_to));
+    unsigned int seed = 1;
+    while (graphs[nlevels - 1]->nvtxs > coarsen_to)
+    {
+        partition_graph_t *fg = graphs[nlevels - 1];
+        partition_graph_t *cg = partition_coarsen_graph(fg, maxvwgt, &seed);
+        if (cg->nvtxs > COARSEN_MIN_SHRINK * fg->nvtxs)
+        {
+            partition_free_graph(cg);
+            bml_free_memory(fg->cmap);
+            fg->cmap = NULL;
+            break;
+        }
+        if (nlevels == max_levels)
+        {
+            partition_graph_t **more =
+                bml_noinit_allocate_memory(sizeof(partition_graph_t *) *
+                                           2 * max_levels);
+            memcpy(more, graphs, sizeof(partition_graph_t *) * max_levels);
+            bml_free_memory(graphs);
+            graphs = more;
+            max_levels *= 2;
+        }
+        graphs[nlevels++] = cg;
+    }
+
+    partition_graph_t *cg = graphs[nlevels - 1];
+    int *cpart = bml_noinit_allocate_memory(sizeof(int) * MAX(cg->nvtxs, 1));
+    if (nparts == 2)
+    {
+        partition_grow_best(cg, tpwgts, cpart);
+    }
+    else
+    {
+        partition_bisect(cg, nparts, 0, cpart);
+        partition_refine(cg, nparts, tpwgts, cpart);
+    }
+
+    for (int level = nlevels - 2; level >= 0; level--)
+    {
+        partition_graph_t *fg = graphs[level];
+        int *cmap = fg->cmap;
+        int *fpart = bml_noinit_allocate_memory(sizeof(int) * fg->nvtxs);
+#pragma omp parallel for                        \
+  shared(fg, cmap, fpart, cpart)
+        for (int v = 0; v < fg->nvtxs; v++)
+        {
+            fpart[v] = cpart[cmap[v]];
+        }
+        bml_free_memory(cpart);
+        cpart = fpart;
+        partition_refine(fg, nparts, tpwgts, cpart);
+        partition_free_graph(graphs[level + 1]);
+    }
+    memcpy(part, cpart, sizeof(int) * g->nvtxs);
+
+    bml_free_memory(g->cmap);
+    g->cmap = NULL;
+    bml_free_memory(cpart);
+    bml_free_memory(graphs);
+}
+
+/** Partition a graph into nparts parts of balanced size.
+ *
+ * A multilevel k-way partitioner in the spirit of METIS: the graph is
+ * coarsened by heavy-edge matching, the coarsest graph is partitioned
+ * by recursive bisection, and the partition is projected back level
+ * by level with Fiduccia-Mattheyses refinement of the edge cut. The
+ * bisections are multilevel themselves, starting from greedy graph
+ * growing. The parts hold at most 3% more or fewer vertices than
+ * average (or one vertex, for small graphs). The result is
+ * deterministic.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param N The number of vertices
+ * \param xadj Index of each row in adjncy, 0-based (from bml_adjacency)
+ * \param adjncy Adjacency vector, 0-based
+ * \param nparts The number of parts
+ * \param part The part of each vertex (on return)
+ */
+void
+bml_partition_graph(
+    int N,
+    int *xadj,
+    int *adjncy,
+    int nparts,
+    int *part)
+{
+    if (nparts <= 1 || N <= nparts)
+    {
+        for (int i = 0; i < N; i++)
+        {
+            part[i] = nparts <= 1 ? 0 : i;
+        }
+        return;
+    }
+
+    partition_graph_t *g = partition_build_graph(N, xadj, adjncy);
+    int *tpwgts = bml_noinit_allocate_memory(sizeof(int) * nparts);
+    for (int p = 0; p < nparts; p++)
+    {
+        tpwgts[p] = N / nparts + (p < N % nparts ? 1 : 0);
+    }
+
+    partition_multilevel(g, nparts, tpwgts, part);
+
+    bml_free_memory(tpwgts);
+    partition_free_graph(g);
+}
+
+/** Return the number of edges cut by a partition.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param N The number of vertices
+ * \param xadj Index of each row in adjncy, 0-based
+ * \param adjncy Adjacency vector of a symmetric graph, 0-based
+ * \param part The part of each vertex
+ * \return The number of edges between different parts
+ */
+int
+bml_partition_edgecut(
+    int N,
+    int *xadj,
+    int *adjncy,
+    int *part)
+{
+    int cut = 0;
+#pragma omp parallel for                        \
+  shared(N, xadj, adjncy, part)                 \
+  reduction(+:cut)
+    for (int i = 0; i < N; i++)
+    {
+        for (int jp = xadj[i]; jp < xadj[i + 1]; jp++)
+        {
+            if (part[adjncy[jp]] != part[i])
+            {
+                cut++;
+            }
+        }
+    }
+    return cut / 2;
+}
+
+/** Return the nodes of one part of a partition.
+ *
+ * The nodes come out in increasing order, ready to be passed to
+ * bml_matrix2submatrix_index as the core of a submatrix.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param N The number of vertices
+ * \param part The part of each vertex
+ * \param ipart The part
+ * \param nodelist The nodes of part ipart (on return)
+ * \return The number of nodes of part ipart
+ */
+int
+bml_partition_nodelist(
+    int N,
+    int *part,
+    int ipart,
+    int *nodelist)
+{
+    int nsize = 0;
+    for (int i = 0; i < N; i++)
+    {
+        if (part[i] == ipart)
+        {
+            nodelist[nsize++] = i;
+        }
+    }
+    return nsize;
+}
+
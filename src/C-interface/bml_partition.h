@@ -0,0 +1,30 @@
+/** \file */
+
+#ifndef __BML_PARTITION_H
+#define __BML_PARTITION_H
+
+#include "bml_types.h"
+
+// Partition a graph into nparts parts of balanced size.
+void bml_partition_graph(
+    int N,
+    int *xadj,
+    int *adjncy,
+    int nparts,
+    int *part);
+
+// Return the number of edges cut by a partition.
+int bml_partition_edgecut(
+    int N,
+    int *xadj,
+    int *adjncy,
+    int *part);
+
+// Return the nodes of one part of a partition.
+int bml_partition_nodelist(
+    int N,
+    int *part,
+    int ipart,
+    int *nodelist);
+
+#endif
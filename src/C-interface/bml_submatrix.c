@@ -1,4 +1,5 @@
 #include "bml_submatrix.h"
+#include "bml_allocate.h"
 #include "bml_introspection.h"
 #include "bml_logger.h"
 #include "csr/bml_submatrix_csr.h"
@@ -8,6 +9,12 @@
 #include "ellblock/bml_submatrix_ellblock.h"
 
 #include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /** Determine element indices for submatrix, given a set of nodes/orbitals.
  *
@@ -240,6 +247,10 @@ bml_submatrix2matrix(
  *
  * \ingroup submatrix_group_C
  *
+ * The graph has an edge for every non-zero off-diagonal element of A
+ * and the neighbours of each row are sorted, as METIS and
+ * bml_partition_graph expect.
+ *
  * \param A Submatrix A
  * \param xadj index to start of each row
  * \param adjncy adjacency vector
@@ -256,7 +267,7 @@ bml_adjacency(
     switch (bml_get_type(A))
     {
         case dense:
-            LOG_ERROR("bml_adjacency routine is not implemented for dense\n");
+            bml_adjacency_dense(A, xadj, adjncy, base_flag);
             break;
         case ellpack:
             bml_adjacency_ellpack(A, xadj, adjncy, base_flag);
@@ -265,11 +276,10 @@ bml_adjacency(
             bml_adjacency_ellsort(A, xadj, adjncy, base_flag);
             break;
         case ellblock:
-            LOG_ERROR
-                ("bml_adjacency routine is not implemented for ellblock\n");
+            bml_adjacency_ellblock(A, xadj, adjncy, base_flag);
             break;
         case csr:
-            LOG_ERROR("bml_adjacency routine is not implemented for csr\n");
+            bml_adjacency_csr(A, xadj, adjncy, base_flag);
             break;
         default:
             LOG_ERROR("unknown matrix type\n");
@@ -391,3 +401,692 @@ bml_assign_submatrix(
             break;
     }
 }
+
+/** Size in bytes of the elements of a batch.
+ */
+static size_t
+submatrix_batch_element_size(
+    bml_submatrix_batch_t * batch)
+{
+    switch (batch->matrix_precision)
+    {
+        case single_real:
+            return sizeof(float);
+        case double_real:
+            return sizeof(double);
+        case single_complex:
+            return 2 * sizeof(float);
+        case double_complex:
+            return 2 * sizeof(double);
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return 0;
+}
+
+/** Wall clock time in seconds.
+ */
+static double
+submatrix_batch_time(
+    )
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+typedef struct
+{
+    int lsize;
+    int ipart;
+} submatrix_batch_part_t;
+
+static int
+submatrix_batch_compare(
+    const void *a,
+    const void *b)
+{
+    const submatrix_batch_part_t *pa = a;
+    const submatrix_batch_part_t *pb = b;
+
+    if (pa->lsize != pb->lsize)
+    {
+        return pa->lsize < pb->lsize ? 1 : -1;
+    }
+    return pa->ipart - pb->ipart;
+}
+
+/** Lay out the blocks of a batch once its indices are known.
+ *
+ * The dense kernels cost O(lsize^3), the largest blocks are run first
+ * so that the dynamic schedule ends with the small ones.
+ */
+static void
+submatrix_batch_layout(
+    bml_submatrix_batch_t * batch)
+{
+    int nparts = batch->nparts;
+    submatrix_batch_part_t *parts =
+        bml_noinit_allocate_memory(sizeof(submatrix_batch_part_t) *
+                                   (nparts + 1));
+
+    batch->value_ptr = bml_noinit_allocate_memory(sizeof(size_t) *
+                                                  (nparts + 1));
+    batch->value_ptr[0] = 0;
+    for (int p = 0; p < nparts; p++)
+    {
+        size_t lsize = batch->index_ptr[p + 1] - batch->index_ptr[p];
+        batch->value_ptr[p + 1] = batch->value_ptr[p] + lsize * lsize;
+        parts[p].lsize = lsize;
+        parts[p].ipart = p;
+    }
+    qsort(parts, nparts, sizeof(submatrix_batch_part_t),
+          submatrix_batch_compare);
+
+    batch->order = bml_noinit_allocate_memory(sizeof(int) * (nparts + 1));
+    for (int p = 0; p < nparts; p++)
+    {
+        batch->order[p] = parts[p].ipart;
+    }
+    bml_free_memory(parts);
+
+    batch->values =
+        bml_allocate_memory(submatrix_batch_element_size(batch) *
+                            (batch->value_ptr[nparts] + 1));
+    batch->timings = bml_allocate_memory(sizeof(double) * (nparts + 1));
+}
+
+/** Build the core+halo indices of all parts of a partition at once.
+ *
+ * The nodes of part p are part_nodes[part_ptr[p]] ...
+ * part_nodes[part_ptr[p + 1] - 1], as bml_partition_nodelist returns
+ * them. The index sets are the ones bml_matrix2submatrix_index builds
+ * part by part, they are built in parallel over the parts and stored
+ * back to back. The batch also holds the arena for the dense
+ * submatrices of all parts.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Hamiltonian matrix A
+ * \param B Graph matrix B
+ * \param nparts Number of parts
+ * \param part_ptr Offsets of the parts into part_nodes (nparts + 1)
+ * \param part_nodes Nodes of all parts
+ * \param double_jump_flag Flag to use double jump (0=no, 1=yes)
+ * \return The batch
+ */
+bml_submatrix_batch_t *
+bml_submatrix_batch_new(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int nparts,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag)
+{
+    bml_submatrix_batch_t *batch =
+        bml_allocate_memory(sizeof(bml_submatrix_batch_t));
+
+    batch->nparts = nparts;
+    batch->matrix_precision = bml_get_precision(A);
+    batch->index_ptr = bml_allocate_memory(sizeof(int) * (nparts + 1));
+    batch->ncore = bml_allocate_memory(sizeof(int) * (nparts + 1));
+
+    switch (bml_get_type(A))
+    {
+        case ellpack:
+            bml_submatrix_batch_index_ellpack(A, B, batch, part_ptr,
+                                              part_nodes, double_jump_flag);
+            break;
+        case ellsort:
+            bml_submatrix_batch_index_ellsort(A, B, batch, part_ptr,
+                                              part_nodes, double_jump_flag);
+            break;
+        default:
+            LOG_ERROR
+                ("bml_submatrix_batch_new not implemented for format\n");
+            break;
+    }
+    submatrix_batch_layout(batch);
+
+    return batch;
+}
+
+/** Extract the dense submatrices of all parts into the batch arena.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param batch The batch built for A
+ */
+void
+bml_submatrix_batch_extract(
+    bml_matrix_t * A,
+    bml_submatrix_batch_t * batch)
+{
+    switch (bml_get_type(A))
+    {
+        case ellpack:
+            bml_submatrix_batch_extract_ellpack(A, batch);
+            break;
+        case ellsort:
+            bml_submatrix_batch_extract_ellsort(A, batch);
+            break;
+        default:
+            LOG_ERROR
+                ("bml_submatrix_batch_extract not implemented for format\n");
+            break;
+    }
+}
+
+/** Run a dense kernel on every submatrix of a batch.
+ *
+ * The parts are spread over the threads, largest first, and each
+ * kernel runs on a single thread. The time each kernel took is left
+ * in batch->timings.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param batch The batch
+ * \param kernel The dense kernel, SP2 or a diagonalization for example
+ * \param data User data passed on to the kernel
+ */
+void
+bml_submatrix_batch_apply(
+    bml_submatrix_batch_t * batch,
+    bml_submatrix_kernel_t kernel,
+    void *data)
+{
+    int nparts = batch->nparts;
+    int *order = batch->order;
+    int *index_ptr = batch->index_ptr;
+    int *ncore = batch->ncore;
+    double *timings = batch->timings;
+    size_t element_size = submatrix_batch_element_size(batch);
+    char *values = batch->values;
+    size_t *value_ptr = batch->value_ptr;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < nparts; k++)
+    {
+        int p = order[k];
+        double start = submatrix_batch_time();
+
+        kernel(p, index_ptr[p + 1] - index_ptr[p], ncore[p],
+               values + value_ptr[p] * element_size, data);
+        timings[p] = submatrix_batch_time() - start;
+    }
+}
+
+/** Assemble the core rows of all submatrices into the final matrix.
+ *
+ * The core rows of the parts must not overlap.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param batch The batch
+ * \param B Matrix B
+ * \param threshold Threshold for elements
+ */
+void
+bml_submatrix_batch_assemble(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_t * B,
+    double threshold)
+{
+    switch (bml_get_type(B))
+    {
+        case ellpack:
+            bml_submatrix_batch_assemble_ellpack(batch, B, threshold);
+            break;
+        case ellsort:
+            bml_submatrix_batch_assemble_ellsort(batch, B, threshold);
+            break;
+        default:
+            LOG_ERROR
+                ("bml_submatrix_batch_assemble not implemented for format\n");
+            break;
+    }
+}
+
+/** Return the dense submatrix of one part of a batch.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param batch The batch
+ * \param ipart The part
+ * \return The row-major lsize x lsize block of the part
+ */
+void *
+bml_submatrix_batch_block(
+    bml_submatrix_batch_t * batch,
+    int ipart)
+{
+    return (char *) batch->values +
+        batch->value_ptr[ipart] * submatrix_batch_element_size(batch);
+}
+
+/** Deallocate a submatrix batch.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param batch The batch
+ */
+void
+bml_deallocate_submatrix_batch(
+    bml_submatrix_batch_t ** batch)
+{
+    if (*batch == NULL)
+    {
+        return;
+    }
+    bml_free_memory((*batch)->index_ptr);
+    bml_free_memory((*batch)->core_halo_index);
+    bml_free_memory((*batch)->ncore);
+    bml_free_memory((*batch)->value_ptr);
+    bml_free_memory((*batch)->values);
+    bml_free_memory((*batch)->order);
+    bml_free_memory((*batch)->timings);
+    bml_free_memory(*batch);
+    *batch = NULL;
+}
+
+/** Sorted off-diagonal pattern of a matrix, row by row.
+ */
+static void
+submatrix_cache_pattern(
+    bml_matrix_t * A,
+    int **ptr,
+    int **cols)
+{
+    int N = bml_get_N(A);
+
+    switch (bml_get_type(A))
+    {
+        case dense:
+        case ellpack:
+        case ellsort:
+        case csr:
+            break;
+        default:
+            LOG_ERROR
+                ("bml_submatrix_index_cache not implemented for format\n");
+            break;
+    }
+    *ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+    *cols = bml_noinit_allocate_memory(sizeof(int) *
+                                       ((size_t) N * bml_get_M(A) + 1));
+    bml_adjacency(A, *ptr, *cols, 0);
+}
+
+/** Build the core+halo indices of one part from the cached patterns.
+ *
+ * The indices are the ones bml_matrix2submatrix_index builds, with
+ * the neighbours of each node in increasing order. ix must be zero on
+ * entry and is left zero, list holds N indices.
+ *
+ * \return Whether the indices changed
+ */
+static int
+submatrix_cache_build_part(
+    bml_submatrix_index_cache_t * cache,
+    int ipart,
+    int *ix,
+    int *list)
+{
+    int *nodelist = cache->part_nodes + cache->part_ptr[ipart];
+    int nsize = cache->part_ptr[ipart + 1] - cache->part_ptr[ipart];
+    int *A_ptr = cache->A_ptr;
+    int *A_cols = cache->A_cols;
+    int *B_ptr = cache->B_ptr;
+    int *B_cols = cache->B_cols;
+    int l = 0;
+    int ll = 0;
+    int ls;
+
+    // Cores are first followed by halos
+    for (int j = 0; j < nsize; j++)
+    {
+        int ii = nodelist[j];
+        if (ix[ii] == 0)
+        {
+            ix[ii] = 1;
+            list[l++] = ii;
+            ll++;
+        }
+    }
+
+    // Collect halo indices from graph, then from H
+    for (int j = 0; j < nsize; j++)
+    {
+        int ii = nodelist[j];
+        for (int jp = B_ptr[ii]; jp < B_ptr[ii + 1]; jp++)
+        {
+            if (ix[B_cols[jp]] == 0)
+            {
+                ix[B_cols[jp]] = 1;
+                list[l++] = B_cols[jp];
+            }
+        }
+    }
+    for (int j = 0; j < nsize; j++)
+    {
+        int ii = nodelist[j];
+        for (int jp = A_ptr[ii]; jp < A_ptr[ii + 1]; jp++)
+        {
+            if (ix[A_cols[jp]] == 0)
+            {
+                ix[A_cols[jp]] = 1;
+                list[l++] = A_cols[jp];
+            }
+        }
+    }
+
+    // Double jump based on graph
+    ls = l;
+    if (cache->double_jump_flag == 1)
+    {
+        for (int j = 0; j < ls; j++)
+        {
+            int ii = list[j];
+            for (int jp = B_ptr[ii]; jp < B_ptr[ii + 1]; jp++)
+            {
+                if (ix[B_cols[jp]] == 0)
+                {
+                    ix[B_cols[jp]] = 1;
+                    list[l++] = B_cols[jp];
+                }
+            }
+        }
+    }
+    else
+    {
+        ls = 0;
+    }
+
+    for (int j = 0; j < l; j++)
+    {
+        ix[list[j]] = 0;
+    }
+
+    int changed = cache->core_halo_index[ipart] == NULL ||
+        cache->lsize[ipart] != l || cache->ncore[ipart] != ll ||
+        memcmp(cache->core_halo_index[ipart], list, sizeof(int) * l) != 0;
+    if (changed)
+    {
+        bml_free_memory(cache->core_halo_index[ipart]);
+        cache->core_halo_index[ipart] =
+            bml_noinit_allocate_memory(sizeof(int) * (l + 1));
+        memcpy(cache->core_halo_index[ipart], list, sizeof(int) * l);
+        cache->lsize[ipart] = l;
+        cache->ncore[ipart] = ll;
+    }
+    cache->nread[ipart] = ls;
+
+    return changed;
+}
+
+/** Rebuild the parts that read a changed row.
+ *
+ * With A_changed and B_changed NULL every part is rebuilt.
+ */
+static void
+submatrix_cache_rebuild(
+    bml_submatrix_index_cache_t * cache,
+    char *A_changed,
+    char *B_changed)
+{
+    int N = cache->N;
+    int nparts = cache->nparts;
+    int ndirty = 0;
+
+#pragma omp parallel reduction(+:ndirty)
+    {
+        int *ix = bml_allocate_memory(sizeof(int) * N);
+        int *list = bml_noinit_allocate_memory(sizeof(int) * N);
+
+#pragma omp for schedule(dynamic)
+        for (int p = 0; p < nparts; p++)
+        {
+            int stale = A_changed == NULL;
+
+            // The rows of A and B of the cores, and the rows of B of
+            // all indices the double jump went through
+            for (int j = cache->part_ptr[p];
+                 j < cache->part_ptr[p + 1] && !stale; j++)
+            {
+                int ii = cache->part_nodes[j];
+                stale = A_changed[ii] || B_changed[ii];
+            }
+            for (int j = 0; j < cache->nread[p] && !stale; j++)
+            {
+                stale = B_changed[cache->core_halo_index[p][j]];
+            }
+
+            cache->dirty[p] = stale
+                && submatrix_cache_build_part(cache, p, ix, list);
+            ndirty += cache->dirty[p];
+        }
+
+        bml_free_memory(ix);
+        bml_free_memory(list);
+    }
+    cache->ndirty = ndirty;
+}
+
+/** Mark the rows whose pattern differs between two snapshots.
+ */
+static void
+submatrix_cache_diff(
+    int N,
+    int *old_ptr,
+    int *old_cols,
+    int *new_ptr,
+    int *new_cols,
+    char *changed)
+{
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        int len = new_ptr[i + 1] - new_ptr[i];
+        changed[i] = len != old_ptr[i + 1] - old_ptr[i] ||
+            memcmp(old_cols + old_ptr[i], new_cols + new_ptr[i],
+                   sizeof(int) * len) != 0;
+    }
+}
+
+/** Build a cache of the core+halo indices of all parts of a partition.
+ *
+ * The parts are given as for bml_submatrix_batch_new. All parts are
+ * dirty after the cache is built.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Hamiltonian matrix A
+ * \param B Graph matrix B
+ * \param nparts Number of parts
+ * \param part_ptr Offsets of the parts into part_nodes (nparts + 1)
+ * \param part_nodes Nodes of all parts
+ * \param double_jump_flag Flag to use double jump (0=no, 1=yes)
+ * \return The cache
+ */
+bml_submatrix_index_cache_t *
+bml_submatrix_index_cache_new(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int nparts,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag)
+{
+    bml_submatrix_index_cache_t *cache =
+        bml_allocate_memory(sizeof(bml_submatrix_index_cache_t));
+
+    cache->N = bml_get_N(A);
+    cache->nparts = nparts;
+    cache->double_jump_flag = double_jump_flag;
+    cache->part_ptr = bml_noinit_allocate_memory(sizeof(int) * (nparts + 1));
+    memcpy(cache->part_ptr, part_ptr, sizeof(int) * (nparts + 1));
+    cache->part_nodes =
+        bml_noinit_allocate_memory(sizeof(int) * (part_ptr[nparts] + 1));
+    memcpy(cache->part_nodes, part_nodes, sizeof(int) * part_ptr[nparts]);
+    submatrix_cache_pattern(A, &cache->A_ptr, &cache->A_cols);
+    submatrix_cache_pattern(B, &cache->B_ptr, &cache->B_cols);
+
+    cache->core_halo_index = bml_allocate_memory(sizeof(int *) * nparts);
+    cache->lsize = bml_allocate_memory(sizeof(int) * nparts);
+    cache->ncore = bml_allocate_memory(sizeof(int) * nparts);
+    cache->nread = bml_allocate_memory(sizeof(int) * nparts);
+    cache->dirty = bml_allocate_memory(sizeof(int) * nparts);
+    submatrix_cache_rebuild(cache, NULL, NULL);
+
+    return cache;
+}
+
+/** Update a cache of core+halo indices to new matrices.
+ *
+ * The patterns of A and B are compared row by row with the ones the
+ * cache holds. Only the parts that read a changed row are rebuilt,
+ * and a part is dirty if its indices changed. The submatrix results
+ * of the clean parts can be reused.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param cache The cache
+ * \param A Hamiltonian matrix A
+ * \param B Graph matrix B
+ * \return The number of dirty parts
+ */
+int
+bml_submatrix_index_cache_update(
+    bml_submatrix_index_cache_t * cache,
+    bml_matrix_t * A,
+    bml_matrix_t * B)
+{
+    int N = cache->N;
+    int *A_ptr, *A_cols, *B_ptr, *B_cols;
+    char *A_changed = bml_noinit_allocate_memory(N + 1);
+    char *B_changed = bml_noinit_allocate_memory(N + 1);
+
+    if (bml_get_N(A) != N)
+    {
+        LOG_ERROR("matrix size changed from %d to %d\n", N, bml_get_N(A));
+    }
+    submatrix_cache_pattern(A, &A_ptr, &A_cols);
+    submatrix_cache_pattern(B, &B_ptr, &B_cols);
+    submatrix_cache_diff(N, cache->A_ptr, cache->A_cols, A_ptr, A_cols,
+                         A_changed);
+    submatrix_cache_diff(N, cache->B_ptr, cache->B_cols, B_ptr, B_cols,
+                         B_changed);
+
+    bml_free_memory(cache->A_ptr);
+    bml_free_memory(cache->A_cols);
+    bml_free_memory(cache->B_ptr);
+    bml_free_memory(cache->B_cols);
+    cache->A_ptr = A_ptr;
+    cache->A_cols = A_cols;
+    cache->B_ptr = B_ptr;
+    cache->B_cols = B_cols;
+
+    submatrix_cache_rebuild(cache, A_changed, B_changed);
+
+    bml_free_memory(A_changed);
+    bml_free_memory(B_changed);
+
+    return cache->ndirty;
+}
+
+/** Return the cached core+halo indices of one part.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param cache The cache
+ * \param ipart The part
+ * \param vsize Size of core_halo_index and number of cores
+ * \return The core+halo indices, owned by the cache
+ */
+int *
+bml_submatrix_index_cache_get(
+    bml_submatrix_index_cache_t * cache,
+    int ipart,
+    int *vsize)
+{
+    vsize[0] = cache->lsize[ipart];
+    vsize[1] = cache->ncore[ipart];
+    return cache->core_halo_index[ipart];
+}
+
+/** Build a submatrix batch from the cached indices.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param cache The cache
+ * \param matrix_precision The precision of the submatrices
+ * \return The batch
+ */
+bml_submatrix_batch_t *
+bml_submatrix_index_cache_batch(
+    bml_submatrix_index_cache_t * cache,
+    bml_matrix_precision_t matrix_precision)
+{
+    int nparts = cache->nparts;
+    bml_submatrix_batch_t *batch =
+        bml_allocate_memory(sizeof(bml_submatrix_batch_t));
+
+    batch->nparts = nparts;
+    batch->matrix_precision = matrix_precision;
+    batch->index_ptr = bml_allocate_memory(sizeof(int) * (nparts + 1));
+    batch->ncore = bml_allocate_memory(sizeof(int) * (nparts + 1));
+    for (int p = 0; p < nparts; p++)
+    {
+        batch->index_ptr[p + 1] = batch->index_ptr[p] + cache->lsize[p];
+        batch->ncore[p] = cache->ncore[p];
+    }
+    batch->core_halo_index =
+        bml_noinit_allocate_memory(sizeof(int) *
+                                   (batch->index_ptr[nparts] + 1));
+    for (int p = 0; p < nparts; p++)
+    {
+        memcpy(batch->core_halo_index + batch->index_ptr[p],
+               cache->core_halo_index[p], sizeof(int) * cache->lsize[p]);
+    }
+    submatrix_batch_layout(batch);
+
+    return batch;
+}
+
+/** Deallocate a cache of core+halo indices.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param cache The cache
+ */
+void
+bml_deallocate_submatrix_index_cache(
+    bml_submatrix_index_cache_t ** cache)
+{
+    if (*cache == NULL)
+    {
+        return;
+    }
+    for (int p = 0; p < (*cache)->nparts; p++)
+    {
+        bml_free_memory((*cache)->core_halo_index[p]);
+    }
+    bml_free_memory((*cache)->core_halo_index);
+    bml_free_memory((*cache)->part_ptr);
+    bml_free_memory((*cache)->part_nodes);
+    bml_free_memory((*cache)->A_ptr);
+    bml_free_memory((*cache)->A_cols);
+    bml_free_memory((*cache)->B_ptr);
+    bml_free_memory((*cache)->B_cols);
+    bml_free_memory((*cache)->lsize);
+    bml_free_memory((*cache)->ncore);
+    bml_free_memory((*cache)->nread);
+    bml_free_memory((*cache)->dirty);
+    bml_free_memory(*cache);
+    *cache = NULL;
+}
@@ -76,4 +76,67 @@ void bml_assign_submatrix(
     bml_matrix_t * B,
     int irow,
     int icol);
+
+// Build the core+halo indices of all parts of a partition at once.
+bml_submatrix_batch_t *bml_submatrix_batch_new(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int nparts,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag);
+
+// Extract the dense submatrices of all parts into the batch arena.
+void bml_submatrix_batch_extract(
+    bml_matrix_t * A,
+    bml_submatrix_batch_t * batch);
+
+// Run a dense kernel on every submatrix of a batch.
+void bml_submatrix_batch_apply(
+    bml_submatrix_batch_t * batch,
+    bml_submatrix_kernel_t kernel,
+    void *data);
+
+// Assemble the core rows of all submatrices into the final matrix.
+void bml_submatrix_batch_assemble(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_t * B,
+    double threshold);
+
+// Return the dense submatrix of one part of a batch.
+void *bml_submatrix_batch_block(
+    bml_submatrix_batch_t * batch,
+    int ipart);
+
+void bml_deallocate_submatrix_batch(
+    bml_submatrix_batch_t ** batch);
+
+// Cache the core+halo indices of all parts of a partition.
+bml_submatrix_index_cache_t *bml_submatrix_index_cache_new(
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int nparts,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag);
+
+// Update the cached indices of the parts whose neighbourhood changed.
+int bml_submatrix_index_cache_update(
+    bml_submatrix_index_cache_t * cache,
+    bml_matrix_t * A,
+    bml_matrix_t * B);
+
+// Return the cached core+halo indices of one part.
+int *bml_submatrix_index_cache_get(
+    bml_submatrix_index_cache_t * cache,
+    int ipart,
+    int *vsize);
+
+// Build a submatrix batch from the cached indices.
+bml_submatrix_batch_t *bml_submatrix_index_cache_batch(
+    bml_submatrix_index_cache_t * cache,
+    bml_matrix_precision_t matrix_precision);
+
+void bml_deallocate_submatrix_index_cache(
+    bml_submatrix_index_cache_t ** cache);
 #endif
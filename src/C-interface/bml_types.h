@@ -3,6 +3,9 @@
 #ifndef __BML_TYPES_H
 #define __BML_TYPES_H
 
+#include <stddef.h>
+#include <stdint.h>
+
 /** The supported matrix types. */
 typedef enum
 {
@@ -78,6 +81,225 @@ typedef enum
     graph_distributed
 } bml_distribution_mode_t;
 
+/** The row accumulators of the sparse matrix multiplies. */
+typedef enum
+{
+    /** Dense for small N, hash otherwise. */
+    accumulator_auto,
+    /** Dense scatter vector of length N. */
+    accumulator_dense,
+    /** Open-addressing hash table sized to the row fill. */
+    accumulator_hash
+} bml_accumulator_type_t;
+
+/** The message layouts of bml_allGatherVParallel. */
+typedef enum
+{
+    /** Ship the padded rows (ELLPACK and ELLSORT only). */
+    gather_padded,
+    /** Ship only the stored elements of each row. */
+    gather_compressed
+} bml_gather_mode_t;
+
+/** The encodings of column index arrays in files and messages. */
+typedef enum
+{
+    /** Plain 32-bit indices. */
+    index_encoding_none,
+    /** Per-row differences, bit-packed or variable-byte. */
+    index_encoding_delta
+} bml_index_encoding_t;
+
+/** The row costs a balanced domain decomposition evens out. */
+typedef enum
+{
+    /** Every row costs the same. */
+    balance_rows,
+    /** A row costs its number of non-zeros. */
+    balance_nnz,
+    /** A row costs the flops of its row of X * X, the sum of the
+     * non-zeros of the rows its columns point to. */
+    balance_multiply
+} bml_balance_t;
+
+/** The algorithms of the distributed2d matrix multiply. */
+typedef enum
+{
+    /** Cannon's algorithm, shifting blocks between neighbours. */
+    distributed_multiply_cannon,
+    /** SUMMA, broadcasting blocks along process rows and columns. */
+    distributed_multiply_summa
+} bml_distributed_multiply_t;
+
+/** Sparsity plan of the sparse matrix square X * X.
+ *
+ * The plan is built by a symbolic pass over the pattern of X and is
+ * reused by the numeric multiplies as long as the pattern of X stays
+ * within the one the plan was built for. Rows outside
+ * [rowMin, rowMax) have no output columns, the input pattern is kept
+ * for all the rows the numeric pass reads.
+ */
+typedef struct
+{
+    /** The number of rows. */
+    int N;
+    /** The first row covered by the plan. */
+    int rowMin;
+    /** One past the last row covered by the plan. */
+    int rowMax;
+    /** Row pointers into in_cols (length N + 1). */
+    int *in_ptr;
+    /** The input column indices the plan was built for. */
+    int *in_cols;
+    /** The number of rows read by the numeric pass. */
+    int nread;
+    /** The rows read by the numeric pass, the rows of the plan and the
+     *  rows they reference. */
+    int *read_rows;
+    /** Row pointers into cols (length N + 1). */
+    int *row_ptr;
+    /** The output column indices of each row. */
+    int *cols;
+    /** The largest number of output columns in a row. */
+    int max_row_nnz;
+    /** The number of rows with k output columns (length max_row_nnz + 1). */
+    int *row_nnz_histogram;
+    /** The number of row chunks. */
+    int nchunks;
+    /** The first row of each chunk (length nchunks + 1), balanced by flops. */
+    int *chunk_ptr;
+} bml_multiply_plan_t;
+
+/** Statistics of a norm screened block multiply.
+ *
+ * A block product is skipped when the product of the Frobenius norms
+ * of its two blocks is below the screening tolerance. The sum of these
+ * norm products bounds the Frobenius norm of the error.
+ */
+typedef struct
+{
+    /** The number of block products computed. */
+    int64_t computed;
+    /** The number of block products skipped. */
+    int64_t skipped;
+    /** Upper bound of the Frobenius norm of the error from skipping. */
+    double error_bound;
+} bml_screening_stats_t;
+
+/** Batch of the dense core+halo submatrices of a partitioned matrix.
+ *
+ * All the submatrices live in one contiguous arena, a row-major
+ * lsize x lsize block per part with the lsize core+halo indices of
+ * the part, its core rows first.
+ */
+typedef struct
+{
+    /** The number of parts. */
+    int nparts;
+    /** The precision of the blocks. */
+    bml_matrix_precision_t matrix_precision;
+    /** Offsets of the parts into core_halo_index (length nparts + 1). */
+    int *index_ptr;
+    /** The core+halo indices of all parts. */
+    int *core_halo_index;
+    /** The number of core rows of each part. */
+    int *ncore;
+    /** Offsets of the blocks into values, in elements (length nparts + 1). */
+    size_t *value_ptr;
+    /** The dense blocks. */
+    void *values;
+    /** The parts by decreasing block size, the order they are run in. */
+    int *order;
+    /** The time the kernel took on each part, in seconds. */
+    double *timings;
+} bml_submatrix_batch_t;
+
+/** Core+halo indices of the parts of a partition kept across steps.
+ *
+ * The cache keeps the sparsity patterns of A and B the indices were
+ * built from. An update compares the new patterns row by row and only
+ * rebuilds the parts that read a changed row.
+ */
+typedef struct
+{
+    /** The number of rows. */
+    int N;
+    /** The number of parts. */
+    int nparts;
+    /** Flag to use double jump (0=no, 1=yes). */
+    int double_jump_flag;
+    /** Offsets of the parts into part_nodes (length nparts + 1). */
+    int *part_ptr;
+    /** The nodes of all parts. */
+    int *part_nodes;
+    /** Row pointers of the pattern of A (length N + 1). */
+    int *A_ptr;
+    /** The off-diagonal columns of A, sorted by row. */
+    int *A_cols;
+    /** Row pointers of the pattern of B (length N + 1). */
+    int *B_ptr;
+    /** The off-diagonal columns of B, sorted by row. */
+    int *B_cols;
+    /** The core+halo indices of each part, cores first. */
+    int **core_halo_index;
+    /** The number of core+halo indices of each part. */
+    int *lsize;
+    /** The number of core rows of each part. */
+    int *ncore;
+    /** The number of indices whose rows of B the double jump read. */
+    int *nread;
+    /** Whether the indices of a part changed in the last update. */
+    int *dirty;
+    /** The number of dirty parts. */
+    int ndirty;
+} bml_submatrix_index_cache_t;
+
+/** Header of a binary matrix file.
+ *
+ * The header is followed by the native arrays of the matrix format,
+ * each starting at a multiple of BML_BINARY_ALIGNMENT bytes.
+ */
+typedef struct
+{
+    /** "BMLBIN" padded with NUL characters. */
+    char magic[8];
+    /** The version of the file layout. */
+    int32_t version;
+    /** BML_BINARY_ENDIANNESS as stored by the writing host. */
+    int32_t endianness;
+    /** The matrix type. */
+    int32_t matrix_type;
+    /** The real precision. */
+    int32_t matrix_precision;
+    /** The number of rows. */
+    int32_t N;
+    /** The number of columns per row (ellpack, ellsort, ellblock, csr). */
+    int32_t M;
+    /** The number of block rows (ellblock). */
+    int32_t NB;
+    /** The max. number of blocks per row (ellblock). */
+    int32_t MB;
+    /** The number of stored values. */
+    int64_t nvalues;
+    /** The encoding of the column indices (version 2). */
+    int32_t index_encoding;
+    /** The size of the encoded column indices in bytes (version 2). */
+    int64_t index_bytes;
+} bml_binary_header_t;
+
+/** Dense kernel run on each block of a submatrix batch.
+ *
+ * The kernel gets the part number, the block size lsize, the number
+ * of core rows llsize, the row-major block and the user data.
+ */
+typedef void (
+    *bml_submatrix_kernel_t) (
+    int ipart,
+    int lsize,
+    int llsize,
+    void *block,
+    void *data);
+
 /** Decomposition for working in parallel. */
 struct bml_domain_t
 {
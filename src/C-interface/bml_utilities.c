@@ -1,3 +1,5 @@
+#define _POSIX_C_SOURCE 200112L
+
 #include "../macros.h"
 #include "bml_export.h"
 #include "bml_introspection.h"
@@ -17,7 +19,26 @@
 #endif
 
 #include <complex.h>
+#include <fcntl.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/** Number of parse chunks per thread of the Matrix Market reader. */
+#define MM_CHUNKS_PER_THREAD 4
+
+/** Longest number the Matrix Market reader hands to strtod. */
+#define MM_MAX_TOKEN 128
+
+static bml_index_encoding_t s_binary_index_encoding = index_encoding_none;
 
 /** Print a bml vector.
  *
@@ -622,3 +643,731 @@ bml_sqrtint(
     }
     return i;
 }
+
+/** Exact powers of ten of the fast path of mm_parse_double. */
+static const double mm_pow10[] = {
+    1e0, 1e1, 1e2, 1e3, 1e4, 1e5, 1e6, 1e7, 1e8, 1e9, 1e10, 1e11,
+    1e12, 1e13, 1e14, 1e15, 1e16, 1e17, 1e18, 1e19, 1e20, 1e21, 1e22
+};
+
+static int
+mm_is_space(
+    char c)
+{
+    return c == ' ' || c == '\t' || c == '\r';
+}
+
+static int
+mm_is_digit(
+    char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static const char *
+mm_skip_space(
+    const char *p,
+    const char *end)
+{
+    while (p < end && mm_is_space(*p))
+    {
+        p++;
+    }
+    return p;
+}
+
+/** Parse a non-negative integer, return NULL if there is none.
+ */
+static const char *
+mm_parse_int(
+    const char *p,
+    const char *end,
+    int *value)
+{
+    long v = 0;
+    const char *start;
+
+    p = mm_skip_space(p, end);
+    start = p;
+    while (p < end && mm_is_digit(*p) && v <= INT32_MAX)
+    {
+        v = 10 * v + (*p - '0');
+        p++;
+    }
+    if (p == start || v > INT32_MAX)
+    {
+        return NULL;
+    }
+    *value = (int) v;
+    return p;
+}
+
+/** Parse a floating point number, return NULL if there is none.
+ *
+ * Numbers of at most 2^53 significant digits and powers of ten up to
+ * 10^22 are converted exactly with one rounding (Clinger's fast
+ * path), which covers what bml_write_bml_matrix writes. Anything else
+ * goes to strtod.
+ */
+static const char *
+mm_parse_double(
+    const char *p,
+    const char *end,
+    double *value)
+{
+    const char *start;
+    uint64_t mantissa = 0;
+    int ndigits = 0;
+    int exponent = 0;
+    int exact = 1;
+    int negative = 0;
+
+    p = mm_skip_space(p, end);
+    start = p;
+    if (p < end && (*p == '-' || *p == '+'))
+    {
+        negative = *p == '-';
+        p++;
+    }
+    const char *digits = p;
+    for (; p < end && mm_is_digit(*p); p++)
+    {
+        if (ndigits < 19)
+        {
+            mantissa = 10 * mantissa + (*p - '0');
+            ndigits += mantissa > 0;
+        }
+        else
+        {
+            exponent++;
+            exact &= *p == '0';
+        }
+    }
+    if (p < end && *p == '.')
+    {
+        p++;
+        for (; p < end && mm_is_digit(*p); p++)
+        {
+            if (ndigits < 19)
+            {
+                mantissa = 10 * mantissa + (*p - '0');
+                ndigits += mantissa > 0;
+                exponent--;
+            }
+            else
+            {
+                exact &= *p == '0';
+            }
+        }
+    }
+    int has_digits = p > digits && !(p == digits + 1 && *digits == '.');
+    if (has_digits && p < end && (*p == 'e' || *p == 'E'))
+    {
+        int e = 0;
+        int e_negative = 0;
+        p++;
+        if (p < end && (*p == '-' || *p == '+'))
+        {
+            e_negative = *p == '-';
+            p++;
+        }
+        if (p == end || !mm_is_digit(*p))
+        {
+            return NULL;
+        }
+        for (; p < end && mm_is_digit(*p); p++)
+        {
+            e = e < 10000 ? 10 * e + (*p - '0') : e;
+        }
+        exponent += e_negative ? -e : e;
+    }
+
+    if (has_digits && exact && mantissa <= (UINT64_C(1) << 53)
+        && exponent >= -22 && exponent <= 22)
+    {
+        double v = (double) mantissa;
+        v = exponent < 0 ? v / mm_pow10[-exponent] : v * mm_pow10[exponent];
+        *value = negative ? -v : v;
+    }
+    else
+    {
+        // inf, nan, long mantissas and large exponents
+        char token[MM_MAX_TOKEN];
+        char *token_end;
+        const char *q = start;
+        int n = 0;
+
+        while (q < end && !mm_is_space(*q) && *q != '\n'
+               && n < MM_MAX_TOKEN - 1)
+        {
+            token[n++] = *q++;
+        }
+        token[n] = '\0';
+        *value = strtod(token, &token_end);
+        if (token_end == token)
+        {
+            return NULL;
+        }
+        p = start + (token_end - token);
+    }
+    if (p < end && !mm_is_space(*p) && *p != '\n')
+    {
+        return NULL;
+    }
+    return p;
+}
+
+/** Return the start of the next line.
+ */
+static const char *
+mm_next_line(
+    const char *p,
+    const char *end)
+{
+    const char *nl = memchr(p, '\n', end - p);
+    return nl == NULL ? end : nl + 1;
+}
+
+/** Whether a line holds an entry, not a comment or blank.
+ */
+static int
+mm_is_entry(
+    const char *p,
+    const char *end)
+{
+    p = mm_skip_space(p, end);
+    return p < end && *p != '\n' && *p != '%';
+}
+
+/** Store a value of a compressed row in the matrix precision.
+ */
+static void
+mm_store(
+    void *vals,
+    bml_matrix_precision_t matrix_precision,
+    size_t k,
+    double re,
+    double im)
+{
+    switch (matrix_precision)
+    {
+        case single_real:
+            ((float *) vals)[k] = re;
+            break;
+        case double_real:
+            ((double *) vals)[k] = re;
+            break;
+        case single_complex:
+            ((float *) vals)[2 * k] = re;
+            ((float *) vals)[2 * k + 1] = im;
+            break;
+        case double_complex:
+            ((double *) vals)[2 * k] = re;
+            ((double *) vals)[2 * k + 1] = im;
+            break;
+        default:
+            break;
+    }
+}
+
+/** Read a Matrix Market coordinate file into compressed rows.
+ *
+ * The file is mapped into memory and cut into chunks at line breaks.
+ * The chunks are parsed in parallel, with a hand written number
+ * parser, into a coordinate list and per row counts. The compressed
+ * rows keep the entries of each row in file order. Symmetric,
+ * skew-symmetric, hermitian and skew-hermitian files are expanded to
+ * both triangles, pattern files get values of one, and the imaginary
+ * part of complex files is dropped for real precisions.
+ *
+ * The arrays are allocated with bml_allocate_memory, the caller frees
+ * them with bml_free_memory.
+ *
+ * \param filename The Matrix Market file
+ * \param matrix_precision The precision of the values
+ * \param N The number of rows
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ */
+void
+bml_read_compressed_rows(
+    char *filename,
+    bml_matrix_precision_t matrix_precision,
+    int *N,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+    char *buffer = NULL;
+    char *mapped = NULL;
+
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        LOG_ERROR("can not open %s\n", filename);
+    }
+    size_t length = st.st_size;
+    if (length > 0)
+    {
+        mapped = mmap(NULL, length, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (mapped == MAP_FAILED)
+        {
+            // Read the whole file instead
+            mapped = NULL;
+            buffer = bml_noinit_allocate_memory(length + 1);
+            size_t nread = 0;
+            while (nread < length)
+            {
+                ssize_t n = read(fd, buffer + nread, length - nread);
+                if (n <= 0)
+                {
+                    LOG_ERROR("read error on %s\n", filename);
+                }
+                nread += n;
+            }
+        }
+    }
+    const char *data = mapped != NULL ? mapped : buffer;
+    const char *end = data + length;
+    const char *p = data;
+
+    // Banner, comments and size line
+    char line[MM_MAX_TOKEN];
+    char banner[MM_MAX_TOKEN], object[MM_MAX_TOKEN], format[MM_MAX_TOKEN];
+    char field[MM_MAX_TOKEN], symmetry[MM_MAX_TOKEN];
+    const char *next = mm_next_line(p, end);
+    size_t n = MIN((size_t) (next - p), (size_t) MM_MAX_TOKEN - 1);
+    memcpy(line, p, n);
+    line[n] = '\0';
+    if (sscanf(line, "%127s %127s %127s %127s %127s", banner, object, format,
+               field, symmetry) != 5)
+    {
+        LOG_ERROR("read error on header of %s\n", filename);
+    }
+    LOG_DEBUG("Read: %s %s %s %s %s\n", banner, object, format, field,
+              symmetry);
+    if (strcmp(format, "coordinate") != 0)
+    {
+        LOG_ERROR("only coordinate Matrix Market files are supported\n");
+    }
+    int is_complex = strcmp(field, "complex") == 0;
+    int is_pattern = strcmp(field, "pattern") == 0;
+    int is_symmetric = strcmp(symmetry, "general") != 0;
+    double mirror_re = strncmp(symmetry, "skew", 4) == 0 ? -1 : 1;
+    double mirror_im = strstr(symmetry, "hermitian") != NULL ? -mirror_re :
+        mirror_re;
+
+    p = next;
+    while (p < end && !mm_is_entry(p, end))
+    {
+        p = mm_next_line(p, end);
+    }
+    int n_rows, n_cols, nnz;
+    const char *q = mm_parse_int(p, end, &n_rows);
+    q = q == NULL ? NULL : mm_parse_int(q, end, &n_cols);
+    q = q == NULL ? NULL : mm_parse_int(q, end, &nnz);
+    if (q == NULL || n_rows != n_cols)
+    {
+        LOG_ERROR("read error on size line of %s\n", filename);
+    }
+    LOG_DEBUG("hdimx = %d, nnz = %d\n", n_rows, nnz);
+    const char *body = mm_next_line(q, end);
+
+    // Cut the entries into chunks at line breaks
+#ifdef _OPENMP
+    int nchunks = MM_CHUNKS_PER_THREAD * omp_get_max_threads();
+#else
+    int nchunks = 1;
+#endif
+    const char **chunk =
+        bml_noinit_allocate_memory(sizeof(char *) * (nchunks + 1));
+    size_t *chunk_entries =
+        bml_allocate_memory(sizeof(size_t) * (nchunks + 1));
+    chunk[0] = body;
+    for (int c = 1; c < nchunks; c++)
+    {
+        const char *b = body + (end - body) * (size_t) c / nchunks;
+        b = MAX(b, chunk[c - 1]);
+        chunk[c] = b > body && b[-1] == '\n' ? b : mm_next_line(b, end);
+    }
+    chunk[nchunks] = end;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int c = 0; c < nchunks; c++)
+    {
+        size_t count = 0;
+        for (const char *l = chunk[c]; l < chunk[c + 1];
+             l = mm_next_line(l, end))
+        {
+            count += mm_is_entry(l, end);
+        }
+        chunk_entries[c + 1] = count;
+    }
+    for (int c = 0; c < nchunks; c++)
+    {
+        chunk_entries[c + 1] += chunk_entries[c];
+    }
+    if (chunk_entries[nchunks] != (size_t) nnz)
+    {
+        LOG_ERROR("%s has %zu entries, the header says %d\n", filename,
+                  chunk_entries[nchunks], nnz);
+    }
+
+    // Parse the entries into a coordinate list and count the rows
+    int *coo_row = bml_noinit_allocate_memory(sizeof(int) * (nnz + 1));
+    int *coo_col = bml_noinit_allocate_memory(sizeof(int) * (nnz + 1));
+    double *coo_val =
+        bml_noinit_allocate_memory(sizeof(double) * 2 * (nnz + 1));
+    int *count = bml_allocate_memory(sizeof(int) * (n_rows + 1));
+    int errors = 0;
+
+#pragma omp parallel for schedule(dynamic) reduction(+:errors)
+    for (int c = 0; c < nchunks; c++)
+    {
+        size_t k = chunk_entries[c];
+        for (const char *l = chunk[c]; l < chunk[c + 1];
+             l = mm_next_line(l, end))
+        {
+            if (!mm_is_entry(l, end))
+            {
+                continue;
+            }
+            int irow = 0, icol = 0;
+            double re = 1, im = 0;
+            const char *t = mm_parse_int(l, end, &irow);
+            t = t == NULL ? NULL : mm_parse_int(t, end, &icol);
+            if (t != NULL && !is_pattern)
+            {
+                t = mm_parse_double(t, end, &re);
+                if (t != NULL && is_complex)
+                {
+                    t = mm_parse_double(t, end, &im);
+                }
+            }
+            if (t == NULL || irow < 1 || irow > n_rows || icol < 1
+                || icol > n_rows)
+            {
+                errors++;
+                irow = icol = 1;
+            }
+            coo_row[k] = irow - 1;
+            coo_col[k] = icol - 1;
+            coo_val[2 * k] = re;
+            coo_val[2 * k + 1] = im;
+            k++;
+#pragma omp atomic
+            count[irow - 1]++;
+            if (is_symmetric && irow != icol)
+            {
+#pragma omp atomic
+                count[icol - 1]++;
+            }
+        }
+    }
+    if (errors > 0)
+    {
+        LOG_ERROR("%d malformed entries in %s\n", errors, filename);
+    }
+
+    // Scatter into compressed rows, in file order within each row
+    size_t element_size = matrix_precision == single_real ? sizeof(float)
+        : matrix_precision == double_real ? sizeof(double)
+        : matrix_precision == single_complex ? 2 * sizeof(float)
+        : 2 * sizeof(double);
+    *N = n_rows;
+    *row_ptr = bml_allocate_memory(sizeof(int) * (n_rows + 1));
+    for (int i = 0; i < n_rows; i++)
+    {
+        (*row_ptr)[i + 1] = (*row_ptr)[i] + count[i];
+        count[i] = (*row_ptr)[i];
+    }
+    *cols = bml_noinit_allocate_memory(sizeof(int) *
+                                       ((*row_ptr)[n_rows] + 1));
+    *vals = bml_noinit_allocate_memory(element_size *
+                                       ((*row_ptr)[n_rows] + 1));
+    for (int k = 0; k < nnz; k++)
+    {
+        int i = coo_row[k];
+        int j = coo_col[k];
+        (*cols)[count[i]] = j;
+        mm_store(*vals, matrix_precision, count[i]++, coo_val[2 * k],
+                 coo_val[2 * k + 1]);
+        if (is_symmetric && i != j)
+        {
+            (*cols)[count[j]] = i;
+            mm_store(*vals, matrix_precision, count[j]++,
+                     mirror_re * coo_val[2 * k],
+                     mirror_im * coo_val[2 * k + 1]);
+        }
+    }
+
+    bml_free_memory(coo_row);
+    bml_free_memory(coo_col);
+    bml_free_memory(coo_val);
+    bml_free_memory(count);
+    bml_free_memory(chunk);
+    bml_free_memory(chunk_entries);
+    if (mapped != NULL)
+    {
+        munmap(mapped, length);
+    }
+    bml_free_memory(buffer);
+    close(fd);
+}
+
+/** Write a bml matrix to a binary file.
+ *
+ * The file holds a bml_binary_header_t and the native arrays of the
+ * matrix format, written with a few large writes.
+ *
+ * \param A The matrix
+ * \param filename The file
+ */
+void
+bml_write_bml_matrix_binary(
+    bml_matrix_t * A,
+    char *filename)
+{
+    int fd = open(filename, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0)
+    {
+        LOG_ERROR("can not open %s\n", filename);
+    }
+
+    switch (bml_get_type(A))
+    {
+        case dense:
+            bml_write_bml_matrix_binary_dense(A, fd);
+            break;
+        case ellpack:
+            bml_write_bml_matrix_binary_ellpack(A, fd);
+            break;
+        case ellsort:
+            bml_write_bml_matrix_binary_ellsort(A, fd);
+            break;
+        case ellblock:
+            bml_write_bml_matrix_binary_ellblock(A, fd);
+            break;
+        case csr:
+            bml_write_bml_matrix_binary_csr(A, fd);
+            break;
+        default:
+            LOG_ERROR("unknown type (%d)\n", bml_get_type(A));
+            break;
+    }
+
+    if (close(fd) != 0)
+    {
+        LOG_ERROR("write error on %s\n", filename);
+    }
+}
+
+/** Read a bml matrix from a binary file.
+ *
+ * The file is mapped copy-on-write. With zero_copy set, the dense,
+ * ellpack and ellsort matrices use the arrays of the mapping in place
+ * and keep the mapping until they are deallocated; writing to such a
+ * matrix does not change the file. Otherwise, and for the other
+ * formats, the arrays are copied in parallel into a new matrix.
+ *
+ * \param filename The file
+ * \param zero_copy Whether to use the arrays of the file in place
+ * \return The matrix, with the type and precision stored in the file
+ */
+bml_matrix_t *
+bml_read_bml_matrix_binary(
+    char *filename,
+    int zero_copy)
+{
+    int fd = open(filename, O_RDONLY);
+    struct stat st;
+
+    if (fd < 0 || fstat(fd, &st) != 0)
+    {
+        LOG_ERROR("can not open %s\n", filename);
+    }
+    size_t size = st.st_size;
+    if (size < sizeof(bml_binary_header_t))
+    {
+        LOG_ERROR("%s is not a binary bml matrix\n", filename);
+    }
+    void *mapping =
+        mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE, fd, 0);
+    if (mapping == MAP_FAILED)
+    {
+        LOG_ERROR("can not map %s\n", filename);
+    }
+    close(fd);
+
+    bml_binary_header_t *header = mapping;
+    if (strncmp(header->magic, "BMLBIN", 8) != 0)
+    {
+        LOG_ERROR("%s is not a binary bml matrix\n", filename);
+    }
+    if (header->endianness != BML_BINARY_ENDIANNESS)
+    {
+        LOG_ERROR("%s was written with a different byte order\n", filename);
+    }
+    // Version 1 headers are padded with zeros, plain indices
+    if (header->version < 1 || header->version > BML_BINARY_VERSION)
+    {
+        LOG_ERROR("%s has version %d, expected at most %d\n", filename,
+                  header->version, BML_BINARY_VERSION);
+    }
+    LOG_DEBUG("Read: type %d precision %d N %d M %d\n", header->matrix_type,
+              header->matrix_precision, header->N, header->M);
+
+    // The format readers either keep the mapping or unmap it
+    switch (header->matrix_type)
+    {
+        case dense:
+            return bml_read_bml_matrix_binary_dense(mapping, size,
+                                                    zero_copy);
+        case ellpack:
+            return bml_read_bml_matrix_binary_ellpack(mapping, size,
+                                                      zero_copy);
+        case ellsort:
+            return bml_read_bml_matrix_binary_ellsort(mapping, size,
+                                                      zero_copy);
+        case ellblock:
+            return bml_read_bml_matrix_binary_ellblock(mapping, size,
+                                                       zero_copy);
+        case csr:
+            return bml_read_bml_matrix_binary_csr(mapping, size, zero_copy);
+        default:
+            LOG_ERROR("unknown type (%d)\n", header->matrix_type);
+            break;
+    }
+    return NULL;
+}
+
+/** Select the encoding of the column indices of binary matrix files.
+ *
+ * With index_encoding_delta, the ELLPACK, ELLSORT and CSR column
+ * indices are written compressed by bml_encode_index. Such files are
+ * always read by copying.
+ *
+ * \param index_encoding The index encoding
+ */
+void
+bml_set_binary_index_encoding(
+    bml_index_encoding_t index_encoding)
+{
+    s_binary_index_encoding = index_encoding;
+}
+
+/** Get the encoding of the column indices of binary matrix files.
+ *
+ * \return The index encoding
+ */
+bml_index_encoding_t
+bml_get_binary_index_encoding(
+    void)
+{
+    return s_binary_index_encoding;
+}
+
+/** Initialize the header of a binary matrix file.
+ *
+ * \param header The header
+ * \param matrix_type The matrix type
+ * \param matrix_precision The real precision
+ * \param N The number of rows
+ * \param M The number of columns per row
+ */
+void
+bml_init_binary_header(
+    bml_binary_header_t * header,
+    bml_matrix_type_t matrix_type,
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int M)
+{
+    memset(header, 0, sizeof(bml_binary_header_t));
+    memcpy(header->magic, "BMLBIN", 6);
+    header->version = BML_BINARY_VERSION;
+    header->endianness = BML_BINARY_ENDIANNESS;
+    header->matrix_type = matrix_type;
+    header->matrix_precision = matrix_precision;
+    header->N = N;
+    header->M = M;
+}
+
+/** Write one section of a binary matrix file.
+ *
+ * The section is padded with zeros to a multiple of
+ * BML_BINARY_ALIGNMENT bytes.
+ *
+ * \param fd The file descriptor
+ * \param data The data
+ * \param size The size of the data in bytes
+ */
+void
+bml_write_binary_section(
+    int fd,
+    void *data,
+    size_t size)
+{
+    static const char padding[BML_BINARY_ALIGNMENT] = { 0 };
+    const char *p = data;
+    size_t nwritten = 0;
+
+    while (nwritten < size)
+    {
+        ssize_t n = write(fd, p + nwritten, size - nwritten);
+        if (n <= 0)
+        {
+            LOG_ERROR("write error\n");
+        }
+        nwritten += n;
+    }
+    size_t npad = (BML_BINARY_ALIGNMENT - size % BML_BINARY_ALIGNMENT)
+        % BML_BINARY_ALIGNMENT;
+    if (npad > 0 && write(fd, padding, npad) != (ssize_t) npad)
+    {
+        LOG_ERROR("write error\n");
+    }
+}
+
+/** Return the next section of a mapped binary matrix file.
+ *
+ * \param mapping The mapped file
+ * \param mapping_size The size of the file in bytes
+ * \param offset The offset of the section, moved to the next one
+ * \param size The size of the section in bytes
+ * \return The section
+ */
+void *
+bml_binary_section(
+    void *mapping,
+    size_t mapping_size,
+    size_t *offset,
+    size_t size)
+{
+    if (*offset + size > mapping_size)
+    {
+        LOG_ERROR("binary matrix file is truncated\n");
+    }
+    void *section = (char *) mapping + *offset;
+    *offset += (size + BML_BINARY_ALIGNMENT - 1) / BML_BINARY_ALIGNMENT
+        * BML_BINARY_ALIGNMENT;
+    return section;
+}
+
+/** Unmap a binary matrix file.
+ *
+ * \param mapping The mapped file
+ * \param mapping_size The size of the file in bytes
+ */
+void
+bml_unmap_binary_file(
+    void *mapping,
+    size_t mapping_size)
+{
+    if (mapping != NULL)
+    {
+        munmap(mapping, mapping_size);
+    }
+}
@@ -43,6 +43,59 @@ void bml_write_bml_matrix(
     bml_matrix_t * A,
     char *filename);
 
+void bml_read_compressed_rows(
+    char *filename,
+    bml_matrix_precision_t matrix_precision,
+    int *N,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+/** The version of the binary matrix file layout. */
+#define BML_BINARY_VERSION 2
+
+/** Marker telling the byte order of a binary matrix file. */
+#define BML_BINARY_ENDIANNESS 0x01020304
+
+/** Alignment of the arrays in a binary matrix file, in bytes. */
+#define BML_BINARY_ALIGNMENT 64
+
+void bml_write_bml_matrix_binary(
+    bml_matrix_t * A,
+    char *filename);
+
+bml_matrix_t *bml_read_bml_matrix_binary(
+    char *filename,
+    int zero_copy);
+
+void bml_set_binary_index_encoding(
+    bml_index_encoding_t index_encoding);
+
+bml_index_encoding_t bml_get_binary_index_encoding(
+    void);
+
+void bml_init_binary_header(
+    bml_binary_header_t * header,
+    bml_matrix_type_t matrix_type,
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int M);
+
+void bml_write_binary_section(
+    int fd,
+    void *data,
+    size_t size);
+
+void *bml_binary_section(
+    void *mapping,
+    size_t mapping_size,
+    size_t *offset,
+    size_t size);
+
+void bml_unmap_binary_file(
+    void *mapping,
+    size_t mapping_size);
+
 int bml_sqrtint(
     const int x);
 #endif
@@ -42,6 +42,8 @@ void TYPED_FUNC(
     double beta,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     int N = A->N_;
     int tsize = bml_get_bandwidth_csr(A);
 #pragma omp parallel default(none) \
@@ -62,9 +64,9 @@ void TYPED_FUNC(
                 avals[pos] *= alpha;
                 csr_table_insert(table, acols[pos]);
             }
-            int *bcols = B->data_[i]->cols_;
-            REAL_T *bvals = (REAL_T *) B->data_[i]->vals_;
-            const int bnnz = B->data_[i]->NNZ_;
+            int *bcols = csr_matrix_row_cols(B, i);
+            REAL_T *bvals = csr_matrix_row_vals(B, i);
+            const int bnnz = csr_matrix_row_NNZ(B, i);
             for (int pos = 0; pos < bnnz; pos++)
             {
                 int *idx = (int *) csr_table_lookup(table, bcols[pos]);
@@ -130,6 +132,8 @@ void TYPED_FUNC(
     double beta,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     int N = A->N_;
 
 #pragma omp parallel for                  \
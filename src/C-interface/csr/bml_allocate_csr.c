@@ -192,11 +192,24 @@ bml_deallocate_csr(
     const int n = A->N_;
     for (int i = 0; i < n; i++)
     {
-        csr_deallocate_row((A->data_)[i]);
+        if (csr_matrix_compact(A))
+        {
+            // the row entries belong to the contiguous storage
+            bml_free_memory((A->data_)[i]);
+        }
+        else
+        {
+            csr_deallocate_row((A->data_)[i]);
+        }
     }
     bml_free_memory(A->data_);
+    bml_free_memory(A->row_ptr_);
+    bml_free_memory(A->cols_);
+    bml_free_memory(A->vals_);
 //    bml_free_memory(A->lvarsgid_);
-//    bml_deallocate_domain(A->domain);
+    // only set by bml_rebalance_domain
+    if (A->domain != NULL)
+        bml_deallocate_domain(A->domain);
 //    bml_deallocate_domain(A->domain2);
     bml_free_memory(A);
 }
@@ -233,6 +246,75 @@ bml_clear_csr(
     }
 }
 
+/** Store the rows of a matrix contiguously.
+ *
+ * The rows are copied into row_ptr/cols/vals arrays that the multiply,
+ * add, trace, and norm kernels read directly. Functions that change
+ * the sparsity pattern of the matrix expand it first; expand the matrix
+ * before setting its elements from several threads.
+ *
+ * \ingroup allocate_group
+ *
+ * \param A The matrix.
+ */
+void
+bml_compact_csr(
+    bml_matrix_csr_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_compact_csr_single_real(A);
+            break;
+        case double_real:
+            bml_compact_csr_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_compact_csr_single_complex(A);
+            break;
+        case double_complex:
+            bml_compact_csr_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+/** Store the rows of a compact matrix separately again.
+ *
+ * \ingroup allocate_group
+ *
+ * \param A The matrix.
+ */
+void
+bml_expand_csr(
+    bml_matrix_csr_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_expand_csr_single_real(A);
+            break;
+        case double_real:
+            bml_expand_csr_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_expand_csr_single_complex(A);
+            break;
+        case double_complex:
+            bml_expand_csr_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 /** Allocate the csr matrix.
  *
  *  Note that the matrix \f$ a \f$ will be newly allocated. If it is
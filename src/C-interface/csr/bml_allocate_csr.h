@@ -58,6 +58,36 @@ void bml_clear_csr_single_complex(
 void bml_clear_csr_double_complex(
     bml_matrix_csr_t * A);
 
+void bml_compact_csr(
+    bml_matrix_csr_t * A);
+
+void bml_compact_csr_single_real(
+    bml_matrix_csr_t * A);
+
+void bml_compact_csr_double_real(
+    bml_matrix_csr_t * A);
+
+void bml_compact_csr_single_complex(
+    bml_matrix_csr_t * A);
+
+void bml_compact_csr_double_complex(
+    bml_matrix_csr_t * A);
+
+void bml_expand_csr(
+    bml_matrix_csr_t * A);
+
+void bml_expand_csr_single_real(
+    bml_matrix_csr_t * A);
+
+void bml_expand_csr_double_real(
+    bml_matrix_csr_t * A);
+
+void bml_expand_csr_single_complex(
+    bml_matrix_csr_t * A);
+
+void bml_expand_csr_double_complex(
+    bml_matrix_csr_t * A);
+
 /*
 csr_sparse_row_t *csr_noinit_row(
     const int alloc_size);
@@ -44,6 +44,7 @@ void TYPED_FUNC(
     bml_matrix_csr_t * A)
 {
     const int n = A->N_;
+    TYPED_FUNC(bml_expand_csr) (A);
 #pragma omp parallel for
     for (int i = 0; i < n; i++)
     {
@@ -52,6 +53,99 @@ void TYPED_FUNC(
     A->TOTNNZ_ = 0;
 }
 
+/** Store the rows of a matrix contiguously.
+ *
+ * The rows keep pointing at their entries, now in the contiguous
+ * cols/vals arrays, so that code reading the rows is unaffected.
+ *
+ * \ingroup allocate_group
+ *
+ * \param A The matrix.
+ */
+void TYPED_FUNC(
+    bml_compact_csr) (
+    bml_matrix_csr_t * A)
+{
+    if (csr_matrix_compact(A))
+    {
+        return;
+    }
+
+    const int N = A->N_;
+    int *row_ptr = bml_noinit_allocate_memory(sizeof(int) * (N + 1));
+    row_ptr[0] = 0;
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        row_ptr[i + 1] = A->data_[i]->NNZ_;
+    }
+    for (int i = 0; i < N; i++)
+    {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+
+    const int nnz = row_ptr[N];
+    int *cols = bml_noinit_allocate_memory(sizeof(int) * MAX(nnz, 1));
+    REAL_T *vals = bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(nnz, 1));
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        csr_sparse_row_t *row = A->data_[i];
+        const int annz = row->NNZ_;
+        memcpy(&cols[row_ptr[i]], row->cols_, sizeof(int) * annz);
+        memcpy(&vals[row_ptr[i]], row->vals_, sizeof(REAL_T) * annz);
+        bml_free_memory(row->cols_);
+        bml_free_memory(row->vals_);
+        row->cols_ = &cols[row_ptr[i]];
+        row->vals_ = &vals[row_ptr[i]];
+        row->alloc_size_ = annz;
+    }
+    A->row_ptr_ = row_ptr;
+    A->cols_ = cols;
+    A->vals_ = vals;
+    A->TOTNNZ_ = nnz;
+}
+
+/** Store the rows of a compact matrix separately again.
+ *
+ * Needed before entries can be inserted into a row.
+ *
+ * \ingroup allocate_group
+ *
+ * \param A The matrix.
+ */
+void TYPED_FUNC(
+    bml_expand_csr) (
+    bml_matrix_csr_t * A)
+{
+    if (!csr_matrix_compact(A))
+    {
+        return;
+    }
+
+    const int N = A->N_;
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        csr_sparse_row_t *row = A->data_[i];
+        const int annz = row->NNZ_;
+        const int size = INIT_ROW_SPACE >= annz ? INIT_ROW_SPACE : annz;
+        int *cols = bml_noinit_allocate_memory(sizeof(int) * size);
+        REAL_T *vals = bml_noinit_allocate_memory(sizeof(REAL_T) * size);
+        memcpy(cols, row->cols_, sizeof(int) * annz);
+        memcpy(vals, row->vals_, sizeof(REAL_T) * annz);
+        row->cols_ = cols;
+        row->vals_ = vals;
+        row->alloc_size_ = size;
+    }
+    bml_free_memory(A->row_ptr_);
+    bml_free_memory(A->cols_);
+    bml_free_memory(A->vals_);
+    A->row_ptr_ = NULL;
+    A->cols_ = NULL;
+    A->vals_ = NULL;
+}
+
 /** Allocate a matrix row with uninitialized values.
  *
  *  Note that the row \f$ a \f$ will be newly allocated. If it is
@@ -108,6 +202,11 @@ bml_matrix_csr_t *TYPED_FUNC(
     A->NZMAX_ = matrix_dimension.N_nz_max;
     A->TOTNNZ_ = 0;
     A->distribution_mode = distrib_mode;
+    A->domain = NULL;
+    A->domain2 = NULL;
+    A->row_ptr_ = NULL;
+    A->cols_ = NULL;
+    A->vals_ = NULL;
     /** allocate csr row data */
     const int N = A->N_;
     A->data_ = bml_noinit_allocate_memory(sizeof(csr_sparse_row_t *) * N);
@@ -93,6 +93,51 @@ void bml_reorder_csr_double_complex(
     bml_matrix_csr_t * A,
     int *perm);
 
+void bml_copy_panel_csr(
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_csr_single_real(
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_csr_double_real(
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_csr_single_complex(
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_csr_double_complex(
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
 
 void bml_save_domain_csr(
     bml_matrix_csr_t * A);
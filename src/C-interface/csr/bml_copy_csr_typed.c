@@ -6,6 +6,7 @@
 #include "../bml_copy.h"
 #include "../bml_types.h"
 #include "bml_copy_csr.h"
+#include "bml_setters_csr.h"
 #include "bml_types_csr.h"
 
 #include <complex.h>
@@ -57,6 +58,9 @@ bml_matrix_csr_t *TYPED_FUNC(
     B->NZMAX_ = A->NZMAX_;
     B->TOTNNZ_ = A->TOTNNZ_;
     B->distribution_mode = A->distribution_mode;
+    B->row_ptr_ = NULL;
+    B->cols_ = NULL;
+    B->vals_ = NULL;
 
     /** allocate csr row data */
     B->data_ = bml_noinit_allocate_memory(sizeof(csr_sparse_row_t *) * N);
@@ -70,7 +74,14 @@ bml_matrix_csr_t *TYPED_FUNC(
     }
 
     // copy domain info
-//    bml_copy_domain(A->domain, B->domain);
+    B->domain = NULL;
+    B->domain2 = NULL;
+    if (A->domain != NULL)
+    {
+        B->domain = bml_default_domain(N, A->NZMAX_, distributed);
+        bml_copy_domain(A->domain, B->domain);
+        bml_set_domain_extents(B->domain);
+    }
 //    bml_copy_domain(A->domain2, B->domain2);
 
     return B;
@@ -115,6 +126,8 @@ void TYPED_FUNC(
     bml_matrix_csr_t * A,
     bml_matrix_csr_t * B)
 {
+    TYPED_FUNC(bml_expand_csr) (B);
+
     const int N = A->N_;
     // check that sizes match
     assert(A->N_ == B->N_);
@@ -153,3 +166,57 @@ void TYPED_FUNC(
 {
     LOG_ERROR("bml_reorder_csr not implemented\n");
 }
+
+/** Copy a panel of a csr matrix.
+ *
+ *  B(l0 + i, j) = A(i0 + i, j) for 0 <= i < nrows and j0 <= j < j0 +
+ *  ncols, the other elements of B are zero.
+ *
+ *  \ingroup copy_group
+ *
+ *  \param A The matrix to copy from
+ *  \param B The panel
+ *  \param i0 The first row of the panel in A
+ *  \param nrows The number of rows of the panel
+ *  \param j0 The first column of the panel
+ *  \param ncols The number of columns of the panel
+ *  \param l0 The first row of the panel in B
+ */
+void TYPED_FUNC(
+    bml_copy_panel_csr) (
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0)
+{
+    TYPED_FUNC(bml_clear_csr) (B);
+
+    int max_nnz = 0;
+    for (int i = 0; i < nrows; i++)
+        max_nnz = MAX(max_nnz, A->data_[i0 + i]->NNZ_);
+
+    int *cols = bml_allocate_memory(sizeof(int) * max_nnz);
+    REAL_T *vals = bml_allocate_memory(sizeof(REAL_T) * max_nnz);
+    for (int i = 0; i < nrows; i++)
+    {
+        csr_sparse_row_t *row = A->data_[i0 + i];
+        int *row_cols = row->cols_;
+        REAL_T *row_vals = row->vals_;
+        int count = 0;
+        for (int jp = 0; jp < row->NNZ_; jp++)
+        {
+            if (row_cols[jp] >= j0 && row_cols[jp] < j0 + ncols)
+            {
+                cols[count] = row_cols[jp];
+                vals[count++] = row_vals[jp];
+            }
+        }
+        TYPED_FUNC(bml_set_sparse_row_csr) (B, l0 + i, count, cols, vals,
+                                            0.);
+    }
+    bml_free_memory(cols);
+    bml_free_memory(vals);
+}
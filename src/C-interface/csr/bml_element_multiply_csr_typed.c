@@ -40,6 +40,8 @@ void TYPED_FUNC(
     bml_matrix_csr_t * C,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (C);
+
     const int A_N = A->N_;
     const int C_N = C->N_;
 
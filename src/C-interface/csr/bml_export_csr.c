@@ -42,3 +42,45 @@ bml_export_to_dense_csr(
     }
     return NULL;
 }
+
+/** Convert a bml matrix into compressed rows.
+ *
+ * \ingroup convert_group
+ *
+ * \param A The bml matrix
+ * \param row_ptr The row pointers, allocated here
+ * \param cols The column indices, allocated here
+ * \param vals The values, allocated here
+ */
+void
+bml_export_to_compressed_rows_csr(
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_export_to_compressed_rows_csr_single_real(A, row_ptr, cols,
+                                                          vals);
+            break;
+        case double_real:
+            bml_export_to_compressed_rows_csr_double_real(A, row_ptr, cols,
+                                                          vals);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_export_to_compressed_rows_csr_single_complex(A, row_ptr, cols,
+                                                             vals);
+            break;
+        case double_complex:
+            bml_export_to_compressed_rows_csr_double_complex(A, row_ptr, cols,
+                                                             vals);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
@@ -23,4 +23,34 @@ void *bml_export_to_dense_csr_double_complex(
     bml_matrix_csr_t * A,
     bml_dense_order_t order);
 
+void bml_export_to_compressed_rows_csr(
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_csr_single_real(
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_csr_double_real(
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_csr_single_complex(
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_csr_double_complex(
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
 #endif
@@ -67,3 +67,47 @@ void *TYPED_FUNC(
     }
     return A_dense;
 }
+
+/** Convert a bml matrix into compressed rows.
+ *
+ * The entries of row i are cols[k] and vals[k] for
+ * row_ptr[i] <= k < row_ptr[i + 1]. All stored elements are
+ * exported.
+ *
+ * \ingroup convert_group
+ *
+ * \param A The bml matrix
+ * \param row_ptr The row pointers (N + 1), allocated here
+ * \param cols The column indices, allocated here
+ * \param vals The values, allocated here
+ */
+void TYPED_FUNC(
+    bml_export_to_compressed_rows_csr) (
+    bml_matrix_csr_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    int N = A->N_;
+    int *A_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+    for (int i = 0; i < N; i++)
+    {
+        A_ptr[i + 1] = A_ptr[i] + A->data_[i]->NNZ_;
+    }
+
+    int *A_cols = bml_noinit_allocate_memory(sizeof(int) * MAX(A_ptr[N], 1));
+    REAL_T *A_vals =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(A_ptr[N], 1));
+
+#pragma omp parallel for shared(A_ptr, A_cols, A_vals)
+    for (int i = 0; i < N; i++)
+    {
+        csr_sparse_row_t *row = A->data_[i];
+        memcpy(&A_cols[A_ptr[i]], row->cols_, sizeof(int) * row->NNZ_);
+        memcpy(&A_vals[A_ptr[i]], row->vals_, sizeof(REAL_T) * row->NNZ_);
+    }
+
+    *row_ptr = A_ptr;
+    *cols = A_cols;
+    *vals = A_vals;
+}
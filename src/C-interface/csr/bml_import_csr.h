@@ -44,4 +44,45 @@ bml_matrix_csr_t
                                                bml_distribution_mode_t
                                                distrib_mode);
 
+bml_matrix_csr_t *bml_import_from_compressed_rows_csr(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_csr_t *bml_import_from_compressed_rows_csr_single_real(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_csr_t *bml_import_from_compressed_rows_csr_double_real(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_csr_t *bml_import_from_compressed_rows_csr_single_complex(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_csr_t *bml_import_from_compressed_rows_csr_double_complex(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
 #endif
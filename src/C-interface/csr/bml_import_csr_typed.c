@@ -66,3 +66,51 @@ bml_matrix_csr_t
 
     return csr_A;
 }
+
+/** Convert compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group
+ *
+ * \param N The number of rows/columns
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ * \param M The number of non-zeroes per row
+ * \param distrib_mode The distribution mode
+ * \return The bml matrix
+ */
+bml_matrix_csr_t *TYPED_FUNC(
+    bml_import_from_compressed_rows_csr) (
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode)
+{
+    bml_matrix_csr_t *A_bml =
+        TYPED_FUNC(bml_zero_matrix_csr) (N, M, distrib_mode);
+
+    REAL_T *A_vals = (REAL_T *) vals;
+
+#pragma omp parallel for shared(A_vals)
+    for (int i = 0; i < N; i++)
+    {
+        csr_sparse_row_t *row = A_bml->data_[i];
+        int nnz = row_ptr[i + 1] - row_ptr[i];
+        if (nnz > row->alloc_size_)
+        {
+            row->alloc_size_ = nnz;
+            row->cols_ =
+                bml_reallocate_memory(row->cols_, sizeof(int) * nnz);
+            row->vals_ =
+                bml_reallocate_memory(row->vals_, sizeof(REAL_T) * nnz);
+        }
+        memcpy(row->cols_, &cols[row_ptr[i]], sizeof(int) * nnz);
+        memcpy(row->vals_, &A_vals[row_ptr[i]], sizeof(REAL_T) * nnz);
+        row->NNZ_ = nnz;
+    }
+    A_bml->TOTNNZ_ = row_ptr[N];
+
+    return A_bml;
+}
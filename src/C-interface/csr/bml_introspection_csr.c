@@ -174,3 +174,37 @@ bml_get_sparsity_csr(
     }
     return -1;
 }
+
+/** Return the cost of every row of a matrix.
+ *
+ * \param A The bml matrix.
+ * \param balance What a row costs.
+ * \param cost The cost of each row (length N).
+ */
+void
+bml_get_row_costs_csr(
+    bml_matrix_csr_t * A,
+    bml_balance_t balance,
+    double *cost)
+{
+    int N = A->N_;
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        switch (balance)
+        {
+            case balance_nnz:
+                cost[i] = A->data_[i]->NNZ_;
+                break;
+            case balance_multiply:
+                cost[i] = 0.;
+                for (int jp = 0; jp < A->data_[i]->NNZ_; jp++)
+                    cost[i] += A->data_[A->data_[i]->cols_[jp]]->NNZ_;
+                break;
+            default:
+                cost[i] = 1.;
+                break;
+        }
+    }
+}
@@ -19,6 +19,11 @@ int bml_get_row_bandwidth_csr(
     bml_matrix_csr_t * A,
     int i);
 
+void bml_get_row_costs_csr(
+    bml_matrix_csr_t * A,
+    bml_balance_t balance,
+    double *cost);
+
 int bml_get_bandwidth_csr(
     bml_matrix_csr_t * A);
 
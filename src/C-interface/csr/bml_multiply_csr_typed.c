@@ -6,6 +6,7 @@
 #include "../bml_multiply.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
+#include "../../internal-blas/bml_accumulator.h"
 #include "bml_add_csr.h"
 #include "bml_allocate_csr.h"
 #include "bml_multiply_csr.h"
@@ -22,6 +23,112 @@
 #include <omp.h>
 #endif
 
+/** Store the row accumulated in acc as row i of a matrix.
+ *
+ * The row storage is grown to hold all accumulated entries.
+ *
+ * \param acc The row accumulator
+ * \param row The row to overwrite
+ * \param diag The column kept regardless of threshold (-1 for none)
+ * \param threshold The threshold
+ */
+static void TYPED_FUNC(
+    csr_extract_row_accumulator) (
+    bml_accumulator_t * acc,
+    csr_sparse_row_t * row,
+    const int diag,
+    const double threshold)
+{
+    if (acc->size > row->alloc_size_)
+    {
+        row->alloc_size_ = acc->size;
+        row->cols_ =
+            bml_reallocate_memory(row->cols_, sizeof(int) * row->alloc_size_);
+        row->vals_ =
+            bml_reallocate_memory(row->vals_,
+                                  sizeof(REAL_T) * row->alloc_size_);
+    }
+    row->NNZ_ =
+        TYPED_FUNC(bml_accumulator_extract) (acc, diag, threshold, row->cols_,
+                                             (REAL_T *) row->vals_);
+}
+
+/** Fused matrix multiply and add.
+ *
+ * \f$ C \leftarrow \alpha A \, B + \beta C \f$
+ *
+ * Each row of C is accumulated from \f$ \beta C_{i,:} \f$ and
+ * \f$ \alpha A_{i,:} B \f$ in one row accumulator and written back in
+ * place, without a temporary product matrix. The threshold is applied
+ * once to the sum. C must not alias A or B.
+ *
+ * \param A Matrix A
+ * \param B Matrix B
+ * \param C Matrix C
+ * \param alpha Scalar factor multiplied by A * B
+ * \param beta Scalar factor multiplied by C
+ * \param threshold Threshold for the result
+ */
+static void TYPED_FUNC(
+    bml_multiply_fused_csr) (
+    bml_matrix_csr_t * A,
+    bml_matrix_csr_t * B,
+    bml_matrix_csr_t * C,
+    double alpha,
+    double beta,
+    double threshold)
+{
+    const int C_N = C->N_;
+
+    int use_alpha = (alpha > (double) 0.0 || alpha < (double) 0.0);
+    int use_beta = (beta > (double) 0.0 || beta < (double) 0.0);
+
+#pragma omp parallel                           \
+    shared(C_N)
+    {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (C_N, C->NZMAX_);
+
+#pragma omp for
+        for (int i = 0; i < C_N; i++)
+        {
+            csr_sparse_row_t *crow = C->data_[i];
+            if (use_beta)
+            {
+                TYPED_FUNC(bml_accumulator_add_row) (acc, crow->NNZ_,
+                                                     crow->cols_,
+                                                     (REAL_T *) crow->vals_,
+                                                     beta);
+            }
+            if (use_alpha)
+            {
+                int *acols = csr_matrix_row_cols(A, i);
+                REAL_T *avals = csr_matrix_row_vals(A, i);
+                const int annz = csr_matrix_row_NNZ(A, i);
+                for (int pos = 0; pos < annz; pos++)
+                {
+                    const int j = acols[pos];
+                    TYPED_FUNC(bml_accumulator_add_row) (acc,
+                                                         csr_matrix_row_NNZ
+                                                         (B, j),
+                                                         csr_matrix_row_cols
+                                                         (B, j),
+                                                         csr_matrix_row_vals
+                                                         (B, j),
+                                                         alpha *
+                                                         avals[pos]);
+                }
+            }
+
+            TYPED_FUNC(csr_extract_row_accumulator) (acc, crow, -1,
+                                                     threshold);
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+}
+
 /** Matrix multiply.
  *
  * \f$ C \leftarrow \alpha A \, B + \beta C \f$
@@ -44,6 +151,8 @@ void TYPED_FUNC(
     double beta,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (C);
+
     double ONE = 1.0;
     double ZERO = 0.0;
 
@@ -54,10 +163,24 @@ void TYPED_FUNC(
         LOG_ERROR("Either matrix A or B are NULL\n");
     }
 
+    // the fused kernel updates C in place, so C must not alias A or B;
+    // distributed matrices keep the gather of the temporary product
+    int fused = (C != A && C != B);
+#ifdef DO_MPI
+    if (bml_getNRanks() > 1 && C->distribution_mode == distributed)
+    {
+        fused = 0;
+    }
+#endif
+
     if (A == B && alpha == ONE && beta == ZERO)
     {
         trace = TYPED_FUNC(bml_multiply_x2_csr) (A, C, threshold);
     }
+    else if (fused)
+    {
+        TYPED_FUNC(bml_multiply_fused_csr) (A, B, C, alpha, beta, threshold);
+    }
     else
     {
         bml_matrix_dimension_t matrix_dimension = { C->N_, C->N_, C->NZMAX_ };
@@ -104,6 +227,8 @@ void *TYPED_FUNC(
     bml_matrix_csr_t * X2,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (X2);
+
     int X_N = X->N_;
 
     REAL_T traceX = 0.0;
@@ -111,89 +236,53 @@ void *TYPED_FUNC(
 
     double *trace = bml_allocate_memory(sizeof(double) * 2);
 
-#if !(defined(__IBMC__) || defined(__ibmxl__))
-    int ix[X_N], jx[X_N];
-    REAL_T x[X_N];
-
-    memset(ix, 0, X_N * sizeof(int));
-    memset(jx, 0, X_N * sizeof(int));
-    memset(x, 0.0, X_N * sizeof(REAL_T));
-#endif
-
-#if defined(__IBMC__) || defined(__ibmxl__)
-#pragma omp parallel for                               \
-    shared(X_N)  \
+#pragma omp parallel                                   \
+    shared(X_N)                                        \
     reduction(+: traceX, traceX2)
-#else
-#if !(defined(CRAY_SDK) || defined(INTEL_SDK))
-#pragma vector aligned
-#endif
-#pragma omp parallel for                               \
-    shared(X_N)  \
-    firstprivate(ix,jx, x)                             \
-    reduction(+: traceX, traceX2)
-#endif
-
-    for (int i = 0; i < X_N; i++)       // CALCULATES THRESHOLDED X^2
     {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (X_N, X2->NZMAX_);
 
-#if defined(__IBMC__) || defined(__ibmxl__)
-        int ix[X_N], jx[X_N];
-        REAL_T x[X_N];
-
-        memset(ix, 0, X_N * sizeof(int));
-#endif
-
-        int *icols = X->data_[i]->cols_;
-        REAL_T *ivals = (REAL_T *) X->data_[i]->vals_;
-        const int innz = X->data_[i]->NNZ_;
-
-        int l = 0;
-        for (int ipos = 0; ipos < innz; ipos++)
+#pragma omp for
+        for (int i = 0; i < X_N; i++)   // CALCULATES THRESHOLDED X^2
         {
-            REAL_T a = ivals[ipos];
-            const int j = icols[ipos];
-            if (j == i)
-            {
-                traceX = traceX + a;
-            }
-            const int jnnz = X->data_[j]->NNZ_;
-            REAL_T *jvals = (REAL_T *) X->data_[j]->vals_;
-            int *jcols = X->data_[j]->cols_;
-            for (int jpos = 0; jpos < jnnz; jpos++)
+            int *icols = csr_matrix_row_cols(X, i);
+            REAL_T *ivals = csr_matrix_row_vals(X, i);
+            const int innz = csr_matrix_row_NNZ(X, i);
+
+            for (int ipos = 0; ipos < innz; ipos++)
             {
-                const int k = jcols[jpos];
-                if (ix[k] == 0)
+                REAL_T a = ivals[ipos];
+                const int j = icols[ipos];
+                if (j == i)
                 {
-                    x[k] = 0.0;
-                    jx[l] = k;
-                    ix[k] = i + 1;
-                    l++;
+                    traceX = traceX + a;
                 }
-                // TEMPORARY STORAGE VECTOR LENGTH FULL N
-                x[k] = x[k] + a * jvals[jpos];
+                TYPED_FUNC(bml_accumulator_add_row) (acc,
+                                                     csr_matrix_row_NNZ(X, j),
+                                                     csr_matrix_row_cols(X,
+                                                                         j),
+                                                     csr_matrix_row_vals(X,
+                                                                         j),
+                                                     a);
             }
-        }
 
-        // clear row
-        TYPED_FUNC(csr_clear_row) (X2->data_[i]);
-        for (int j = 0; j < l; j++)
-        {
-            int jp = jx[j];
-            REAL_T xtmp = x[jp];
-            if (jp == i)
-            {
-                traceX2 = traceX2 + xtmp;
-                TYPED_FUNC(csr_set_row_element_new) (X2->data_[i], jp, &xtmp);
-            }
-            else if (is_above_threshold(xtmp, threshold))
+            csr_sparse_row_t *row = X2->data_[i];
+            TYPED_FUNC(csr_extract_row_accumulator) (acc, row, i, threshold);
+
+            int *x2cols = row->cols_;
+            REAL_T *x2vals = (REAL_T *) row->vals_;
+            for (int pos = 0; pos < row->NNZ_; pos++)
             {
-                TYPED_FUNC(csr_set_row_element_new) (X2->data_[i], jp, &xtmp);
+                if (x2cols[pos] == i)
+                {
+                    traceX2 = traceX2 + x2vals[pos];
+                }
             }
-            // reset
-            ix[jp] = 0;
-            x[jp] = 0.0;
         }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
     }
     trace[0] = traceX;
     trace[1] = traceX2;
@@ -219,78 +308,41 @@ void TYPED_FUNC(
     bml_matrix_csr_t * C,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (C);
+
     const int A_N = A->N_;
     const int C_N = C->N_;
 
-#if !(defined(__IBMC__) || defined(__ibmxl__))
-    int ix[C_N], jx[C_N];
-    REAL_T x[C_N];
-
-    memset(ix, 0, C_N * sizeof(int));
-    memset(jx, 0, C_N * sizeof(int));
-    memset(x, 0.0, C_N * sizeof(REAL_T));
-#endif
-
-#if defined(__IBMC__) || defined(__ibmxl__)
-#pragma omp parallel for                       \
+#pragma omp parallel                           \
     shared(A_N, C_N)
-#else
-#pragma omp parallel for                       \
-    firstprivate(ix, jx, x)
-#endif
-
-    for (int i = 0; i < A_N; i++)
     {
-#if defined(__IBMC__) || defined(__ibmxl__)
-        int ix[C_N], jx[C_N];
-        REAL_T x[C_N];
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (C_N, C->NZMAX_);
 
-        memset(ix, 0, C_N * sizeof(int));
-#endif
-        int *acols = A->data_[i]->cols_;
-        REAL_T *avals = (REAL_T *) A->data_[i]->vals_;
-        const int annz = A->data_[i]->NNZ_;
-        int l = 0;
-        for (int pos = 0; pos < annz; pos++)
+#pragma omp for
+        for (int i = 0; i < A_N; i++)
         {
-            REAL_T a = avals[pos];
-            const int j = acols[pos];
-
-            const int bnnz = B->data_[j]->NNZ_;
-            REAL_T *bvals = (REAL_T *) B->data_[j]->vals_;
-            int *bcols = B->data_[j]->cols_;
-            for (int bpos = 0; bpos < bnnz; bpos++)
+            int *acols = csr_matrix_row_cols(A, i);
+            REAL_T *avals = csr_matrix_row_vals(A, i);
+            const int annz = csr_matrix_row_NNZ(A, i);
+            for (int pos = 0; pos < annz; pos++)
             {
-                const int k = bcols[bpos];
-                if (ix[k] == 0)
-                {
-                    x[k] = 0.0;
-                    jx[l] = k;
-                    ix[k] = i + 1;
-                    l++;
-                }
-                // TEMPORARY STORAGE VECTOR LENGTH FULL N
-                x[k] = x[k] + a * bvals[bpos];
+                const int j = acols[pos];
+                TYPED_FUNC(bml_accumulator_add_row) (acc,
+                                                     csr_matrix_row_NNZ(B, j),
+                                                     csr_matrix_row_cols(B,
+                                                                         j),
+                                                     csr_matrix_row_vals(B,
+                                                                         j),
+                                                     avals[pos]);
             }
+
+            TYPED_FUNC(csr_extract_row_accumulator) (acc, C->data_[i], i,
+                                                     threshold);
         }
-        // clear row
-        TYPED_FUNC(csr_clear_row) (C->data_[i]);
-        for (int j = 0; j < l; j++)
-        {
-            int jp = jx[j];
-            REAL_T xtmp = x[jp];
-            if (jp == i)
-            {
-                TYPED_FUNC(csr_set_row_element_new) (C->data_[i], jp, &xtmp);
-            }
-            else if (is_above_threshold(xtmp, threshold))
-            {
-                TYPED_FUNC(csr_set_row_element_new) (C->data_[i], jp, &xtmp);
-            }
-            // reset
-            ix[jp] = 0;
-            x[jp] = 0.0;
-        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
     }
 }
 
@@ -37,8 +37,8 @@ double TYPED_FUNC(
   reduction(+:sum)
     for (int i = 0; i < N; i++)
     {
-        REAL_T *vals = (REAL_T *) A->data_[i]->vals_;
-        const int annz = A->data_[i]->NNZ_;
+        REAL_T *vals = csr_matrix_row_vals(A, i);
+        const int annz = csr_matrix_row_NNZ(A, i);
         for (int pos = 0; pos < annz; pos++)
         {
             REAL_T xval = vals[pos];
@@ -70,9 +70,9 @@ double TYPED_FUNC(
   reduction(+:sum)
     for (int i = 0; i < core_size; i++)
     {
-        int *cols = A->data_[i]->cols_;
-        REAL_T *vals = (REAL_T *) A->data_[i]->vals_;
-        const int annz = A->data_[i]->NNZ_;
+        int *cols = csr_matrix_row_cols(A, i);
+        REAL_T *vals = csr_matrix_row_vals(A, i);
+        const int annz = csr_matrix_row_NNZ(A, i);
         for (int pos = 0; pos < annz; pos++)
         {
             if (cols[pos] < core_size)
@@ -110,9 +110,9 @@ double TYPED_FUNC(
 
     for (int i = 0; i < N; i++)
     {
-        int *acols = A->data_[i]->cols_;
-        REAL_T *avals = (REAL_T *) A->data_[i]->vals_;
-        const int annz = A->data_[i]->NNZ_;
+        int *acols = csr_matrix_row_cols(A, i);
+        REAL_T *avals = csr_matrix_row_vals(A, i);
+        const int annz = csr_matrix_row_NNZ(A, i);
 
         /* create hash table */
         csr_row_index_hash_t *table = csr_noinit_table(annz);
@@ -121,9 +121,9 @@ double TYPED_FUNC(
             cvals[pos] = alpha * avals[pos];
             csr_table_insert(table, acols[pos]);
         }
-        int *bcols = B->data_[i]->cols_;
-        REAL_T *bvals = (REAL_T *) B->data_[i]->vals_;
-        const int bnnz = B->data_[i]->NNZ_;
+        int *bcols = csr_matrix_row_cols(B, i);
+        REAL_T *bvals = csr_matrix_row_vals(B, i);
+        const int bnnz = csr_matrix_row_NNZ(B, i);
         int cnt = annz;
         for (int pos = 0; pos < bnnz; pos++)
         {
@@ -184,9 +184,9 @@ double TYPED_FUNC(
 
     for (int i = 0; i < N; i++)
     {
-        int *acols = A->data_[i]->cols_;
-        REAL_T *avals = (REAL_T *) A->data_[i]->vals_;
-        const int annz = A->data_[i]->NNZ_;
+        int *acols = csr_matrix_row_cols(A, i);
+        REAL_T *avals = csr_matrix_row_vals(A, i);
+        const int annz = csr_matrix_row_NNZ(A, i);
 
         /* create hash table */
         csr_row_index_hash_t *table = csr_noinit_table(annz);
@@ -195,9 +195,9 @@ double TYPED_FUNC(
             cvals[pos] = alpha * avals[pos];
             csr_table_insert(table, acols[pos]);
         }
-        int *bcols = B->data_[i]->cols_;
-        REAL_T *bvals = (REAL_T *) B->data_[i]->vals_;
-        const int bnnz = B->data_[i]->NNZ_;
+        int *bcols = csr_matrix_row_cols(B, i);
+        REAL_T *bvals = csr_matrix_row_vals(B, i);
+        const int bnnz = csr_matrix_row_NNZ(B, i);
         int cnt = annz;
         for (int pos = 0; pos < bnnz; pos++)
         {
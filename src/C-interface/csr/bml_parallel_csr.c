@@ -7,6 +7,38 @@
 #include <stdlib.h>
 #include <string.h>
 
+/** Gather bml matrix across MPI ranks.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The matrix
+ */
+void
+bml_allGatherVParallel_csr(
+    bml_matrix_csr_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_allGatherVParallel_csr_single_real(A);
+            break;
+        case double_real:
+            bml_allGatherVParallel_csr_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_allGatherVParallel_csr_single_complex(A);
+            break;
+        case double_complex:
+            bml_allGatherVParallel_csr_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 #ifdef DO_MPI
 void
 bml_mpi_send_csr(
@@ -64,6 +96,60 @@ bml_mpi_recv_csr(
     }
 }
 
+void
+bml_mpi_isend_csr(
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_csr_single_real(A, dst, comm);
+            break;
+        case double_real:
+            bml_mpi_isend_csr_double_real(A, dst, comm);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_csr_single_complex(A, dst, comm);
+            break;
+        case double_complex:
+            bml_mpi_isend_csr_double_complex(A, dst, comm);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+void
+bml_mpi_isend_complete_csr(
+    bml_matrix_csr_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_complete_csr_single_real(A);
+            break;
+        case double_real:
+            bml_mpi_isend_complete_csr_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_complete_csr_single_complex(A);
+            break;
+        case double_complex:
+            bml_mpi_isend_complete_csr_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 void
 bml_mpi_irecv_csr(
     bml_matrix_csr_t * A,
@@ -118,6 +204,20 @@ bml_mpi_irecv_complete_csr(
     }
 }
 
+/** Make progress on the nonblocking sends or receives of A.
+ *
+ *  \param A The matrix
+ *  \return Non-zero if they are done
+ */
+int
+bml_mpi_test_csr(
+    bml_matrix_csr_t * A)
+{
+    int flag;
+    MPI_Testall(3, A->req, &flag, MPI_STATUSES_IGNORE);
+    return flag;
+}
+
 bml_matrix_csr_t *
 bml_mpi_recv_matrix_csr(
     bml_matrix_precision_t matrix_precision,
@@ -3,6 +3,21 @@
 
 #include "bml_types_csr.h"
 
+void bml_allGatherVParallel_csr(
+    bml_matrix_csr_t * A);
+
+void bml_allGatherVParallel_csr_single_real(
+    bml_matrix_csr_t * A);
+
+void bml_allGatherVParallel_csr_double_real(
+    bml_matrix_csr_t * A);
+
+void bml_allGatherVParallel_csr_single_complex(
+    bml_matrix_csr_t * A);
+
+void bml_allGatherVParallel_csr_double_complex(
+    bml_matrix_csr_t * A);
+
 #ifdef DO_MPI
 void bml_mpi_send_csr(
     bml_matrix_csr_t * A,
@@ -48,6 +63,40 @@ void bml_mpi_recv_csr_double_complex(
     const int src,
     MPI_Comm comm);
 
+void bml_mpi_isend_csr(
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm);
+
+void bml_mpi_isend_csr_single_real(
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_csr_double_real(
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_csr_single_complex(
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_csr_double_complex(
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm);
+
+void bml_mpi_isend_complete_csr(
+    bml_matrix_csr_t * A);
+
+void bml_mpi_isend_complete_csr_single_real(
+    bml_matrix_csr_t * A);
+void bml_mpi_isend_complete_csr_double_real(
+    bml_matrix_csr_t * A);
+void bml_mpi_isend_complete_csr_single_complex(
+    bml_matrix_csr_t * A);
+void bml_mpi_isend_complete_csr_double_complex(
+    bml_matrix_csr_t * A);
+
 void bml_mpi_irecv_csr(
     bml_matrix_csr_t * A,
     const int src,
@@ -82,6 +131,9 @@ void bml_mpi_irecv_complete_csr_single_complex(
 void bml_mpi_irecv_complete_csr_double_complex(
     bml_matrix_csr_t * A);
 
+int bml_mpi_test_csr(
+    bml_matrix_csr_t * A);
+
 bml_matrix_csr_t *bml_mpi_recv_matrix_csr(
     bml_matrix_precision_t matrix_precision,
     int N,
@@ -19,6 +19,109 @@
 #include <mpi.h>
 #endif
 
+/** Gather a bml matrix across MPI ranks.
+ *
+ *  Only the stored elements of each row are shipped. Without a
+ *  domain the rows are split evenly over the ranks.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The matrix A
+ */
+void TYPED_FUNC(
+    bml_allGatherVParallel_csr) (
+    bml_matrix_csr_t * A)
+{
+#ifdef DO_MPI
+    TYPED_FUNC(bml_expand_csr) (A);
+
+    int myRank = bml_getMyRank();
+    int nRanks = bml_getNRanks();
+
+    int N = A->N_;
+    bml_domain_t *A_domain = A->domain;
+    if (A_domain == NULL)
+    {
+        A_domain = bml_default_domain(N, A->NZMAX_, distributed);
+    }
+    int rowMin = A_domain->localRowMin[myRank];
+    int rowMax = A_domain->localRowMax[myRank];
+
+    // Number of non-zeros per row
+    int *nnz = bml_allocate_memory(sizeof(int) * N);
+    for (int i = rowMin; i < rowMax; i++)
+    {
+        nnz[i] = A->data_[i]->NNZ_;
+    }
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                   nnz, A_domain->localRowExtent,
+                   A_domain->localRowMin, MPI_INT, ccomm);
+
+    int *row_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+    int *counts = bml_allocate_memory(sizeof(int) * nRanks);
+    int *displs = bml_allocate_memory(sizeof(int) * nRanks);
+    bml_gather_row_layout(A_domain->localRowMin, A_domain->localRowMax,
+                          N, nnz, row_ptr, counts, displs);
+
+    int *cols_buffer =
+        bml_noinit_allocate_memory(sizeof(int) * MAX(row_ptr[N], 1));
+    REAL_T *vals_buffer =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(row_ptr[N], 1));
+
+#pragma omp parallel for shared(row_ptr, cols_buffer, vals_buffer)
+    for (int i = rowMin; i < rowMax; i++)
+    {
+        csr_sparse_row_t *row = A->data_[i];
+        memcpy(&cols_buffer[row_ptr[i]], row->cols_, sizeof(int) * nnz[i]);
+        memcpy(&vals_buffer[row_ptr[i]], row->vals_, sizeof(REAL_T) * nnz[i]);
+    }
+
+    // Column indices
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                   cols_buffer, counts, displs, MPI_INT, ccomm);
+
+    // Values
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                   vals_buffer, counts, displs, MPI_T, ccomm);
+
+#pragma omp parallel for shared(nnz, row_ptr, cols_buffer, vals_buffer)
+    for (int i = 0; i < N; i++)
+    {
+        if (i < rowMin || i >= rowMax)
+        {
+            csr_sparse_row_t *row = A->data_[i];
+            if (nnz[i] > row->alloc_size_)
+            {
+                row->alloc_size_ = nnz[i];
+                row->cols_ =
+                    bml_reallocate_memory(row->cols_, sizeof(int) * nnz[i]);
+                row->vals_ =
+                    bml_reallocate_memory(row->vals_,
+                                          sizeof(REAL_T) * nnz[i]);
+            }
+            memcpy(row->cols_, &cols_buffer[row_ptr[i]],
+                   sizeof(int) * nnz[i]);
+            memcpy(row->vals_, &vals_buffer[row_ptr[i]],
+                   sizeof(REAL_T) * nnz[i]);
+            row->NNZ_ = nnz[i];
+        }
+    }
+
+    if (A_domain != A->domain)
+    {
+        bml_deallocate_domain(A_domain);
+    }
+    bml_free_memory(nnz);
+    bml_free_memory(row_ptr);
+    bml_free_memory(counts);
+    bml_free_memory(displs);
+    bml_free_memory(cols_buffer);
+    bml_free_memory(vals_buffer);
+#else
+    (void) A;
+#endif
+}
+
 #ifdef DO_MPI
 void TYPED_FUNC(
     bml_mpi_send_csr) (
@@ -79,6 +182,8 @@ void TYPED_FUNC(
     const int src,
     MPI_Comm comm)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     MPI_Status status;
     int mpiret;
 
@@ -124,6 +229,58 @@ void TYPED_FUNC(
     bml_free_memory(values);
 }
 
+void TYPED_FUNC(
+    bml_mpi_isend_csr) (
+    bml_matrix_csr_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    // pack the rows, the buffers live until the sends complete
+    A->nnz_buffer = bml_allocate_memory(sizeof(int) * A->N_);
+    int totnnz = 0;
+    for (int i = 0; i < A->N_; i++)
+    {
+        A->nnz_buffer[i] = A->data_[i]->NNZ_;
+        totnnz += A->nnz_buffer[i];
+    }
+    int mpiret =
+        MPI_Isend(A->nnz_buffer, A->N_, MPI_INT, dst, 111, comm, A->req);
+    if (mpiret != MPI_SUCCESS)
+        LOG_ERROR("MPI_Isend failed for nnz");
+
+    A->cols_buffer = bml_allocate_memory(sizeof(int) * totnnz);
+    A->buffer = bml_allocate_memory(sizeof(REAL_T) * totnnz);
+    int *pcols = A->cols_buffer;
+    REAL_T *pvalues = A->buffer;
+    for (int i = 0; i < A->N_; i++)
+    {
+        csr_sparse_row_t *row = A->data_[i];
+        memcpy(pcols, row->cols_, row->NNZ_ * sizeof(int));
+        memcpy(pvalues, row->vals_, row->NNZ_ * sizeof(REAL_T));
+        pcols += row->NNZ_;
+        pvalues += row->NNZ_;
+    }
+    mpiret =
+        MPI_Isend(A->cols_buffer, totnnz, MPI_INT, dst, 112, comm,
+                  A->req + 1);
+    if (mpiret != MPI_SUCCESS)
+        LOG_ERROR("MPI_Isend failed for cols");
+
+    mpiret = MPI_Isend(A->buffer, totnnz, MPI_T, dst, 113, comm, A->req + 2);
+    if (mpiret != MPI_SUCCESS)
+        LOG_ERROR("MPI_Isend failed for values");
+}
+
+void TYPED_FUNC(
+    bml_mpi_isend_complete_csr) (
+    bml_matrix_csr_t * A)
+{
+    MPI_Waitall(3, A->req, MPI_STATUSES_IGNORE);
+    bml_free_memory(A->nnz_buffer);
+    bml_free_memory(A->cols_buffer);
+    bml_free_memory(A->buffer);
+}
+
 void TYPED_FUNC(
     bml_mpi_irecv_csr) (
     bml_matrix_csr_t * A,
@@ -159,6 +316,8 @@ void TYPED_FUNC(
     bml_mpi_irecv_complete_csr) (
     bml_matrix_csr_t * A)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     MPI_Waitall(3, A->req, MPI_STATUS_IGNORE);
 
     // move data from receive buffer into matrix
@@ -197,21 +356,25 @@ void TYPED_FUNC(
     const int root,
     MPI_Comm comm)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     assert(A->N_ > 0);
 
+    int myrank;
+    MPI_Comm_rank(comm, &myrank);
+
     int totnnz = 0;
-    if (bml_getMyRank() == root)
+    if (myrank == root)
         for (int i = 0; i < A->N_; i++)
         {
             totnnz += A->data_[i]->NNZ_;
         }
     MPI_Bcast(&totnnz, 1, MPI_INT, root, comm);
-    assert(totnnz > 0);
 
     // bcast cols
     int *cols = bml_allocate_memory(sizeof(int) * totnnz);
     int *pcols = cols;
-    if (bml_getMyRank() == root)
+    if (myrank == root)
         for (int i = 0; i < A->N_; i++)
         {
             csr_sparse_row_t *row = A->data_[i];
@@ -222,7 +385,7 @@ void TYPED_FUNC(
 
     // bcast nnz
     int *nnz = bml_allocate_memory(sizeof(int) * A->N_);
-    if (bml_getMyRank() == root)
+    if (myrank == root)
         for (int i = 0; i < A->N_; i++)
         {
             csr_sparse_row_t *row = A->data_[i];
@@ -233,7 +396,7 @@ void TYPED_FUNC(
     // bcast matrix elements
     REAL_T *values = bml_allocate_memory(sizeof(REAL_T) * totnnz);
     REAL_T *pvalues = values;
-    if (bml_getMyRank() == root)
+    if (myrank == root)
         for (int i = 0; i < A->N_; i++)
         {
             csr_sparse_row_t *row = A->data_[i];
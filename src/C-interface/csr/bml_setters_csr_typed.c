@@ -4,6 +4,7 @@
 #include "../bml_allocate.h"
 #include "../bml_types.h"
 #include "bml_setters_csr.h"
+#include "bml_allocate_csr.h"
 #include "bml_types_csr.h"
 
 #include <stdio.h>
@@ -148,6 +149,7 @@ void TYPED_FUNC(
     const int j,
     void *element)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
     // Insert new entry into row i.
     // Use the pointer to row i directly, since there
     // may be reallocation of memory
@@ -174,6 +176,7 @@ void TYPED_FUNC(
     const int j,
     void *element)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
 
     // Insert new entry into row i.
     // Use the pointer to row i directly, since there
@@ -199,6 +202,8 @@ void TYPED_FUNC(
     void *rowvals,
     const double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     const int A_N = A->N_;
     int nzcount, *cols;
     REAL_T *vals = rowvals;
@@ -237,6 +242,8 @@ void TYPED_FUNC(
     void *diag,
     const double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     REAL_T *diagonal = diag;
     int A_N = A->N_;
 
@@ -316,6 +323,7 @@ void TYPED_FUNC(
     void *vals,
     const double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
 
     // set row entries
     TYPED_FUNC(csr_set_sparse_row) (A->data_[i], count, cols, vals,
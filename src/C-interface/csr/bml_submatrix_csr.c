@@ -80,3 +80,83 @@ bml_assign_submatrix_csr(
             break;
     }
 }
+
+static int
+compare_index(
+    const void *a,
+    const void *b)
+{
+    int aId = *((int *) a);
+    int bId = *((int *) b);
+
+    return (aId > bId) - (aId < bId);
+}
+
+/** Assemble adjacency structure from matrix.
+ *
+ * The diagonal is left out and the neighbours of each row are sorted.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param xadj Index of each row in adjncy
+ * \param adjncy Adjacency vector
+ * \param base_flag Return 0- or 1-based
+ */
+void
+bml_adjacency_csr(
+    bml_matrix_csr_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag)
+{
+    int A_N = A->N_;
+    csr_sparse_row_t **A_rows = A->data_;
+
+    xadj[0] = 0;
+    for (int i = 0; i < A_N; i++)
+    {
+        int nedges = A_rows[i]->NNZ_;
+        for (int jj = 0; jj < A_rows[i]->NNZ_; jj++)
+        {
+            if (A_rows[i]->cols_[jj] == i)
+            {
+                nedges--;
+                break;
+            }
+        }
+        xadj[i + 1] = xadj[i] + nedges;
+    }
+
+#pragma omp parallel for                        \
+  shared(A_N, A_rows, xadj, adjncy)
+    for (int i = 0; i < A_N; i++)
+    {
+        int *cols = A_rows[i]->cols_;
+        int j = xadj[i];
+        for (int jj = 0; jj < A_rows[i]->NNZ_; jj++)
+        {
+            if (cols[jj] != i)
+            {
+                adjncy[j] = cols[jj];
+                j++;
+            }
+        }
+        qsort(&adjncy[xadj[i]], xadj[i + 1] - xadj[i], sizeof(int),
+              compare_index);
+    }
+
+    if (base_flag == 1)
+    {
+#pragma omp parallel for                        \
+  shared(xadj, A_N, adjncy)
+        for (int i = 0; i < xadj[A_N]; i++)
+        {
+            adjncy[i] += 1;
+        }
+        for (int i = 0; i < A_N + 1; i++)
+        {
+            xadj[i] += 1;
+        }
+    }
+}
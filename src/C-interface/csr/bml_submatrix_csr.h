@@ -65,4 +65,10 @@ void bml_assign_submatrix_csr_double_complex(
     int irow,
     int icol);
 
+void bml_adjacency_csr(
+    bml_matrix_csr_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
 #endif
@@ -75,6 +75,8 @@ void TYPED_FUNC(
     int irow,
     int icol)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     int B_N = B->N_;
 
     // loop over rows of B
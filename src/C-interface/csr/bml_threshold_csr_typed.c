@@ -75,6 +75,8 @@ void TYPED_FUNC(
     bml_matrix_csr_t * A,
     double threshold)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     int N = A->N_;
 
     int rlen;
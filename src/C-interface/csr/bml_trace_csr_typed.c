@@ -45,8 +45,17 @@ double TYPED_FUNC(
   reduction(+:trace)
     for (int i = 0; i < N; i++)
     {
-        trace +=
-            *((REAL_T *) TYPED_FUNC(csr_get_row_element) (A->data_[i], i));
+        int *cols = csr_matrix_row_cols(A, i);
+        REAL_T *vals = csr_matrix_row_vals(A, i);
+        const int annz = csr_matrix_row_NNZ(A, i);
+        for (int pos = 0; pos < annz; pos++)
+        {
+            if (cols[pos] == i)
+            {
+                trace += vals[pos];
+                break;
+            }
+        }
     }
 
     return (double) REAL_PART(trace);
@@ -81,18 +90,18 @@ double TYPED_FUNC(
 
     for (int i = 0; i < A_N; i++)
     {
-        int *acols = A->data_[i]->cols_;
-        REAL_T *avals = (REAL_T *) A->data_[i]->vals_;
-        const int annz = A->data_[i]->NNZ_;
+        int *acols = csr_matrix_row_cols(A, i);
+        REAL_T *avals = csr_matrix_row_vals(A, i);
+        const int annz = csr_matrix_row_NNZ(A, i);
 
         for (int pos = 0; pos < annz; pos++)
         {
             REAL_T a = avals[pos];
             const int j = acols[pos];
 
-            const int bnnz = B->data_[j]->NNZ_;
-            REAL_T *bvals = (REAL_T *) B->data_[j]->vals_;
-            int *bcols = B->data_[j]->cols_;
+            const int bnnz = csr_matrix_row_NNZ(B, j);
+            REAL_T *bvals = csr_matrix_row_vals(B, j);
+            int *bcols = csr_matrix_row_cols(B, j);
             for (int bpos = 0; bpos < bnnz; bpos++)
             {
                 const int k = bcols[bpos];
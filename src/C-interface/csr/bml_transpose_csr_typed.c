@@ -117,6 +117,8 @@ void TYPED_FUNC(
     bml_transpose_csr) (
     bml_matrix_csr_t * A)
 {
+    TYPED_FUNC(bml_expand_csr) (A);
+
     int N = A->N_;
     int nz_t[N];
     memset(nz_t, 0, sizeof(int) * N);
@@ -78,6 +78,13 @@ struct bml_matrix_csr_t
     csr_row_index_hash_t *table_;
     /** The matrix data */
     csr_sparse_row_t **data_;
+    /** Row offsets into the contiguous storage of a compact matrix,
+     * NULL if the rows are stored separately. */
+    int *row_ptr_;
+    /** Contiguous column indexes of a compact matrix */
+    int *cols_;
+    /** Contiguous non-zero entries of a compact matrix */
+    void *vals_;
 
     /** The domain decomposition when running in parallel. */
     bml_domain_t *domain;
@@ -108,5 +115,20 @@ typedef struct bml_matrix_csr_t bml_matrix_csr_t;
 #define csr_matrix_type(csr_matrix) ((csr_matrix)->matrix_type)
 #define csr_matrix_precision(csr_matrix) ((csr_matrix)->matrix_precision)
 #define csr_matrix_distribution_mode(csr_matrix) ((csr_matrix)->distribution_mode)
+#define csr_matrix_compact(csr_matrix) ((csr_matrix)->row_ptr_ != NULL)
+/** row i of a csr matrix, read from the contiguous storage if the
+ * matrix is compact (csr_matrix_row_vals for typed code only) */
+#define csr_matrix_row_NNZ(csr_matrix, i) \
+    (csr_matrix_compact(csr_matrix) \
+     ? (csr_matrix)->row_ptr_[(i) + 1] - (csr_matrix)->row_ptr_[i] \
+     : (csr_matrix)->data_[i]->NNZ_)
+#define csr_matrix_row_cols(csr_matrix, i) \
+    (csr_matrix_compact(csr_matrix) \
+     ? (csr_matrix)->cols_ + (csr_matrix)->row_ptr_[i] \
+     : (csr_matrix)->data_[i]->cols_)
+#define csr_matrix_row_vals(csr_matrix, i) \
+    (csr_matrix_compact(csr_matrix) \
+     ? (REAL_T *) (csr_matrix)->vals_ + (csr_matrix)->row_ptr_[i] \
+     : (REAL_T *) (csr_matrix)->data_[i]->vals_)
 
 #endif
@@ -1,9 +1,14 @@
 #include "../../macros.h"
 #include "../../typed.h"
+#include "../bml_allocate.h"
+#include "../bml_compress.h"
 #include "../bml_logger.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
 #include "../bml_utilities.h"
+#include "bml_export_csr.h"
+#include "bml_import_csr.h"
+#include "bml_allocate_csr.h"
 #include "bml_types_csr.h"
 #include "bml_setters_csr.h"
 #include "bml_utilities_csr.h"
@@ -25,83 +30,36 @@ void TYPED_FUNC(
     bml_matrix_csr_t * A,
     char *filename)
 {
-    FILE *hFile;
-    char header1[20], header2[20], header3[20], header4[20], header5[20];
-    int hdimx, nnz, irow, icol;
-    REAL_T value;
+    TYPED_FUNC(bml_expand_csr) (A);
 
-    hFile = fopen(filename, "r");
-
-    // Read header
-    if (fscanf(hFile, "%s %s %s %s %s", header1, header2, header3, header4,
-               header5) != 5)
-    {
-        LOG_ERROR("read error on header\n");
-    }
-
-    LOG_DEBUG("Read: %s %s %s %s %s\n", header1, header2, header3, header4,
-              header5);
+    int N = A->N_;
 
-    int symflag = strcmp(header5, "symmetric");
+    int file_N;
+    int *row_ptr;
+    int *cols;
+    REAL_T *vals;
 
-    // Read N, N, # of non-zeroes
-    if (fscanf(hFile, "%d %d %d", &hdimx, &hdimx, &nnz) != 3)
+    bml_read_compressed_rows(filename, A->matrix_precision, &file_N,
+                             &row_ptr, &cols, (void **) &vals);
+    if (file_N != N)
     {
-        LOG_ERROR("read error\n");
+        LOG_ERROR("%s holds a matrix of size %d, expected %d\n", filename,
+                  file_N, N);
     }
 
-    LOG_DEBUG("hdimx = %d, nnz = %d\n", hdimx, nnz);
-
-    // Read in values
-    for (int i = 0; i < nnz; i++)
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
     {
-#if defined(SINGLE_REAL)
-        if (fscanf(hFile, "%d %d %f\n", &irow, &icol, &value) != 3)
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
         {
-            LOG_ERROR("read error\n");
-        }
-#elif defined(DOUBLE_REAL)
-        if (fscanf(hFile, "%d %d %lf\n", &irow, &icol, &value) != 3)
-        {
-            LOG_ERROR("read error\n");
-        }
-#elif defined(SINGLE_COMPLEX)
-        double real_part, imaginary_part;
-        if (fscanf
-            (hFile, "%d %d %lf %lf\n", &irow, &icol, &real_part,
-             &imaginary_part) != 4)
-        {
-            LOG_ERROR("read error\n");
-        }
-        value = real_part + I * imaginary_part;
-        LOG_DEBUG("read: %d %d %e %e %e\n", irow, icol, real_part,
-                  imaginary_part, value);
-#elif defined(DOUBLE_COMPLEX)
-        double real_part, imaginary_part;
-        if (fscanf
-            (hFile, "%d %d %lf %lf\n", &irow, &icol, &real_part,
-             &imaginary_part) != 4)
-        {
-            LOG_ERROR("read error\n");
-        }
-        value = real_part + I * imaginary_part;
-#else
-        LOG_ERROR("unknown precision\n");
-#endif
-
-        irow--;
-        icol--;
-        // set new element
-        TYPED_FUNC(csr_set_row_element_new) (A->data_[irow], icol, &value);
-        // Set symmetric value if necessary
-        if (symflag == 0 && icol != irow)
-        {
-            TYPED_FUNC(csr_set_row_element_new) (A->data_[icol], irow,
-                                                 &value);
+            TYPED_FUNC(csr_set_row_element_new) (A->data_[i], cols[k],
+                                                 &vals[k]);
         }
     }
 
-    fclose(hFile);
+    bml_free_memory(row_ptr);
+    bml_free_memory(cols);
+    bml_free_memory(vals);
 }
 
 /** Write a Matrix Market format file from a bml matrix.
@@ -176,3 +134,118 @@ void TYPED_FUNC(
 
     fclose(mFile);
 }
+
+/** Write a bml matrix to a binary file.
+ *
+ *  The rows are packed into compressed row arrays first.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param A The matrix to be written
+ *  \param fd The file descriptor of the binary file
+ */
+void TYPED_FUNC(
+    bml_write_bml_matrix_binary_csr) (
+    bml_matrix_csr_t * A,
+    int fd)
+{
+    int N = A->N_;
+    int *row_ptr;
+    int *cols;
+    REAL_T *vals;
+    bml_binary_header_t header;
+
+    TYPED_FUNC(bml_export_to_compressed_rows_csr) (A, &row_ptr, &cols,
+                                                   (void **) &vals);
+
+    void *index = cols;
+    size_t index_bytes = sizeof(int) * row_ptr[N];
+
+    bml_init_binary_header(&header, csr, A->matrix_precision, N, A->NZMAX_);
+    header.nvalues = row_ptr[N];
+    if (bml_get_binary_index_encoding() == index_encoding_delta)
+    {
+        int *nnz = bml_noinit_allocate_memory(sizeof(int) * MAX(N, 1));
+        for (int i = 0; i < N; i++)
+        {
+            nnz[i] = row_ptr[i + 1] - row_ptr[i];
+        }
+        size_t bound = bml_encode_index_bound(N, row_ptr[N]);
+        index = bml_noinit_allocate_memory(bound);
+        index_bytes = bml_encode_index(N, 0, nnz, cols, 0, index);
+        header.index_encoding = index_encoding_delta;
+        header.index_bytes = index_bytes;
+        bml_free_memory(nnz);
+    }
+    bml_write_binary_section(fd, &header, sizeof(bml_binary_header_t));
+    bml_write_binary_section(fd, row_ptr, sizeof(int) * (N + 1));
+    bml_write_binary_section(fd, index, index_bytes);
+    bml_write_binary_section(fd, vals, sizeof(REAL_T) * row_ptr[N]);
+
+    if (index != cols)
+    {
+        bml_free_memory(index);
+    }
+    bml_free_memory(row_ptr);
+    bml_free_memory(cols);
+    bml_free_memory(vals);
+}
+
+/** Read a bml matrix from a mapped binary file.
+ *
+ *  The rows are always copied and the mapping is unmapped.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param mapping The mapped file
+ *  \param mapping_size The size of the file in bytes
+ *  \param zero_copy Ignored, the rows are separate allocations
+ *  \return The matrix
+ */
+bml_matrix_csr_t *TYPED_FUNC(
+    bml_read_bml_matrix_binary_csr) (
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy)
+{
+    bml_binary_header_t *header = mapping;
+    int N = header->N;
+    size_t offset = 0;
+
+    // the rows are separate allocations and always get copied
+    (void) zero_copy;
+
+    bml_binary_section(mapping, mapping_size, &offset,
+                       sizeof(bml_binary_header_t));
+    int *row_ptr = bml_binary_section(mapping, mapping_size, &offset,
+                                      sizeof(int) * (N + 1));
+    int encoded = header->index_encoding == index_encoding_delta;
+    int *cols = bml_binary_section(mapping, mapping_size, &offset,
+                                   encoded ? (size_t) header->index_bytes :
+                                   sizeof(int) * row_ptr[N]);
+    REAL_T *vals = bml_binary_section(mapping, mapping_size, &offset,
+                                      sizeof(REAL_T) * row_ptr[N]);
+    int *decoded = NULL;
+    if (encoded)
+    {
+        int *nnz = bml_noinit_allocate_memory(sizeof(int) * MAX(N, 1));
+        for (int i = 0; i < N; i++)
+        {
+            nnz[i] = row_ptr[i + 1] - row_ptr[i];
+        }
+        decoded = bml_noinit_allocate_memory(sizeof(int) *
+                                             MAX(row_ptr[N], 1));
+        bml_decode_index(N, 0, nnz, cols, decoded, 0);
+        cols = decoded;
+        bml_free_memory(nnz);
+    }
+
+    bml_matrix_csr_t *A =
+        TYPED_FUNC(bml_import_from_compressed_rows_csr) (N, row_ptr, cols,
+                                                         vals, header->M,
+                                                         sequential);
+
+    bml_free_memory(decoded);
+    bml_unmap_binary_file(mapping, mapping_size);
+    return A;
+}
@@ -2,6 +2,7 @@
 #include "../bml_logger.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
+#include "../bml_utilities.h"
 #include "bml_allocate_dense.h"
 #include "bml_types_dense.h"
 
@@ -45,7 +46,14 @@ bml_deallocate_dense(
     magma_int_t ret = magma_free(A->matrix);
     assert(ret == MAGMA_SUCCESS);
 #else
-    bml_free_memory(A->matrix);
+    if (A->mapping != NULL)
+    {
+        bml_unmap_binary_file(A->mapping, A->mapping_size);
+    }
+    else
+    {
+        bml_free_memory(A->matrix);
+    }
 #endif
     bml_free_memory(A);
 }
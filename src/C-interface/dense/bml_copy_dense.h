@@ -58,6 +58,51 @@ void bml_reorder_dense_double_complex(
     bml_matrix_dense_t * A,
     int *perm);
 
+void bml_copy_panel_dense(
+    bml_matrix_dense_t * A,
+    bml_matrix_dense_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_dense_single_real(
+    bml_matrix_dense_t * A,
+    bml_matrix_dense_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_dense_double_real(
+    bml_matrix_dense_t * A,
+    bml_matrix_dense_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_dense_single_complex(
+    bml_matrix_dense_t * A,
+    bml_matrix_dense_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_dense_double_complex(
+    bml_matrix_dense_t * A,
+    bml_matrix_dense_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
 void bml_save_domain_dense(
     bml_matrix_dense_t * A);
 
@@ -153,3 +153,48 @@ void TYPED_FUNC(
 
     bml_deallocate_dense(B);
 }
+
+/** Copy a panel of a dense matrix.
+ *
+ *  B(l0 + i, j) = A(i0 + i, j) for 0 <= i < nrows and j0 <= j < j0 +
+ *  ncols, the other elements of B are zero.
+ *
+ *  \ingroup copy_group
+ *
+ *  \param A The matrix to copy from
+ *  \param B The panel
+ *  \param i0 The first row of the panel in A
+ *  \param nrows The number of rows of the panel
+ *  \param j0 The first column of the panel
+ *  \param ncols The number of columns of the panel
+ *  \param l0 The first row of the panel in B
+ */
+void TYPED_FUNC(
+    bml_copy_panel_dense) (
+    bml_matrix_dense_t * A,
+    bml_matrix_dense_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0)
+{
+    int N = A->N;
+
+    REAL_T *A_matrix = A->matrix;
+    REAL_T *B_matrix = B->matrix;
+
+#ifdef MKL_GPU
+#pragma omp target update from(A_matrix[0:N*N])
+#endif
+    memset(B_matrix, 0, sizeof(REAL_T) * N * N);
+#pragma omp parallel for
+    for (int i = 0; i < nrows; i++)
+    {
+        memcpy(&B_matrix[ROWMAJOR(l0 + i, j0, N, N)],
+               &A_matrix[ROWMAJOR(i0 + i, j0, N, N)], ncols * sizeof(REAL_T));
+    }
+#ifdef MKL_GPU
+#pragma omp target update to(B_matrix[0:N*N])
+#endif
+}
@@ -23,8 +23,23 @@
 #include "../lapack.h"
 #endif
 
+#include <stdlib.h>
 #include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#if defined(HAVE_MKL_SET_NUM_THREADS_LOCAL)
+int mkl_set_num_threads_local(
+    int nt);
+#elif defined(HAVE_OPENBLAS_SET_NUM_THREADS)
+void openblas_set_num_threads(
+    int num_threads);
+int openblas_get_num_threads(
+    void);
+#endif
+
 /** \page diagonalize
  *
  * Note: We can't generify these functions easily since the API
@@ -580,3 +595,364 @@ bml_diagonalize_dense(
             break;
     }
 }
+
+/** Workspace of one thread of the batched diagonalization.
+ *
+ * Sized once for the largest matrix the thread may get, with the
+ * sizes LAPACK asks for in a workspace query.
+ */
+typedef struct
+{
+    /** Copy of the matrix, overwritten by LAPACK. */
+    void *a;
+    /** Eigenvectors (complex only). */
+    void *z;
+    /** Real eigenvalues. */
+    void *w;
+    void *work;
+    int lwork;
+    void *rwork;
+    int lrwork;
+    int *iwork;
+    int liwork;
+    int *isuppz;
+} diagonalize_workspace_t;
+
+#if !defined(BML_USE_MAGMA) && !defined(MKL_GPU) && !defined(NOBLAS)
+
+/** Query the workspace sizes for matrices up to N x N.
+ */
+static void
+diagonalize_batched_query(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    diagonalize_workspace_t * ws)
+{
+    int info;
+    int query = -1;
+    int il = 1;
+    int M;
+    int isuppz[2];
+
+    memset(ws, 0, sizeof(diagonalize_workspace_t));
+    switch (matrix_precision)
+    {
+        case single_real:
+        {
+            float a, w, work;
+            C_SSYEVD("V", "U", &N, &a, &N, &w, &work, &query,
+                     &ws->liwork, &query, &info);
+            ws->lwork = (int) work;
+            break;
+        }
+        case double_real:
+        {
+            double a, w, work;
+            C_DSYEVD("V", "U", &N, &a, &N, &w, &work, &query,
+                     &ws->liwork, &query, &info);
+            ws->lwork = (int) work;
+            break;
+        }
+#ifdef BML_COMPLEX
+        case single_complex:
+        {
+            float complex a, z, work;
+            float vl = -FLT_MAX, vu = FLT_MAX, abstol = 0, w, rwork;
+            C_CHEEVR("V", "A", "U", &N, &a, &N, &vl, &vu, &il, &N,
+                     &abstol, &M, &w, &z, &N, isuppz, &work, &query, &rwork,
+                     &query, &ws->liwork, &query, &info);
+            ws->lwork = (int) crealf(work);
+            ws->lrwork = (int) rwork;
+            break;
+        }
+        case double_complex:
+        {
+            double complex a, z, work;
+            double vl = -DBL_MAX, vu = DBL_MAX, abstol = 0, w, rwork;
+            C_ZHEEVR("V", "A", "U", &N, &a, &N, &vl, &vu, &il, &N,
+                     &abstol, &M, &w, &z, &N, isuppz, &work, &query, &rwork,
+                     &query, &ws->liwork, &query, &info);
+            ws->lwork = (int) creal(work);
+            ws->lrwork = (int) rwork;
+            break;
+        }
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    if (info != 0)
+    {
+        LOG_ERROR("workspace query failed, info = %d\n", info);
+    }
+}
+
+/** Allocate the workspace of a thread from the queried sizes.
+ */
+static void
+diagonalize_batched_allocate(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    diagonalize_workspace_t * ws)
+{
+    size_t real_size =
+        matrix_precision == single_real
+        || matrix_precision == single_complex ? sizeof(float) :
+        sizeof(double);
+    size_t size = matrix_precision == single_real
+        || matrix_precision == double_real ? real_size : 2 * real_size;
+
+    ws->a = bml_noinit_allocate_memory(size * N * N + 1);
+    ws->w = bml_noinit_allocate_memory(real_size * N + 1);
+    ws->work = bml_noinit_allocate_memory(size * ws->lwork + 1);
+    ws->iwork = bml_noinit_allocate_memory(sizeof(int) * ws->liwork + 1);
+    if (size != real_size)
+    {
+        ws->z = bml_noinit_allocate_memory(size * N * N + 1);
+        ws->rwork = bml_noinit_allocate_memory(real_size * ws->lrwork + 1);
+        ws->isuppz = bml_noinit_allocate_memory(sizeof(int) * 2 * N + 1);
+    }
+}
+
+static void
+diagonalize_batched_free(
+    diagonalize_workspace_t * ws)
+{
+    bml_free_memory(ws->a);
+    bml_free_memory(ws->z);
+    bml_free_memory(ws->w);
+    bml_free_memory(ws->work);
+    bml_free_memory(ws->rwork);
+    bml_free_memory(ws->iwork);
+    bml_free_memory(ws->isuppz);
+}
+
+/** Diagonalize one matrix with a preallocated workspace.
+ *
+ * Same results as bml_diagonalize_dense, the real cases use the
+ * divide and conquer syevd.
+ */
+static void
+diagonalize_batched_one(
+    bml_matrix_dense_t * A,
+    void *eigenvalues,
+    bml_matrix_dense_t * eigenvectors,
+    diagonalize_workspace_t * ws)
+{
+    int N = A->N;
+    int info = 0;
+    int il = 1;
+    int M;
+
+    switch (A->matrix_precision)
+    {
+        case single_real:
+        {
+            float *evecs = ws->a;
+            float *E_matrix = eigenvectors->matrix;
+            memcpy(evecs, A->matrix, sizeof(float) * N * N);
+            C_SSYEVD("V", "U", &N, evecs, &N, eigenvalues, ws->work,
+                     &ws->lwork, ws->iwork, &ws->liwork, &info);
+            for (int i = 0; i < N; i++)
+            {
+                for (int j = 0; j < N; j++)
+                {
+                    E_matrix[ROWMAJOR(i, j, N, N)] =
+                        evecs[COLMAJOR(i, j, N, N)];
+                }
+            }
+            break;
+        }
+        case double_real:
+        {
+            double *evecs = ws->a;
+            double *E_matrix = eigenvectors->matrix;
+            memcpy(evecs, A->matrix, sizeof(double) * N * N);
+            C_DSYEVD("V", "U", &N, evecs, &N, eigenvalues, ws->work,
+                     &ws->lwork, ws->iwork, &ws->liwork, &info);
+            for (int i = 0; i < N; i++)
+            {
+                for (int j = 0; j < N; j++)
+                {
+                    E_matrix[ROWMAJOR(i, j, N, N)] =
+                        evecs[COLMAJOR(i, j, N, N)];
+                }
+            }
+            break;
+        }
+#ifdef BML_COMPLEX
+        case single_complex:
+        {
+            float complex *evecs = ws->z;
+            float complex *E_matrix = eigenvectors->matrix;
+            float complex *typed_eigenvalues = eigenvalues;
+            float *evals = ws->w;
+            float vl = -FLT_MAX, vu = FLT_MAX, abstol = 0;
+            memcpy(ws->a, A->matrix, sizeof(float complex) * N * N);
+            C_CHEEVR("V", "A", "U", &N, ws->a, &N, &vl, &vu, &il, &N,
+                     &abstol, &M, evals, evecs, &N, ws->isuppz, ws->work,
+                     &ws->lwork, ws->rwork, &ws->lrwork, ws->iwork,
+                     &ws->liwork, &info);
+            for (int i = 0; i < N; i++)
+            {
+                typed_eigenvalues[i] = evals[i];
+                for (int j = 0; j < N; j++)
+                {
+                    E_matrix[ROWMAJOR(i, j, N, N)] =
+                        evecs[COLMAJOR(i, j, N, N)];
+                }
+            }
+            break;
+        }
+        case double_complex:
+        {
+            double complex *evecs = ws->z;
+            double complex *E_matrix = eigenvectors->matrix;
+            double complex *typed_eigenvalues = eigenvalues;
+            double *evals = ws->w;
+            double vl = -DBL_MAX, vu = DBL_MAX, abstol = 0;
+            memcpy(ws->a, A->matrix, sizeof(double complex) * N * N);
+            C_ZHEEVR("V", "A", "U", &N, ws->a, &N, &vl, &vu, &il, &N,
+                     &abstol, &M, evals, evecs, &N, ws->isuppz, ws->work,
+                     &ws->lwork, ws->rwork, &ws->lrwork, ws->iwork,
+                     &ws->liwork, &info);
+            for (int i = 0; i < N; i++)
+            {
+                typed_eigenvalues[i] = evals[i];
+                for (int j = 0; j < N; j++)
+                {
+                    E_matrix[ROWMAJOR(i, j, N, N)] =
+                        evecs[COLMAJOR(i, j, N, N)];
+                }
+            }
+            break;
+        }
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    if (info != 0)
+    {
+        LOG_ERROR("diagonalization failed, info = %d\n", info);
+    }
+}
+
+#endif
+
+static int
+diagonalize_batched_compare(
+    const void *a,
+    const void *b)
+{
+    const int *ia = a;
+    const int *ib = b;
+
+    if (ia[0] != ib[0])
+    {
+        return ia[0] < ib[0] ? 1 : -1;
+    }
+    return ia[1] - ib[1];
+}
+
+/** Diagonalize many dense matrices.
+ *
+ * The matrices are sorted by size. The ones larger than cutoff are
+ * diagonalized one after the other by bml_diagonalize_dense, with all
+ * threads working on each in the threaded LAPACK. The others are
+ * spread over the threads, largest first, one matrix per thread at a
+ * time, each thread with a workspace allocated once for the largest
+ * of them. A threaded MKL or OpenBLAS is kept to one thread in the
+ * threads of the batch.
+ *
+ * \param nmatrices Number of matrices
+ * \param A The matrices, all of the same precision
+ * \param eigenvalues The eigenvalues of each matrix
+ * \param eigenvectors The eigenvectors of each matrix
+ * \param cutoff Size above which a matrix uses all threads
+ */
+void
+bml_diagonalize_batched_dense(
+    int nmatrices,
+    bml_matrix_dense_t ** A,
+    void **eigenvalues,
+    bml_matrix_dense_t ** eigenvectors,
+    int cutoff)
+{
+    int (*order)[2] = bml_noinit_allocate_memory(sizeof(int[2]) *
+                                                 (nmatrices + 1));
+    int nlarge = 0;
+
+    for (int k = 0; k < nmatrices; k++)
+    {
+        if (A[k]->matrix_precision != A[0]->matrix_precision)
+        {
+            LOG_ERROR("matrices of a batch must have the same precision\n");
+        }
+        order[k][0] = A[k]->N;
+        order[k][1] = k;
+        if (A[k]->N > cutoff)
+        {
+            nlarge++;
+        }
+    }
+    qsort(order, nmatrices, sizeof(int[2]), diagonalize_batched_compare);
+
+#if defined(BML_USE_MAGMA) || defined(MKL_GPU) || defined(NOBLAS)
+    // The matrices live on the device, diagonalize them in turn
+    nlarge = nmatrices;
+#endif
+
+    for (int k = 0; k < nlarge; k++)
+    {
+        int m = order[k][1];
+        bml_diagonalize_dense(A[m], eigenvalues[m], eigenvectors[m]);
+    }
+
+#if !defined(BML_USE_MAGMA) && !defined(MKL_GPU) && !defined(NOBLAS)
+    if (nlarge < nmatrices)
+    {
+        bml_matrix_precision_t matrix_precision = A[0]->matrix_precision;
+        int max_N = order[nlarge][0];
+        diagonalize_workspace_t query;
+
+        diagonalize_batched_query(matrix_precision, max_N, &query);
+
+#if !defined(HAVE_MKL_SET_NUM_THREADS_LOCAL) && \
+    defined(HAVE_OPENBLAS_SET_NUM_THREADS)
+        int blas_threads = openblas_get_num_threads();
+        openblas_set_num_threads(1);
+#endif
+
+#pragma omp parallel
+        {
+#ifdef HAVE_MKL_SET_NUM_THREADS_LOCAL
+            int blas_threads = mkl_set_num_threads_local(1);
+#endif
+            diagonalize_workspace_t ws = query;
+
+            diagonalize_batched_allocate(matrix_precision, max_N, &ws);
+
+#pragma omp for schedule(dynamic)
+            for (int k = nlarge; k < nmatrices; k++)
+            {
+                int m = order[k][1];
+                diagonalize_batched_one(A[m], eigenvalues[m],
+                                        eigenvectors[m], &ws);
+            }
+
+            diagonalize_batched_free(&ws);
+#ifdef HAVE_MKL_SET_NUM_THREADS_LOCAL
+            mkl_set_num_threads_local(blas_threads);
+#endif
+        }
+
+#if !defined(HAVE_MKL_SET_NUM_THREADS_LOCAL) && \
+    defined(HAVE_OPENBLAS_SET_NUM_THREADS)
+        openblas_set_num_threads(blas_threads);
+#endif
+    }
+#endif
+
+    bml_free_memory(order);
+}
@@ -28,4 +28,11 @@ void bml_diagonalize_dense_double_complex(
     void *eigenvalues,
     bml_matrix_dense_t * eigenvectors);
 
+void bml_diagonalize_batched_dense(
+    int nmatrices,
+    bml_matrix_dense_t ** A,
+    void **eigenvalues,
+    bml_matrix_dense_t ** eigenvectors,
+    int cutoff);
+
 #endif
@@ -12,6 +12,7 @@
 #endif
 
 #include <complex.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -74,3 +75,78 @@ void *TYPED_FUNC(
     }
     return A_dense;
 }
+
+/** Convert a bml matrix into compressed rows.
+ *
+ * The entries of row i are cols[k] and vals[k] for
+ * row_ptr[i] <= k < row_ptr[i + 1]. Only the non-zero
+ * elements are exported.
+ *
+ * \ingroup convert_group
+ *
+ * \param A The bml matrix
+ * \param row_ptr The row pointers (N + 1), allocated here
+ * \param cols The column indices, allocated here
+ * \param vals The values, allocated here
+ */
+void TYPED_FUNC(
+    bml_export_to_compressed_rows_dense) (
+    bml_matrix_dense_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    int N = A->N;
+#if defined(BML_USE_MAGMA) || defined(MKL_GPU)
+    REAL_T *A_dense =
+        TYPED_FUNC(bml_export_to_dense_dense) (A, dense_row_major);
+#else
+    REAL_T *A_dense = A->matrix;
+#endif
+    int *A_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+
+#pragma omp parallel for shared(A_ptr, A_dense)
+    for (int i = 0; i < N; i++)
+    {
+        int nnz = 0;
+        for (int j = 0; j < N; j++)
+        {
+            if (is_above_threshold(A_dense[ROWMAJOR(i, j, N, N)], 0.0))
+            {
+                nnz++;
+            }
+        }
+        A_ptr[i + 1] = nnz;
+    }
+    for (int i = 0; i < N; i++)
+    {
+        A_ptr[i + 1] += A_ptr[i];
+    }
+
+    int *A_cols = bml_noinit_allocate_memory(sizeof(int) * MAX(A_ptr[N], 1));
+    REAL_T *A_vals =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(A_ptr[N], 1));
+
+#pragma omp parallel for shared(A_ptr, A_cols, A_vals, A_dense)
+    for (int i = 0; i < N; i++)
+    {
+        int k = A_ptr[i];
+        for (int j = 0; j < N; j++)
+        {
+            REAL_T A_ij = A_dense[ROWMAJOR(i, j, N, N)];
+            if (is_above_threshold(A_ij, 0.0))
+            {
+                A_cols[k] = j;
+                A_vals[k] = A_ij;
+                k++;
+            }
+        }
+    }
+#if defined(BML_USE_MAGMA) || defined(MKL_GPU)
+    bml_free_memory(A_dense);
+#endif
+
+    *row_ptr = A_ptr;
+    *cols = A_cols;
+    *vals = A_vals;
+}
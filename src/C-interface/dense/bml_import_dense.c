@@ -59,3 +59,62 @@ bml_import_from_dense_dense(
     }
     return A_bml;
 }
+
+/** Convert compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group
+ *
+ * \param matrix_precision The real precision
+ * \param N The number of rows/columns
+ * \param row_ptr The row pointers
+ * \param cols The column indices
+ * \param vals The values
+ * \return The bml matrix
+ */
+bml_matrix_dense_t *
+bml_import_from_compressed_rows_dense(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode)
+{
+    switch (matrix_precision)
+    {
+        case single_real:
+            return bml_import_from_compressed_rows_dense_single_real(N,
+                                                                     row_ptr,
+                                                                     cols,
+                                                                     vals,
+                                                                     distrib_mode);
+            break;
+        case double_real:
+            return bml_import_from_compressed_rows_dense_double_real(N,
+                                                                     row_ptr,
+                                                                     cols,
+                                                                     vals,
+                                                                     distrib_mode);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_import_from_compressed_rows_dense_single_complex(N,
+                                                                        row_ptr,
+                                                                        cols,
+                                                                        vals,
+                                                                        distrib_mode);
+            break;
+        case double_complex:
+            return bml_import_from_compressed_rows_dense_double_complex(N,
+                                                                        row_ptr,
+                                                                        cols,
+                                                                        vals,
+                                                                        distrib_mode);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
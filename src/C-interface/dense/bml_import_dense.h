@@ -57,4 +57,40 @@ void *bml_export_to_dense_dense_double_complex(
     bml_matrix_dense_t * A,
     bml_dense_order_t order);
 
+bml_matrix_dense_t *bml_import_from_compressed_rows_dense(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_dense_t *bml_import_from_compressed_rows_dense_single_real(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_dense_t *bml_import_from_compressed_rows_dense_double_real(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_dense_t *bml_import_from_compressed_rows_dense_single_complex(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_dense_t *bml_import_from_compressed_rows_dense_double_complex(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode);
+
 #endif
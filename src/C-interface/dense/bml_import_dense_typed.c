@@ -74,3 +74,50 @@ bml_matrix_dense_t *TYPED_FUNC(
 #endif
     return A_bml;
 }
+
+/** Convert compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group
+ *
+ * \param N The number of rows/columns
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ * \param distrib_mode The distribution mode
+ * \return The bml matrix
+ */
+bml_matrix_dense_t *TYPED_FUNC(
+    bml_import_from_compressed_rows_dense) (
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    bml_distribution_mode_t distrib_mode)
+{
+    REAL_T *A_vals = (REAL_T *) vals;
+#if defined(BML_USE_MAGMA) || defined(MKL_GPU)
+    REAL_T *A_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
+#else
+    bml_matrix_dimension_t matrix_dimension = { N, N, N, NULL, 0 };
+    bml_matrix_dense_t *A_bml =
+        TYPED_FUNC(bml_zero_matrix_dense) (matrix_dimension, distrib_mode);
+    REAL_T *A_dense = A_bml->matrix;
+#endif
+
+#pragma omp parallel for shared(A_dense, A_vals)
+    for (int i = 0; i < N; i++)
+    {
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+        {
+            A_dense[ROWMAJOR(i, cols[k], N, N)] = A_vals[k];
+        }
+    }
+
+#if defined(BML_USE_MAGMA) || defined(MKL_GPU)
+    bml_matrix_dense_t *A_bml =
+        TYPED_FUNC(bml_import_from_dense_dense) (dense_row_major, N, A_dense,
+                                                 distrib_mode);
+    bml_free_memory(A_dense);
+#endif
+    return A_bml;
+}
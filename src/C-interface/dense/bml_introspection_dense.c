@@ -200,3 +200,25 @@ bml_get_data_ptr_dense(
 {
     return A->matrix;
 }
+
+/** Return the cost of every row of a matrix.
+ *
+ * All rows of a dense matrix cost the same, whatever the balance.
+ *
+ * \param A The bml matrix.
+ * \param balance What a row costs, ignored.
+ * \param cost The cost of each row (length N).
+ */
+void
+bml_get_row_costs_dense(
+    bml_matrix_dense_t * A,
+    bml_balance_t balance,
+    double *cost)
+{
+    (void) balance;
+
+    for (int i = 0; i < A->N; i++)
+    {
+        cost[i] = 1.;
+    }
+}
@@ -35,6 +35,11 @@ int bml_get_row_bandwidth_dense_double_complex(
     bml_matrix_dense_t * A,
     int i);
 
+void bml_get_row_costs_dense(
+    bml_matrix_dense_t * A,
+    bml_balance_t balance,
+    double *cost);
+
 int bml_get_bandwidth_dense(
     bml_matrix_dense_t * A);
 
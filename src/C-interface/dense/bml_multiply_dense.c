@@ -163,3 +163,79 @@ bml_multiply_adjust_AB_dense(
             break;
     }
 }
+
+/** Split precision matrix square.
+ *
+ * X2 = X * X from single precision slices of X.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X Matrix X
+ *  \param X2 Matrix X2
+ *  \param nslices Number of slices per operand, 0 for full precision
+ */
+void
+bml_multiply_x2_split_dense(
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices)
+{
+    switch (X->matrix_precision)
+    {
+        case single_real:
+            bml_multiply_x2_split_dense_single_real(X, X2, nslices);
+            break;
+        case double_real:
+            bml_multiply_x2_split_dense_double_real(X, X2, nslices);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_multiply_x2_split_dense_single_complex(X, X2, nslices);
+            break;
+        case double_complex:
+            bml_multiply_x2_split_dense_double_complex(X, X2, nslices);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+/** Accuracy of the split precision matrix square.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X Matrix X
+ *  \param nslices Number of slices per operand
+ *  \return The largest error of X * X relative to its largest element
+ */
+double
+bml_multiply_x2_split_error_dense(
+    bml_matrix_dense_t * X,
+    int nslices)
+{
+    switch (X->matrix_precision)
+    {
+        case single_real:
+            return bml_multiply_x2_split_error_dense_single_real(X, nslices);
+            break;
+        case double_real:
+            return bml_multiply_x2_split_error_dense_double_real(X, nslices);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_multiply_x2_split_error_dense_single_complex(X,
+                                                                    nslices);
+            break;
+        case double_complex:
+            return bml_multiply_x2_split_error_dense_double_complex(X,
+                                                                    nslices);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return 0;
+}
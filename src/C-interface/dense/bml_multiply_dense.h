@@ -109,4 +109,49 @@ void bml_multiply_adjust_AB_dense_double_complex(
     bml_matrix_dense_t * B,
     bml_matrix_dense_t * C);
 
+void bml_multiply_x2_split_dense(
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices);
+
+void bml_multiply_x2_split_dense_single_real(
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices);
+
+void bml_multiply_x2_split_dense_double_real(
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices);
+
+void bml_multiply_x2_split_dense_single_complex(
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices);
+
+void bml_multiply_x2_split_dense_double_complex(
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices);
+
+double bml_multiply_x2_split_error_dense(
+    bml_matrix_dense_t * X,
+    int nslices);
+
+double bml_multiply_x2_split_error_dense_single_real(
+    bml_matrix_dense_t * X,
+    int nslices);
+
+double bml_multiply_x2_split_error_dense_double_real(
+    bml_matrix_dense_t * X,
+    int nslices);
+
+double bml_multiply_x2_split_error_dense_single_complex(
+    bml_matrix_dense_t * X,
+    int nslices);
+
+double bml_multiply_x2_split_error_dense_double_complex(
+    bml_matrix_dense_t * X,
+    int nslices);
+
 #endif
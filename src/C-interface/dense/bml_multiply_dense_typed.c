@@ -3,6 +3,7 @@
 #endif
 
 #include "../../internal-blas/bml_gemm.h"
+#include "../../macros.h"
 #include "../../typed.h"
 #include "../bml_allocate.h"
 #include "../bml_logger.h"
@@ -16,6 +17,8 @@
 #include "bml_types_dense.h"
 #include "bml_mptc_dense.cuh"
 
+#include <float.h>
+#include <math.h>
 #include <stdlib.h>
 #include <string.h>
 
@@ -129,7 +132,11 @@ void *TYPED_FUNC(
     double *trace = bml_allocate_memory(sizeof(double) * 2);
 
     trace[0] = TYPED_FUNC(bml_trace_dense) (X);
+#if defined(BML_MPTC) && !defined(BML_USE_MAGMA) && !defined(MKL_GPU)
+    TYPED_FUNC(bml_multiply_x2_split_dense) (X, X2, bml_get_mptc_slices());
+#else
     TYPED_FUNC(bml_multiply_dense) (X, X, X2, 1.0, 0.0);
+#endif
     trace[1] = TYPED_FUNC(bml_trace_dense) (X2);
 
     return trace;
@@ -178,3 +185,282 @@ void TYPED_FUNC(
     TYPED_FUNC(bml_gemm) ("T", "T", &A->N, &A->N, &A->N, &alpha, A->matrix,
                           &A->N, B->matrix, &A->N, &beta, C->matrix, &A->N);
 }
+
+/** Length of the blocks of the inner dimension of the split products.
+ *
+ * The single precision sums over one block are exact as long as twice
+ * the bits per slice plus log2 of the block length fit into the single
+ * precision mantissa, so shorter blocks allow wider slices.
+ */
+#ifndef BML_MPTC_KBLOCK
+#define BML_MPTC_KBLOCK 256
+#endif
+
+/* The split precision square runs on double precision host matrices. */
+#if (defined(DOUBLE_REAL) || defined(DOUBLE_COMPLEX)) \
+    && !defined(BML_USE_MAGMA) && !defined(MKL_GPU)
+#define BML_SPLIT_X2
+#endif
+
+#ifdef BML_SPLIT_X2
+
+#if defined(DOUBLE_REAL)
+#define SPLIT_T float
+#define SPLIT_GEMM bml_gemm_single_real
+#else
+#define SPLIT_T float complex
+#define SPLIT_GEMM bml_gemm_single_complex
+#endif
+
+/** Split a matrix into integer valued single precision slices.
+ *
+ * Every row (or column) a of X is scaled by a power of two so that its
+ * largest element is below 1, and then written as
+ *
+ * X(a, :) = scale[a] sum_s slice_s(a, :) 2^(-(s + 1) nbits)
+ *           + O(scale[a] 2^(-nslices nbits))
+ *
+ * with integer valued slices bounded by 2^nbits.
+ *
+ * \param N The matrix dimension
+ * \param X The row-major matrix
+ * \param by_row Scale by rows (1) or by columns (0)
+ * \param nslices The number of slices
+ * \param nbits The number of bits per slice
+ * \param scale The power of two of every row (or column)
+ * \param slices The nslices slices, N * N elements each
+ */
+static void TYPED_FUNC(
+    bml_split_dense) (
+    const int N,
+    const REAL_T * X,
+    const int by_row,
+    const int nslices,
+    const int nbits,
+    double *scale,
+    SPLIT_T * slices)
+{
+    double w[nslices];
+    double w_inv[nslices];
+    double *xmax = bml_allocate_memory(sizeof(double) * N);
+    double *scale_inv = bml_allocate_memory(sizeof(double) * N);
+
+    for (int s = 0; s < nslices; s++)
+    {
+        w[s] = ldexp(1.0, (s + 1) * nbits);
+        w_inv[s] = ldexp(1.0, -(s + 1) * nbits);
+    }
+
+    // largest element of every row (or column), traversing X by rows
+    for (int i = 0; i < N; i++)
+    {
+        for (int j = 0; j < N; j++)
+        {
+            REAL_T x = X[ROWMAJOR(i, j, N, N)];
+            double x_abs = fabs(REAL_PART(x));
+            double y_abs = fabs(IMAGINARY_PART(x));
+            x_abs = (y_abs > x_abs ? y_abs : x_abs);
+            int a = (by_row ? i : j);
+            xmax[a] = (x_abs > xmax[a] ? x_abs : xmax[a]);
+        }
+    }
+    for (int a = 0; a < N; a++)
+    {
+        int e;
+        frexp(xmax[a], &e);
+        scale[a] = ldexp(1.0, e);
+        scale_inv[a] = ldexp(1.0, -e);
+    }
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        for (int j = 0; j < N; j++)
+        {
+            REAL_T x = X[ROWMAJOR(i, j, N, N)];
+            double x_scale = (by_row ? scale_inv[i] : scale_inv[j]);
+            double re = REAL_PART(x) * x_scale;
+            double im = IMAGINARY_PART(x) * x_scale;
+            for (int s = 0; s < nslices; s++)
+            {
+                double q_re = rint(re * w[s]);
+                double q_im = rint(im * w[s]);
+                re -= q_re * w_inv[s];
+                im -= q_im * w_inv[s];
+#if defined(DOUBLE_REAL)
+                slices[(size_t) s * N * N + ROWMAJOR(i, j, N, N)] = q_re;
+#else
+                slices[(size_t) s * N * N + ROWMAJOR(i, j, N, N)] =
+                    q_re + q_im * I;
+#endif
+            }
+        }
+    }
+
+    bml_free_memory(xmax);
+    bml_free_memory(scale_inv);
+}
+
+#endif
+
+/** Split precision matrix square.
+ *
+ * X2 = X * X
+ *
+ * The double precision X is split into nslices single precision slices
+ * per operand (Ozaki scheme). The slice products of order below
+ * nslices are computed with the single precision gemm, exactly, one
+ * block of the inner dimension at a time, and are recombined in
+ * double precision. Each slice adds about 8 bits of accuracy; the
+ * error of X2 relative to its largest element is reported by
+ * bml_multiply_x2_split_error_dense. Single precision matrices, and
+ * nslices < 1, use the regular multiply.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X Matrix X
+ *  \param X2 Matrix X2
+ *  \param nslices Number of slices per operand
+ */
+void TYPED_FUNC(
+    bml_multiply_x2_split_dense) (
+    bml_matrix_dense_t * X,
+    bml_matrix_dense_t * X2,
+    int nslices)
+{
+#ifdef BML_SPLIT_X2
+    if (nslices < 1)
+    {
+        TYPED_FUNC(bml_multiply_dense) (X, X, X2, 1.0, 0.0);
+        return;
+    }
+
+    int N = X->N;
+    int kblock = MIN(N, BML_MPTC_KBLOCK);
+    int kbits = 0;
+    while ((1 << kbits) < kblock)
+    {
+        kbits++;
+    }
+#if defined(DOUBLE_COMPLEX)
+    // real and imaginary parts sum 2 products per term
+    kbits++;
+#endif
+    int nbits = (FLT_MANT_DIG - kbits) / 2;
+
+    size_t slice_size = (size_t) N * N;
+    double *row_scale = bml_allocate_memory(sizeof(double) * N);
+    double *col_scale = bml_allocate_memory(sizeof(double) * N);
+    SPLIT_T *left =
+        bml_noinit_allocate_memory(sizeof(SPLIT_T) * nslices * slice_size);
+    SPLIT_T *right =
+        bml_noinit_allocate_memory(sizeof(SPLIT_T) * nslices * slice_size);
+    SPLIT_T *product = bml_noinit_allocate_memory(sizeof(SPLIT_T) * slice_size);
+
+    // left operand scaled by rows, right operand scaled by columns
+    TYPED_FUNC(bml_split_dense) (N, X->matrix, 1, nslices, nbits, row_scale,
+                                 left);
+    TYPED_FUNC(bml_split_dense) (N, X->matrix, 0, nslices, nbits, col_scale,
+                                 right);
+
+    REAL_T *X2_matrix = X2->matrix;
+    REAL_T *order_sum = bml_noinit_allocate_memory(sizeof(REAL_T) * slice_size);
+    memset(X2_matrix, 0, sizeof(REAL_T) * slice_size);
+
+    // smallest terms first
+    const SPLIT_T one = 1;
+    const SPLIT_T zero = 0;
+    for (int order = nslices - 1; order >= 0; order--)
+    {
+        // the integer valued sums of one order are exact in double
+        memset(order_sum, 0, sizeof(REAL_T) * slice_size);
+        for (int k = 0; k < N; k += kblock)
+        {
+            int kc = MIN(kblock, N - k);
+            for (int s = 0; s <= order; s++)
+            {
+                SPLIT_T *L = left + s * slice_size;
+                SPLIT_T *R = right + (order - s) * slice_size;
+
+                // product = L(:, k:k+kc) * R(k:k+kc, :), row-major
+                SPLIT_GEMM("N", "N", &N, &N, &kc, &one, R + (size_t) k * N,
+                           &N, L + k, &N, &zero, product, &N);
+
+#pragma omp parallel for
+                for (size_t ij = 0; ij < slice_size; ij++)
+                {
+                    order_sum[ij] += product[ij];
+                }
+            }
+        }
+
+        double w = ldexp(1.0, -(order + 2) * nbits);
+#pragma omp parallel for
+        for (int i = 0; i < N; i++)
+        {
+            double wi = w * row_scale[i];
+            for (int j = 0; j < N; j++)
+            {
+                X2_matrix[ROWMAJOR(i, j, N, N)] +=
+                    order_sum[ROWMAJOR(i, j, N, N)] * (wi * col_scale[j]);
+            }
+        }
+    }
+
+    bml_free_memory(row_scale);
+    bml_free_memory(col_scale);
+    bml_free_memory(left);
+    bml_free_memory(right);
+    bml_free_memory(product);
+    bml_free_memory(order_sum);
+#else
+    (void) nslices;
+    TYPED_FUNC(bml_multiply_dense) (X, X, X2, 1.0, 0.0);
+#endif
+}
+
+/** Accuracy report of the split precision matrix square.
+ *
+ * Compares the split precision X * X against the regular multiply.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X Matrix X
+ *  \param nslices Number of slices per operand
+ *  \return The largest error of X * X relative to its largest element
+ */
+double TYPED_FUNC(
+    bml_multiply_x2_split_error_dense) (
+    bml_matrix_dense_t * X,
+    int nslices)
+{
+#if !defined(BML_USE_MAGMA) && !defined(MKL_GPU)
+    int N = X->N;
+    bml_matrix_dimension_t matrix_dimension = { N, N, N, NULL, 0 };
+    bml_matrix_dense_t *full =
+        TYPED_FUNC(bml_zero_matrix_dense) (matrix_dimension, sequential);
+    bml_matrix_dense_t *split =
+        TYPED_FUNC(bml_zero_matrix_dense) (matrix_dimension, sequential);
+
+    TYPED_FUNC(bml_multiply_dense) (X, X, full, 1.0, 0.0);
+    TYPED_FUNC(bml_multiply_x2_split_dense) (X, split, nslices);
+
+    REAL_T *full_matrix = full->matrix;
+    REAL_T *split_matrix = split->matrix;
+    double max_error = 0;
+    double max_value = 0;
+    for (int i = 0; i < N * N; i++)
+    {
+        max_error = fmax(max_error, ABS(split_matrix[i] - full_matrix[i]));
+        max_value = fmax(max_value, ABS(full_matrix[i]));
+    }
+
+    bml_deallocate_dense(full);
+    bml_deallocate_dense(split);
+
+    return max_value > 0 ? max_error / max_value : max_error;
+#else
+    LOG_ERROR("split precision accuracy report needs host matrices\n");
+    return 0;
+#endif
+}
@@ -128,6 +128,60 @@ bml_mpi_recv_dense(
     }
 }
 
+void
+bml_mpi_isend_dense(
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_dense_single_real(A, dst, comm);
+            break;
+        case double_real:
+            bml_mpi_isend_dense_double_real(A, dst, comm);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_dense_single_complex(A, dst, comm);
+            break;
+        case double_complex:
+            bml_mpi_isend_dense_double_complex(A, dst, comm);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+void
+bml_mpi_isend_complete_dense(
+    bml_matrix_dense_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_complete_dense_single_real(A);
+            break;
+        case double_real:
+            bml_mpi_isend_complete_dense_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_complete_dense_single_complex(A);
+            break;
+        case double_complex:
+            bml_mpi_isend_complete_dense_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 void
 bml_mpi_irecv_dense(
     bml_matrix_dense_t * A,
@@ -182,6 +236,20 @@ bml_mpi_irecv_complete_dense(
     }
 }
 
+/** Make progress on the nonblocking sends or receives of A.
+ *
+ *  \param A The matrix
+ *  \return Non-zero if they are done
+ */
+int
+bml_mpi_test_dense(
+    bml_matrix_dense_t * A)
+{
+    int flag;
+    MPI_Test(&A->req, &flag, MPI_STATUS_IGNORE);
+    return flag;
+}
+
 bml_matrix_dense_t *
 bml_mpi_recv_matrix_dense(
     bml_matrix_precision_t matrix_precision,
@@ -80,6 +80,40 @@ void bml_mpi_recv_dense_double_complex(
     const int src,
     MPI_Comm comm);
 
+void bml_mpi_isend_dense(
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm);
+
+void bml_mpi_isend_dense_single_real(
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_dense_double_real(
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_dense_single_complex(
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_dense_double_complex(
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm);
+
+void bml_mpi_isend_complete_dense(
+    bml_matrix_dense_t * A);
+
+void bml_mpi_isend_complete_dense_single_real(
+    bml_matrix_dense_t * A);
+void bml_mpi_isend_complete_dense_double_real(
+    bml_matrix_dense_t * A);
+void bml_mpi_isend_complete_dense_single_complex(
+    bml_matrix_dense_t * A);
+void bml_mpi_isend_complete_dense_double_complex(
+    bml_matrix_dense_t * A);
+
 void bml_mpi_irecv_dense(
     bml_matrix_dense_t * A,
     const int src,
@@ -114,6 +148,9 @@ void bml_mpi_irecv_complete_dense_single_complex(
 void bml_mpi_irecv_complete_dense_double_complex(
     bml_matrix_dense_t * A);
 
+int bml_mpi_test_dense(
+    bml_matrix_dense_t * A);
+
 bml_matrix_dense_t *bml_mpi_recv_matrix_dense(
     bml_matrix_precision_t matrix_precision,
     int N,
@@ -43,7 +43,7 @@ void TYPED_FUNC(
 
     MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
                    A_matrix, A_domain->localElements,
-                   A_domain->localDispl, REAL_MPI_TYPE, ccomm);
+                   A_domain->localDispl, MPI_T, ccomm);
 #endif
 }
 
@@ -118,6 +118,34 @@ void TYPED_FUNC(
 #endif
 }
 
+void TYPED_FUNC(
+    bml_mpi_isend_dense) (
+    bml_matrix_dense_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+#ifdef BML_USE_MAGMA
+    A->buffer = bml_allocate_memory(sizeof(MAGMA_T) * A->N * A->N);
+    MAGMA(getmatrix) (A->N, A->N, A->matrix, A->ld, A->buffer, A->N,
+                      bml_queue());
+    REAL_T *A_matrix = A->buffer;
+#else
+    REAL_T *A_matrix = A->matrix;
+#endif
+
+    MPI_Isend(A_matrix, A->N * A->N, MPI_T, dst, 222, comm, &A->req);
+}
+
+void TYPED_FUNC(
+    bml_mpi_isend_complete_dense) (
+    bml_matrix_dense_t * A)
+{
+    MPI_Wait(&A->req, MPI_STATUS_IGNORE);
+#ifdef BML_USE_MAGMA
+    free(A->buffer);
+#endif
+}
+
 void TYPED_FUNC(
     bml_mpi_irecv_dense) (
     bml_matrix_dense_t * A,
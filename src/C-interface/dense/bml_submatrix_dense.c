@@ -80,3 +80,41 @@ bml_assign_submatrix_dense(
             break;
     }
 }
+
+/** Assemble adjacency structure from matrix.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param xadj Index of each row in adjncy
+ * \param adjncy Adjacency vector
+ * \param base_flag Return 0- or 1-based
+ */
+void
+bml_adjacency_dense(
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_adjacency_dense_single_real(A, xadj, adjncy, base_flag);
+            break;
+        case double_real:
+            bml_adjacency_dense_double_real(A, xadj, adjncy, base_flag);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_adjacency_dense_single_complex(A, xadj, adjncy, base_flag);
+            break;
+        case double_complex:
+            bml_adjacency_dense_double_complex(A, xadj, adjncy, base_flag);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
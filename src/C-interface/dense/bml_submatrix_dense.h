@@ -68,4 +68,34 @@ void bml_assign_submatrix_dense_double_complex(
     int irow,
     int icol);
 
+void bml_adjacency_dense(
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_dense_single_real(
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_dense_double_real(
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_dense_single_complex(
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_dense_double_complex(
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
 #endif
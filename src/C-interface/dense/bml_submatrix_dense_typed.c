@@ -9,6 +9,7 @@
 
 #include <memory.h>
 #include <complex.h>
+#include <math.h>
 
 /** Extract submatrix into new matrix of same format
  *
@@ -84,3 +85,63 @@ void TYPED_FUNC(
     }
 #endif
 }
+
+/** Assemble adjacency structure from matrix.
+ *
+ * Every non-zero off-diagonal element is an edge, the neighbours of
+ * each row come out sorted.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param xadj Index of each row in adjncy
+ * \param adjncy Adjacency vector
+ * \param base_flag Return 0- or 1-based
+ */
+void TYPED_FUNC(
+    bml_adjacency_dense) (
+    bml_matrix_dense_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag)
+{
+    int A_N = A->N;
+    REAL_T *A_matrix = A->matrix;
+
+    xadj[0] = 0;
+    for (int i = 0; i < A_N; i++)
+    {
+        int nedges = 0;
+        for (int j = 0; j < A_N; j++)
+        {
+            if (j != i && ABS(A_matrix[ROWMAJOR(i, j, A_N, A_N)]) > 0)
+            {
+                nedges++;
+            }
+        }
+        xadj[i + 1] = xadj[i] + nedges;
+    }
+
+#pragma omp parallel for                        \
+  shared(A_N, A_matrix, xadj, adjncy)
+    for (int i = 0; i < A_N; i++)
+    {
+        int jp = xadj[i];
+        for (int j = 0; j < A_N; j++)
+        {
+            if (j != i && ABS(A_matrix[ROWMAJOR(i, j, A_N, A_N)]) > 0)
+            {
+                adjncy[jp] = j + base_flag;
+                jp++;
+            }
+        }
+    }
+
+    if (base_flag == 1)
+    {
+        for (int i = 0; i < A_N + 1; i++)
+        {
+            xadj[i] += 1;
+        }
+    }
+}
@@ -30,6 +30,10 @@ struct bml_matrix_dense_t
     bml_domain_t *domain;
     /** A copy of the domain decomposition. */
     bml_domain_t *domain2;
+    /** The binary file the arrays are mapped from, NULL if allocated. */
+    void *mapping;
+    /** The size of the mapping in bytes. */
+    size_t mapping_size;
 #ifdef DO_MPI
     /** Buffer for communications */
     void *buffer;
@@ -86,3 +86,69 @@ bml_print_bml_matrix_dense(
             break;
     }
 }
+
+void
+bml_write_bml_matrix_binary_dense(
+    bml_matrix_dense_t * A,
+    int fd)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_write_bml_matrix_binary_dense_single_real(A, fd);
+            break;
+        case double_real:
+            bml_write_bml_matrix_binary_dense_double_real(A, fd);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_write_bml_matrix_binary_dense_single_complex(A, fd);
+            break;
+        case double_complex:
+            bml_write_bml_matrix_binary_dense_double_complex(A, fd);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+bml_matrix_dense_t *
+bml_read_bml_matrix_binary_dense(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy)
+{
+    bml_binary_header_t *header = mapping;
+
+    switch (header->matrix_precision)
+    {
+        case single_real:
+            return
+                bml_read_bml_matrix_binary_dense_single_real(mapping,
+                                                             mapping_size,
+                                                             zero_copy);
+        case double_real:
+            return
+                bml_read_bml_matrix_binary_dense_double_real(mapping,
+                                                             mapping_size,
+                                                             zero_copy);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return
+                bml_read_bml_matrix_binary_dense_single_complex(mapping,
+                                                                mapping_size,
+                                                                zero_copy);
+        case double_complex:
+            return
+                bml_read_bml_matrix_binary_dense_double_complex(mapping,
+                                                                mapping_size,
+                                                                zero_copy);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
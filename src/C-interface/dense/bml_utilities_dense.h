@@ -83,4 +83,49 @@ void bml_write_bml_matrix_dense_double_complex(
     bml_matrix_dense_t * A,
     char *filename);
 
+void bml_write_bml_matrix_binary_dense(
+    bml_matrix_dense_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_dense_single_real(
+    bml_matrix_dense_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_dense_double_real(
+    bml_matrix_dense_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_dense_single_complex(
+    bml_matrix_dense_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_dense_double_complex(
+    bml_matrix_dense_t * A,
+    int fd);
+
+bml_matrix_dense_t *bml_read_bml_matrix_binary_dense(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_dense_t *bml_read_bml_matrix_binary_dense_single_real(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_dense_t *bml_read_bml_matrix_binary_dense_double_real(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_dense_t *bml_read_bml_matrix_binary_dense_single_complex(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_dense_t *bml_read_bml_matrix_binary_dense_double_complex(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
 #endif
@@ -29,12 +29,6 @@ void TYPED_FUNC(
     bml_matrix_dense_t * A,
     char *filename)
 {
-    FILE *matrix_file;
-    char header1[20], header2[20], header3[20], header4[20], header5[20];
-    int hdimx, nnz, irow, icol;
-    int values_read;
-    double real_part, imaginary_part;
-
     int N = A->N;
 
 #ifdef BML_USE_MAGMA
@@ -43,67 +37,26 @@ void TYPED_FUNC(
     REAL_T *A_matrix = A->matrix;
 #endif
 
-    matrix_file = fopen(filename, "r");
-
-    // Read header
-    if ((values_read = fscanf
-         (matrix_file, "%s %s %s %s %s", header1, header2, header3, header4,
-          header5)) < 5)
-    {
-        LOG_ERROR("Line 1, expected 5 entries, read %d\n", values_read);
-    }
+    int file_N;
+    int *row_ptr;
+    int *cols;
+    REAL_T *vals;
 
-    // Read N, N, # of non-zeroes
-    if ((values_read =
-         fscanf(matrix_file, "%d %d %d", &hdimx, &hdimx, &nnz)) < 3)
+    bml_read_compressed_rows(filename, A->matrix_precision, &file_N,
+                             &row_ptr, &cols, (void **) &vals);
+    if (file_N != N)
     {
-        LOG_ERROR("Line 2, Expected 3 entries, read %d\n", values_read);
+        LOG_ERROR("%s holds a matrix of size %d, expected %d\n", filename,
+                  file_N, N);
     }
 
-    // Read in values
-    for (int i = 0; i < nnz; i++)
+#pragma omp parallel for shared(A_matrix)
+    for (int i = 0; i < N; i++)
     {
-#if defined(SINGLE_REAL)
-        if ((values_read =
-             fscanf(matrix_file, "%d %d %lg\n", &irow, &icol,
-                    &real_part)) < 3)
-        {
-            LOG_ERROR("Line %d, expected 3 entries, read %d\n", i + 3,
-                      values_read);
-        }
-        A_matrix[ROWMAJOR(irow - 1, icol - 1, N, N)] = real_part;
-#elif defined(DOUBLE_REAL)
-        if ((values_read =
-             fscanf(matrix_file, "%d %d %lg\n", &irow, &icol,
-                    &real_part)) < 3)
+        for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
         {
-            LOG_ERROR("Line %d, expected 3 entries, read %d\n", i + 3,
-                      values_read);
+            A_matrix[ROWMAJOR(i, cols[k], N, N)] = vals[k];
         }
-        A_matrix[ROWMAJOR(irow - 1, icol - 1, N, N)] = real_part;
-#elif defined(SINGLE_COMPLEX)
-        if ((values_read =
-             fscanf(matrix_file, "%d %d %lg %lg\n", &irow, &icol, &real_part,
-                    &imaginary_part)) < 4)
-        {
-            LOG_ERROR("Line %d, expected 4 entries, read %d\n", i + 3,
-                      values_read);
-        }
-        A_matrix[ROWMAJOR(irow - 1, icol - 1, N, N)] =
-            real_part + I * imaginary_part;
-#elif defined(DOUBLE_COMPLEX)
-        if ((values_read =
-             fscanf(matrix_file, "%d %d %lg %lg\n", &irow, &icol, &real_part,
-                    &imaginary_part)) < 4)
-        {
-            LOG_ERROR("Line %d, expected 4 entries, read %d\n", i + 3,
-                      values_read);
-        }
-        A_matrix[ROWMAJOR(irow - 1, icol - 1, N, N)] =
-            real_part + I * imaginary_part;
-#else
-        LOG_ERROR("unknown precision\n");
-#endif
     }
 
 #ifdef BML_USE_MAGMA
@@ -115,7 +68,9 @@ void TYPED_FUNC(
 // push back to GPU
 #pragma omp target update to(A_matrix[0:N*N])
 #endif
-    fclose(matrix_file);
+    bml_free_memory(row_ptr);
+    bml_free_memory(cols);
+    bml_free_memory(vals);
 }
 
 /** Write a Matrix Market format file from a bml matrix.
@@ -229,3 +184,111 @@ void TYPED_FUNC(
     bml_free_memory(A_matrix);
 #endif
 }
+
+/** Write a bml matrix to a binary file.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param A The matrix to be written
+ *  \param fd The file descriptor of the binary file
+ */
+void TYPED_FUNC(
+    bml_write_bml_matrix_binary_dense) (
+    bml_matrix_dense_t * A,
+    int fd)
+{
+    int N = A->N;
+    bml_binary_header_t header;
+
+#ifdef BML_USE_MAGMA
+    REAL_T *A_matrix = bml_allocate_memory(sizeof(REAL_T) * N * N);
+    MAGMA(getmatrix) (N, N, A->matrix, A->ld, (MAGMA_T *) A_matrix, N,
+                      bml_queue());
+#else
+    REAL_T *A_matrix = (REAL_T *) A->matrix;
+#ifdef MKL_GPU
+// pull from GPU
+#pragma omp target update from(A_matrix[0:N*N])
+#endif
+#endif
+
+    bml_init_binary_header(&header, dense, A->matrix_precision, N, N);
+    header.nvalues = (int64_t) N * N;
+    bml_write_binary_section(fd, &header, sizeof(bml_binary_header_t));
+    bml_write_binary_section(fd, A_matrix, sizeof(REAL_T) * N * N);
+
+#ifdef BML_USE_MAGMA
+    bml_free_memory(A_matrix);
+#endif
+}
+
+/** Read a bml matrix from a mapped binary file.
+ *
+ *  The matrix either keeps the mapping or the mapping is unmapped.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param mapping The mapped file
+ *  \param mapping_size The size of the file in bytes
+ *  \param zero_copy Whether to use the array of the mapping in place
+ *  \return The matrix
+ */
+bml_matrix_dense_t *TYPED_FUNC(
+    bml_read_bml_matrix_binary_dense) (
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy)
+{
+    bml_binary_header_t *header = mapping;
+    int N = header->N;
+    size_t offset = 0;
+
+    bml_binary_section(mapping, mapping_size, &offset,
+                       sizeof(bml_binary_header_t));
+    REAL_T *matrix = bml_binary_section(mapping, mapping_size, &offset,
+                                        sizeof(REAL_T) * N * N);
+
+    // The device copy of the matrix needs an allocated matrix
+#if !defined(BML_USE_MAGMA) && !defined(MKL_GPU)
+    if (zero_copy)
+    {
+        bml_matrix_dense_t *A =
+            bml_allocate_memory(sizeof(bml_matrix_dense_t));
+        A->matrix_type = dense;
+        A->matrix_precision = MATRIX_PRECISION;
+        A->distribution_mode = sequential;
+        A->N = N;
+        A->ld = N;
+        A->matrix = matrix;
+        A->domain = bml_default_domain(N, N, sequential);
+        A->domain2 = bml_default_domain(N, N, sequential);
+        A->mapping = mapping;
+        A->mapping_size = mapping_size;
+        return A;
+    }
+#endif
+
+    bml_matrix_dimension_t matrix_dimension = { N, N, N, NULL, 0 };
+    bml_matrix_dense_t *A =
+        TYPED_FUNC(bml_zero_matrix_dense) (matrix_dimension, sequential);
+#ifdef BML_USE_MAGMA
+    MAGMA(setmatrix) (N, N, (MAGMA_T *) matrix, N, A->matrix, A->ld,
+                      bml_queue());
+#else
+    REAL_T *A_matrix = (REAL_T *) A->matrix;
+
+#pragma omp parallel for shared(A_matrix)
+    for (int i = 0; i < N; i++)
+    {
+        memcpy(&A_matrix[ROWMAJOR(i, 0, N, N)], &matrix[ROWMAJOR(i, 0, N, N)],
+               sizeof(REAL_T) * N);
+    }
+#ifdef MKL_GPU
+// push back to GPU
+#pragma omp target update to(A_matrix[0:N*N])
+#endif
+#endif
+
+    bml_unmap_binary_file(mapping, mapping_size);
+    return A;
+}
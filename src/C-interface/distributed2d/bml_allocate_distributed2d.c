@@ -4,42 +4,194 @@
 #include "../bml_types.h"
 #include "../bml_logger.h"
 #include "../bml_utilities.h"
+#include "../bml_introspection.h"
+#include "../bml_getters.h"
+#include "../bml_setters.h"
+#include "../../macros.h"
 #include "bml_allocate_distributed2d.h"
+#include "bml_setters_distributed2d.h"
 #include "bml_types_distributed2d.h"
 
 #include <assert.h>
 #include <math.h>
+#include <string.h>
 
 /* MPI communicator for all the distributed2d matrices */
 static MPI_Comm s_comm = MPI_COMM_NULL;
 static MPI_Comm r_comm = MPI_COMM_NULL;
 static MPI_Comm c_comm = MPI_COMM_NULL;
 
+/* communicator the grids were built from, and the 2.5D replication */
+static MPI_Comm s_base_comm = MPI_COMM_NULL;
+static MPI_Comm s_depth_comm = MPI_COMM_NULL;
+static int s_nlayers = 1;
+
+/* shape of the grid of every layer, 0 for a dimension chosen by MPI */
+static int s_nprows = 0;
+static int s_npcols = 0;
+
 void
 bml_setcomm_distributed2d(
     MPI_Comm comm)
 {
+    s_base_comm = comm;
+
+    // release the grid set up before, the matrices allocated on it
+    // must have been deallocated
+    if (s_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&s_comm);
+    if (s_depth_comm != MPI_COMM_NULL)
+        MPI_Comm_free(&s_depth_comm);
+
     // create new communicator
     int ntasks;
     MPI_Comm_size(comm, &ntasks);
     int mytask;
     MPI_Comm_rank(comm, &mytask);
-    int p = bml_sqrtint(ntasks);
-    if (p * p != ntasks)
+
+    // split the tasks into s_nlayers consecutive copies of the grid
+    if (ntasks % s_nlayers != 0)
     {
-        LOG_ERROR
-            ("p=%d: invalid number of tasks. Must be an integer square.\n",
-             p);
+        LOG_ERROR("%d tasks can not be split into %d layers\n", ntasks,
+                  s_nlayers);
     }
-    int dims[2] = { p, p };
+    int layer_size = ntasks / s_nlayers;
+    MPI_Comm layer_comm;
+    MPI_Comm_split(comm, mytask / layer_size, mytask, &layer_comm);
+    MPI_Comm_split(comm, mytask % layer_size, mytask, &s_depth_comm);
+    ntasks = layer_size;
+    mytask = mytask % layer_size;
+
+    // arrange the tasks of a layer in a grid, as square as possible
+    // unless set by bml_set_grid_distributed2d
+    if ((s_nprows > 0 && ntasks % s_nprows != 0)
+        || (s_npcols > 0 && ntasks % s_npcols != 0)
+        || (s_nprows > 0 && s_npcols > 0 && s_nprows * s_npcols != ntasks))
+    {
+        LOG_ERROR("%d tasks can not be arranged in a %d x %d grid\n",
+                  ntasks, s_nprows, s_npcols);
+    }
+    int dims[2] = { s_nprows, s_npcols };
+    MPI_Dims_create(ntasks, 2, dims);
     int periods[2] = { 1, 1 };
     int reorder = 0;
-    MPI_Cart_create(comm, 2, dims, periods, reorder, &s_comm);
+    MPI_Cart_create(layer_comm, 2, dims, periods, reorder, &s_comm);
+    MPI_Comm_free(&layer_comm);
 
-    // use seed based on task ID
+    // use seed based on task ID, the same in all the layers
     srand(13 * mytask + 17);
 }
 
+/** Set the replication factor of the 2.5D multiply.
+ *
+ * The tasks are split into nlayers copies of an nprows x npcols grid,
+ * with nlayers * nprows * npcols tasks in total. Every layer holds all
+ * distributed2d matrices and computes its share of the Cannon steps or
+ * SUMMA panels of a multiply, the partial products are then summed
+ * over the layers. Affects the matrices allocated afterwards, the
+ * ones allocated before have to be deallocated first. May be called
+ * before bml_init.
+ *
+ * \param nlayers The number of copies of the grid
+ */
+void
+bml_set_replication_distributed2d(
+    int nlayers)
+{
+    assert(nlayers > 0);
+
+    s_nlayers = nlayers;
+    if (s_base_comm != MPI_COMM_NULL)
+        bml_setcomm_distributed2d(s_base_comm);
+}
+
+/** Set the shape of the process grid.
+ *
+ * The tasks of every layer are arranged in an nprows x npcols grid,
+ * N has to be a multiple of both. A dimension of 0 is chosen by
+ * MPI_Dims_create, by default the grid is as close to square as the
+ * number of tasks allows. Affects the matrices allocated afterwards,
+ * the ones allocated before have to be deallocated first. May be
+ * called before bml_init.
+ *
+ * \param nprows The number of process rows, or 0
+ * \param npcols The number of process columns, or 0
+ */
+void
+bml_set_grid_distributed2d(
+    int nprows,
+    int npcols)
+{
+    assert(nprows >= 0);
+    assert(npcols >= 0);
+
+    s_nprows = nprows;
+    s_npcols = npcols;
+    if (s_base_comm != MPI_COMM_NULL)
+        bml_setcomm_distributed2d(s_base_comm);
+}
+
+/** Get the replication factor of the 2.5D multiply.
+ *
+ * \return The number of copies of the grid
+ */
+int
+bml_get_replication_distributed2d(
+    void)
+{
+    return s_nlayers;
+}
+
+/* size of a matrix element */
+static size_t
+bml_element_size_distributed2d(
+    bml_matrix_precision_t matrix_precision)
+{
+    size_t element_size = 0;
+    switch (matrix_precision)
+    {
+        case single_real:
+            element_size = sizeof(float);
+            break;
+        case double_real:
+            element_size = sizeof(double);
+            break;
+        case single_complex:
+            element_size = 2 * sizeof(float);
+            break;
+        case double_complex:
+            element_size = 2 * sizeof(double);
+            break;
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return element_size;
+}
+
+/** Memory of the local submatrix of A on every task.
+ *
+ * Estimated from the storage of the local format, nnz padding
+ * included. Summed over all tasks this gives nlayers times the
+ * memory of one copy of A, the price of the 2.5D multiply.
+ *
+ * \param A The matrix
+ * \return The number of bytes per task
+ */
+size_t
+bml_local_memory_distributed2d(
+    bml_matrix_distributed2d_t * A)
+{
+    size_t n = bml_get_N(A->matrix);
+    size_t m = bml_get_M(A->matrix);
+    size_t element_size =
+        bml_element_size_distributed2d(A->matrix_precision);
+    if (bml_get_type(A->matrix) == dense)
+        return n * n * element_size;
+    // values and column indices, plus the non-zeros per row
+    return n * m * (element_size + sizeof(int)) + n * sizeof(int);
+}
+
 // set various fields in matrix struct
 void
 bml_setup_distributed2d(
@@ -58,22 +210,92 @@ bml_setup_distributed2d(
     MPI_Comm_rank(A->comm, &mytask);
     A->mpitask = mytask;
 
+    int dims[2];
+    int periods[2];
     int coords[2];
-    MPI_Cart_coords(A->comm, A->mpitask, 2, coords);
+    MPI_Cart_get(A->comm, 2, dims, periods, coords);
 
-    int p = bml_sqrtint(ntasks);
-    A->nprows = p;
-    A->npcols = p;
+    A->nprows = dims[0];
+    A->npcols = dims[1];
     A->myprow = coords[0];
     A->mypcol = coords[1];
     A->N = N;
-    A->n = N / p;
+    A->nr = N / A->nprows;
+    A->nc = N / A->npcols;
+    A->n = MAX(A->nr, A->nc);
     A->matrix_type = distributed2d;
 
     MPI_Comm_split(A->comm, A->myprow, A->mypcol, &A->row_comm);
     MPI_Comm_split(A->comm, A->mypcol, A->myprow, &A->col_comm);
 
-    assert(A->n * p == N);
+    A->depth_comm = s_depth_comm;
+    A->nlayers = s_nlayers;
+    MPI_Comm_rank(s_depth_comm, &A->mylayer);
+
+    assert(A->nr * A->nprows == N);
+    assert(A->nc * A->npcols == N);
+}
+
+/** Number of non-zeros per row of the local submatrix.
+ *
+ * \param A The matrix
+ * \param M The number of non-zeros per row of the whole matrix
+ * \return The share of M of the local columns
+ */
+int
+bml_local_M_distributed2d(
+    bml_matrix_distributed2d_t * A,
+    int M)
+{
+    return M / A->npcols;
+}
+
+/** Local rows holding elements of the diagonal.
+ *
+ * Local row i holds the diagonal element in local column i + offset
+ * for ilo <= i < ihi, the range is empty if the block of the task
+ * does not cross the diagonal.
+ *
+ * \param A The matrix
+ * \param ilo First local row holding a diagonal element
+ * \param ihi Last local row holding a diagonal element, plus one
+ * \param offset Local column minus local row of the diagonal
+ */
+void
+bml_local_diagonal_distributed2d(
+    bml_matrix_distributed2d_t * A,
+    int *ilo,
+    int *ihi,
+    int *offset)
+{
+    *offset = A->myprow * A->nr - A->mypcol * A->nc;
+    *ilo = MAX(0, -*offset);
+    *ihi = MAX(*ilo, MIN(A->nr, A->nc - *offset));
+}
+
+/** Zero the local submatrix beyond its nr rows and nc columns.
+ *
+ * Only a non-square grid pads the local submatrices.
+ *
+ * \param A The matrix
+ */
+void
+bml_clear_padding_distributed2d(
+    bml_matrix_distributed2d_t * A)
+{
+    if (A->nr == A->n && A->nc == A->n)
+        return;
+
+    size_t element_size =
+        bml_element_size_distributed2d(A->matrix_precision);
+    for (int i = 0; i < A->n; i++)
+    {
+        char *row = bml_get_row(A->matrix, i);
+        int j0 = (i < A->nr) ? A->nc : 0;
+        memset(row + j0 * element_size, 0, (A->n - j0) * element_size);
+        bml_set_row(A->matrix, i, row, 0.);
+        bml_free_memory(row);
+    }
 }
 
 /** Deallocate a matrix.
@@ -89,6 +311,11 @@ bml_deallocate_distributed2d(
     assert(A != NULL);
     assert(A->matrix != NULL);
     bml_deallocate(&(A->matrix));
+    for (int i = 0; i < 5; i++)
+    {
+        if (A->shift_buffer[i] != NULL)
+            bml_deallocate(&(A->shift_buffer[i]));
+    }
     bml_free_memory(A);
 }
 
@@ -133,7 +360,7 @@ bml_zero_matrix_distributed2d(
     bml_setup_distributed2d(N, A);
     A->M = M;
     A->matrix_precision = matrix_precision;
-    int m = M / bml_sqrtint(A->ntasks);
+    int m = bml_local_M_distributed2d(A, M);
     A->matrix =
         bml_zero_matrix(matrix_type, matrix_precision, A->n, m, sequential);
     return A;
@@ -166,9 +393,10 @@ bml_random_matrix_distributed2d(
     bml_setup_distributed2d(N, A);
     A->M = M;
     A->matrix_precision = matrix_precision;
-    int m = M / bml_sqrtint(A->ntasks);
+    int m = bml_local_M_distributed2d(A, M);
     A->matrix =
         bml_random_matrix(matrix_type, matrix_precision, A->n, m, sequential);
+    bml_clear_padding_distributed2d(A);
     return A;
 }
 
@@ -199,13 +427,24 @@ bml_identity_matrix_distributed2d(
     bml_setup_distributed2d(N, A);
     A->M = M;
     A->matrix_precision = matrix_precision;
-    int m = M / bml_sqrtint(A->ntasks);
-    A->matrix = (A->myprow == A->mypcol) ?
-        bml_identity_matrix(matrix_type, matrix_precision, A->n, m,
-                            sequential) : bml_zero_matrix(matrix_type,
-                                                          matrix_precision,
-                                                          A->n, m,
-                                                          sequential);
+    int m = bml_local_M_distributed2d(A, M);
+    if (A->nprows == A->npcols)
+    {
+        A->matrix = (A->myprow == A->mypcol) ?
+            bml_identity_matrix(matrix_type, matrix_precision, A->n, m,
+                                sequential) : bml_zero_matrix(matrix_type,
+                                                              matrix_precision,
+                                                              A->n, m,
+                                                              sequential);
+    }
+    else
+    {
+        // the diagonal crosses the blocks off their local diagonals
+        A->matrix =
+            bml_zero_matrix(matrix_type, matrix_precision, A->n, m,
+                            sequential);
+        bml_add_diagonal_distributed2d(A, 1.);
+    }
 
     return A;
 }
@@ -3,13 +3,41 @@
 
 #include "bml_types_distributed2d.h"
 
+#include <stddef.h>
+
 void bml_setcomm_distributed2d(
     MPI_Comm comm);
 
+void bml_set_replication_distributed2d(
+    int nlayers);
+
+int bml_get_replication_distributed2d(
+    void);
+
+void bml_set_grid_distributed2d(
+    int nprows,
+    int npcols);
+
+size_t bml_local_memory_distributed2d(
+    bml_matrix_distributed2d_t * A);
+
 void bml_setup_distributed2d(
     const int N,
     bml_matrix_distributed2d_t * A);
 
+int bml_local_M_distributed2d(
+    bml_matrix_distributed2d_t * A,
+    int M);
+
+void bml_local_diagonal_distributed2d(
+    bml_matrix_distributed2d_t * A,
+    int *ilo,
+    int *ihi,
+    int *offset);
+
+void bml_clear_padding_distributed2d(
+    bml_matrix_distributed2d_t * A);
+
 void bml_deallocate_distributed2d(
     bml_matrix_distributed2d_t * A);
 
@@ -146,6 +146,14 @@ void TYPED_FUNC(
     bml_matrix_distributed2d_t * eigenvectors)
 {
 #ifdef BML_USE_SCALAPACK
+    // the local submatrices are the square blocks of the ScaLAPACK
+    // distribution, which leaves out the padded non-square grids
+    if (A->nprows != A->npcols)
+    {
+        LOG_ERROR("diagonalization needs a square process grid, "
+                  "not %d x %d\n", A->nprows, A->npcols);
+    }
+
     REAL_T *typed_eigenvalues = (REAL_T *) eigenvalues;
     // distributed2d format uses a row block distribution
     char order = 'R';
@@ -32,6 +32,10 @@ void *TYPED_FUNC(
     int N = A_bml->N;
     int n = A_bml->n;
 
+    // rows and columns held by a task, as LACPY sees them
+    int lm = (order == dense_row_major) ? A_bml->nc : A_bml->nr;
+    int ln = (order == dense_row_major) ? A_bml->nr : A_bml->nc;
+
     REAL_T *A_dense = NULL;
     if (myrank == 0)
         A_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
@@ -49,7 +53,7 @@ void *TYPED_FUNC(
     else
     {
         // copy local data into A_dense
-        C_BLAS(LACPY) ("A", &n, &n, sendbuf, &n, A_dense, &N);
+        C_BLAS(LACPY) ("A", &lm, &ln, sendbuf, &n, A_dense, &N);
         REAL_T **recvbuf =
             bml_allocate_memory((ntasks - 1) * sizeof(REAL_T *));
         MPI_Request *request =
@@ -66,9 +70,12 @@ void *TYPED_FUNC(
             MPI_Cart_coords(A_bml->comm, src, 2, coords);
             int ip = coords[0];
             int jp = coords[1];
+            int offset = (order == dense_row_major) ?
+                N * A_bml->nr * ip + A_bml->nc * jp :
+                A_bml->nr * ip + N * A_bml->nc * jp;
             MPI_Wait(&request[src - 1], &status);
-            C_BLAS(LACPY) ("A", &n, &n, recvbuf[src - 1], &n,
-                           A_dense + n * N * ip + n * jp, &N);
+            C_BLAS(LACPY) ("A", &lm, &ln, recvbuf[src - 1], &n,
+                           A_dense + offset, &N);
         }
         for (int src = 1; src < ntasks; src++)
         {
@@ -11,7 +11,7 @@ void *TYPED_FUNC(
     bml_matrix_distributed2d_t * A,
     int i)
 {
-    const int nloc = A->N / A->nprows;
+    const int nloc = A->nr;
     // allocate full row to be returned
     REAL_T *row = bml_allocate_memory(A->N * sizeof(REAL_T));
 
@@ -24,7 +24,8 @@ void *TYPED_FUNC(
     {
         int irow = i - A->myprow * nloc;
         sub_row = bml_get_row(A->matrix, irow);
-        mycount = nloc;
+        // the local columns, without the padding of the submatrix
+        mycount = A->nc;
     }
 
     int *recvcounts = calloc(A->ntasks, sizeof(int));
@@ -42,15 +42,20 @@ bml_matrix_distributed2d_t *TYPED_FUNC(
     bml_setup_distributed2d(N, A_bml);
     assert(A_bml->comm != MPI_COMM_NULL);
     A_bml->M = M;
+    A_bml->matrix_precision = MATRIX_PRECISION;
 
     // local submatrix dimensions
     int n = A_bml->n;
     int myrank = A_bml->mpitask;
     int ntasks = A_bml->ntasks;
-    int m = M / bml_sqrtint(ntasks);
+    int m = bml_local_M_distributed2d(A_bml, M);
     assert(m <= n);
     assert(m > 0);
 
+    // rows and columns held by a task, as LACPY sees them
+    int lm = (order == dense_row_major) ? A_bml->nc : A_bml->nr;
+    int ln = (order == dense_row_major) ? A_bml->nr : A_bml->nc;
+
     REAL_T *recvbuf = bml_allocate_memory(n * n * sizeof(REAL_T));
     int tag = 0;
     MPI_Status status;
@@ -68,15 +73,18 @@ bml_matrix_distributed2d_t *TYPED_FUNC(
             int ip = coords[0];
             int jp = coords[1];
             // pack data into buffer
+            int offset = (order == dense_row_major) ?
+                N * A_bml->nr * ip + A_bml->nc * jp :
+                A_bml->nr * ip + N * A_bml->nc * jp;
             sendbuf[dest - 1] = bml_allocate_memory(n * n * sizeof(REAL_T));
             REAL_T *array = (REAL_T *) (A);
-            C_BLAS(LACPY) ("A", &n, &n, array + N * n * ip + n * jp, &N,
+            C_BLAS(LACPY) ("A", &lm, &ln, array + offset, &N,
                            sendbuf[dest - 1], &n);
             MPI_Isend(sendbuf[dest - 1], n * n, MPI_T, dest, tag, A_bml->comm,
                       &request[dest - 1]);
         }
         // put local data into recvbuf
-        C_BLAS(LACPY) ("A", &n, &n, A, &N, recvbuf, &n);
+        C_BLAS(LACPY) ("A", &lm, &ln, A, &N, recvbuf, &n);
         for (int dest = 1; dest < ntasks; dest++)
         {
             MPI_Wait(&request[dest - 1], &status);
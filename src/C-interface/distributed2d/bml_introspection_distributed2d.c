@@ -115,9 +115,9 @@ bml_get_sparsity_distributed2d(
     bml_matrix_distributed2d_t * A,
     double threshold)
 {
+    // the zeros of the padding of the local submatrix do not count
     double sp = bml_get_sparsity(A->matrix, threshold);
-    int nloc = A->N / A->nprows;
-    sp *= nloc * nloc;
+    sp = sp * A->n * A->n - (A->n * A->n - A->nr * A->nc);
 
     bml_sumRealReduce(&sp);
     sp /= (A->N * A->N);
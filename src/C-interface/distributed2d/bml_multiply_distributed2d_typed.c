@@ -5,6 +5,9 @@
 #include "../bml_logger.h"
 #include "../bml_copy.h"
 #include "../bml_parallel.h"
+#include "../bml_introspection.h"
+#include "../bml_scale.h"
+#include "../bml_add.h"
 
 #include "bml_allocate_distributed2d.h"
 #include "bml_types_distributed2d.h"
@@ -12,94 +15,510 @@
 #include <stdlib.h>
 #include <assert.h>
 #include <mpi.h>
+#include <pthread.h>
+#include <sched.h>
 #include <stdio.h>
 
-/** Matrix multiply using Cannon's algorithm.
- *
- * C = alpha * A * B + beta * C
+/* Return a buffer shaped like A, reusing *buffer when it still fits.
+ */
+static bml_matrix_t *TYPED_FUNC(
+    bml_shift_buffer_distributed2d) (
+    bml_matrix_t ** buffer,
+    bml_matrix_t * A)
+{
+    if (*buffer != NULL
+        && (bml_get_type(*buffer) != bml_get_type(A)
+            || bml_get_precision(*buffer) != bml_get_precision(A)
+            || bml_get_N(*buffer) != bml_get_N(A)
+            || bml_get_M(*buffer) != bml_get_M(A)))
+    {
+        bml_deallocate(buffer);
+    }
+    if (*buffer == NULL)
+        *buffer = bml_copy_new(A);
+    return *buffer;
+}
+
+/* Return non-zero if the local submatrix A has no stored elements.
+ */
+static int TYPED_FUNC(
+    bml_block_is_empty_distributed2d) (
+    bml_matrix_t * A)
+{
+    return bml_get_bandwidth(A) == 0;
+}
+
+/* A shift sends a one int header, whether the submatrix has stored
+ * elements, ahead of the submatrix and skips the submatrix itself when
+ * it is empty. The submatrix is received once its header is in.
+ */
+typedef struct
+{
+    bml_matrix_t *src;
+    bml_matrix_t *dst_buffer;
+    int src_task;
+    MPI_Comm comm;
+    int send_flag;
+    int recv_flag;
+    int posted;
+    MPI_Request header_req[2];
+} bml_shift_t;
+
+/* Make progress on a shift without blocking, posting the receive of
+ * the submatrix when its header is in. Return non-zero when all the
+ * messages of the shift are done.
+ */
+static int TYPED_FUNC(
+    bml_shift_progress_distributed2d) (
+    bml_shift_t * shift)
+{
+    int done;
+    if (!shift->posted)
+    {
+        MPI_Test(&shift->header_req[0], &done, MPI_STATUS_IGNORE);
+        if (!done)
+            return 0;
+        shift->posted = 1;
+        if (shift->recv_flag)
+            bml_mpi_irecv(shift->dst_buffer, shift->src_task, shift->comm);
+    }
+    MPI_Test(&shift->header_req[1], &done, MPI_STATUS_IGNORE);
+    if (shift->recv_flag)
+        done = bml_mpi_test(shift->dst_buffer) && done;
+    if (shift->send_flag)
+        done = bml_mpi_test(shift->src) && done;
+    return done;
+}
+
+/* Start moving the local submatrix src to the task dst, while
+ * receiving into dst_buffer from the task src_task.
+ */
+static void TYPED_FUNC(
+    bml_shift_start_distributed2d) (
+    bml_matrix_t * src,
+    bml_matrix_t * dst_buffer,
+    int src_task,
+    int dst_task,
+    MPI_Comm comm,
+    bml_shift_t * shift)
+{
+    shift->src = src;
+    shift->dst_buffer = dst_buffer;
+    shift->src_task = src_task;
+    shift->comm = comm;
+    shift->send_flag = !TYPED_FUNC(bml_block_is_empty_distributed2d) (src);
+    shift->posted = 0;
+    MPI_Irecv(&shift->recv_flag, 1, MPI_INT, src_task, 110, comm,
+              &shift->header_req[0]);
+    MPI_Isend(&shift->send_flag, 1, MPI_INT, dst_task, 110, comm,
+              &shift->header_req[1]);
+    if (shift->send_flag)
+        bml_mpi_isend(src, dst_task, comm);
+    TYPED_FUNC(bml_shift_progress_distributed2d) (shift);
+}
+
+static void TYPED_FUNC(
+    bml_shift_complete_distributed2d) (
+    bml_shift_t * shift)
+{
+    if (!shift->posted)
+    {
+        MPI_Wait(&shift->header_req[0], MPI_STATUS_IGNORE);
+        shift->posted = 1;
+        if (shift->recv_flag)
+            bml_mpi_irecv(shift->dst_buffer, shift->src_task, shift->comm);
+    }
+    if (shift->recv_flag)
+        bml_mpi_irecv_complete(shift->dst_buffer);
+    else
+        bml_clear(shift->dst_buffer);
+    if (shift->send_flag)
+        bml_mpi_isend_complete(shift->src);
+    MPI_Wait(&shift->header_req[1], MPI_STATUS_IGNORE);
+}
+
+/* Body of the progress thread, polls the shifts of A and B until they
+ * are done.
+ */
+static void *TYPED_FUNC(
+    bml_shift_thread_distributed2d) (
+    void *arg)
+{
+    bml_shift_t *shift = arg;
+    for (;;)
+    {
+        int doneA = TYPED_FUNC(bml_shift_progress_distributed2d) (shift);
+        int doneB =
+            TYPED_FUNC(bml_shift_progress_distributed2d) (shift + 1);
+        if (doneA && doneB)
+            break;
+        sched_yield();
+    }
+    return NULL;
+}
+
+/* Return non-zero if a progress thread may drive the shifts, see
+ * bml_set_multiply_progress_thread.
+ */
+static int TYPED_FUNC(
+    bml_use_progress_thread_distributed2d) (
+    void)
+{
+    if (!bml_get_multiply_progress_thread())
+        return 0;
+    int level;
+    MPI_Query_thread(&level);
+    return level >= MPI_THREAD_SERIALIZED;
+}
+
+/* C = alpha * A * B + beta * C for local submatrices, skipping the
+ * product when A or B is empty.
+ */
+static void TYPED_FUNC(
+    bml_multiply_block_distributed2d) (
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    bml_matrix_t * C,
+    double alpha,
+    double beta,
+    double threshold)
+{
+    if (!TYPED_FUNC(bml_block_is_empty_distributed2d) (A)
+        && !TYPED_FUNC(bml_block_is_empty_distributed2d) (B))
+    {
+        bml_multiply(A, B, C, alpha, beta, threshold);
+    }
+    else if (beta != 1.)
+    {
+        REAL_T scale = beta;
+        bml_scale_inplace(&scale, C);
+    }
+}
+
+/* Matrix multiply using Cannon's algorithm.
  *
- *  \ingroup multiply_group
+ * Only the steps [kfirst, klast) of the npcols steps are done, the
+ * other ones are left to the other layers of a replicated grid.
  *
- *  \param A Matrix A
- *  \param B Matrix B
- *  \param C Matrix C
- *  \param alpha Scalar factor multiplied by A * B
- *  \param beta Scalar factor multiplied by C
- *  \param threshold Used for sparse multiply
+ * The shifts are double buffered: the submatrices of step k+1 are in
+ * flight while the local product of step k is computed, driven by a
+ * progress thread if bml_set_multiply_progress_thread enabled one. The
+ * buffers are attached to C and reused by the next multiply into C.
  */
-void TYPED_FUNC(
-    bml_multiply_distributed2d) (
+static void TYPED_FUNC(
+    bml_multiply_cannon_distributed2d) (
     bml_matrix_distributed2d_t * A,
     bml_matrix_distributed2d_t * B,
     bml_matrix_distributed2d_t * C,
     double alpha,
     double beta,
-    double threshold)
+    double threshold,
+    int kfirst,
+    int klast)
 {
-    // make a copy of A and B local submatrices
-    bml_matrix_t *Atmp1 = bml_copy_new(A->matrix);
-    bml_matrix_t *Atmp2 = bml_copy_new(A->matrix);
-
-    bml_matrix_t *Btmp1 = bml_copy_new(B->matrix);
-    bml_matrix_t *Btmp2 = bml_copy_new(B->matrix);
+    if (kfirst >= klast)
+    {
+        REAL_T scale = beta;
+        bml_scale_inplace(&scale, C->matrix);
+        return;
+    }
 
-    // shift all submatrices A(i,j) to the left by i steps
-    if (A->myprow > 0)
+    bml_matrix_t *Abuf[2];
+    bml_matrix_t *Bbuf[2];
+    for (int i = 0; i < 2; i++)
     {
-        int src, dst;
-        MPI_Cart_shift(A->comm, 1, -1 * A->myprow, &src, &dst);
-        bml_mpi_irecv(Atmp2, src, A->comm);
-        bml_mpi_send(Atmp1, dst, A->comm);
-        bml_mpi_irecv_complete(Atmp2);
+        Abuf[i] =
+            TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->shift_buffer[i],
+                                                        A->matrix);
+        Bbuf[i] =
+            TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->
+                                                        shift_buffer[2 + i],
+                                                        B->matrix);
     }
 
-    // shift all submatrices B(i,j) up by j steps
-    if (B->mypcol > 0)
+    // shift all submatrices A(i,j) to the left by i + kfirst steps
+    // and all submatrices B(i,j) up by j + kfirst steps
+    // (out of copies, A and B may be the same matrix)
+    int shiftA = (A->myprow + kfirst) % A->npcols;
+    int shiftB = (B->mypcol + kfirst) % B->nprows;
+    int srcA, dstA, srcB, dstB;
+    MPI_Cart_shift(A->comm, 1, -1 * shiftA, &srcA, &dstA);
+    MPI_Cart_shift(B->comm, 0, -1 * shiftB, &srcB, &dstB);
+    bml_shift_t shift[2];
+    bml_copy(A->matrix, Abuf[shiftA > 0 ? 1 : 0]);
+    bml_copy(B->matrix, Bbuf[shiftB > 0 ? 1 : 0]);
+    if (shiftA > 0)
+        TYPED_FUNC(bml_shift_start_distributed2d) (Abuf[1], Abuf[0], srcA,
+                                                   dstA, A->comm, &shift[0]);
+    if (shiftB > 0)
+        TYPED_FUNC(bml_shift_start_distributed2d) (Bbuf[1], Bbuf[0], srcB,
+                                                   dstB, B->comm, &shift[1]);
+    if (shiftA > 0)
+        TYPED_FUNC(bml_shift_complete_distributed2d) (&shift[0]);
+    if (shiftB > 0)
+        TYPED_FUNC(bml_shift_complete_distributed2d) (&shift[1]);
+
+    // then move all submatrices one step to the left and up
+    MPI_Cart_shift(A->comm, 1, -1, &srcA, &dstA);
+    MPI_Cart_shift(B->comm, 0, -1, &srcB, &dstB);
+
+    int use_thread = TYPED_FUNC(bml_use_progress_thread_distributed2d) ();
+    int cur = 0;
+    for (int k = kfirst; k < klast; k++)
     {
-        int src, dst;
-        MPI_Cart_shift(B->comm, 0, -1 * B->mypcol, &src, &dst);
-        bml_mpi_irecv(Btmp2, src, B->comm);
-        bml_mpi_send(Btmp1, dst, B->comm);
-        bml_mpi_irecv_complete(Btmp2);
+        int next = 1 - cur;
+        int more = (k + 1 < klast);
+        int threaded = 0;
+        pthread_t progress;
+
+        // send the current submatrices on while they are multiplied
+        if (more)
+        {
+            TYPED_FUNC(bml_shift_start_distributed2d) (Abuf[cur],
+                                                       Abuf[next], srcA,
+                                                       dstA, A->comm,
+                                                       &shift[0]);
+            TYPED_FUNC(bml_shift_start_distributed2d) (Bbuf[cur],
+                                                       Bbuf[next], srcB,
+                                                       dstB, B->comm,
+                                                       &shift[1]);
+            if (use_thread)
+                threaded =
+                    (pthread_create
+                     (&progress, NULL,
+                      TYPED_FUNC(bml_shift_thread_distributed2d),
+                      shift) == 0);
+        }
+
+        // perform local submatrices multiplication
+        TYPED_FUNC(bml_multiply_block_distributed2d) (Abuf[cur], Bbuf[cur],
+                                                      C->matrix, alpha,
+                                                      k == kfirst ? beta : 1.,
+                                                      threshold);
+
+        if (more)
+        {
+            if (threaded)
+            {
+                pthread_join(progress, NULL);
+            }
+            else
+            {
+                TYPED_FUNC(bml_shift_progress_distributed2d) (&shift[0]);
+                TYPED_FUNC(bml_shift_progress_distributed2d) (&shift[1]);
+            }
+            TYPED_FUNC(bml_shift_complete_distributed2d) (&shift[0]);
+            TYPED_FUNC(bml_shift_complete_distributed2d) (&shift[1]);
+        }
+        cur = next;
     }
+}
 
-    // perform local submatrices multiplication
-    bml_multiply(Atmp2, Btmp2, C->matrix, alpha, beta, threshold);
+/* Sum the partial products C of all layers of a replicated grid, on
+ * a binary tree over depth_comm, and broadcast the sum back.
+ */
+static void TYPED_FUNC(
+    bml_reduce_layers_distributed2d) (
+    bml_matrix_distributed2d_t * C,
+    double threshold)
+{
+    bml_matrix_t *Cbuf =
+        TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->shift_buffer[4],
+                                                    C->matrix);
 
-    for (int k = 1; k < C->npcols; k++)
+    for (int step = 1; step < C->nlayers; step *= 2)
     {
-        // swap pointers to have latest matrices in tmp1
-        bml_matrix_t *tmp = Atmp1;
-        Atmp1 = Atmp2;
-        Atmp2 = tmp;
-        tmp = Btmp1;
-        Btmp1 = Btmp2;
-        Btmp2 = tmp;
-
-        // Move local submatrices one step to left
+        if (C->mylayer % (2 * step) == step)
+        {
+            bml_mpi_send(C->matrix, C->mylayer - step, C->depth_comm);
+        }
+        else if (C->mylayer % (2 * step) == 0
+                 && C->mylayer + step < C->nlayers)
         {
-            int src, dst;
-            MPI_Cart_shift(A->comm, 1, -1, &src, &dst);
-            bml_mpi_irecv(Atmp2, src, A->comm);
-            bml_mpi_send(Atmp1, dst, A->comm);
-            bml_mpi_irecv_complete(Atmp2);
+            bml_mpi_irecv(Cbuf, C->mylayer + step, C->depth_comm);
+            bml_mpi_irecv_complete(Cbuf);
+            bml_add(C->matrix, Cbuf, 1., 1., threshold);
         }
+    }
+    bml_mpi_bcast_matrix(C->matrix, 0, C->depth_comm);
+}
+
+/* End of the SUMMA panel starting at k0.
+ *
+ * A panel stops at the next edge of the blocks of columns of A, at
+ * multiples of nc, or of the blocks of rows of B, at multiples of nr,
+ * so that it has a single owner in every process row and column. The
+ * edges of both meet at the multiples of lcm(nr, nc). Panels are at
+ * most width wide unless width is 0.
+ */
+static int TYPED_FUNC(
+    bml_summa_panel_end_distributed2d) (
+    bml_matrix_distributed2d_t * C,
+    int k0,
+    int width)
+{
+    int k1 = MIN((k0 / C->nc + 1) * C->nc, (k0 / C->nr + 1) * C->nr);
+    if (width > 0 && k0 + width < k1)
+        k1 = k0 + width;
+    return k1;
+}
+
+/* Matrix multiply using SUMMA.
+ *
+ * The inner dimension is cut into panels, see
+ * bml_summa_panel_end_distributed2d. For every panel the process
+ * column holding it broadcasts its columns of A along the process rows
+ * and the process row holding it its rows of B along the process
+ * columns, moved to the local columns of the panel of A. On a square
+ * grid with whole blocks as panels the owners broadcast their own
+ * submatrices, the panels are cut into buffers attached to C
+ * otherwise. Only the panels [pfirst, plast) are done, the other ones
+ * are left to the other layers of a replicated grid.
+ */
+static void TYPED_FUNC(
+    bml_multiply_summa_distributed2d) (
+    bml_matrix_distributed2d_t * A,
+    bml_matrix_distributed2d_t * B,
+    bml_matrix_distributed2d_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    int pfirst,
+    int plast)
+{
+    if (pfirst >= plast)
+    {
+        REAL_T scale = beta;
+        bml_scale_inplace(&scale, C->matrix);
+        return;
+    }
+
+    bml_matrix_t *Abuf =
+        TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->shift_buffer[0],
+                                                    A->matrix);
+    bml_matrix_t *Bbuf =
+        TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->shift_buffer[2],
+                                                    B->matrix);
+
+    // the panels of an operand that is C are cut from a copy of it
+    bml_matrix_t *Asrc = A->matrix;
+    bml_matrix_t *Bsrc = B->matrix;
+    if (A == C)
+    {
+        Asrc =
+            TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->shift_buffer[1],
+                                                        A->matrix);
+        bml_copy(A->matrix, Asrc);
+    }
+    if (B == C)
+    {
+        Bsrc = (A == B) ? Asrc :
+            TYPED_FUNC(bml_shift_buffer_distributed2d) (&C->shift_buffer[3],
+                                                        B->matrix);
+        if (A != B)
+            bml_copy(B->matrix, Bsrc);
+    }
 
-        // Move local submatrices one step up
+    int width = bml_get_summa_panel_width();
+    int k0 = 0;
+    for (int p = 0; p < plast; p++)
+    {
+        int k1 = TYPED_FUNC(bml_summa_panel_end_distributed2d) (C, k0,
+                                                                width);
+        if (p >= pfirst)
         {
-            int src, dst;
-            MPI_Cart_shift(B->comm, 0, -1, &src, &dst);
-            bml_mpi_irecv(Btmp2, src, B->comm);
-            bml_mpi_send(Btmp1, dst, B->comm);
-            bml_mpi_irecv_complete(Btmp2);
+            // owners of the panel and its offsets in their submatrices
+            int len = k1 - k0;
+            int pa = k0 / A->nc;
+            int ka = k0 - pa * A->nc;
+            int pb = k0 / B->nr;
+            int kb = k0 - pb * B->nr;
+            int whole = (len == A->n && ka == 0 && kb == 0);
+
+            bml_matrix_t *Ak = Abuf;
+            bml_matrix_t *Bk = Bbuf;
+            if (A->mypcol == pa)
+            {
+                if (whole)
+                    Ak = Asrc;
+                else
+                    bml_copy_panel(Asrc, Abuf, 0, A->n, ka, len, 0);
+            }
+            if (B->myprow == pb)
+            {
+                if (whole)
+                    Bk = Bsrc;
+                else
+                    bml_copy_panel(Bsrc, Bbuf, kb, len, 0, B->n, ka);
+            }
+
+            bml_mpi_bcast_matrix(Ak, pa, A->row_comm);
+            bml_mpi_bcast_matrix(Bk, pb, B->col_comm);
+
+            TYPED_FUNC(bml_multiply_block_distributed2d) (Ak, Bk, C->matrix,
+                                                          alpha,
+                                                          p == pfirst ?
+                                                          beta : 1.,
+                                                          threshold);
         }
+        k0 = k1;
+    }
+}
 
-        // perform local submatrices multiplication
-        bml_multiply(Atmp2, Btmp2, C->matrix, alpha, 1., threshold);
+/** Matrix multiply.
+ *
+ * C = alpha * A * B + beta * C
+ *
+ * Uses Cannon's algorithm or SUMMA, see bml_set_distributed_multiply;
+ * always SUMMA on a non-square grid. On a replicated grid
+ * (bml_set_replication_distributed2d) the steps are split over the
+ * layers and the partial products summed.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param A Matrix A
+ *  \param B Matrix B
+ *  \param C Matrix C
+ *  \param alpha Scalar factor multiplied by A * B
+ *  \param beta Scalar factor multiplied by C
+ *  \param threshold Used for sparse multiply
+ */
+void TYPED_FUNC(
+    bml_multiply_distributed2d) (
+    bml_matrix_distributed2d_t * A,
+    bml_matrix_distributed2d_t * B,
+    bml_matrix_distributed2d_t * C,
+    double alpha,
+    double beta,
+    double threshold)
+{
+    // Cannon's shifts need a square grid, SUMMA does any grid
+    int summa = (bml_get_distributed_multiply() == distributed_multiply_summa
+                 || C->nprows != C->npcols);
+
+    int nsteps = C->npcols;
+    if (summa)
+    {
+        int width = bml_get_summa_panel_width();
+        nsteps = 0;
+        for (int k0 = 0; k0 < C->N;
+             k0 = TYPED_FUNC(bml_summa_panel_end_distributed2d) (C, k0,
+                                                                  width))
+            nsteps++;
     }
 
-    bml_deallocate(&Atmp1);
-    bml_deallocate(&Atmp2);
-    bml_deallocate(&Btmp1);
-    bml_deallocate(&Btmp2);
+    // every layer does its share of the steps
+    int kfirst = C->mylayer * nsteps / C->nlayers;
+    int klast = (C->mylayer + 1) * nsteps / C->nlayers;
+    double layer_beta = (C->mylayer == 0) ? beta : 0.;
+    if (summa)
+        TYPED_FUNC(bml_multiply_summa_distributed2d) (A, B, C, alpha,
+                                                      layer_beta, threshold,
+                                                      kfirst, klast);
+    else
+        TYPED_FUNC(bml_multiply_cannon_distributed2d) (A, B, C, alpha,
+                                                       layer_beta, threshold,
+                                                       kfirst, klast);
+    if (C->nlayers > 1)
+        TYPED_FUNC(bml_reduce_layers_distributed2d) (C, threshold);
 }
@@ -7,10 +7,13 @@
 #include "../bml_scale.h"
 #include "../bml_introspection.h"
 #include "../bml_add.h"
+#include "bml_allocate_distributed2d.h"
 #include "bml_normalize_distributed2d.h"
+#include "bml_setters_distributed2d.h"
 #include "bml_types_distributed2d.h"
 
 #include <float.h>
+#include <math.h>
 #include <complex.h>
 
 void TYPED_FUNC(
@@ -25,7 +28,9 @@ void TYPED_FUNC(
     double threshold = 0.0;
 
     bml_scale_inplace(&scalar, bml_get_local_matrix(A));
-    if (A->myprow == A->mypcol)
+    if (A->nprows != A->npcols)
+        bml_add_diagonal_distributed2d(A, gershfact);
+    else if (A->myprow == A->mypcol)
         bml_add_identity(bml_get_local_matrix(A), gershfact, threshold);
 }
 
@@ -33,29 +38,39 @@ void *TYPED_FUNC(
     bml_gershgorin_distributed2d) (
     bml_matrix_distributed2d_t * A)
 {
-    int nloc = A->N / A->nprows;
+    int nloc = A->nr;
+    int ilo, ihi, offset;
+    bml_local_diagonal_distributed2d(A, &ilo, &ihi, &offset);
+
+    // local rows ilo to ihi hold the diagonal, off the local diagonal
+    // unless offset is 0
     REAL_T *rad = bml_allocate_memory(nloc * sizeof(REAL_T));
-    REAL_T *offdiag_sum =
-        bml_accumulate_offdiag(A->matrix, A->myprow != A->mypcol);
+    REAL_T *dval = bml_get_diagonal(A->matrix);
+    REAL_T *offdiag_sum = bml_accumulate_offdiag(A->matrix, offset != 0);
+    if (offset != 0)
+    {
+        for (int i = ilo; i < ihi; i++)
+        {
+            REAL_T *row = bml_get_row(A->matrix, i);
+            dval[i] = row[i + offset];
+            offdiag_sum[i] -= ABS(dval[i]);
+            bml_free_memory(row);
+        }
+    }
     MPI_Allreduce(offdiag_sum, rad, nloc, MPI_T, MPI_SUM, A->row_comm);
     free(offdiag_sum);
 
     double emin = DBL_MAX;
     double emax = DBL_MIN;
 
-    if (A->myprow == A->mypcol)
+    for (int i = ilo; i < ihi; i++)
     {
-        REAL_T *dval = bml_get_diagonal(A->matrix);
-
-        for (int i = 0; i < nloc; i++)
-        {
-            if (REAL_PART(dval[i] + rad[i]) > emax)
-                emax = REAL_PART(dval[i] + rad[i]);
-            if (REAL_PART(dval[i] - rad[i]) < emin)
-                emin = REAL_PART(dval[i] - rad[i]);
-        }
-        free(dval);
+        if (REAL_PART(dval[i] + rad[i]) > emax)
+            emax = REAL_PART(dval[i] + rad[i]);
+        if (REAL_PART(dval[i] - rad[i]) < emin)
+            emin = REAL_PART(dval[i] - rad[i]);
     }
+    free(dval);
     bml_free_memory(rad);
 
     double *eval = bml_allocate_memory(sizeof(double) * 2);
@@ -69,3 +69,35 @@ bml_set_row_distributed2d(
             break;
     }
 }
+
+/** Add alpha to the diagonal elements held by the local submatrix.
+ *
+ * \param A The matrix.
+ * \param alpha The shift of the diagonal.
+ */
+void
+bml_add_diagonal_distributed2d(
+    bml_matrix_distributed2d_t * A,
+    double alpha)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_add_diagonal_distributed2d_single_real(A, alpha);
+            break;
+        case double_real:
+            bml_add_diagonal_distributed2d_double_real(A, alpha);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_add_diagonal_distributed2d_single_complex(A, alpha);
+            break;
+        case double_complex:
+            bml_add_diagonal_distributed2d_double_complex(A, alpha);
+            break;
+#endif
+        default:
+            LOG_ERROR("unkonwn precision\n");
+            break;
+    }
+}
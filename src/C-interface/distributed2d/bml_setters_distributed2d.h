@@ -58,4 +58,24 @@ void bml_set_row_distributed2d_double_complex(
     void *row,
     double threshold);
 
+void bml_add_diagonal_distributed2d(
+    bml_matrix_distributed2d_t * A,
+    double alpha);
+
+void bml_add_diagonal_distributed2d_single_real(
+    bml_matrix_distributed2d_t * A,
+    double alpha);
+
+void bml_add_diagonal_distributed2d_double_real(
+    bml_matrix_distributed2d_t * A,
+    double alpha);
+
+void bml_add_diagonal_distributed2d_single_complex(
+    bml_matrix_distributed2d_t * A,
+    double alpha);
+
+void bml_add_diagonal_distributed2d_double_complex(
+    bml_matrix_distributed2d_t * A,
+    double alpha);
+
 #endif
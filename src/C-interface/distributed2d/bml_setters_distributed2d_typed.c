@@ -1,9 +1,17 @@
 #include "../../macros.h"
 #include "../../typed.h"
 #include "../bml_logger.h"
+#include "../bml_allocate.h"
+#include "../bml_getters.h"
 #include "../bml_setters.h"
+#include "bml_allocate_distributed2d.h"
+#include "bml_setters_distributed2d.h"
 #include "bml_types_distributed2d.h"
 
+#include <complex.h>
+#include <math.h>
+#include <string.h>
+
 void TYPED_FUNC(
     bml_set_diagonal_distributed2d) (
     bml_matrix_distributed2d_t * A,
@@ -12,10 +20,46 @@ void TYPED_FUNC(
 {
     REAL_T *diagonal = _diagonal;
 
-    if (A->myprow == A->mypcol)
+    if (A->nprows == A->npcols)
+    {
+        if (A->myprow == A->mypcol)
+        {
+            int offset = A->myprow * A->N / A->nprows;
+            bml_set_diagonal(A->matrix, diagonal + offset, threshold);
+        }
+        return;
+    }
+
+    int ilo, ihi, offset;
+    bml_local_diagonal_distributed2d(A, &ilo, &ihi, &offset);
+    for (int i = ilo; i < ihi; i++)
+    {
+        REAL_T d = diagonal[A->myprow * A->nr + i];
+        REAL_T *row = bml_get_row(A->matrix, i);
+        row[i + offset] = (ABS(d) > threshold) ? d : 0.;
+        bml_set_row(A->matrix, i, row, 0.);
+        bml_free_memory(row);
+    }
+}
+
+/** Add alpha to the diagonal elements held by the local submatrix.
+ *
+ * \param A The matrix
+ * \param alpha The shift of the diagonal
+ */
+void TYPED_FUNC(
+    bml_add_diagonal_distributed2d) (
+    bml_matrix_distributed2d_t * A,
+    double alpha)
+{
+    int ilo, ihi, offset;
+    bml_local_diagonal_distributed2d(A, &ilo, &ihi, &offset);
+    for (int i = ilo; i < ihi; i++)
     {
-        int offset = A->myprow * A->N / A->nprows;
-        bml_set_diagonal(A->matrix, diagonal + offset, threshold);
+        REAL_T *row = bml_get_row(A->matrix, i);
+        row[i + offset] += alpha;
+        bml_set_row(A->matrix, i, row, 0.);
+        bml_free_memory(row);
     }
 }
 
@@ -26,7 +70,7 @@ void TYPED_FUNC(
     void *row,
     double threshold)
 {
-    const int nloc = A->N / A->nprows;
+    const int nloc = A->nr;
 
     if (i < A->myprow * nloc)
         return;
@@ -36,8 +80,18 @@ void TYPED_FUNC(
     // subrow corresponds to local columns only
     // by pointing to first local element
     // assuming row is a dense array
-    REAL_T *sub_row = (REAL_T *) row + A->mypcol * nloc;
+    REAL_T *sub_row = (REAL_T *) row + A->mypcol * A->nc;
 
     int irow = i - A->myprow * nloc;
-    bml_set_row(A->matrix, irow, sub_row, threshold);
+    if (A->nc == A->n)
+    {
+        bml_set_row(A->matrix, irow, sub_row, threshold);
+        return;
+    }
+
+    // the padding columns of the local submatrix stay zero
+    REAL_T *local_row = bml_allocate_memory(A->n * sizeof(REAL_T));
+    memcpy(local_row, sub_row, A->nc * sizeof(REAL_T));
+    bml_set_row(A->matrix, irow, local_row, threshold);
+    bml_free_memory(local_row);
 }
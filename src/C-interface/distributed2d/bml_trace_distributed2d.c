@@ -1,3 +1,4 @@
+#include "../bml_introspection.h"
 #include "../bml_logger.h"
 #include "../bml_trace.h"
 #include "../bml_types.h"
@@ -19,14 +20,27 @@ double
 bml_trace_distributed2d(
     bml_matrix_distributed2d_t * A)
 {
-    double trace = 0.;
-
-    if (A->myprow == A->mypcol)
-        trace = bml_trace(A->matrix);
-
-    bml_sumRealReduce(&trace);
-
-    return trace;
+    switch (bml_get_precision(A))
+    {
+        case single_real:
+            return bml_trace_distributed2d_single_real(A);
+            break;
+        case double_real:
+            return bml_trace_distributed2d_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_trace_distributed2d_single_complex(A);
+            break;
+        case double_complex:
+            return bml_trace_distributed2d_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return 0;
 }
 
 /** Calculate the trace of a matrix multiplication.
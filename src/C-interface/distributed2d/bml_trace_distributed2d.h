@@ -6,6 +6,18 @@
 double bml_trace_distributed2d(
     bml_matrix_distributed2d_t * A);
 
+double bml_trace_distributed2d_single_real(
+    bml_matrix_distributed2d_t * A);
+
+double bml_trace_distributed2d_double_real(
+    bml_matrix_distributed2d_t * A);
+
+double bml_trace_distributed2d_single_complex(
+    bml_matrix_distributed2d_t * A);
+
+double bml_trace_distributed2d_double_complex(
+    bml_matrix_distributed2d_t * A);
+
 double bml_trace_mult_distributed2d(
     bml_matrix_distributed2d_t * A,
     bml_matrix_distributed2d_t * B);
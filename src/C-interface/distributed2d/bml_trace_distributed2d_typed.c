@@ -0,0 +1,47 @@
+#include "../../macros.h"
+#include "../../typed.h"
+#include "../bml_allocate.h"
+#include "../bml_getters.h"
+#include "../bml_parallel.h"
+#include "../bml_trace.h"
+#include "bml_allocate_distributed2d.h"
+#include "bml_trace_distributed2d.h"
+#include "bml_types_distributed2d.h"
+
+#include <complex.h>
+
+/** Calculate the trace of a matrix.
+ *
+ *  \ingroup trace_group
+ *
+ *  \param A The matrix to calculate a trace for
+ *  \return the trace of A
+ */
+double TYPED_FUNC(
+    bml_trace_distributed2d) (
+    bml_matrix_distributed2d_t * A)
+{
+    double trace = 0.;
+
+    if (A->nprows == A->npcols)
+    {
+        if (A->myprow == A->mypcol)
+            trace = bml_trace(A->matrix);
+    }
+    else
+    {
+        // the diagonal crosses the blocks off their local diagonals
+        int ilo, ihi, offset;
+        bml_local_diagonal_distributed2d(A, &ilo, &ihi, &offset);
+        for (int i = ilo; i < ihi; i++)
+        {
+            REAL_T *row = bml_get_row(A->matrix, i);
+            trace += REAL_PART(row[i + offset]);
+            bml_free_memory(row);
+        }
+    }
+
+    bml_sumRealReduce(&trace);
+
+    return trace;
+}
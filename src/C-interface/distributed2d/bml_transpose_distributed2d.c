@@ -6,6 +6,10 @@
 #include "bml_transpose_distributed2d.h"
 #include "bml_types_distributed2d.h"
 #include "bml_copy_distributed2d.h"
+#include "bml_export_distributed2d.h"
+#include "bml_import_distributed2d.h"
+#include "../bml_allocate.h"
+#include "../bml_introspection.h"
 
 #include <stdlib.h>
 #include <string.h>
@@ -24,6 +28,22 @@ bml_transpose_new_distributed2d(
 {
     assert(A->M > 0);
 
+    // the transposed blocks do not map onto the blocks of a non-square
+    // grid, read A back column by column from a dense copy on task 0
+    if (A->nprows != A->npcols)
+    {
+        void *A_dense =
+            bml_export_to_dense_distributed2d(A, dense_row_major);
+        bml_matrix_distributed2d_t *B =
+            bml_import_from_dense_distributed2d(bml_get_type(A->matrix),
+                                                A->matrix_precision,
+                                                dense_column_major, A->N,
+                                                A_dense, 0., A->M);
+        if (A->mpitask == 0)
+            bml_free_memory(A_dense);
+        return B;
+    }
+
     bml_matrix_distributed2d_t *B = bml_copy_distributed2d_new(A);
     assert(B != NULL);
 
@@ -54,6 +74,16 @@ bml_transpose_distributed2d(
 {
     assert(A->M > 0);
 
+    if (A->nprows != A->npcols)
+    {
+        bml_matrix_distributed2d_t *B = bml_transpose_new_distributed2d(A);
+        bml_matrix_t *matrix = A->matrix;
+        A->matrix = B->matrix;
+        B->matrix = matrix;
+        bml_deallocate_distributed2d(B);
+        return;
+    }
+
     bml_matrix_distributed2d_t *B = bml_copy_distributed2d_new(A);
 
     if (A->myprow != A->mypcol)
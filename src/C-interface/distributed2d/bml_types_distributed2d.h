@@ -21,6 +21,11 @@ struct bml_matrix_distributed2d_t
     bml_matrix_t *matrix;
     /** local submatrix dimensions */
     int n;
+    /** rows and columns of the matrix held in the local submatrix,
+     * N / nprows and N / npcols; on a non-square grid the local
+     * submatrix is padded with zeros to the larger of the two */
+    int nr;
+    int nc;
     /** MPI communicator */
     MPI_Comm comm;
     MPI_Comm row_comm;
@@ -35,6 +40,16 @@ struct bml_matrix_distributed2d_t
     int mypcol;
     /** local MPI task ID */
     int mpitask;
+    /** tasks holding the same block in the other copies of the grid */
+    MPI_Comm depth_comm;
+    /** number of copies of the grid (2.5D replication) */
+    int nlayers;
+    /** copy of the grid this task belongs to */
+    int mylayer;
+    /** local submatrices of A and B shifted around by a multiply into
+     * this matrix, and of the partial products summed over the layers,
+     * kept for the next multiply */
+    bml_matrix_t *shift_buffer[5];
 };
 typedef struct bml_matrix_distributed2d_t bml_matrix_distributed2d_t;
 
@@ -1,11 +1,15 @@
 #include "bml_utilities_distributed2d.h"
 #include "bml_allocate_distributed2d.h"
+#include "bml_export_distributed2d.h"
+#include "bml_import_distributed2d.h"
 #include "../bml_introspection.h"
 #include "../bml_utilities.h"
 #include "../bml_allocate.h"
 #include "../bml_parallel.h"
 #include "../bml_submatrix.h"
 #include "../bml_copy.h"
+#include "../bml_export.h"
+#include "../bml_import.h"
 #include "../ellblock/bml_types_ellblock.h"
 #include "../ellblock/bml_allocate_ellblock.h"
 #include "../bml_logger.h"
@@ -25,6 +29,32 @@ bml_read_bml_matrix_distributed2d(
     int *bsizes;
     bml_matrix_t *Alocal = bml_get_local_matrix(A);
     bml_matrix_t *B;
+
+    // the blocks of a non-square grid are padded, distribute the
+    // matrix read by task 0 through a dense copy instead
+    if (A->nprows != A->npcols)
+    {
+        void *B_dense = NULL;
+        if (A->mpitask == 0)
+        {
+            B = bml_zero_matrix(bml_get_type(A->matrix),
+                                A->matrix_precision, A->N, A->M, sequential);
+            bml_read_bml_matrix(B, filename);
+            B_dense = bml_export_to_dense(B, dense_row_major);
+            bml_deallocate(&B);
+        }
+        bml_matrix_distributed2d_t *C =
+            bml_import_from_dense_distributed2d(bml_get_type(A->matrix),
+                                                A->matrix_precision,
+                                                dense_row_major, A->N,
+                                                B_dense, 0., A->M);
+        bml_copy(C->matrix, A->matrix);
+        bml_deallocate_distributed2d(C);
+        if (A->mpitask == 0)
+            bml_free_memory(B_dense);
+        return;
+    }
+
     switch (bml_get_type(A->matrix))
     {
             // special case for ellblock: we need block sizes to exactly
@@ -76,6 +106,26 @@ bml_write_bml_matrix_distributed2d(
     int *bsizes;
     bml_matrix_t *Alocal = bml_get_local_matrix(A);
 
+    // the blocks of a non-square grid are padded, collect them on
+    // task 0 through a dense copy instead
+    if (A->nprows != A->npcols)
+    {
+        void *A_dense =
+            bml_export_to_dense_distributed2d(A, dense_row_major);
+        if (A->mpitask == 0)
+        {
+            bml_matrix_t *B = bml_import_from_dense(bml_get_type(A->matrix),
+                                                    A->matrix_precision,
+                                                    dense_row_major, A->N,
+                                                    A->M, A_dense, 0.,
+                                                    sequential);
+            bml_write_bml_matrix(B, filename);
+            bml_deallocate(&B);
+            bml_free_memory(A_dense);
+        }
+        return;
+    }
+
     // task 0 collects all blocks and write matrix
     if (A->mpitask == 0)
     {
@@ -173,13 +173,7 @@ void TYPED_FUNC(
             if (is_above_threshold(normx, threshold))
             {
                 int kb = ROWMAJOR(ib, ll, NB, MB);
-                if (A_ptr_value[kb] == NULL)
-                {
-                    A_ptr_value[kb]
-                        =
-                        TYPED_FUNC(bml_allocate_block_ellblock) (A, ib,
-                                                                 nelements);
-                }
+                TYPED_FUNC(bml_reuse_block_ellblock) (A, ib, kb, nelements);
                 for (int kk = 0; kk < nelements; kk++)
                 {
                     A_ptr_value[kb][kk] = x[kk];
@@ -7,7 +7,14 @@
 #include "bml_types_ellblock.h"
 
 #include <assert.h>
+#include <stdint.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
 
 /*
  * variables visible only in that file
@@ -16,6 +23,8 @@ static int *s_default_bsize = NULL;
 static int s_default_block_dim = 4;
 static int s_nb = 0;
 static int s_mb = 0;
+static int s_block_size_discovery = 0;
+static double s_block_fill_efficiency = 0.0;
 
 /*
  *  * function to set values of static variables visible in that file only
@@ -80,6 +89,218 @@ bml_get_block_sizes(
     return s_default_bsize;
 }
 
+/** Enable the discovery of block sizes from the sparsity pattern.
+ *
+ * While no block sizes are set, the first matrix imported or converted
+ * to ellblock then sets them from its own pattern with
+ * bml_find_block_sizes instead of using uniform blocks.
+ *
+ * \param flag 1 to discover the block sizes, 0 for uniform blocks
+ */
+void
+bml_set_block_size_discovery(
+    int flag)
+{
+    s_block_size_discovery = flag;
+}
+
+/** Whether block sizes are discovered from the sparsity pattern.
+ *
+ * \return 1 if the block sizes are discovered
+ */
+int
+bml_get_block_size_discovery(
+    void)
+{
+    return s_block_size_discovery;
+}
+
+/** Fill efficiency of the discovered block sizes.
+ *
+ * \return The fraction of the stored block elements in the pattern
+ * the block sizes were discovered from, 0 if they were not discovered
+ */
+double
+bml_get_block_fill_efficiency(
+    void)
+{
+    return s_block_fill_efficiency;
+}
+
+/** Find block sizes from a sparsity pattern.
+ *
+ * Consecutive rows with identical column structure, like the orbitals
+ * of one atom, are put in the same block. Runs longer than max_bsize
+ * are split into blocks of about equal size.
+ *
+ * \param N The number of rows
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices, in any order within a row
+ * \param max_bsize The largest block size
+ * \param bsize The block sizes (N elements)
+ * \param efficiency The fraction of the stored block elements that are
+ * in the pattern (can be NULL)
+ * \return The number of blocks
+ */
+int
+bml_find_block_sizes(
+    int N,
+    int *row_ptr,
+    int *cols,
+    int max_bsize,
+    int *bsize,
+    double *efficiency)
+{
+    assert(max_bsize > 0);
+
+    // row i starts a new block if its columns differ from row i - 1
+    char *boundary = bml_noinit_allocate_memory(N * sizeof(char));
+#pragma omp parallel
+    {
+        int *mark = bml_allocate_memory(N * sizeof(int));
+#pragma omp for
+        for (int i = 0; i < N; i++)
+        {
+            boundary[i] = (i == 0
+                           || row_ptr[i + 1] - row_ptr[i] !=
+                           row_ptr[i] - row_ptr[i - 1]);
+            if (boundary[i])
+                continue;
+            // mark the columns of row i - 1 with i
+            for (int k = row_ptr[i - 1]; k < row_ptr[i]; k++)
+                mark[cols[k]] = i;
+            for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+            {
+                if (mark[cols[k]] != i)
+                {
+                    boundary[i] = 1;
+                    break;
+                }
+            }
+        }
+        bml_free_memory(mark);
+    }
+
+    int nb = 0;
+    int start = 0;
+    for (int i = 1; i <= N; i++)
+    {
+        if (i == N || boundary[i])
+        {
+            int length = i - start;
+            int nsplit = (length + max_bsize - 1) / max_bsize;
+            for (int k = 0; k < nsplit; k++)
+            {
+                bsize[nb++] = length / nsplit + (k < length % nsplit);
+            }
+            start = i;
+        }
+    }
+    bml_free_memory(boundary);
+
+    if (efficiency != NULL)
+    {
+        int *block = bml_noinit_allocate_memory(N * sizeof(int));
+        int *offset = bml_allocate_memory((nb + 1) * sizeof(int));
+        for (int ib = 0; ib < nb; ib++)
+        {
+            offset[ib + 1] = offset[ib] + bsize[ib];
+            for (int i = offset[ib]; i < offset[ib + 1]; i++)
+                block[i] = ib;
+        }
+        int64_t stored = 0;
+#pragma omp parallel reduction(+:stored)
+        {
+            int *mark = bml_allocate_memory(nb * sizeof(int));
+#pragma omp for
+            for (int ib = 0; ib < nb; ib++)
+            {
+                for (int k = row_ptr[offset[ib]]; k < row_ptr[offset[ib + 1]];
+                     k++)
+                {
+                    int jb = block[cols[k]];
+                    if (mark[jb] != ib + 1)
+                    {
+                        mark[jb] = ib + 1;
+                        stored += (int64_t) bsize[ib] * bsize[jb];
+                    }
+                }
+            }
+            bml_free_memory(mark);
+        }
+        *efficiency = stored > 0 ? (double) row_ptr[N] / stored : 1.0;
+        bml_free_memory(block);
+        bml_free_memory(offset);
+    }
+
+    return nb;
+}
+
+/** Block sizes for a matrix with the given sparsity pattern.
+ *
+ * If no block sizes are set yet and block size discovery is enabled,
+ * the block sizes are found from the pattern and set for all the
+ * following ellblock matrices. Otherwise this is bml_get_block_sizes.
+ *
+ * \param N The number of rows
+ * \param M The number of non-zeroes per row
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \return The block sizes
+ */
+int *
+bml_get_block_sizes_from_pattern(
+    int N,
+    int M,
+    int *row_ptr,
+    int *cols)
+{
+    if (s_default_bsize != NULL || !s_block_size_discovery)
+    {
+        return bml_get_block_sizes(N, M);
+    }
+
+    int *bsize = bml_noinit_allocate_memory(N * sizeof(int));
+    int nb = bml_find_block_sizes(N, row_ptr, cols, BMAXSIZE, bsize,
+                                  &s_block_fill_efficiency);
+
+    // the largest number of blocks in a block row of the pattern, or
+    // as many as M columns fill with blocks of the average size
+    int mb = (int) ((int64_t) M * nb / N) + 1;
+    int *block = bml_noinit_allocate_memory(N * sizeof(int));
+    int *mark = bml_allocate_memory(nb * sizeof(int));
+    for (int ib = 0, i = 0; ib < nb; ib++)
+        for (int ii = 0; ii < bsize[ib]; ii++)
+            block[i++] = ib;
+    for (int ib = 0, i = 0; ib < nb; ib++)
+    {
+        int nnzb = 0;
+        for (int ii = 0; ii < bsize[ib]; ii++, i++)
+        {
+            for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+            {
+                int jb = block[cols[k]];
+                if (mark[jb] != ib + 1)
+                {
+                    mark[jb] = ib + 1;
+                    nnzb++;
+                }
+            }
+        }
+        mb = MAX(mb, nnzb);
+    }
+    bml_free_memory(block);
+    bml_free_memory(mark);
+    mb = MIN(MAX(mb, 4), nb);
+
+    LOG_INFO("found %d blocks for N = %d, fill efficiency %f\n", nb, N,
+             s_block_fill_efficiency);
+    bml_set_block_sizes(bsize, nb, mb);
+    bml_free_memory(bsize);
+
+    return s_default_bsize;
+}
+
 int
 bml_get_mb(
     )
@@ -110,6 +331,283 @@ count_nelements(
     return nelements;
 }
 
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+#ifndef MALLOC_ALIGNMENT
+#define MALLOC_ALIGNMENT 64
+#endif
+
+/** Size of an arena allocation, keeping the blocks aligned. */
+#define ARENA_ROUND(nbytes) \
+    (((nbytes) + MALLOC_ALIGNMENT - 1) / MALLOC_ALIGNMENT * MALLOC_ALIGNMENT)
+
+/** Add a chunk to the arena of a block row.
+ *
+ * \param A The matrix
+ * \param arena The arena
+ * \param size The size of the chunk in bytes
+ */
+static void
+bml_add_arena_chunk_ellblock(
+    bml_matrix_ellblock_t * A,
+    bml_ellblock_arena_t * arena,
+    size_t size)
+{
+    arena->chunks =
+        realloc(arena->chunks,
+                (arena->nchunks + 1) * sizeof(bml_ellblock_chunk_t));
+    arena->chunks[arena->nchunks].data = bml_noinit_allocate_memory(size);
+    arena->chunks[arena->nchunks].size = size;
+    arena->nchunks++;
+
+#pragma omp critical (bml_ellblock_arena)
+    {
+        A->arena_reserved += size;
+        A->arena_peak = MAX(A->arena_peak, A->arena_reserved);
+    }
+}
+
+/** Set up the arenas of the block rows of a matrix.
+ *
+ * \param A The matrix
+ * \param row_bytes The initial size of the arena of each block row
+ */
+void
+bml_init_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    size_t * row_bytes)
+{
+    A->arena = bml_allocate_memory(A->NB * sizeof(bml_ellblock_arena_t));
+    A->arena_reserved = 0;
+    A->arena_peak = 0;
+    for (int ib = 0; ib < A->NB; ib++)
+    {
+        bml_add_arena_chunk_ellblock(A, &A->arena[ib],
+                                     ARENA_ROUND(row_bytes[ib]));
+    }
+}
+
+/** Allocate memory for a block from the arena of a block row.
+ *
+ * The memory starts at a multiple of MALLOC_ALIGNMENT bytes into an
+ * aligned chunk. Only one thread may allocate from a row at a time.
+ *
+ * \param A The matrix
+ * \param ib The block row
+ * \param nbytes The size of the block in bytes
+ * \return The memory
+ */
+void *
+bml_allocate_from_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib,
+    size_t nbytes)
+{
+    bml_ellblock_arena_t *arena = &A->arena[ib];
+    nbytes = ARENA_ROUND(nbytes);
+
+    while (arena->used + nbytes > arena->chunks[arena->current].size)
+    {
+        if (arena->current + 1 == arena->nchunks)
+        {
+            size_t size = arena->chunks[arena->nchunks - 1].size;
+            bml_add_arena_chunk_ellblock(A, arena, MAX(2 * size, nbytes));
+        }
+        arena->current++;
+        arena->used = 0;
+    }
+
+    void *allocation = arena->chunks[arena->current].data + arena->used;
+    arena->used += nbytes;
+    arena->allocated += nbytes;
+    arena->live += nbytes;
+    return allocation;
+}
+
+/** Return the memory of a block to the arena of a block row.
+ *
+ * The memory stays a hole until the row is compacted or reset.
+ *
+ * \param A The matrix
+ * \param ib The block row
+ * \param nbytes The size of the block in bytes
+ */
+void
+bml_release_to_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib,
+    size_t nbytes)
+{
+    A->arena[ib].live -= MIN(A->arena[ib].live, ARENA_ROUND(nbytes));
+}
+
+/** Reset the arena of a block row, freeing all its blocks in O(1).
+ *
+ * The chunks are kept for the blocks allocated next.
+ *
+ * \param A The matrix
+ * \param ib The block row
+ */
+void
+bml_reset_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib)
+{
+    bml_ellblock_arena_t *arena = &A->arena[ib];
+    arena->current = 0;
+    arena->used = 0;
+    arena->allocated = 0;
+    arena->live = 0;
+}
+
+/** Compact the arena of a block row.
+ *
+ * If more than half of the handed out memory is in holes, or the row
+ * spilled into more than one chunk, the blocks of the row are copied
+ * into a single chunk and the old chunks are freed. Pointers to blocks
+ * of the row outside of A->ptr_value become invalid.
+ *
+ * \param A The matrix
+ * \param ib The block row
+ * \param element_size The size of a matrix element in bytes
+ */
+void
+bml_compact_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib,
+    size_t element_size)
+{
+    bml_ellblock_arena_t *arena = &A->arena[ib];
+    if (arena->nchunks == 1 && arena->allocated <= 2 * arena->live)
+    {
+        return;
+    }
+
+    size_t live = 0;
+    for (int jp = 0; jp < A->nnzb[ib]; jp++)
+    {
+        int jb = A->indexb[ROWMAJOR(ib, jp, A->NB, A->MB)];
+        live += ARENA_ROUND(element_size * A->bsize[ib] * A->bsize[jb]);
+    }
+    size_t size = MAX(live, arena->chunks[0].size);
+    char *data = bml_noinit_allocate_memory(size);
+
+    size_t used = 0;
+    for (int jp = 0; jp < A->MB; jp++)
+    {
+        int ind = ROWMAJOR(ib, jp, A->NB, A->MB);
+        if (jp < A->nnzb[ib])
+        {
+            int jb = A->indexb[ind];
+            size_t nbytes = element_size * A->bsize[ib] * A->bsize[jb];
+            memcpy(data + used, A->ptr_value[ind], nbytes);
+            A->ptr_value[ind] = data + used;
+            used += ARENA_ROUND(nbytes);
+        }
+        else
+        {
+            A->ptr_value[ind] = NULL;
+        }
+    }
+
+    size_t freed = 0;
+    for (int k = 0; k < arena->nchunks; k++)
+    {
+        freed += arena->chunks[k].size;
+        bml_free_memory(arena->chunks[k].data);
+    }
+    arena->chunks[0].data = data;
+    arena->chunks[0].size = size;
+    arena->nchunks = 1;
+    arena->current = 0;
+    arena->used = used;
+    arena->allocated = used;
+    arena->live = used;
+
+#pragma omp critical (bml_ellblock_arena)
+    {
+        A->arena_reserved += size;
+        A->arena_peak = MAX(A->arena_peak, A->arena_reserved);
+        A->arena_reserved -= freed;
+    }
+}
+
+/** Free the arenas of the block rows of a matrix.
+ *
+ * \param A The matrix
+ */
+void
+bml_free_arena_ellblock(
+    bml_matrix_ellblock_t * A)
+{
+    for (int ib = 0; ib < A->NB; ib++)
+    {
+        for (int k = 0; k < A->arena[ib].nchunks; k++)
+        {
+            bml_free_memory(A->arena[ib].chunks[k].data);
+        }
+        free(A->arena[ib].chunks);
+    }
+    bml_free_memory(A->arena);
+}
+#endif
+
+/** Memory usage of the blocks of a matrix.
+ *
+ * Without the memory pool every block is a chunk of its own.
+ *
+ * \param A The matrix
+ * \param stats The memory usage
+ */
+void
+bml_get_memory_stats_ellblock(
+    bml_matrix_ellblock_t * A,
+    bml_ellblock_memory_stats_t * stats)
+{
+    memset(stats, 0, sizeof(bml_ellblock_memory_stats_t));
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+    for (int ib = 0; ib < A->NB; ib++)
+    {
+        stats->allocated += A->arena[ib].allocated;
+        stats->live += A->arena[ib].live;
+        stats->nchunks += A->arena[ib].nchunks;
+    }
+    stats->reserved = A->arena_reserved;
+    stats->peak = A->arena_peak;
+#else
+    size_t element_size = 0;
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            element_size = sizeof(float);
+            break;
+        case double_real:
+        case single_complex:
+            element_size = sizeof(double);
+            break;
+        case double_complex:
+            element_size = 2 * sizeof(double);
+            break;
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    for (int ib = 0; ib < A->NB; ib++)
+    {
+        for (int jp = 0; jp < A->nnzb[ib]; jp++)
+        {
+            int jb = A->indexb[ROWMAJOR(ib, jp, A->NB, A->MB)];
+            stats->live += element_size * A->bsize[ib] * A->bsize[jb];
+        }
+        stats->nchunks += A->nnzb[ib];
+    }
+    stats->reserved = stats->live;
+    stats->peak = stats->live;
+    stats->allocated = stats->live;
+#endif
+    stats->fragmentation = stats->allocated > 0
+        ? 1.0 - (double) stats->live / stats->allocated : 0.0;
+}
+
 /** Deallocate a matrix.
  *
  * \ingroup allocate_group
@@ -121,9 +619,7 @@ bml_deallocate_ellblock(
     bml_matrix_ellblock_t * A)
 {
 #ifdef BML_ELLBLOCK_USE_MEMPOOL
-    bml_free_memory(A->memory_pool_offsets);
-    bml_free_memory(A->memory_pool_ptr);
-    bml_free_memory(A->memory_pool);
+    bml_free_arena_ellblock(A);
 #else
     for (int ib = 0; ib < A->NB; ib++)
         for (int jp = 0; jp < A->nnzb[ib]; jp++)
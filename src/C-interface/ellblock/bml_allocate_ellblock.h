@@ -203,6 +203,49 @@ void bml_set_block_sizes(
 int *bml_get_block_sizes(
     int N,
     int M);
+void bml_set_block_size_discovery(
+    int flag);
+int bml_get_block_size_discovery(
+    void);
+double bml_get_block_fill_efficiency(
+    void);
+int bml_find_block_sizes(
+    int N,
+    int *row_ptr,
+    int *cols,
+    int max_bsize,
+    int *bsize,
+    double *efficiency);
+int *bml_get_block_sizes_from_pattern(
+    int N,
+    int M,
+    int *row_ptr,
+    int *cols);
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+void bml_init_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    size_t * row_bytes);
+void *bml_allocate_from_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib,
+    size_t nbytes);
+void bml_release_to_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib,
+    size_t nbytes);
+void bml_reset_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib);
+void bml_compact_arena_ellblock(
+    bml_matrix_ellblock_t * A,
+    int ib,
+    size_t element_size);
+void bml_free_arena_ellblock(
+    bml_matrix_ellblock_t * A);
+#endif
+void bml_get_memory_stats_ellblock(
+    bml_matrix_ellblock_t * A,
+    bml_ellblock_memory_stats_t * stats);
 int bml_get_mb(
     );
 int bml_get_nb(
@@ -227,6 +270,30 @@ void *bml_allocate_block_ellblock_double_complex(
     const int ib,
     const int nelements);
 
+void *bml_reuse_block_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    const int ib,
+    const int ind,
+    const int nelements);
+
+void *bml_reuse_block_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    const int ib,
+    const int ind,
+    const int nelements);
+
+void *bml_reuse_block_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    const int ib,
+    const int ind,
+    const int nelements);
+
+void *bml_reuse_block_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    const int ib,
+    const int ind,
+    const int nelements);
+
 void bml_free_block_ellblock_single_real(
     bml_matrix_ellblock_t * A,
     const int ib,
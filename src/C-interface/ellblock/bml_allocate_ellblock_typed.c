@@ -25,81 +25,69 @@ void *TYPED_FUNC(
     const int nelements)
 {
 #ifdef BML_ELLBLOCK_USE_MEMPOOL
-    void *allocation = A->memory_pool_ptr[ib];
-    assert(allocation != NULL);
-
-    // update block row ib pointer for next call
-    A->memory_pool_ptr[ib] = ((REAL_T **) A->memory_pool_ptr)[ib] + nelements;
-
-    return allocation;
+    return bml_allocate_from_arena_ellblock(A, ib,
+                                            nelements * sizeof(REAL_T));
 #else
     //return calloc(nelements, sizeof(REAL_T));
     return bml_noinit_allocate_memory(nelements * sizeof(REAL_T));
 #endif
 }
 
+/** Make sure a block slot holds a block with room for nelements.
+ *
+ * The block already in the slot is kept if it is large enough.
+ * Block slots at or past nnzb[ib] must hold a block or NULL.
+ *
+ * \param A The matrix
+ * \param ib The block row
+ * \param ind The index of the block slot in A->ptr_value
+ * \param nelements The number of elements in the block
+ * \return The block
+ */
+void *TYPED_FUNC(
+    bml_reuse_block_ellblock) (
+    bml_matrix_ellblock_t * A,
+    const int ib,
+    const int ind,
+    const int nelements)
+{
+    if (A->ptr_value[ind] != NULL)
+    {
+        int jb = A->indexb[ind];
+        int old_nelements = jb >= 0 ? A->bsize[ib] * A->bsize[jb] : 0;
+        if (old_nelements >= nelements)
+            return A->ptr_value[ind];
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+        bml_release_to_arena_ellblock(A, ib, old_nelements * sizeof(REAL_T));
+#else
+        bml_free_memory(A->ptr_value[ind]);
+#endif
+    }
+    A->ptr_value[ind] =
+        TYPED_FUNC(bml_allocate_block_ellblock) (A, ib, nelements);
+    return A->ptr_value[ind];
+}
+
 void TYPED_FUNC(
     bml_free_block_ellblock) (
     bml_matrix_ellblock_t * A,
     const int ib,
     const int jb)
 {
-#ifdef BML_ELLBLOCK_USE_MEMPOOL
-    int shift = 0;
-    REAL_T *dst = NULL;
-    REAL_T *src = NULL;
-    int nelements = 0;
-    // loop over allocated blocks in row
     for (int jp = 0; jp < A->nnzb[ib]; jp++)
     {
         int ind = ROWMAJOR(ib, jp, A->NB, A->MB);
         int j = A->indexb[ind];
-        // shift pointers when block to be freed is reached
         if (j == jb)
         {
-            shift = A->bsize[ib] * A->bsize[jb];
-            //printf("Remove block %d %d %d\n", ib, jb, shift);
-            // simply set pointer to NULL if last allocated block in row
-            if (jp == A->nnzb[ib] - 1)
-            {
-                A->ptr_value[ind] = NULL;
-                break;
-            }
-            // save pointers to beginning and end of memory
-            // to be freed
-            dst = A->ptr_value[ind];
-            src = A->ptr_value[ind + 1];
-
-            // shift pointers for subsequent blocks
-            for (int jpp = jp + 1; jpp < A->nnzb[ib]; jpp++)
-            {
-                int ind = ROWMAJOR(ib, jpp, A->NB, A->MB);
-
-                // count elements to be shifted in memory
-                int jbb = A->indexb[ind];
-                nelements += A->bsize[ib] * A->bsize[jbb];
-                //printf("%d <- %d\n", ind-1, ind);
-                A->indexb[ind - 1] = A->indexb[ind];
-                A->ptr_value[ind - 1] = (REAL_T *) A->ptr_value[ind] - shift;
-            }
-            A->ptr_value[A->nnzb[ib] - 1] = NULL;
-            break;
-        }
-    }
-    // make sure we found block to deallocate
-    assert(shift > 0);
-
-    // move data in memory to reflect shift in pointers
-    if (nelements > 0)
-        memmove(dst, src, nelements * sizeof(REAL_T));
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+            // leave a hole, reclaimed when the row is compacted
+            bml_release_to_arena_ellblock(A, ib,
+                                          A->bsize[ib] * A->bsize[jb] *
+                                          sizeof(REAL_T));
 #else
-    for (int jp = 0; jp < A->nnzb[ib]; jp++)
-    {
-        int ind = ROWMAJOR(ib, jp, A->NB, A->MB);
-        int j = A->indexb[ind];
-        if (j == jb)
-        {
             bml_free_memory(A->ptr_value[ind]);
+#endif
             for (int jpp = jp + 1; jpp < A->nnzb[ib]; jpp++)
             {
                 int ind = ROWMAJOR(ib, jpp, A->NB, A->MB);
@@ -112,13 +100,13 @@ void TYPED_FUNC(
             break;
         }
     }
-#endif
     A->nnzb[ib]--;
 }
 
 /** Clear a matrix.
  *
- * Numbers of non-zeroes/row are set to zero.
+ * Numbers of non-zeroes/row are set to zero. With the memory pool the
+ * arena of each block row is reset in O(1).
  *
  * \ingroup allocate_group
  *
@@ -128,18 +116,20 @@ void TYPED_FUNC(
     bml_clear_ellblock) (
     bml_matrix_ellblock_t * A)
 {
-#ifdef BML_ELLBLOCK_USE_MEMPOOL
     for (int ib = 0; ib < A->NB; ib++)
-        A->memory_pool_ptr[ib] =
-            (REAL_T *) A->memory_pool + A->memory_pool_offsets[ib];
+    {
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+        bml_reset_arena_ellblock(A, ib);
 #else
-    for (int ib = 0; ib < A->NB; ib++)
         for (int jp = 0; jp < A->nnzb[ib]; jp++)
         {
             int ind = ROWMAJOR(ib, jp, A->NB, A->MB);
             bml_free_memory(A->ptr_value[ind]);
         }
 #endif
+    }
+    for (int i = 0; i < A->NB * A->MB; i++)
+        A->ptr_value[i] = NULL;
     memset(A->nnzb, 0, A->NB * sizeof(int));
 }
 
@@ -214,19 +204,12 @@ bml_matrix_ellblock_t *TYPED_FUNC(
     if (ncols_storage < 3 * maxbsize)
         ncols_storage = 3 * maxbsize;
 #ifdef BML_ELLBLOCK_USE_MEMPOOL
-    A->memory_pool =
-        (REAL_T *) bml_allocate_memory(sizeof(REAL_T) * N * ncols_storage);
-
-    // allocate memory for pointers to allocated blocks
-    A->memory_pool_offsets = (int *) bml_allocate_memory(sizeof(int) * NB);
-    A->memory_pool_offsets[0] = 0;
-    for (int ib = 1; ib < NB; ib++)
-        A->memory_pool_offsets[ib] = A->memory_pool_offsets[ib - 1]
-            + bsize[ib - 1] * ncols_storage;
-    A->memory_pool_ptr = bml_allocate_memory(sizeof(REAL_T *) * NB);
+    // the arenas grow on demand beyond this initial size
+    size_t *row_bytes = bml_allocate_memory(sizeof(size_t) * NB);
     for (int ib = 0; ib < NB; ib++)
-        A->memory_pool_ptr[ib] =
-            (REAL_T *) (A->memory_pool) + A->memory_pool_offsets[ib];
+        row_bytes[ib] = sizeof(REAL_T) * bsize[ib] * ncols_storage;
+    bml_init_arena_ellblock(A, row_bytes);
+    bml_free_memory(row_bytes);
 #endif
     A->ptr_value = bml_allocate_memory(sizeof(REAL_T *) * NB * MB);
     for (int i = 0; i < NB * MB; i++)
@@ -1,6 +1,7 @@
 #include "../../macros.h"
 #include "../../typed.h"
 #include "../bml_allocate.h"
+#include "../bml_export.h"
 #include "../bml_getters.h"
 #include "../bml_introspection.h"
 #include "../bml_logger.h"
@@ -28,7 +29,22 @@ bml_matrix_ellblock_t *TYPED_FUNC(
     }
 
     //create new empty matrix
-    int *bsize = bml_get_block_sizes(N, N);
+    int *bsize = NULL;
+    if (bml_get_block_size_discovery())
+    {
+        int *row_ptr = NULL;
+        int *cols = NULL;
+        void *vals = NULL;
+        bml_export_to_compressed_rows(A, &row_ptr, &cols, &vals);
+        bsize = bml_get_block_sizes_from_pattern(N, N, row_ptr, cols);
+        bml_free_memory(row_ptr);
+        bml_free_memory(cols);
+        bml_free_memory(vals);
+    }
+    else
+    {
+        bsize = bml_get_block_sizes(N, N);
+    }
     int nb = bml_get_nb();
 
     bml_matrix_ellblock_t *B =
@@ -58,6 +58,51 @@ void bml_reorder_ellblock_double_complex(
     bml_matrix_ellblock_t * A,
     int *perm);
 
+void bml_copy_panel_ellblock(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
 void bml_save_domain_ellblock(
     bml_matrix_ellblock_t * A);
 
@@ -5,6 +5,8 @@
 #include "../bml_types.h"
 #include "bml_allocate_ellblock.h"
 #include "bml_copy_ellblock.h"
+#include "bml_getters_ellblock.h"
+#include "bml_setters_ellblock.h"
 #include "bml_types_ellblock.h"
 
 #include <assert.h>
@@ -42,7 +44,7 @@ bml_matrix_ellblock_t
     for (int ib = 0; ib < NB; ib++)
     {
         assert(B->bsize[ib] > 0);
-        assert(B->bsize[ib] < 10);
+        assert(B->bsize[ib] <= BMAXSIZE);
         for (int jp = 0; jp < A->nnzb[ib]; jp++)
         {
             int ind = ROWMAJOR(ib, jp, NB, MB);
@@ -85,7 +87,6 @@ void TYPED_FUNC(
 
     int *A_indexb = A->indexb;
     int *B_indexb = B->indexb;
-    memcpy(B_indexb, A_indexb, NB * MB * sizeof(int));
 
 #pragma omp parallel for
     for (int ib = 0; ib < NB; ib++)
@@ -94,13 +95,10 @@ void TYPED_FUNC(
         {
             int ind = ROWMAJOR(ib, jp, NB, MB);
             assert(A_ptr_value[ind] != NULL);
-            int jb = B_indexb[ind];
+            int jb = A_indexb[ind];
             int nelements = A->bsize[ib] * A->bsize[jb];
-            if (B_ptr_value[ind] == NULL)
-                B_ptr_value[ind]
-                    =
-                    TYPED_FUNC(bml_allocate_block_ellblock) (B, ib,
-                                                             nelements);
+            TYPED_FUNC(bml_reuse_block_ellblock) (B, ib, ind, nelements);
+            B_indexb[ind] = jb;
             assert(B_ptr_value[ind] != NULL);
             memcpy(B_ptr_value[ind], A_ptr_value[ind],
                    nelements * sizeof(REAL_T));
@@ -169,3 +167,42 @@ void TYPED_FUNC(
         }
     }
 }
+
+/** Copy a panel of an ellblock matrix.
+ *
+ *  B(l0 + i, j) = A(i0 + i, j) for 0 <= i < nrows and j0 <= j < j0 +
+ *  ncols, the other elements of B are zero.
+ *
+ *  \ingroup copy_group
+ *
+ *  \param A The matrix to copy from
+ *  \param B The panel
+ *  \param i0 The first row of the panel in A
+ *  \param nrows The number of rows of the panel
+ *  \param j0 The first column of the panel
+ *  \param ncols The number of columns of the panel
+ *  \param l0 The first row of the panel in B
+ */
+void TYPED_FUNC(
+    bml_copy_panel_ellblock) (
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0)
+{
+    int N = A->N;
+
+    // the blocks straddle the edges of the panel, go through rows
+    TYPED_FUNC(bml_clear_ellblock) (B);
+    for (int i = 0; i < nrows; i++)
+    {
+        REAL_T *row = TYPED_FUNC(bml_get_row_ellblock) (A, i0 + i);
+        memset(row, 0, j0 * sizeof(REAL_T));
+        memset(row + j0 + ncols, 0, (N - j0 - ncols) * sizeof(REAL_T));
+        TYPED_FUNC(bml_set_row_ellblock) (B, l0 + i, row, 0.);
+        bml_free_memory(row);
+    }
+}
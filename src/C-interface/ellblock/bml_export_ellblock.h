@@ -23,4 +23,34 @@ void *bml_export_to_dense_ellblock_double_complex(
     bml_matrix_ellblock_t * A,
     bml_dense_order_t order);
 
+void bml_export_to_compressed_rows_ellblock(
+    bml_matrix_ellblock_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
 #endif
@@ -100,3 +100,105 @@ void *TYPED_FUNC(
 
     return A_dense;
 }
+
+/** Convert a bml matrix into compressed rows.
+ *
+ * The entries of row i are cols[k] and vals[k] for
+ * row_ptr[i] <= k < row_ptr[i + 1]. Only the non-zero
+ * elements of the stored blocks are exported.
+ *
+ * \ingroup convert_group
+ *
+ * \param A The bml matrix
+ * \param row_ptr The row pointers (N + 1), allocated here
+ * \param cols The column indices, allocated here
+ * \param vals The values, allocated here
+ */
+void TYPED_FUNC(
+    bml_export_to_compressed_rows_ellblock) (
+    bml_matrix_ellblock_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    int N = A->N;
+    int NB = A->NB;
+    int MB = A->MB;
+    int *A_nnzb = A->nnzb;
+    int *A_indexb = A->indexb;
+    int *bsize = A->bsize;
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+
+    int *offset = bml_allocate_memory(sizeof(int) * (NB + 1));
+    for (int ib = 0; ib < NB; ib++)
+    {
+        offset[ib + 1] = offset[ib] + bsize[ib];
+    }
+
+    int *A_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+
+    // count the non-zeros of every row
+#pragma omp parallel for shared(A_ptr, A_nnzb, A_indexb, A_ptr_value)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        for (int ii = 0; ii < bsize[ib]; ii++)
+        {
+            int nnz = 0;
+            for (int jp = 0; jp < A_nnzb[ib]; jp++)
+            {
+                int ind = ROWMAJOR(ib, jp, NB, MB);
+                int jb = A_indexb[ind];
+                REAL_T *A_value = A_ptr_value[ind];
+                for (int jj = 0; jj < bsize[jb]; jj++)
+                {
+                    if (is_above_threshold
+                        (A_value[ROWMAJOR(ii, jj, bsize[ib], bsize[jb])],
+                         0.0))
+                    {
+                        nnz++;
+                    }
+                }
+            }
+            A_ptr[offset[ib] + ii + 1] = nnz;
+        }
+    }
+    for (int i = 0; i < N; i++)
+    {
+        A_ptr[i + 1] += A_ptr[i];
+    }
+
+    int *A_cols = bml_noinit_allocate_memory(sizeof(int) * MAX(A_ptr[N], 1));
+    REAL_T *A_vals =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(A_ptr[N], 1));
+
+#pragma omp parallel for shared(A_ptr, A_cols, A_vals, A_nnzb, A_indexb, A_ptr_value)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        for (int ii = 0; ii < bsize[ib]; ii++)
+        {
+            int k = A_ptr[offset[ib] + ii];
+            for (int jp = 0; jp < A_nnzb[ib]; jp++)
+            {
+                int ind = ROWMAJOR(ib, jp, NB, MB);
+                int jb = A_indexb[ind];
+                REAL_T *A_value = A_ptr_value[ind];
+                for (int jj = 0; jj < bsize[jb]; jj++)
+                {
+                    REAL_T A_ij =
+                        A_value[ROWMAJOR(ii, jj, bsize[ib], bsize[jb])];
+                    if (is_above_threshold(A_ij, 0.0))
+                    {
+                        A_cols[k] = offset[jb] + jj;
+                        A_vals[k] = A_ij;
+                        k++;
+                    }
+                }
+            }
+        }
+    }
+    bml_free_memory(offset);
+
+    *row_ptr = A_ptr;
+    *cols = A_cols;
+    *vals = A_vals;
+}
@@ -48,4 +48,45 @@ bml_matrix_ellblock_t
                                                     bml_distribution_mode_t
                                                     distrib_mode);
 
+bml_matrix_ellblock_t *bml_import_from_compressed_rows_ellblock(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_ellblock_t *bml_import_from_compressed_rows_ellblock_single_real(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_ellblock_t *bml_import_from_compressed_rows_ellblock_double_real(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_ellblock_t *bml_import_from_compressed_rows_ellblock_single_complex(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
+bml_matrix_ellblock_t *bml_import_from_compressed_rows_ellblock_double_complex(
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode);
+
 #endif
@@ -34,6 +34,30 @@ bml_matrix_ellblock_t
                                                   bml_distribution_mode_t
                                                   distrib_mode)
 {
+    REAL_T *dense_A = (REAL_T *) A;
+
+    // find the block sizes from the pattern of the dense matrix
+    if (bml_get_block_size_discovery())
+    {
+        int *row_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+        int *cols = bml_noinit_allocate_memory(sizeof(int) * N * N);
+        for (int i = 0; i < N; i++)
+        {
+            row_ptr[i + 1] = row_ptr[i];
+            for (int j = 0; j < N; j++)
+            {
+                REAL_T a_ij = (order == dense_row_major)
+                    ? dense_A[ROWMAJOR(i, j, N, N)]
+                    : dense_A[COLMAJOR(i, j, N, N)];
+                if (is_above_threshold(a_ij, threshold))
+                    cols[row_ptr[i + 1]++] = j;
+            }
+        }
+        bml_get_block_sizes_from_pattern(N, M, row_ptr, cols);
+        bml_free_memory(row_ptr);
+        bml_free_memory(cols);
+    }
+
     bml_matrix_ellblock_t *A_bml =
         TYPED_FUNC(bml_zero_matrix_ellblock) (N, M, distrib_mode);
 
@@ -43,8 +67,6 @@ bml_matrix_ellblock_t
     int *A_nnzb = A_bml->nnzb;
     int *A_bsize = A_bml->bsize;
 
-    REAL_T *dense_A = (REAL_T *) A;
-
     int *offset = malloc(NB * sizeof(int));
     offset[0] = 0;
     for (int ib = 1; ib < NB; ib++)
@@ -101,3 +123,132 @@ bml_matrix_ellblock_t
 
     return A_bml;
 }
+
+/** Convert compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group
+ *
+ * \param N The number of rows/columns
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ * \param M The number of non-zeroes per row
+ * \param distrib_mode The distribution mode
+ * \return The bml matrix
+ */
+bml_matrix_ellblock_t *TYPED_FUNC(
+    bml_import_from_compressed_rows_ellblock) (
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode)
+{
+    int *bsize = bml_get_block_sizes_from_pattern(N, M, row_ptr, cols);
+    int NB = bml_get_nb();
+
+    int *offset = bml_allocate_memory(sizeof(int) * (NB + 1));
+    for (int ib = 0; ib < NB; ib++)
+    {
+        offset[ib + 1] = offset[ib] + bsize[ib];
+    }
+    // block column of every column
+    int *col_block = bml_noinit_allocate_memory(sizeof(int) * N);
+    for (int ib = 0; ib < NB; ib++)
+    {
+        for (int j = offset[ib]; j < offset[ib + 1]; j++)
+        {
+            col_block[j] = ib;
+        }
+    }
+
+    // find the number of blocks and the storage width of each block row
+    int max_nnzb = 0;
+    int max_width = 0;
+#pragma omp parallel reduction(max:max_nnzb, max_width)
+    {
+        int *mark = bml_allocate_memory(sizeof(int) * NB);
+#pragma omp for
+        for (int ib = 0; ib < NB; ib++)
+        {
+            int nnzb = 0;
+            int width = 0;
+            for (int k = row_ptr[offset[ib]]; k < row_ptr[offset[ib + 1]];
+                 k++)
+            {
+                int jb = col_block[cols[k]];
+                if (mark[jb] != ib + 1)
+                {
+                    mark[jb] = ib + 1;
+                    nnzb++;
+                    width += bsize[jb];
+                }
+            }
+            max_nnzb = MAX(max_nnzb, nnzb);
+            max_width = MAX(max_width, width);
+        }
+        bml_free_memory(mark);
+    }
+
+    int MB = MAX(bml_get_mb(), max_nnzb);
+    bml_matrix_ellblock_t *A_bml =
+        TYPED_FUNC(bml_block_matrix_ellblock) (NB, MB, MAX(M, max_width),
+                                               bsize, distrib_mode);
+
+    int *A_nnzb = A_bml->nnzb;
+    int *A_indexb = A_bml->indexb;
+    REAL_T **A_ptr_value = (REAL_T **) A_bml->ptr_value;
+    REAL_T *A_vals = (REAL_T *) vals;
+
+#pragma omp parallel
+    {
+        // position of each block column within the current block row
+        int *slot = bml_noinit_allocate_memory(sizeof(int) * NB);
+        for (int jb = 0; jb < NB; jb++)
+        {
+            slot[jb] = -1;
+        }
+#pragma omp for
+        for (int ib = 0; ib < NB; ib++)
+        {
+            int nnzb = 0;
+            for (int ii = 0; ii < bsize[ib]; ii++)
+            {
+                int i = offset[ib] + ii;
+                for (int k = row_ptr[i]; k < row_ptr[i + 1]; k++)
+                {
+                    int jb = col_block[cols[k]];
+                    if (slot[jb] < 0)
+                    {
+                        int ind = ROWMAJOR(ib, nnzb, NB, MB);
+                        int nelements = bsize[ib] * bsize[jb];
+                        A_ptr_value[ind] =
+                            TYPED_FUNC(bml_allocate_block_ellblock) (A_bml,
+                                                                     ib,
+                                                                     nelements);
+                        memset(A_ptr_value[ind], 0,
+                               sizeof(REAL_T) * nelements);
+                        A_indexb[ind] = jb;
+                        slot[jb] = nnzb;
+                        nnzb++;
+                    }
+                    REAL_T *A_value = A_ptr_value[ROWMAJOR(ib, slot[jb], NB,
+                                                           MB)];
+                    A_value[ROWMAJOR(ii, cols[k] - offset[jb], bsize[ib],
+                                     bsize[jb])] = A_vals[k];
+                }
+            }
+            A_nnzb[ib] = nnzb;
+            for (int jp = 0; jp < nnzb; jp++)
+            {
+                slot[A_indexb[ROWMAJOR(ib, jp, NB, MB)]] = -1;
+            }
+        }
+        bml_free_memory(slot);
+    }
+    bml_free_memory(col_block);
+    bml_free_memory(offset);
+
+    return A_bml;
+}
@@ -58,6 +58,62 @@ bml_multiply_ellblock(
     }
 }
 
+/** Norm screened matrix multiply.
+ *
+ * C = alpha * A * B + beta * C
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param A Matrix A
+ *  \param B Matrix B
+ *  \param C Matrix C
+ *  \param alpha Scalar factor multiplied by A * B
+ *  \param beta Scalar factor multiplied by C
+ *  \param threshold Used for sparse multiply
+ *  \param screening Screening tolerance relative to threshold
+ *  \param stats Statistics of the skipped products (can be NULL)
+ */
+void
+bml_multiply_screened_ellblock(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_multiply_screened_ellblock_single_real(A, B, C, alpha,
+                                                       beta, threshold,
+                                                       screening, stats);
+            break;
+        case double_real:
+            bml_multiply_screened_ellblock_double_real(A, B, C, alpha,
+                                                       beta, threshold,
+                                                       screening, stats);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_multiply_screened_ellblock_single_complex(A, B, C, alpha,
+                                                          beta, threshold,
+                                                          screening, stats);
+            break;
+        case double_complex:
+            bml_multiply_screened_ellblock_double_complex(A, B, C, alpha,
+                                                          beta, threshold,
+                                                          screening, stats);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 /** Matrix multiply.
  *
  * X2 = X * X
@@ -98,6 +98,88 @@ void bml_multiply_AB_ellblock_double_complex(
     bml_matrix_ellblock_t * C,
     double threshold);
 
+void bml_multiply_screened_ellblock(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_screened_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_screened_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_screened_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_screened_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_AB_screened_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double threshold,
+    double tolerance,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_AB_screened_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double threshold,
+    double tolerance,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_AB_screened_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double threshold,
+    double tolerance,
+    bml_screening_stats_t * stats);
+
+void bml_multiply_AB_screened_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double threshold,
+    double tolerance,
+    bml_screening_stats_t * stats);
+
 void bml_multiply_adjust_AB_ellblock(
     bml_matrix_ellblock_t * A,
     bml_matrix_ellblock_t * B,
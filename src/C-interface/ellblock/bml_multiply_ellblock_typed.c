@@ -25,145 +25,154 @@
 #include <omp.h>
 #endif
 
-void TYPED_FUNC(
-    bml_multiply_block1) (
-    REAL_T * mat0,
-    REAL_T * mat1,
-    const int ld,
-    REAL_T * x,
-    const int bsizeib,
-    const int bsizekb)
+/** The real type underlying REAL_T. */
+#if defined(SINGLE_REAL) || defined(SINGLE_COMPLEX)
+#define REAL_PART_T float
+#else
+#define REAL_PART_T double
+#endif
+
+/** Block product \f$ x \leftarrow x + a \, b \f$.
+ *
+ * All blocks are stored row-major: a is bsizei x bsizej, b is
+ * bsizej x bsizek and x is bsizei x bsizek. The innermost loop runs
+ * along a row of b and x so that it vectorizes without transposing b.
+ *
+ * \param bsizei The number of rows of a and x
+ * \param bsizej The number of columns of a and rows of b
+ * \param bsizek The number of columns of b and x
+ * \param a The left block
+ * \param b The right block
+ * \param x The accumulated product
+ */
+static inline void TYPED_FUNC(
+    bml_multiply_block_kernel) (
+    const int bsizei,
+    const int bsizej,
+    const int bsizek,
+    const REAL_T * restrict a,
+    const REAL_T * restrict b,
+    REAL_T * restrict x)
 {
-    REAL_T *xk = x;
-    for (int ii = 0; ii < bsizeib; ii++)
+#if defined(SINGLE_COMPLEX) || defined(DOUBLE_COMPLEX)
+    /* Real and imaginary parts are accumulated separately, a complex
+     * multiply in C would go through the C99 Annex G library call. */
+    const REAL_PART_T *a_ri = (const REAL_PART_T *) a;
+    const REAL_PART_T *b_ri = (const REAL_PART_T *) b;
+    REAL_PART_T *x_ri = (REAL_PART_T *) x;
+
+    for (int ii = 0; ii < bsizei; ii++)
     {
-        REAL_T *a = mat0 + ld * ii;
-        REAL_T *b = mat1;
-        for (int jj = 0; jj < bsizekb; jj++)
+        REAL_PART_T *xi = x_ri + 2 * ii * bsizek;
+        for (int jj = 0; jj < bsizej; jj++)
         {
-            (*xk) += a[0] * b[0];
-            xk++;
-            b += ld;
+            const REAL_PART_T a_re = a_ri[2 * (ii * bsizej + jj)];
+            const REAL_PART_T a_im = a_ri[2 * (ii * bsizej + jj) + 1];
+            const REAL_PART_T *bj = b_ri + 2 * jj * bsizek;
+#pragma omp simd
+            for (int kk = 0; kk < bsizek; kk++)
+            {
+                xi[2 * kk] += a_re * bj[2 * kk] - a_im * bj[2 * kk + 1];
+                xi[2 * kk + 1] += a_re * bj[2 * kk + 1] + a_im * bj[2 * kk];
+            }
         }
     }
-}
-
-void TYPED_FUNC(
-    bml_multiply_block2) (
-    REAL_T * mat0,
-    REAL_T * mat1,
-    const int ld,
-    REAL_T * x,
-    const int bsizeib,
-    const int bsizekb)
-{
-    REAL_T *xk = x;
-    for (int ii = 0; ii < bsizeib; ii++)
+#else
+    for (int ii = 0; ii < bsizei; ii++)
     {
-        REAL_T *a = mat0 + ld * ii;
-        REAL_T *b = mat1;
-        for (int jj = 0; jj < bsizekb; jj++)
+        REAL_T *xi = x + ii * bsizek;
+        for (int jj = 0; jj < bsizej; jj++)
         {
-            (*xk) += a[0] * b[0] + a[1] * b[1];
-            xk++;
-            b += ld;
+            const REAL_T aij = a[ii * bsizej + jj];
+            const REAL_T *bj = b + jj * bsizek;
+#pragma omp simd
+            for (int kk = 0; kk < bsizek; kk++)
+                xi[kk] += aij * bj[kk];
         }
     }
+#endif
 }
 
-void TYPED_FUNC(
-    bml_multiply_block3) (
-    REAL_T * mat0,
-    REAL_T * mat1,
-    const int ld,
-    REAL_T * x,
-    const int bsizeib,
-    const int bsizekb)
-{
-    REAL_T *xk = x;
-    for (int ii = 0; ii < bsizeib; ii++)
-    {
-        REAL_T *a = mat0 + ld * ii;
-        REAL_T *b = mat1;
-        for (int jj = 0; jj < bsizekb; jj++)
-        {
-            (*xk) += a[0] * b[0] + a[1] * b[1] + a[2] * b[2];
-            xk++;
-            b += ld;
-        }
+/* Instantiate the block kernel for every (bsizei, bsizek) pair up to
+ * BMAXSIZE. With both sizes known at compile time the row loop is
+ * unrolled and the column loop vectorized to its exact length; only
+ * the inner dimension bsizej remains a runtime argument. */
+#if BMAXSIZE != 25
+#error "The block kernel table has to be extended to BMAXSIZE"
+#endif
+
+#define BML_BLOCK_COLUMNS(F, I)                                     \
+    F(I, 1) F(I, 2) F(I, 3) F(I, 4) F(I, 5) F(I, 6) F(I, 7)         \
+    F(I, 8) F(I, 9) F(I, 10) F(I, 11) F(I, 12) F(I, 13) F(I, 14)    \
+    F(I, 15) F(I, 16) F(I, 17) F(I, 18) F(I, 19) F(I, 20) F(I, 21)  \
+    F(I, 22) F(I, 23) F(I, 24) F(I, 25)
+
+#define BML_BLOCK_ROWS(R)                                           \
+    R(1) R(2) R(3) R(4) R(5) R(6) R(7) R(8) R(9) R(10) R(11) R(12)  \
+    R(13) R(14) R(15) R(16) R(17) R(18) R(19) R(20) R(21) R(22)     \
+    R(23) R(24) R(25)
+
+#define BML_MULTIPLY_BLOCK_DEFINE(I, K)                             \
+    static void TYPED_FUNC(                                         \
+        bml_multiply_block_##I##_##K) (                             \
+        const REAL_T * restrict a,                                  \
+        const REAL_T * restrict b,                                  \
+        const int bsizej,                                           \
+        REAL_T * restrict x)                                        \
+    {                                                               \
+        TYPED_FUNC(bml_multiply_block_kernel) (I, bsizej, K,        \
+                                               a, b, x);            \
     }
-}
 
-void TYPED_FUNC(
-    bml_multiply_block4) (
-    REAL_T * mat0,
-    REAL_T * mat1,
-    const int ld,
-    REAL_T * x,
-    const int bsizeib,
-    const int bsizekb)
+#define BML_MULTIPLY_BLOCK_ROW(I)                                   \
+    BML_BLOCK_COLUMNS(BML_MULTIPLY_BLOCK_DEFINE, I)
+
+#define BML_MULTIPLY_BLOCK_ENTRY(I, K)                              \
+    TYPED_FUNC(bml_multiply_block_##I##_##K),
+
+#define BML_MULTIPLY_BLOCK_TABLE_ROW(I)                             \
+    {BML_BLOCK_COLUMNS(BML_MULTIPLY_BLOCK_ENTRY, I)},
+
+BML_BLOCK_ROWS(BML_MULTIPLY_BLOCK_ROW)
+
+/** Block kernels indexed by (bsizei - 1, bsizek - 1). */
+static void (
+    *const TYPED_FUNC(bml_multiply_block_table)[BMAXSIZE][BMAXSIZE]) (
+    const REAL_T * restrict,
+    const REAL_T * restrict,
+    const int,
+    REAL_T * restrict) =
 {
-    REAL_T *xk = x;
-    for (int ii = 0; ii < bsizeib; ii++)
-    {
-        REAL_T *a = mat0 + ld * ii;
-        REAL_T *b = mat1;
-        for (int jj = 0; jj < bsizekb; jj++)
-        {
-            (*xk) += a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3];
-            xk++;
-            b += ld;
-        }
-    }
-}
+BML_BLOCK_ROWS(BML_MULTIPLY_BLOCK_TABLE_ROW)};
 
-void TYPED_FUNC(
-    bml_multiply_block5) (
-    REAL_T * mat0,
-    REAL_T * mat1,
-    const int ld,
+/** Block product \f$ x \leftarrow x + a \, b \f$ through the kernel
+ *  specialized for the block sizes.
+ *
+ * \param a The bsizei x bsizej left block
+ * \param b The bsizej x bsizek right block
+ * \param x The bsizei x bsizek accumulated product
+ * \param bsizei The number of rows of a and x
+ * \param bsizej The number of columns of a and rows of b
+ * \param bsizek The number of columns of b and x
+ */
+static inline void TYPED_FUNC(
+    bml_multiply_block) (
+    const REAL_T * a,
+    const REAL_T * b,
     REAL_T * x,
-    const int bsizeib,
-    const int bsizekb)
+    const int bsizei,
+    const int bsizej,
+    const int bsizek)
 {
-    REAL_T *xk = x;
-    for (int ii = 0; ii < bsizeib; ii++)
+    if (bsizei <= BMAXSIZE && bsizek <= BMAXSIZE)
     {
-        REAL_T *a = mat0 + ld * ii;
-        REAL_T *b = mat1;
-        for (int jj = 0; jj < bsizekb; jj++)
-        {
-            (*xk) +=
-                a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] +
-                a[4] * b[4];
-            xk++;
-            b += ld;
-        }
+        TYPED_FUNC(bml_multiply_block_table)[bsizei - 1][bsizek - 1]
+            (a, b, bsizej, x);
     }
-}
-
-void TYPED_FUNC(
-    bml_multiply_block6) (
-    REAL_T * mat0,
-    REAL_T * mat1,
-    const int ld,
-    REAL_T * x,
-    const int bsizeib,
-    const int bsizekb)
-{
-    REAL_T *xk = x;
-    for (int ii = 0; ii < bsizeib; ii++)
+    else
     {
-        REAL_T *a = mat0 + ld * ii;
-        REAL_T *b = mat1;
-        for (int jj = 0; jj < bsizekb; jj++)
-        {
-            (*xk) +=
-                a[0] * b[0] + a[1] * b[1] + a[2] * b[2] + a[3] * b[3] +
-                a[4] * b[4] + a[5] * b[5];
-            xk++;
-            b += ld;
-        }
+        TYPED_FUNC(bml_multiply_block_kernel) (bsizei, bsizej, bsizek,
+                                               a, b, x);
     }
 }
 
@@ -230,6 +239,129 @@ void TYPED_FUNC(
     }
 }
 
+/** Norm screened matrix multiply.
+ *
+ * \f$ C \leftarrow \alpha A \, B + \beta C \f$
+ *
+ * \ingroup multiply_group
+ *
+ * \param A Matrix A
+ * \param B Matrix B
+ * \param C Matrix C
+ * \param alpha Scalar factor multiplied by A * B
+ * \param beta Scalar factor multiplied by C
+ * \param threshold Used for sparse multiply
+ * \param screening Screening tolerance relative to threshold
+ * \param stats Statistics of the skipped products (can be NULL)
+ */
+void TYPED_FUNC(
+    bml_multiply_screened_ellblock) (
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double alpha,
+    double beta,
+    double threshold,
+    double screening,
+    bml_screening_stats_t * stats)
+{
+    if (A == NULL || B == NULL)
+    {
+        LOG_ERROR("Either matrix A or B are NULL\n");
+    }
+
+    bml_matrix_ellblock_t *A2 =
+        TYPED_FUNC(bml_block_matrix_ellblock) (C->NB, C->MB, C->M,
+                                               C->bsize,
+                                               C->distribution_mode);
+
+    TYPED_FUNC(bml_multiply_AB_screened_ellblock) (A, B, A2, threshold,
+                                                   screening * threshold,
+                                                   stats);
+    if (stats != NULL)
+    {
+        stats->error_bound *= fabs(alpha);
+    }
+
+#ifdef DO_MPI
+    if (bml_getNRanks() > 1 && A2->distribution_mode == distributed)
+    {
+        bml_allGatherVParallel(A2);
+    }
+#endif
+
+    TYPED_FUNC(bml_add_ellblock) (C, A2, beta, alpha, threshold);
+
+    bml_deallocate_ellblock(A2);
+}
+
+/** Frobenius norms of the blocks of a matrix.
+ *
+ * The blocks of each block row are ordered by decreasing norm, so that
+ * a screened loop over a row can stop at the first product below the
+ * tolerance.
+ *
+ * \param A Matrix A
+ * \param order The positions of the blocks of a row, by decreasing norm
+ * \param norm The block norms, in that order
+ * \param tail The sums of the norms from a position to the end of the row
+ */
+static void TYPED_FUNC(
+    bml_sorted_block_norms_ellblock) (
+    bml_matrix_ellblock_t * A,
+    int *order,
+    double *norm,
+    double *tail)
+{
+    int NB = A->NB;
+    int MB = A->MB;
+    int *A_nnzb = A->nnzb;
+    int *A_indexb = A->indexb;
+    int *bsize = A->bsize;
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+
+#pragma omp parallel for
+    for (int ib = 0; ib < NB; ib++)
+    {
+        int *row_order = order + ROWMAJOR(ib, 0, NB, MB);
+        double *row_norm = norm + ROWMAJOR(ib, 0, NB, MB);
+        double *row_tail = tail + ROWMAJOR(ib, 0, NB, MB);
+
+        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, NB, MB);
+            REAL_T *A_value = A_ptr_value[ind];
+            int nelements = bsize[ib] * bsize[A_indexb[ind]];
+            double sum = 0.0;
+            for (int i = 0; i < nelements; i++)
+            {
+                double re = REAL_PART(A_value[i]);
+                double im = IMAGINARY_PART(A_value[i]);
+                sum += re * re + im * im;
+            }
+            double block_norm = sqrt(sum);
+
+            // insertion sort, rows hold at most MB blocks
+            int q = jp;
+            while (q > 0 && row_norm[q - 1] < block_norm)
+            {
+                row_norm[q] = row_norm[q - 1];
+                row_order[q] = row_order[q - 1];
+                q--;
+            }
+            row_norm[q] = block_norm;
+            row_order[q] = jp;
+        }
+
+        double sum = 0.0;
+        for (int q = A_nnzb[ib] - 1; q >= 0; q--)
+        {
+            sum += row_norm[q];
+            row_tail[q] = sum;
+        }
+    }
+}
+
 /** Matrix multiply.
  *
  * \f$ X^{2} \leftarrow X \, X \f$
@@ -284,21 +416,6 @@ void *TYPED_FUNC(
 
     char xptrset = 0;
 
-    void (
-    *fun_ptr_arr[]) (
-    REAL_T *,
-    REAL_T *,
-    const int,
-    REAL_T *,
-    const int,
-    const int) =
-    {
-    TYPED_FUNC(bml_multiply_block1),
-            TYPED_FUNC(bml_multiply_block2),
-            TYPED_FUNC(bml_multiply_block3),
-            TYPED_FUNC(bml_multiply_block4),
-            TYPED_FUNC(bml_multiply_block5), TYPED_FUNC(bml_multiply_block6)};
-
 #if defined(__IBMC__) || defined(__ibmxl__)
 #pragma omp parallel for                           \
     firstprivate(xptrset)            \
@@ -332,9 +449,6 @@ void *TYPED_FUNC(
             xptrset = 1;
         }
 
-        REAL_T *T_value_right =
-            bml_noinit_allocate_memory(maxbsize2 * sizeof(REAL_T));
-
         // loop over non-zero blocks in row block ib
         for (int jp = 0; jp < X_nnzb[ib]; jp++)
         {
@@ -363,17 +477,9 @@ void *TYPED_FUNC(
 
                 // multiply block ib,jb by block jb,kb
 #ifndef BML_USE_XSMM
-                const int bsizekb = bsize[kb];
-                // transpose storage for matrix on the right
-                for (int ii = 0; ii < bsizejb; ii++)
-                {
-                    const int offset = ii * bsizekb;
-                    for (int jj = 0; jj < bsizekb; jj++)
-                        T_value_right[jj * bsizejb + ii]
-                            = X_value_right[offset + jj];
-                }
-                (*fun_ptr_arr[bsizejb - 1]) (X_value_left, T_value_right,
-                                             bsizejb, x, bsize[ib], bsizekb);
+                TYPED_FUNC(bml_multiply_block) (X_value_left, X_value_right,
+                                                x, bsize[ib], bsizejb,
+                                                bsize[kb]);
 #else
                 REAL_T alpha = (REAL_T) 1.;
                 REAL_T beta = (REAL_T) 1.;
@@ -411,10 +517,8 @@ void *TYPED_FUNC(
                 int nelements = bsize[ib] * bsize[jp];
                 int ind = ROWMAJOR(ib, ll, NB, MB);
                 assert(ind < NB * MB);
-                if (X2_ptr_value[ind] == NULL)
-                    X2_ptr_value[ind] =
-                        TYPED_FUNC(bml_allocate_block_ellblock) (X2, ib,
-                                                                 nelements);
+                TYPED_FUNC(bml_reuse_block_ellblock) (X2, ib, ind,
+                                                      nelements);
                 REAL_T *X2_value = X2_ptr_value[ind];
                 assert(X2_value != NULL);
                 memcpy(X2_value, xtmp, nelements * sizeof(REAL_T));
@@ -425,8 +529,6 @@ void *TYPED_FUNC(
             memset(x_ptr[jp], 0, maxbsize2 * sizeof(REAL_T));
         }
         X2_nnzb[ib] = ll;
-
-        bml_free_memory(T_value_right);
     }
 
     trace[0] = traceX;
@@ -454,6 +556,37 @@ void TYPED_FUNC(
     bml_matrix_ellblock_t * B,
     bml_matrix_ellblock_t * C,
     double threshold)
+{
+    TYPED_FUNC(bml_multiply_AB_screened_ellblock) (A, B, C, threshold, 0.0,
+                                                   NULL);
+}
+
+/** Norm screened matrix multiply.
+ *
+ * \f$ C \leftarrow B \, A \f$
+ *
+ * The product of the blocks \f$ A_{ij} \f$ and \f$ B_{jk} \f$ is
+ * skipped if \f$ \| A_{ij} \|_F \| B_{jk} \|_F \f$ is below the
+ * tolerance. The blocks of each row of B are visited by decreasing norm,
+ * so the first skipped product ends the row.
+ *
+ * \ingroup multiply_group
+ *
+ * \param A Matrix A
+ * \param B Matrix B
+ * \param C Matrix C
+ * \param threshold Used for sparse multiply
+ * \param tolerance Screening tolerance, no screening if not positive
+ * \param stats Statistics of the skipped products (can be NULL)
+ */
+void TYPED_FUNC(
+    bml_multiply_AB_screened_ellblock) (
+    bml_matrix_ellblock_t * A,
+    bml_matrix_ellblock_t * B,
+    bml_matrix_ellblock_t * C,
+    double threshold,
+    double tolerance,
+    bml_screening_stats_t * stats)
 {
     assert(A->NB == B->NB);
     assert(A->NB == C->NB);
@@ -495,28 +628,48 @@ void TYPED_FUNC(
 
     char xptrset = 0;
 
-    void (
-    *fun_ptr_arr[]) (
-    REAL_T *,
-    REAL_T *,
-    const int,
-    REAL_T *,
-    const int,
-    const int) =
+    const int screen = tolerance > 0.0;
+    int *A_order = NULL;
+    double *A_norm = NULL;
+    double *A_tail = NULL;
+    int *B_order = NULL;
+    double *B_norm = NULL;
+    double *B_tail = NULL;
+    if (screen)
     {
-    TYPED_FUNC(bml_multiply_block1),
-            TYPED_FUNC(bml_multiply_block2),
-            TYPED_FUNC(bml_multiply_block3),
-            TYPED_FUNC(bml_multiply_block4),
-            TYPED_FUNC(bml_multiply_block5), TYPED_FUNC(bml_multiply_block6)};
+        A_order = bml_allocate_memory(NB * A->MB * sizeof(int));
+        A_norm = bml_allocate_memory(NB * A->MB * sizeof(double));
+        A_tail = bml_allocate_memory(NB * A->MB * sizeof(double));
+        TYPED_FUNC(bml_sorted_block_norms_ellblock) (A, A_order, A_norm,
+                                                     A_tail);
+        if (B == A)
+        {
+            B_order = A_order;
+            B_norm = A_norm;
+            B_tail = A_tail;
+        }
+        else
+        {
+            B_order = bml_allocate_memory(NB * B->MB * sizeof(int));
+            B_norm = bml_allocate_memory(NB * B->MB * sizeof(double));
+            B_tail = bml_allocate_memory(NB * B->MB * sizeof(double));
+            TYPED_FUNC(bml_sorted_block_norms_ellblock) (B, B_order, B_norm,
+                                                         B_tail);
+        }
+    }
+    int64_t computed = 0;
+    int64_t skipped = 0;
+    double error_bound = 0.0;
 
     //loop over row blocks
 #if defined(__IBMC__) || defined(__ibmxl__)
 #pragma omp parallel for                       \
-    firstprivate( xptrset)
+    firstprivate( xptrset)                     \
+    reduction(+: computed, skipped, error_bound)
 #else
 #pragma omp parallel for                       \
-    firstprivate(ix, jx, x_ptr, xptrset)
+    firstprivate(ix, jx, x_ptr, xptrset)       \
+    reduction(+: computed, skipped, error_bound)
 #endif
 
     for (int ib = 0; ib < NB; ib++)
@@ -542,18 +695,32 @@ void TYPED_FUNC(
             xptrset = 1;
         }
 
-        REAL_T *T_value_right =
-            bml_noinit_allocate_memory(maxbsize2 * sizeof(REAL_T));
-
         //loop over blocks in this block row "ib"
-        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        for (int jq = 0; jq < A_nnzb[ib]; jq++)
         {
+            int jp = screen ? A_order[ROWMAJOR(ib, jq, NB, A->MB)] : jq;
+            double A_block_norm =
+                screen ? A_norm[ROWMAJOR(ib, jq, NB, A->MB)] : 0.0;
             int ind = ROWMAJOR(ib, jp, NB, A->MB);
             REAL_T *A_value = A_ptr_value[ind];
             int jb = A_indexb[ind];
             const int bsizejb = bsize[jb];
-            for (int kp = 0; kp < B_nnzb[jb]; kp++)
+            for (int kq = 0; kq < B_nnzb[jb]; kq++)
             {
+                int kp = kq;
+                if (screen)
+                {
+                    int indq = ROWMAJOR(jb, kq, NB, B->MB);
+                    // the remaining blocks of the row are smaller still
+                    if (A_block_norm * B_norm[indq] < tolerance)
+                    {
+                        skipped += B_nnzb[jb] - kq;
+                        error_bound += A_block_norm * B_tail[indq];
+                        break;
+                    }
+                    kp = B_order[indq];
+                }
+                computed++;
                 int kb = B_indexb[ROWMAJOR(jb, kp, NB, B->MB)];
                 //compute column block "kb" of result
                 if (ix[kb] == 0)
@@ -565,17 +732,9 @@ void TYPED_FUNC(
                 }
                 REAL_T *x = x_ptr[kb];
                 REAL_T *B_value = B_ptr_value[ROWMAJOR(jb, kp, NB, B->MB)];
-                // transpose storage for matrix on the right
-                const int bsizekb = bsize[kb];
-                for (int ii = 0; ii < bsizejb; ii++)
-                {
-                    const int offset = ii * bsizekb;
-                    for (int jj = 0; jj < bsizekb; jj++)
-                        T_value_right[jj * bsizejb + ii]
-                            = B_value[offset + jj];
-                }
-                (*fun_ptr_arr[bsizejb - 1]) (A_value, T_value_right,
-                                             bsizejb, x, bsize[ib], bsizekb);
+                TYPED_FUNC(bml_multiply_block) (A_value, B_value, x,
+                                                bsize[ib], bsizejb,
+                                                bsize[kb]);
             }
         }
 
@@ -609,11 +768,29 @@ void TYPED_FUNC(
             memset(x_ptr[jp], 0, maxbsize2 * sizeof(REAL_T));
         }
         C_nnzb[ib] = ll;
-
-        bml_free_memory(T_value_right);
     }
 
     free(x_ptr_storage);
+
+    if (screen)
+    {
+        if (B_order != A_order)
+        {
+            bml_free_memory(B_order);
+            bml_free_memory(B_norm);
+            bml_free_memory(B_tail);
+        }
+        bml_free_memory(A_order);
+        bml_free_memory(A_norm);
+        bml_free_memory(A_tail);
+    }
+
+    if (stats != NULL)
+    {
+        stats->computed = computed;
+        stats->skipped = skipped;
+        stats->error_bound = error_bound;
+    }
 }
 
 /** Matrix multiply with threshold adjustment.
@@ -7,6 +7,38 @@
 #include <stdlib.h>
 #include <string.h>
 
+/** Gather bml matrix across MPI ranks.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The matrix
+ */
+void
+bml_allGatherVParallel_ellblock(
+    bml_matrix_ellblock_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_allGatherVParallel_ellblock_single_real(A);
+            break;
+        case double_real:
+            bml_allGatherVParallel_ellblock_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_allGatherVParallel_ellblock_single_complex(A);
+            break;
+        case double_complex:
+            bml_allGatherVParallel_ellblock_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 #ifdef DO_MPI
 void
 bml_mpi_send_ellblock(
@@ -64,6 +96,60 @@ bml_mpi_recv_ellblock(
     }
 }
 
+void
+bml_mpi_isend_ellblock(
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_ellblock_single_real(A, dst, comm);
+            break;
+        case double_real:
+            bml_mpi_isend_ellblock_double_real(A, dst, comm);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_ellblock_single_complex(A, dst, comm);
+            break;
+        case double_complex:
+            bml_mpi_isend_ellblock_double_complex(A, dst, comm);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+void
+bml_mpi_isend_complete_ellblock(
+    bml_matrix_ellblock_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_complete_ellblock_single_real(A);
+            break;
+        case double_real:
+            bml_mpi_isend_complete_ellblock_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_complete_ellblock_single_complex(A);
+            break;
+        case double_complex:
+            bml_mpi_isend_complete_ellblock_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 void
 bml_mpi_irecv_ellblock(
     bml_matrix_ellblock_t * A,
@@ -118,6 +204,20 @@ bml_mpi_irecv_complete_ellblock(
     }
 }
 
+/** Make progress on the nonblocking sends or receives of A.
+ *
+ *  \param A The matrix
+ *  \return Non-zero if they are done
+ */
+int
+bml_mpi_test_ellblock(
+    bml_matrix_ellblock_t * A)
+{
+    int flag;
+    MPI_Testall(3, A->req, &flag, MPI_STATUSES_IGNORE);
+    return flag;
+}
+
 bml_matrix_ellblock_t *
 bml_mpi_recv_matrix_ellblock(
     bml_matrix_precision_t matrix_precision,
@@ -3,6 +3,21 @@
 
 #include "bml_types_ellblock.h"
 
+void bml_allGatherVParallel_ellblock(
+    bml_matrix_ellblock_t * A);
+
+void bml_allGatherVParallel_ellblock_single_real(
+    bml_matrix_ellblock_t * A);
+
+void bml_allGatherVParallel_ellblock_double_real(
+    bml_matrix_ellblock_t * A);
+
+void bml_allGatherVParallel_ellblock_single_complex(
+    bml_matrix_ellblock_t * A);
+
+void bml_allGatherVParallel_ellblock_double_complex(
+    bml_matrix_ellblock_t * A);
+
 #ifdef DO_MPI
 void bml_mpi_send_ellblock(
     bml_matrix_ellblock_t * A,
@@ -48,6 +63,40 @@ void bml_mpi_recv_ellblock_double_complex(
     const int src,
     MPI_Comm comm);
 
+void bml_mpi_isend_ellblock(
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm);
+
+void bml_mpi_isend_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm);
+void bml_mpi_isend_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm);
+
+void bml_mpi_isend_complete_ellblock(
+    bml_matrix_ellblock_t * A);
+
+void bml_mpi_isend_complete_ellblock_single_real(
+    bml_matrix_ellblock_t * A);
+void bml_mpi_isend_complete_ellblock_double_real(
+    bml_matrix_ellblock_t * A);
+void bml_mpi_isend_complete_ellblock_single_complex(
+    bml_matrix_ellblock_t * A);
+void bml_mpi_isend_complete_ellblock_double_complex(
+    bml_matrix_ellblock_t * A);
+
 void bml_mpi_irecv_ellblock(
     bml_matrix_ellblock_t * A,
     const int src,
@@ -82,6 +131,9 @@ void bml_mpi_irecv_complete_ellblock_single_complex(
 void bml_mpi_irecv_complete_ellblock_double_complex(
     bml_matrix_ellblock_t * A);
 
+int bml_mpi_test_ellblock(
+    bml_matrix_ellblock_t * A);
+
 bml_matrix_ellblock_t *bml_mpi_recv_matrix_ellblock(
     bml_matrix_precision_t matrix_precision,
     int N,
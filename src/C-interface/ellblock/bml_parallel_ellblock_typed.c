@@ -18,6 +18,144 @@
 #include <mpi.h>
 #endif
 
+/** Gather a bml matrix across MPI ranks.
+ *
+ *  The block rows are split evenly over the ranks and only the
+ *  stored blocks of each block row are shipped.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The matrix A
+ */
+void TYPED_FUNC(
+    bml_allGatherVParallel_ellblock) (
+    bml_matrix_ellblock_t * A)
+{
+#ifdef DO_MPI
+    int myRank = bml_getMyRank();
+    int nRanks = bml_getNRanks();
+
+    int NB = A->NB;
+    int MB = A->MB;
+    int *bsize = A->bsize;
+    int *A_nnzb = A->nnzb;
+    int *A_indexb = A->indexb;
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+
+    // Block rows of each rank
+    int *localRowMin = bml_allocate_memory(sizeof(int) * nRanks);
+    int *localRowMax = bml_allocate_memory(sizeof(int) * nRanks);
+    int *localRowExtent = bml_allocate_memory(sizeof(int) * nRanks);
+    for (int r = 0; r < nRanks; r++)
+    {
+        localRowExtent[r] = NB / nRanks + (r < NB % nRanks ? 1 : 0);
+        localRowMin[r] = (r == 0 ? 0 : localRowMax[r - 1]);
+        localRowMax[r] = localRowMin[r] + localRowExtent[r];
+    }
+    int rowMin = localRowMin[myRank];
+    int rowMax = localRowMax[myRank];
+
+    // Number of blocks per block row
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                   A_nnzb, localRowExtent, localRowMin, MPI_INT, ccomm);
+
+    int *row_ptr = bml_allocate_memory(sizeof(int) * (NB + 1));
+    int *counts = bml_allocate_memory(sizeof(int) * nRanks);
+    int *displs = bml_allocate_memory(sizeof(int) * nRanks);
+
+    // Block column indices
+    bml_gather_row_layout(localRowMin, localRowMax, NB, A_nnzb, row_ptr,
+                          counts, displs);
+    int *indexb_buffer =
+        bml_noinit_allocate_memory(sizeof(int) * MAX(row_ptr[NB], 1));
+    for (int ib = rowMin; ib < rowMax; ib++)
+    {
+        memcpy(&indexb_buffer[row_ptr[ib]], &A_indexb[ROWMAJOR(ib, 0, NB, MB)],
+               sizeof(int) * A_nnzb[ib]);
+    }
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                   indexb_buffer, counts, displs, MPI_INT, ccomm);
+
+    // Number of elements per block row
+    int *nelements = bml_allocate_memory(sizeof(int) * NB);
+    int *indexb_ptr = bml_allocate_memory(sizeof(int) * (NB + 1));
+    memcpy(indexb_ptr, row_ptr, sizeof(int) * (NB + 1));
+    for (int ib = 0; ib < NB; ib++)
+    {
+        for (int k = indexb_ptr[ib]; k < indexb_ptr[ib + 1]; k++)
+        {
+            nelements[ib] += bsize[ib] * bsize[indexb_buffer[k]];
+        }
+    }
+
+    // Block values
+    bml_gather_row_layout(localRowMin, localRowMax, NB, nelements, row_ptr,
+                          counts, displs);
+    REAL_T *value_buffer =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(row_ptr[NB], 1));
+
+#pragma omp parallel for shared(row_ptr, value_buffer)
+    for (int ib = rowMin; ib < rowMax; ib++)
+    {
+        REAL_T *pvalues = &value_buffer[row_ptr[ib]];
+        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, NB, MB);
+            int block_size = bsize[ib] * bsize[A_indexb[ind]];
+            memcpy(pvalues, A_ptr_value[ind], sizeof(REAL_T) * block_size);
+            pvalues += block_size;
+        }
+    }
+    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                   value_buffer, counts, displs, MPI_T, ccomm);
+
+#pragma omp parallel for shared(row_ptr, indexb_ptr, indexb_buffer, value_buffer)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        if (ib >= rowMin && ib < rowMax)
+            continue;
+
+        // drop the blocks this rank holds in block row ib
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+        bml_reset_arena_ellblock(A, ib);
+#endif
+        for (int jp = 0; jp < MB; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, NB, MB);
+#ifndef BML_ELLBLOCK_USE_MEMPOOL
+            bml_free_memory(A_ptr_value[ind]);
+#endif
+            A_ptr_value[ind] = NULL;
+        }
+        REAL_T *pvalues = &value_buffer[row_ptr[ib]];
+        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, NB, MB);
+            int jb = indexb_buffer[indexb_ptr[ib] + jp];
+            int block_size = bsize[ib] * bsize[jb];
+            A_indexb[ind] = jb;
+            A_ptr_value[ind] =
+                TYPED_FUNC(bml_allocate_block_ellblock) (A, ib, block_size);
+            memcpy(A_ptr_value[ind], pvalues, sizeof(REAL_T) * block_size);
+            pvalues += block_size;
+        }
+    }
+
+    bml_free_memory(localRowMin);
+    bml_free_memory(localRowMax);
+    bml_free_memory(localRowExtent);
+    bml_free_memory(row_ptr);
+    bml_free_memory(counts);
+    bml_free_memory(displs);
+    bml_free_memory(indexb_buffer);
+    bml_free_memory(indexb_ptr);
+    bml_free_memory(nelements);
+    bml_free_memory(value_buffer);
+#else
+    (void) A;
+#endif
+}
+
 #ifdef DO_MPI
 void TYPED_FUNC(
     bml_mpi_send_ellblock) (
@@ -99,6 +237,43 @@ void TYPED_FUNC(
     bml_free_memory(values);
 }
 
+void TYPED_FUNC(
+    bml_mpi_isend_ellblock) (
+    bml_matrix_ellblock_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    MPI_Isend(A->indexb, A->NB * A->MB, MPI_INT, dst, 112, comm, A->req);
+
+    MPI_Isend(A->nnzb, A->NB, MPI_INT, dst, 113, comm, A->req + 1);
+
+    // pack the stored blocks, the buffer lives until the send completes
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+
+    A->buffer = bml_allocate_memory(sizeof(REAL_T) * A->N * A->M);
+    REAL_T *pvalues = A->buffer;
+    for (int ib = 0; ib < A->NB; ib++)
+    {
+        for (int jp = 0; jp < A->nnzb[ib]; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, A->NB, A->MB);
+            int jb = A->indexb[ind];
+            int nelements = A->bsize[ib] * A->bsize[jb];
+            memcpy(pvalues, A_ptr_value[ind], nelements * sizeof(REAL_T));
+            pvalues += nelements;
+        }
+    }
+    MPI_Isend(A->buffer, A->N * A->M, MPI_T, dst, 111, comm, A->req + 2);
+}
+
+void TYPED_FUNC(
+    bml_mpi_isend_complete_ellblock) (
+    bml_matrix_ellblock_t * A)
+{
+    MPI_Waitall(3, A->req, MPI_STATUSES_IGNORE);
+    bml_free_memory(A->buffer);
+}
+
 void TYPED_FUNC(
     bml_mpi_irecv_ellblock) (
     bml_matrix_ellblock_t * A,
@@ -164,12 +339,15 @@ void TYPED_FUNC(
     assert(A->NB > 0);
     assert(A->MB > 0);
 
+    int myrank;
+    MPI_Comm_rank(comm, &myrank);
+
     int *indexb = bml_allocate_memory(sizeof(int) * A->NB * A->MB);
-    if (bml_getMyRank() == root)
+    if (myrank == root)
         memcpy(indexb, A->indexb, A->NB * A->MB * sizeof(int));
 
     int *nnzb = bml_allocate_memory(sizeof(int) * A->NB);
-    if (bml_getMyRank() == root)
+    if (myrank == root)
         memcpy(nnzb, A->nnzb, sizeof(int) * A->NB);
 
     MPI_Bcast(nnzb, A->NB, MPI_INT, root, comm);
@@ -178,7 +356,7 @@ void TYPED_FUNC(
     // bcast matrix elements
     REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
     REAL_T *values = bml_allocate_memory(sizeof(REAL_T) * A->N * A->M);
-    if (bml_getMyRank() == root)
+    if (myrank == root)
     {
         REAL_T *pvalues = values;
         for (int ib = 0; ib < A->NB; ib++)
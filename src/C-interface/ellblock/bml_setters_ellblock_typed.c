@@ -77,12 +77,10 @@ void TYPED_FUNC(
             LOG_ERROR("Number of non-zeroes per row > MB, Increase MB\n");
         }
         int ind = ROWMAJOR(ib, A_nnzb[ib], A->NB, A->MB);
-        assert(A_ptr_value[ind] == NULL);
 
         // printf("allocate new block ib=%d, ind=%d\n", ib, ind);
         int nelements = A_bsize[ib] * A_bsize[jb];
-        A_ptr_value[ind] =
-            TYPED_FUNC(bml_allocate_block_ellblock) (A, ib, nelements);
+        TYPED_FUNC(bml_reuse_block_ellblock) (A, ib, ind, nelements);
         A_indexb[ind] = jb;
 
         REAL_T *A_value = A_ptr_value[ind];
@@ -68,4 +68,34 @@ void bml_assign_submatrix_ellblock_double_complex(
     int irow,
     int icol);
 
+void bml_adjacency_ellblock(
+    bml_matrix_ellblock_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
+void bml_adjacency_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag);
+
 #endif
@@ -9,6 +9,8 @@
 #include "bml_submatrix_ellblock.h"
 #include "bml_types_ellblock.h"
 
+#include <complex.h>
+#include <math.h>
 #include <stdlib.h>
 #include <assert.h>
 
@@ -174,3 +176,122 @@ void TYPED_FUNC(
         }
     }
 }
+
+/** Assemble adjacency structure from matrix.
+ *
+ * Every non-zero off-diagonal element of the stored blocks is an
+ * edge, the neighbours of each row come out sorted.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param xadj Index of each row in adjncy
+ * \param adjncy Adjacency vector
+ * \param base_flag Return 0- or 1-based
+ */
+void TYPED_FUNC(
+    bml_adjacency_ellblock) (
+    bml_matrix_ellblock_t * A,
+    int *xadj,
+    int *adjncy,
+    int base_flag)
+{
+    int NB = A->NB;
+    int MB = A->MB;
+    int *A_nnzb = A->nnzb;
+    int *A_indexb = A->indexb;
+    int *bsize = A->bsize;
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+
+    int *offset = bml_noinit_allocate_memory((NB + 1) * sizeof(int));
+    offset[0] = 0;
+    for (int ib = 0; ib < NB; ib++)
+    {
+        offset[ib + 1] = offset[ib] + bsize[ib];
+    }
+
+    // Count the edges of each row, block row by block row
+    xadj[0] = 0;
+#pragma omp parallel for                        \
+  shared(NB, MB, A_nnzb, A_indexb, bsize, A_ptr_value, offset, xadj)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        for (int ii = 0; ii < bsize[ib]; ii++)
+        {
+            int i = offset[ib] + ii;
+            int nedges = 0;
+            for (int jp = 0; jp < A_nnzb[ib]; jp++)
+            {
+                int ind = ROWMAJOR(ib, jp, NB, MB);
+                int jb = A_indexb[ind];
+                REAL_T *A_value = A_ptr_value[ind];
+                for (int jj = 0; jj < bsize[jb]; jj++)
+                {
+                    if (offset[jb] + jj != i
+                        && ABS(A_value[ROWMAJOR(ii, jj, bsize[ib],
+                                                bsize[jb])]) > 0)
+                    {
+                        nedges++;
+                    }
+                }
+            }
+            xadj[i + 1] = nedges;
+        }
+    }
+    for (int i = 0; i < offset[NB]; i++)
+    {
+        xadj[i + 1] += xadj[i];
+    }
+
+    // Fill the rows in column order, walking the blocks of a block row
+    // by increasing block column
+#pragma omp parallel for                                        \
+  shared(NB, MB, A_nnzb, A_indexb, bsize, A_ptr_value, offset, xadj, adjncy)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        int order[MB];
+        int norder = 0;
+        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        {
+            int k = norder++;
+            int jb = A_indexb[ROWMAJOR(ib, jp, NB, MB)];
+            while (k > 0
+                   && A_indexb[ROWMAJOR(ib, order[k - 1], NB, MB)] > jb)
+            {
+                order[k] = order[k - 1];
+                k--;
+            }
+            order[k] = jp;
+        }
+        for (int ii = 0; ii < bsize[ib]; ii++)
+        {
+            int i = offset[ib] + ii;
+            int j = xadj[i];
+            for (int k = 0; k < norder; k++)
+            {
+                int ind = ROWMAJOR(ib, order[k], NB, MB);
+                int jb = A_indexb[ind];
+                REAL_T *A_value = A_ptr_value[ind];
+                for (int jj = 0; jj < bsize[jb]; jj++)
+                {
+                    if (offset[jb] + jj != i
+                        && ABS(A_value[ROWMAJOR(ii, jj, bsize[ib],
+                                                bsize[jb])]) > 0)
+                    {
+                        adjncy[j] = offset[jb] + jj + base_flag;
+                        j++;
+                    }
+                }
+            }
+        }
+    }
+
+    if (base_flag == 1)
+    {
+        for (int i = 0; i < offset[NB] + 1; i++)
+        {
+            xadj[i] += 1;
+        }
+    }
+    bml_free_memory(offset);
+}
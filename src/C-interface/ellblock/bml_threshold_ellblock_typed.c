@@ -138,5 +138,9 @@ void TYPED_FUNC(
                 jp--;
             }
         }
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+        // reclaim the holes left by the removed blocks
+        bml_compact_arena_ellblock(A, ib, sizeof(REAL_T));
+#endif
     }
 }
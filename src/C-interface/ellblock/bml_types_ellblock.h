@@ -7,6 +7,56 @@
 #include <mpi.h>
 #endif
 
+#ifdef BML_ELLBLOCK_USE_MEMPOOL
+/** Chunk of memory of a block row arena. */
+typedef struct
+{
+    /** The storage. */
+    char *data;
+    /** The size of the storage in bytes. */
+    size_t size;
+} bml_ellblock_chunk_t;
+
+/** Memory arena of the blocks of a block row.
+ *
+ * Blocks are handed out from the chunks in order and never move while
+ * the row grows, a full row gets a new chunk twice the size of its
+ * last one. Freed blocks leave holes until the row is compacted.
+ */
+typedef struct
+{
+    /** The chunks. */
+    bml_ellblock_chunk_t *chunks;
+    /** The number of chunks. */
+    int nchunks;
+    /** The chunk blocks are handed out from. */
+    int current;
+    /** The bytes handed out from the current chunk. */
+    size_t used;
+    /** The bytes handed out since the last reset, freed blocks included. */
+    size_t allocated;
+    /** The bytes in live blocks. */
+    size_t live;
+} bml_ellblock_arena_t;
+#endif
+
+/** Memory usage of the blocks of an ellblock matrix. */
+typedef struct
+{
+    /** The bytes reserved for blocks. */
+    size_t reserved;
+    /** The largest number of bytes reserved for blocks. */
+    size_t peak;
+    /** The bytes handed out to blocks, freed blocks included. */
+    size_t allocated;
+    /** The bytes in live blocks. */
+    size_t live;
+    /** The fraction of the handed out bytes in freed blocks. */
+    double fragmentation;
+    /** The number of chunks (of blocks without the memory pool). */
+    int nchunks;
+} bml_ellblock_memory_stats_t;
+
 /** BLOCK ELLPACK matrix type. */
 struct bml_matrix_ellblock_t
 {
@@ -25,12 +75,12 @@ struct bml_matrix_ellblock_t
     /** The max. number of blocks per row. */
     int MB;
 #ifdef BML_ELLBLOCK_USE_MEMPOOL
-    /** Storage for matrix elements/blocks. */
-    void *memory_pool;
-    /** offsets for storage of row blocks */
-    int *memory_pool_offsets;
-    /** Ptr to last stored block in row block */
-    void **memory_pool_ptr;
+    /** The memory arenas of the block rows. */
+    bml_ellblock_arena_t *arena;
+    /** The bytes reserved in all the arenas. */
+    size_t arena_reserved;
+    /** The largest number of bytes reserved in all the arenas. */
+    size_t arena_peak;
 #endif
     /** Pointers to blocks of values */
     void **ptr_value;
@@ -125,4 +125,49 @@ double bml_norm_inf_fast_double_complex(
     void *v,
     int);
 
+void bml_write_bml_matrix_binary_ellblock(
+    bml_matrix_ellblock_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellblock_single_real(
+    bml_matrix_ellblock_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellblock_double_real(
+    bml_matrix_ellblock_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellblock_single_complex(
+    bml_matrix_ellblock_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellblock_double_complex(
+    bml_matrix_ellblock_t * A,
+    int fd);
+
+bml_matrix_ellblock_t *bml_read_bml_matrix_binary_ellblock(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellblock_t *bml_read_bml_matrix_binary_ellblock_single_real(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellblock_t *bml_read_bml_matrix_binary_ellblock_double_real(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellblock_t *bml_read_bml_matrix_binary_ellblock_single_complex(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellblock_t *bml_read_bml_matrix_binary_ellblock_double_complex(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
 #endif
@@ -1,5 +1,6 @@
 #include "../../macros.h"
 #include "../../typed.h"
+#include "../bml_allocate.h"
 #include "../bml_logger.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
@@ -28,11 +29,7 @@ void TYPED_FUNC(
 {
     assert(A->bsize[0] < 1e6);
 
-    FILE *hFile;
-    char header1[20], header2[20], header3[20], header4[20], header5[20];
-    int hdimx, nnz, irow, icol;
-    REAL_T value;
-
+    int N = A->N;
     int NB = A->NB;
     int MB = A->MB;
     REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
@@ -40,127 +37,79 @@ void TYPED_FUNC(
     int *A_nnzb = A->nnzb;
     int *A_bsize = A->bsize;
 
-    hFile = fopen(filename, "r");
+    int file_N;
+    int *row_ptr;
+    int *cols;
+    REAL_T *vals;
 
-    // Read header
-    if (fscanf(hFile, "%s %s %s %s %s", header1, header2, header3, header4,
-               header5) != 5)
+    bml_read_compressed_rows(filename, A->matrix_precision, &file_N,
+                             &row_ptr, &cols, (void **) &vals);
+    if (file_N != N)
     {
-        LOG_ERROR("read error on header\n");
+        LOG_ERROR("%s holds a matrix of size %d, expected %d\n", filename,
+                  file_N, N);
     }
 
-    int symflag = strcmp(header5, "symmetric");
-
-    // Read N, N, # of non-zeroes
-    if (fscanf(hFile, "%d %d %d", &hdimx, &hdimx, &nnz) != 3)
-    {
-        LOG_ERROR("read error\n");
-    }
-
-    // Read in values
-    for (int i = 0; i < nnz; i++)
+    // Block and position in the block of each row/column
+    int *block = bml_noinit_allocate_memory(sizeof(int) * N);
+    int *offset = bml_noinit_allocate_memory(sizeof(int) * N);
+    int *block_start = bml_noinit_allocate_memory(sizeof(int) * (NB + 1));
+    block_start[0] = 0;
+    for (int ib = 0; ib < NB; ib++)
     {
-#if defined(SINGLE_REAL)
-        if (fscanf(hFile, "%d %d %e\n", &irow, &icol, &value) != 3)
-        {
-            LOG_ERROR("read error\n");
-        }
-#elif defined(DOUBLE_REAL)
-        if (fscanf(hFile, "%d %d %le\n", &irow, &icol, &value) != 3)
-        {
-            LOG_ERROR("read error\n");
-        }
-#elif defined(SINGLE_COMPLEX) || defined(DOUBLE_COMPLEX)
-        double real_part, imaginary_part;
-        if (fscanf
-            (hFile, "%d %d %le %le\n", &irow, &icol, &real_part,
-             &imaginary_part) != 4)
-        {
-            LOG_ERROR("read error\n");
-        }
-        value = real_part + I * imaginary_part;
-#else
-        LOG_ERROR("unknown matrix precision\n");
-#endif
-
-        irow--;
-        icol--;
-
-        /*compute block indexes */
-        int ib = 0;
-        while (irow >= A_bsize[ib])
-        {
-            irow -= A_bsize[ib];
-            ib++;
-        }
-
-        int jb = 0;
-        while (icol >= A_bsize[jb])
-        {
-            icol -= A_bsize[jb];
-            jb++;
-        }
-
-        int found_block = 0;
-        for (int jp = 0; jp < A_nnzb[ib]; jp++)
-        {
-            int ind = ROWMAJOR(ib, jp, NB, MB);
-            int jbb = A_indexb[ind];
-            if (jbb == jb)
-            {
-                found_block = 1;
-                REAL_T *A_value = A_ptr_value[ind];
-                A_value[ROWMAJOR(irow, icol, A_bsize[ib], A_bsize[jb])] =
-                    value;
-            }
-        }
-        //add block if needed
-        if (found_block == 0)
+        block_start[ib + 1] = block_start[ib] + A_bsize[ib];
+        for (int ii = 0; ii < A_bsize[ib]; ii++)
         {
-            //printf("Add new block %d, %d\n",ib, jb);
-            assert(A_nnzb[ib] < MB);
-            int ind = ROWMAJOR(ib, A_nnzb[ib], NB, MB);
-            A_indexb[ind] = jb;
-            A_nnzb[ib]++;
-            int nelements = A_bsize[ib] * A_bsize[jb];
-            A_ptr_value[ind] =
-                TYPED_FUNC(bml_allocate_block_ellblock) (A, ib, nelements);
-            REAL_T *A_value = A_ptr_value[ind];
-            memset(A_value, 0, nelements * sizeof(REAL_T));
-            assert(A_value != NULL);
-            A_value[ROWMAJOR(irow, icol, A_bsize[ib], A_bsize[jb])] = value;
+            block[block_start[ib] + ii] = ib;
+            offset[block_start[ib] + ii] = ii;
         }
+    }
 
-        // Set symmetric value if necessary
-        if (symflag == 0 && icol != irow)
+    // Block rows are independent, blocks are added to their own row
+#pragma omp parallel for schedule(dynamic)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        for (int irow = block_start[ib]; irow < block_start[ib + 1]; irow++)
         {
-            int found_block = 0;
-            for (int ip = 0; ip < A_nnzb[jb]; ip++)
+            int ii = offset[irow];
+            for (int k = row_ptr[irow]; k < row_ptr[irow + 1]; k++)
             {
-                int ind = ROWMAJOR(jb, ip, NB, MB);
-                int ibb = A_indexb[ROWMAJOR(jb, ip, NB, MB)];
-                if (ibb == ib)
+                int jb = block[cols[k]];
+                int ind = -1;
+                for (int jp = 0; jp < A_nnzb[ib]; jp++)
                 {
-                    found_block = 1;
-                    REAL_T *A_value = A_ptr_value[ind];
-                    A_value[ROWMAJOR(icol, irow, A_bsize[jb], A_bsize[ib])] =
-                        value;
+                    if (A_indexb[ROWMAJOR(ib, jp, NB, MB)] == jb)
+                    {
+                        ind = ROWMAJOR(ib, jp, NB, MB);
+                        break;
+                    }
+                }
+                //add block if needed
+                if (ind < 0)
+                {
+                    assert(A_nnzb[ib] < MB);
+                    ind = ROWMAJOR(ib, A_nnzb[ib], NB, MB);
+                    A_indexb[ind] = jb;
+                    A_nnzb[ib]++;
+                    int nelements = A_bsize[ib] * A_bsize[jb];
+                    A_ptr_value[ind] =
+                        TYPED_FUNC(bml_allocate_block_ellblock) (A, ib,
+                                                                 nelements);
+                    memset(A_ptr_value[ind], 0, nelements * sizeof(REAL_T));
                 }
-            }
-            //add block if needed
-            if (found_block == 0)
-            {
-                A_indexb[A_nnzb[jb]] = ib;
-                int ind = ROWMAJOR(jb, A_nnzb[jb], NB, MB);
-                A_nnzb[jb]++;
                 REAL_T *A_value = A_ptr_value[ind];
-                A_value[ROWMAJOR(icol, irow, A_bsize[jb], A_bsize[ib])] =
-                    value;
+                A_value[ROWMAJOR(ii, offset[cols[k]], A_bsize[ib],
+                                 A_bsize[jb])] = vals[k];
             }
         }
     }
 
-    fclose(hFile);
+    bml_free_memory(block);
+    bml_free_memory(offset);
+    bml_free_memory(block_start);
+    bml_free_memory(row_ptr);
+    bml_free_memory(cols);
+    bml_free_memory(vals);
 }
 
 /** Write a Matrix Market format file from a bml matrix.
@@ -327,3 +276,147 @@ double TYPED_FUNC(
         }
     return n2;
 }
+
+/** Write a bml matrix to a binary file.
+ *
+ *  The blocks are packed by block row into one array.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param A The matrix to be written
+ *  \param fd The file descriptor of the binary file
+ */
+void TYPED_FUNC(
+    bml_write_bml_matrix_binary_ellblock) (
+    bml_matrix_ellblock_t * A,
+    int fd)
+{
+    int NB = A->NB;
+    int MB = A->MB;
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+    int *A_indexb = A->indexb;
+    int *A_nnzb = A->nnzb;
+    int *A_bsize = A->bsize;
+    bml_binary_header_t header;
+
+    // Offset of the blocks of each block row
+    size_t *row_offset = bml_allocate_memory(sizeof(size_t) * (NB + 1));
+    for (int ib = 0; ib < NB; ib++)
+    {
+        size_t nelements = 0;
+        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        {
+            int jb = A_indexb[ROWMAJOR(ib, jp, NB, MB)];
+            nelements += A_bsize[ib] * A_bsize[jb];
+        }
+        row_offset[ib + 1] = row_offset[ib] + nelements;
+    }
+
+    REAL_T *values =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(row_offset[NB], 1));
+#pragma omp parallel for schedule(dynamic) shared(values)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        size_t offset = row_offset[ib];
+        for (int jp = 0; jp < A_nnzb[ib]; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, NB, MB);
+            int nelements = A_bsize[ib] * A_bsize[A_indexb[ind]];
+            memcpy(&values[offset], A_ptr_value[ind],
+                   sizeof(REAL_T) * nelements);
+            offset += nelements;
+        }
+    }
+
+    bml_init_binary_header(&header, ellblock, A->matrix_precision, A->N,
+                           A->M);
+    header.NB = NB;
+    header.MB = MB;
+    header.nvalues = row_offset[NB];
+    bml_write_binary_section(fd, &header, sizeof(bml_binary_header_t));
+    bml_write_binary_section(fd, A_bsize, sizeof(int) * NB);
+    bml_write_binary_section(fd, A_nnzb, sizeof(int) * NB);
+    bml_write_binary_section(fd, A_indexb, sizeof(int) * NB * MB);
+    bml_write_binary_section(fd, values, sizeof(REAL_T) * row_offset[NB]);
+
+    bml_free_memory(values);
+    bml_free_memory(row_offset);
+}
+
+/** Read a bml matrix from a mapped binary file.
+ *
+ *  The blocks are always copied and the mapping is unmapped.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param mapping The mapped file
+ *  \param mapping_size The size of the file in bytes
+ *  \param zero_copy Ignored, the blocks are separate allocations
+ *  \return The matrix
+ */
+bml_matrix_ellblock_t *TYPED_FUNC(
+    bml_read_bml_matrix_binary_ellblock) (
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy)
+{
+    bml_binary_header_t *header = mapping;
+    int NB = header->NB;
+    int MB = header->MB;
+    size_t offset = 0;
+
+    // the blocks are separate allocations and always get copied
+    (void) zero_copy;
+
+    bml_binary_section(mapping, mapping_size, &offset,
+                       sizeof(bml_binary_header_t));
+    int *bsize = bml_binary_section(mapping, mapping_size, &offset,
+                                    sizeof(int) * NB);
+    int *nnzb = bml_binary_section(mapping, mapping_size, &offset,
+                                   sizeof(int) * NB);
+    int *indexb = bml_binary_section(mapping, mapping_size, &offset,
+                                     sizeof(int) * NB * MB);
+    REAL_T *values = bml_binary_section(mapping, mapping_size, &offset,
+                                        sizeof(REAL_T) * header->nvalues);
+
+    bml_matrix_ellblock_t *A =
+        TYPED_FUNC(bml_block_matrix_ellblock) (NB, MB, header->M, bsize,
+                                               sequential);
+    REAL_T **A_ptr_value = (REAL_T **) A->ptr_value;
+    int *A_indexb = A->indexb;
+    int *A_nnzb = A->nnzb;
+
+    size_t *row_offset = bml_allocate_memory(sizeof(size_t) * (NB + 1));
+    for (int ib = 0; ib < NB; ib++)
+    {
+        size_t nelements = 0;
+        for (int jp = 0; jp < nnzb[ib]; jp++)
+        {
+            int jb = indexb[ROWMAJOR(ib, jp, NB, MB)];
+            nelements += bsize[ib] * bsize[jb];
+        }
+        row_offset[ib + 1] = row_offset[ib] + nelements;
+    }
+
+#pragma omp parallel for schedule(dynamic)
+    for (int ib = 0; ib < NB; ib++)
+    {
+        size_t offset = row_offset[ib];
+        for (int jp = 0; jp < nnzb[ib]; jp++)
+        {
+            int ind = ROWMAJOR(ib, jp, NB, MB);
+            int nelements = bsize[ib] * bsize[indexb[ind]];
+            A_indexb[ind] = indexb[ind];
+            A_ptr_value[ind] =
+                TYPED_FUNC(bml_allocate_block_ellblock) (A, ib, nelements);
+            memcpy(A_ptr_value[ind], &values[offset],
+                   sizeof(REAL_T) * nelements);
+            offset += nelements;
+        }
+        A_nnzb[ib] = nnzb[ib];
+    }
+
+    bml_free_memory(row_offset);
+    bml_unmap_binary_file(mapping, mapping_size);
+    return A;
+}
@@ -2,8 +2,10 @@
 #include "../../typed.h"
 #include "../bml_add.h"
 #include "../bml_allocate.h"
+#include "../bml_logger.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
+#include "../../internal-blas/bml_accumulator.h"
 #include "bml_add_ellpack.h"
 #include "bml_allocate_ellpack.h"
 #include "bml_types_ellpack.h"
@@ -65,7 +67,8 @@ void TYPED_FUNC(
     TYPED_FUNC(bml_add_cusparse_ellpack) (A, B, alpha, beta, threshold);
 #else
 
-#if !(defined(__IBMC__) || defined(__ibmxl__) || (defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK))))
+#if defined(USE_OMP_OFFLOAD)
+#if !(defined(__IBMC__) || defined(__ibmxl__) || defined(INTEL_SDK) || defined(CRAY_SDK))
     int ix[N], jx[N];
     REAL_T x[N];
 
@@ -74,7 +77,7 @@ void TYPED_FUNC(
     memset(x, 0.0, N * sizeof(REAL_T));
 #endif
 
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
+#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
     int num_chunks = MIN(OFFLOAD_NUM_CHUNKS, rowMax - rowMin + 1);
 
     int *all_ix, *all_jx;
@@ -86,10 +89,6 @@ void TYPED_FUNC(
 
 #pragma omp target map(to:all_ix[0:N*num_chunks],all_jx[0:N*num_chunks],all_x[0:N*num_chunks])
 
-#endif
-
-#if defined (USE_OMP_OFFLOAD)
-#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
 #pragma omp teams distribute parallel for \
     shared(rowMin, rowMax)                \
     shared(A_index, A_value, A_nnz)       \
@@ -103,40 +102,16 @@ void TYPED_FUNC(
         jx = &all_jx[chunk * N];
         x = &all_x[chunk * N];
 
+        for (int i = rowMin + chunk; i < rowMax; i = i + num_chunks)
+        {
 #else
 #pragma omp target teams distribute parallel for \
     shared(rowMin, rowMax)                \
     shared(A_index, A_value, A_nnz)       \
     shared(B_index, B_value, B_nnz)       \
     firstprivate(ix, jx, x)
-#endif
-#else
-#if defined(__IBMC__) || defined(__ibmxl__)
-#pragma omp parallel for \
-    shared(rowMin, rowMax)                \
-    shared(A_index, A_value, A_nnz)       \
-    shared(B_index, B_value, B_nnz)
-#else
-#pragma omp parallel for                  \
-    shared(rowMin, rowMax)                \
-    shared(A_index, A_value, A_nnz)       \
-    shared(B_index, B_value, B_nnz)       \
-    firstprivate(ix, jx, x)
-#endif
-#endif
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
-    for (int i = rowMin + chunk; i < rowMax; i = i + num_chunks)
-    {
-#else
     for (int i = rowMin; i < rowMax; i++)
     {
-
-#if defined(__IBMC__) || defined(__ibmxl__)
-        int ix[N], jx[N];
-        REAL_T x[N];
-
-        memset(ix, 0, N * sizeof(int));
-#endif
 #endif
         int l = 0;
         if (alpha > (double) 0.0 || alpha < (double) 0.0)
@@ -184,10 +159,65 @@ void TYPED_FUNC(
         }
         A_nnz[i] = ll;
     }
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
+#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
 }
 #endif
 
+#else
+
+#pragma omp parallel                      \
+    shared(rowMin, rowMax)                \
+    shared(A_index, A_value, A_nnz)       \
+    shared(B_index, B_value, B_nnz)
+    {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (N, A_M);
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            if (alpha > (double) 0.0 || alpha < (double) 0.0)
+            {
+                TYPED_FUNC(bml_accumulator_add_row) (acc, A_nnz[i],
+                                                     &A_index[ROWMAJOR
+                                                              (i, 0, N,
+                                                               A_M)],
+                                                     &A_value[ROWMAJOR
+                                                              (i, 0, N,
+                                                               A_M)],
+                                                     alpha);
+            }
+            if (beta > (double) 0.0 || beta < (double) 0.0)
+            {
+                TYPED_FUNC(bml_accumulator_add_row) (acc, B_nnz[i],
+                                                     &B_index[ROWMAJOR
+                                                              (i, 0, N,
+                                                               B_M)],
+                                                     &B_value[ROWMAJOR
+                                                              (i, 0, N,
+                                                               B_M)], beta);
+            }
+
+            if (acc->size > A_M)
+            {
+                LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+            }
+
+            A_nnz[i] =
+                TYPED_FUNC(bml_accumulator_extract) (acc, -1, threshold,
+                                                     &A_index[ROWMAJOR
+                                                              (i, 0, N,
+                                                               A_M)],
+                                                     &A_value[ROWMAJOR
+                                                              (i, 0, N,
+                                                               A_M)]);
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+#endif
+
 #endif
 }
 
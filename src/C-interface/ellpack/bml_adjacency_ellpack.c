@@ -1,27 +0,0 @@
-
-#include "../bml_logger.h"
-#include "../bml_types.h"
-#include "bml_types_ellpack.h"
-#include <stdio.h>
-#include<stdlib.h>
-
-void
-bml_adjacency_ellpack(
-    bml_matrix_t * A,
-    int *xadj,
-    int *adjncy)
-{
-
-
-
-
-
-
-
-
-
-
-
-
-
-}
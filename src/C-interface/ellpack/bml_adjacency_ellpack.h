@@ -1,12 +0,0 @@
-#ifndef __BML_ADJACENCY_ELLPACK_H
-#define __BML_ADJACENCY_ELLPACK_H
-
-#include "bml_types_ellpack.h"
-
-
-void bml_adjacency_ellpack(
-    bml_matrix_t * A,
-    int *xadj,
-    int *adjncy);
-
-#endif
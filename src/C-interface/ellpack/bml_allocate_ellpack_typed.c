@@ -2,6 +2,7 @@
 #include "../../typed.h"
 #include "../bml_allocate.h"
 #include "../bml_types.h"
+#include "../bml_utilities.h"
 #include "bml_allocate_ellpack.h"
 #include "bml_types_ellpack.h"
 
@@ -45,9 +46,16 @@ void TYPED_FUNC(
 
     bml_deallocate_domain(A->domain);
     bml_deallocate_domain(A->domain2);
-    bml_free_memory(A->value);
-    bml_free_memory(A->index);
-    bml_free_memory(A->nnz);
+    if (A->mapping != NULL)
+    {
+        bml_unmap_binary_file(A->mapping, A->mapping_size);
+    }
+    else
+    {
+        bml_free_memory(A->value);
+        bml_free_memory(A->index);
+        bml_free_memory(A->nnz);
+    }
 
 #if defined(BML_USE_CUSPARSE)
     bml_free_memory(A->csrRowPtr);
@@ -153,6 +161,7 @@ bml_matrix_ellpack_t
     A->value = bml_noinit_allocate_memory(sizeof(REAL_T) * A->N * A->M);
     A->domain = bml_default_domain(A->N, A->M, distrib_mode);
     A->domain2 = bml_default_domain(A->N, A->M, distrib_mode);
+    A->mapping = NULL;
 
 #if defined(USE_OMP_OFFLOAD)
     int N = A->N;
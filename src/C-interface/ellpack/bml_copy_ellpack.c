@@ -115,6 +115,53 @@ bml_reorder_ellpack(
     }
 }
 
+/** Copy a panel of an ellpack matrix.
+ *
+ *  B(l0 + i, j) = A(i0 + i, j) for 0 <= i < nrows and j0 <= j < j0 +
+ *  ncols, the other elements of B are zero.
+ *
+ *  \ingroup copy_group
+ *
+ *  \param A The matrix to copy from
+ *  \param B The panel
+ *  \param i0 The first row of the panel in A
+ *  \param nrows The number of rows of the panel
+ *  \param j0 The first column of the panel
+ *  \param ncols The number of columns of the panel
+ *  \param l0 The first row of the panel in B
+ */
+void
+bml_copy_panel_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_copy_panel_ellpack_single_real(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        case double_real:
+            bml_copy_panel_ellpack_double_real(A, B, i0, nrows, j0, ncols, l0);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_copy_panel_ellpack_single_complex(A, B, i0, nrows, j0, ncols, l0);
+            break;
+        case double_complex:
+            bml_copy_panel_ellpack_double_complex(A, B, i0, nrows, j0, ncols, l0);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 /** Save the domain for an ellpack matrix.
  *
  * \ingroup copy_group
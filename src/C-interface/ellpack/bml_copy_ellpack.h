@@ -58,6 +58,51 @@ void bml_reorder_ellpack_double_complex(
     bml_matrix_ellpack_t * A,
     int *perm);
 
+void bml_copy_panel_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
 void bml_save_domain_ellpack(
     bml_matrix_ellpack_t * A);
 
@@ -195,3 +195,59 @@ void TYPED_FUNC(
 #pragma omp target update to(B_nnz[:N], B_index[:N*M], B_value[:N*M])
 #endif
 }
+
+/** Copy a panel of an ellpack matrix.
+ *
+ *  B(l0 + i, j) = A(i0 + i, j) for 0 <= i < nrows and j0 <= j < j0 +
+ *  ncols, the other elements of B are zero.
+ *
+ *  \ingroup copy_group
+ *
+ *  \param A The matrix to copy from
+ *  \param B The panel
+ *  \param i0 The first row of the panel in A
+ *  \param nrows The number of rows of the panel
+ *  \param j0 The first column of the panel
+ *  \param ncols The number of columns of the panel
+ *  \param l0 The first row of the panel in B
+ */
+void TYPED_FUNC(
+    bml_copy_panel_ellpack) (
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0)
+{
+    int N = A->N;
+    int A_M = A->M;
+    int B_M = B->M;
+
+    int *A_index = A->index;
+    int *A_nnz = A->nnz;
+    REAL_T *A_value = A->value;
+
+    int *B_index = B->index;
+    int *B_nnz = B->nnz;
+    REAL_T *B_value = B->value;
+
+    memset(B_nnz, 0, sizeof(int) * N);
+#pragma omp parallel for
+    for (int i = 0; i < nrows; i++)
+    {
+        int l = l0 + i;
+        for (int jp = 0; jp < A_nnz[i0 + i]; jp++)
+        {
+            int j = A_index[ROWMAJOR(i0 + i, jp, N, A_M)];
+            if (j >= j0 && j < j0 + ncols)
+            {
+                B_index[ROWMAJOR(l, B_nnz[l], N, B_M)] = j;
+                B_value[ROWMAJOR(l, B_nnz[l], N, B_M)] =
+                    A_value[ROWMAJOR(i0 + i, jp, N, A_M)];
+                B_nnz[l]++;
+            }
+        }
+    }
+}
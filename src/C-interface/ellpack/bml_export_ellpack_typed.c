@@ -71,3 +71,57 @@ void *TYPED_FUNC(
     }
     return A_dense;
 }
+
+/** Convert a bml matrix into compressed rows.
+ *
+ * The entries of row i are cols[k] and vals[k] for
+ * row_ptr[i] <= k < row_ptr[i + 1]. All stored elements are
+ * exported.
+ *
+ * \ingroup convert_group
+ *
+ * \param A The bml matrix
+ * \param row_ptr The row pointers (N + 1), allocated here
+ * \param cols The column indices, allocated here
+ * \param vals The values, allocated here
+ */
+void TYPED_FUNC(
+    bml_export_to_compressed_rows_ellpack) (
+    bml_matrix_ellpack_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals)
+{
+    int N = A->N;
+    int M = A->M;
+    int *A_nnz = A->nnz;
+    int *A_index = A->index;
+    REAL_T *A_value = A->value;
+
+#ifdef USE_OMP_OFFLOAD
+#pragma omp target update from(A_nnz[:N], A_index[:N*M], A_value[:N*M])
+#endif
+
+    int *A_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+    for (int i = 0; i < N; i++)
+    {
+        A_ptr[i + 1] = A_ptr[i] + A_nnz[i];
+    }
+
+    int *A_cols = bml_noinit_allocate_memory(sizeof(int) * MAX(A_ptr[N], 1));
+    REAL_T *A_vals =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(A_ptr[N], 1));
+
+#pragma omp parallel for shared(A_ptr, A_cols, A_vals, A_nnz, A_index, A_value)
+    for (int i = 0; i < N; i++)
+    {
+        memcpy(&A_cols[A_ptr[i]], &A_index[ROWMAJOR(i, 0, N, M)],
+               sizeof(int) * A_nnz[i]);
+        memcpy(&A_vals[A_ptr[i]], &A_value[ROWMAJOR(i, 0, N, M)],
+               sizeof(REAL_T) * A_nnz[i]);
+    }
+
+    *row_ptr = A_ptr;
+    *cols = A_cols;
+    *vals = A_vals;
+}
@@ -0,0 +1,311 @@
+#include "../bml_allocate.h"
+#include "../bml_logger.h"
+#include "../bml_types.h"
+#include "bml_halo_ellpack.h"
+#include "bml_types_ellpack.h"
+
+#include <stdlib.h>
+#include <string.h>
+
+/** Copy the rows owned by this rank out of a full matrix.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The full matrix
+ *  \param rowMin The first owned row
+ *  \param rowMax One past the last owned row
+ *  \return The owned rows, with global column indices
+ */
+bml_matrix_ellpack_t *
+bml_local_rows_ellpack(
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            return bml_local_rows_ellpack_single_real(A, rowMin, rowMax);
+        case double_real:
+            return bml_local_rows_ellpack_double_real(A, rowMin, rowMax);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_local_rows_ellpack_single_complex(A, rowMin, rowMax);
+        case double_complex:
+            return bml_local_rows_ellpack_double_complex(A, rowMin, rowMax);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
+
+/** Build the rows owned by this rank from compressed rows.
+ *
+ *  Only the owned rows are stored, the full matrix is never allocated.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param matrix_precision The precision of the matrix
+ *  \param M The number of non-zeroes per row
+ *  \param rowMin The first owned row
+ *  \param rowMax One past the last owned row
+ *  \param row_ptr The start of each owned row in cols and vals
+ *  (rowMax - rowMin + 1 entries)
+ *  \param cols The global column indices
+ *  \param vals The values
+ *  \return The owned rows, with global column indices
+ */
+bml_matrix_ellpack_t *
+bml_local_rows_compressed_ellpack(
+    bml_matrix_precision_t matrix_precision,
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals)
+{
+    switch (matrix_precision)
+    {
+        case single_real:
+            return bml_local_rows_compressed_ellpack_single_real(M, rowMin,
+                                                                 rowMax,
+                                                                 row_ptr,
+                                                                 cols, vals);
+        case double_real:
+            return bml_local_rows_compressed_ellpack_double_real(M, rowMin,
+                                                                 rowMax,
+                                                                 row_ptr,
+                                                                 cols, vals);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_local_rows_compressed_ellpack_single_complex(M,
+                                                                    rowMin,
+                                                                    rowMax,
+                                                                    row_ptr,
+                                                                    cols,
+                                                                    vals);
+        case double_complex:
+            return bml_local_rows_compressed_ellpack_double_complex(M,
+                                                                    rowMin,
+                                                                    rowMax,
+                                                                    row_ptr,
+                                                                    cols,
+                                                                    vals);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
+
+/** Find the ghost rows of a row distributed matrix.
+ *
+ *  The ghost rows are the rows owned by other ranks that the owned
+ *  rows of A reference. A is grown to hold them after its owned rows.
+ *  The halo has to be created again when the sparsity pattern of the
+ *  owned rows changes.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The owned rows
+ *  \param N The global number of rows
+ *  \param rowMin The first owned row
+ *  \param rowMax One past the last owned row
+ *  \return The halo
+ */
+bml_halo_ellpack_t *
+bml_halo_create_ellpack(
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            return bml_halo_create_ellpack_single_real(A, N, rowMin, rowMax);
+        case double_real:
+            return bml_halo_create_ellpack_double_real(A, N, rowMin, rowMax);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_halo_create_ellpack_single_complex(A, N, rowMin,
+                                                          rowMax);
+        case double_complex:
+            return bml_halo_create_ellpack_double_complex(A, N, rowMin,
+                                                          rowMax);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
+
+/** Refresh the ghost rows from their owners.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The owned and ghost rows
+ *  \param halo The halo of A
+ */
+void
+bml_halo_exchange_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_halo_exchange_ellpack_single_real(A, halo);
+            break;
+        case double_real:
+            bml_halo_exchange_ellpack_double_real(A, halo);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_halo_exchange_ellpack_single_complex(A, halo);
+            break;
+        case double_complex:
+            bml_halo_exchange_ellpack_double_complex(A, halo);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+/** Owned rows of the matrix square of a row distributed matrix.
+ *
+ *  \f$ X2 \leftarrow X \, X \f$
+ *
+ *  The ghost rows of X have to be current. X2 receives the owned rows
+ *  only.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X The owned and ghost rows of X
+ *  \param X2 The owned rows of X^2
+ *  \param halo The halo of X
+ *  \param threshold Used for sparse multiply
+ *  \return The traces of X and X^2, summed over all ranks
+ */
+double *
+bml_multiply_x2_halo_ellpack(
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold)
+{
+    switch (X->matrix_precision)
+    {
+        case single_real:
+            return bml_multiply_x2_halo_ellpack_single_real(X, X2, halo,
+                                                            threshold);
+        case double_real:
+            return bml_multiply_x2_halo_ellpack_double_real(X, X2, halo,
+                                                            threshold);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_multiply_x2_halo_ellpack_single_complex(X, X2, halo,
+                                                               threshold);
+        case double_complex:
+            return bml_multiply_x2_halo_ellpack_double_complex(X, X2, halo,
+                                                               threshold);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
+
+/** Trace of a row distributed matrix.
+ *
+ *  \ingroup trace_group
+ *
+ *  \param A The owned rows
+ *  \param halo The halo of A
+ *  \return The trace, summed over all ranks
+ */
+double
+bml_trace_halo_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            return bml_trace_halo_ellpack_single_real(A, halo);
+        case double_real:
+            return bml_trace_halo_ellpack_double_real(A, halo);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_trace_halo_ellpack_single_complex(A, halo);
+        case double_complex:
+            return bml_trace_halo_ellpack_double_complex(A, halo);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return 0;
+}
+
+/** Frobenius norm of a row distributed matrix.
+ *
+ *  \ingroup norm_group
+ *
+ *  \param A The owned rows
+ *  \param halo The halo of A
+ *  \return The norm, summed over all ranks
+ */
+double
+bml_fnorm_halo_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            return bml_fnorm_halo_ellpack_single_real(A, halo);
+        case double_real:
+            return bml_fnorm_halo_ellpack_double_real(A, halo);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_fnorm_halo_ellpack_single_complex(A, halo);
+        case double_complex:
+            return bml_fnorm_halo_ellpack_double_complex(A, halo);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return 0;
+}
+
+/** Deallocate a halo.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param halo The halo
+ */
+void
+bml_deallocate_halo_ellpack(
+    bml_halo_ellpack_t ** halo)
+{
+    if (*halo == NULL)
+        return;
+    bml_free_memory((*halo)->ghost_rows);
+    bml_free_memory((*halo)->send_rows);
+    bml_free_memory((*halo)->send_count);
+    bml_free_memory((*halo)->send_displ);
+    bml_free_memory((*halo)->recv_count);
+    bml_free_memory((*halo)->recv_displ);
+    bml_free_memory(*halo);
+    *halo = NULL;
+}
@@ -0,0 +1,195 @@
+#ifndef __BML_HALO_ELLPACK_H
+#define __BML_HALO_ELLPACK_H
+
+#include "bml_types_ellpack.h"
+
+bml_matrix_ellpack_t *bml_local_rows_ellpack(
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax);
+
+bml_matrix_ellpack_t *bml_local_rows_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax);
+
+bml_matrix_ellpack_t *bml_local_rows_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax);
+
+bml_matrix_ellpack_t *bml_local_rows_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax);
+
+bml_matrix_ellpack_t *bml_local_rows_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax);
+
+bml_matrix_ellpack_t *bml_local_rows_compressed_ellpack(
+    bml_matrix_precision_t matrix_precision,
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals);
+
+bml_matrix_ellpack_t *bml_local_rows_compressed_ellpack_single_real(
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals);
+
+bml_matrix_ellpack_t *bml_local_rows_compressed_ellpack_double_real(
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals);
+
+bml_matrix_ellpack_t *bml_local_rows_compressed_ellpack_single_complex(
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals);
+
+bml_matrix_ellpack_t *bml_local_rows_compressed_ellpack_double_complex(
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals);
+
+bml_halo_ellpack_t *bml_halo_create_ellpack(
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax);
+
+bml_halo_ellpack_t *bml_halo_create_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax);
+
+bml_halo_ellpack_t *bml_halo_create_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax);
+
+bml_halo_ellpack_t *bml_halo_create_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax);
+
+bml_halo_ellpack_t *bml_halo_create_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax);
+
+void bml_halo_exchange_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+void bml_halo_exchange_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+void bml_halo_exchange_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+void bml_halo_exchange_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+void bml_halo_exchange_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double *bml_multiply_x2_halo_ellpack(
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold);
+
+double *bml_multiply_x2_halo_ellpack_single_real(
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold);
+
+double *bml_multiply_x2_halo_ellpack_double_real(
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold);
+
+double *bml_multiply_x2_halo_ellpack_single_complex(
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold);
+
+double *bml_multiply_x2_halo_ellpack_double_complex(
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold);
+
+double bml_trace_halo_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_trace_halo_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_trace_halo_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_trace_halo_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_trace_halo_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_fnorm_halo_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_fnorm_halo_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_fnorm_halo_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_fnorm_halo_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+double bml_fnorm_halo_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo);
+
+void bml_deallocate_halo_ellpack(
+    bml_halo_ellpack_t ** halo);
+
+#endif
@@ -0,0 +1,634 @@
+#include "../../internal-blas/bml_accumulator.h"
+#include "../../macros.h"
+#include "../../typed.h"
+#include "../bml_allocate.h"
+#include "../bml_logger.h"
+#include "../bml_parallel.h"
+#include "../bml_types.h"
+#include "bml_allocate_ellpack.h"
+#include "bml_halo_ellpack.h"
+#include "bml_types_ellpack.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+#ifdef DO_MPI
+#include <mpi.h>
+#endif
+
+/** Copy the rows owned by this rank out of a full matrix.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The full matrix
+ *  \param rowMin The first owned row
+ *  \param rowMax One past the last owned row
+ *  \return The owned rows, with global column indices
+ */
+bml_matrix_ellpack_t *TYPED_FUNC(
+    bml_local_rows_ellpack) (
+    bml_matrix_ellpack_t * A,
+    int rowMin,
+    int rowMax)
+{
+    int M = A->M;
+    int extent = rowMax - rowMin;
+
+    bml_matrix_ellpack_t *B =
+        TYPED_FUNC(bml_zero_matrix_ellpack) (extent, M, sequential);
+
+    memcpy(B->nnz, &A->nnz[rowMin], sizeof(int) * extent);
+    memcpy(B->index, &A->index[ROWMAJOR(rowMin, 0, A->N, M)],
+           sizeof(int) * extent * M);
+    memcpy(B->value, &((REAL_T *) A->value)[ROWMAJOR(rowMin, 0, A->N, M)],
+           sizeof(REAL_T) * extent * M);
+
+    return B;
+}
+
+/** Build the rows owned by this rank from compressed rows.
+ *
+ *  Only the owned rows are stored, the full matrix is never allocated.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param M The number of non-zeroes per row
+ *  \param rowMin The first owned row
+ *  \param rowMax One past the last owned row
+ *  \param row_ptr The start of each owned row in cols and vals
+ *  (rowMax - rowMin + 1 entries)
+ *  \param cols The global column indices
+ *  \param vals The values
+ *  \return The owned rows, with global column indices
+ */
+bml_matrix_ellpack_t *TYPED_FUNC(
+    bml_local_rows_compressed_ellpack) (
+    int M,
+    int rowMin,
+    int rowMax,
+    int *row_ptr,
+    int *cols,
+    void *vals)
+{
+    int extent = rowMax - rowMin;
+    REAL_T *row_vals = (REAL_T *) vals;
+
+    bml_matrix_ellpack_t *B =
+        TYPED_FUNC(bml_zero_matrix_ellpack) (extent, M, sequential);
+    int *B_nnz = B->nnz;
+    int *B_index = B->index;
+    REAL_T *B_value = (REAL_T *) B->value;
+
+#pragma omp parallel for shared(B_nnz, B_index, B_value)
+    for (int i = 0; i < extent; i++)
+    {
+        int nnz = row_ptr[i + 1] - row_ptr[i];
+        if (nnz > M)
+        {
+            LOG_ERROR("row %d has %d non-zeroes, more than M = %d\n",
+                      rowMin + i, nnz, M);
+        }
+        memcpy(&B_index[ROWMAJOR(i, 0, extent, M)], &cols[row_ptr[i]],
+               sizeof(int) * nnz);
+        memcpy(&B_value[ROWMAJOR(i, 0, extent, M)], &row_vals[row_ptr[i]],
+               sizeof(REAL_T) * nnz);
+        B_nnz[i] = nnz;
+    }
+
+    return B;
+}
+
+static int TYPED_FUNC(
+    bml_halo_compare_ellpack) (
+    const void *a,
+    const void *b)
+{
+    int aId = *((int *) a);
+    int bId = *((int *) b);
+
+    return (aId > bId) - (aId < bId);
+}
+
+/** The local row of a global row, -1 if it is not stored. */
+static int TYPED_FUNC(
+    bml_halo_local_row_ellpack) (
+    bml_halo_ellpack_t * halo,
+    int j)
+{
+    if (j >= halo->rowMin && j < halo->rowMax)
+    {
+        return j - halo->rowMin;
+    }
+    int *ghost = bsearch(&j, halo->ghost_rows, halo->nghost, sizeof(int),
+                         TYPED_FUNC(bml_halo_compare_ellpack));
+    if (ghost == NULL)
+    {
+        return -1;
+    }
+    return halo->rowMax - halo->rowMin + (int) (ghost - halo->ghost_rows);
+}
+
+/** Find the ghost rows of a row distributed matrix.
+ *
+ *  The ghost rows are the rows owned by other ranks that the owned
+ *  rows of A reference. A is grown to hold them after its owned rows.
+ *  The halo has to be created again when the sparsity pattern of the
+ *  owned rows changes. The ranks have to own consecutive ranges of
+ *  rows in rank order.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The owned rows
+ *  \param N The global number of rows
+ *  \param rowMin The first owned row
+ *  \param rowMax One past the last owned row
+ *  \return The halo
+ */
+bml_halo_ellpack_t *TYPED_FUNC(
+    bml_halo_create_ellpack) (
+    bml_matrix_ellpack_t * A,
+    int N,
+    int rowMin,
+    int rowMax)
+{
+#ifdef USE_OMP_OFFLOAD
+    LOG_ERROR("ghost rows are not available with OpenMP offload\n");
+#endif
+    int nRanks = bml_getNRanks();
+    int extent = rowMax - rowMin;
+    int M = A->M;
+    int *A_nnz = A->nnz;
+    int *A_index = A->index;
+
+    if (A->N < extent)
+    {
+        LOG_ERROR("matrix has %d rows, fewer than the %d owned rows\n",
+                  A->N, extent);
+    }
+
+    bml_halo_ellpack_t *halo = bml_allocate_memory(sizeof(bml_halo_ellpack_t));
+    halo->N = N;
+    halo->rowMin = rowMin;
+    halo->rowMax = rowMax;
+
+    // columns of the owned rows that are owned by other ranks
+    int nref = 0;
+    for (int i = 0; i < extent; i++)
+    {
+        nref += A_nnz[i];
+    }
+    int *ghost_rows = bml_noinit_allocate_memory(sizeof(int) * MAX(nref, 1));
+    int nghost = 0;
+    for (int i = 0; i < extent; i++)
+    {
+        for (int jp = 0; jp < A_nnz[i]; jp++)
+        {
+            int j = A_index[ROWMAJOR(i, jp, A->N, M)];
+            if (j < rowMin || j >= rowMax)
+            {
+                ghost_rows[nghost++] = j;
+            }
+        }
+    }
+    qsort(ghost_rows, nghost, sizeof(int),
+          TYPED_FUNC(bml_halo_compare_ellpack));
+    nref = nghost;
+    nghost = 0;
+    for (int k = 0; k < nref; k++)
+    {
+        if (nghost == 0 || ghost_rows[k] != ghost_rows[nghost - 1])
+        {
+            ghost_rows[nghost++] = ghost_rows[k];
+        }
+    }
+    halo->nghost = nghost;
+    halo->ghost_rows =
+        bml_reallocate_memory(ghost_rows, sizeof(int) * MAX(nghost, 1));
+
+    // owned rows of every rank
+    int *rowMins = bml_allocate_memory(sizeof(int) * nRanks);
+    int *rowMaxs = bml_allocate_memory(sizeof(int) * nRanks);
+#ifdef DO_MPI
+    MPI_Allgather(&rowMin, 1, MPI_INT, rowMins, 1, MPI_INT, ccomm);
+    MPI_Allgather(&rowMax, 1, MPI_INT, rowMaxs, 1, MPI_INT, ccomm);
+#else
+    rowMins[0] = rowMin;
+    rowMaxs[0] = rowMax;
+#endif
+    for (int r = 1; r < nRanks; r++)
+    {
+        if (rowMins[r] != rowMaxs[r - 1])
+        {
+            LOG_ERROR("rank %d does not own the rows after rank %d\n", r,
+                      r - 1);
+        }
+    }
+
+    // the sorted ghost rows are grouped by owner, find the owner of
+    // each one in the gathered row ranges
+    halo->recv_count = bml_allocate_memory(sizeof(int) * nRanks);
+    halo->recv_displ = bml_allocate_memory(sizeof(int) * nRanks);
+    for (int k = 0; k < nghost; k++)
+    {
+        int j = halo->ghost_rows[k];
+        int lo = 0;
+        int hi = nRanks - 1;
+        while (lo < hi)
+        {
+            int mid = (lo + hi) / 2;
+            if (rowMaxs[mid] <= j)
+            {
+                lo = mid + 1;
+            }
+            else
+            {
+                hi = mid;
+            }
+        }
+        if (j < rowMins[lo] || j >= rowMaxs[lo])
+        {
+            LOG_ERROR("row %d is not owned by any rank\n", j);
+        }
+        halo->recv_count[lo]++;
+    }
+    for (int r = 1; r < nRanks; r++)
+    {
+        halo->recv_displ[r] =
+            halo->recv_displ[r - 1] + halo->recv_count[r - 1];
+    }
+
+    // the rows every other rank needs from this rank
+    halo->send_count = bml_allocate_memory(sizeof(int) * nRanks);
+    halo->send_displ = bml_allocate_memory(sizeof(int) * nRanks);
+#ifdef DO_MPI
+    MPI_Alltoall(halo->recv_count, 1, MPI_INT, halo->send_count, 1, MPI_INT,
+                 ccomm);
+#endif
+    for (int r = 1; r < nRanks; r++)
+    {
+        halo->send_displ[r] =
+            halo->send_displ[r - 1] + halo->send_count[r - 1];
+    }
+    int nsend = halo->send_displ[nRanks - 1] + halo->send_count[nRanks - 1];
+    halo->send_rows = bml_allocate_memory(sizeof(int) * MAX(nsend, 1));
+#ifdef DO_MPI
+    MPI_Alltoallv(halo->ghost_rows, halo->recv_count, halo->recv_displ,
+                  MPI_INT, halo->send_rows, halo->send_count,
+                  halo->send_displ, MPI_INT, ccomm);
+#endif
+    for (int k = 0; k < nsend; k++)
+    {
+        halo->send_rows[k] -= rowMin;
+    }
+
+    // make room for the ghost rows after the owned rows
+    A->value =
+        bml_reallocate_memory(A->value,
+                              sizeof(REAL_T) * MAX(extent + nghost, 1) * M);
+    A->index =
+        bml_reallocate_memory(A->index,
+                              sizeof(int) * MAX(extent + nghost, 1) * M);
+    A->nnz =
+        bml_reallocate_memory(A->nnz, sizeof(int) * MAX(extent + nghost, 1));
+    memset(&A->nnz[extent], 0, sizeof(int) * nghost);
+    A->N = extent + nghost;
+
+    bml_free_memory(rowMins);
+    bml_free_memory(rowMaxs);
+
+    return halo;
+}
+
+/** Refresh the ghost rows from their owners.
+ *
+ *  Each rank only exchanges messages with the ranks it shares ghost
+ *  rows with, and only the stored elements of each row are sent.
+ *
+ *  \ingroup parallel_group
+ *
+ *  \param A The owned and ghost rows
+ *  \param halo The halo of A
+ */
+void TYPED_FUNC(
+    bml_halo_exchange_ellpack) (
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo)
+{
+#ifdef DO_MPI
+    int nRanks = bml_getNRanks();
+    int extent = halo->rowMax - halo->rowMin;
+    int nghost = halo->nghost;
+    int M = A->M;
+    int *A_nnz = A->nnz;
+    int *A_index = A->index;
+    REAL_T *A_value = A->value;
+
+    int *send_count = halo->send_count;
+    int *send_displ = halo->send_displ;
+    int *recv_count = halo->recv_count;
+    int *recv_displ = halo->recv_displ;
+    int nsend = send_displ[nRanks - 1] + send_count[nRanks - 1];
+
+    MPI_Request *requests =
+        bml_allocate_memory(sizeof(MPI_Request) * 4 * nRanks);
+    int nrequests = 0;
+
+    // row lengths
+    int *send_nnz = bml_allocate_memory(sizeof(int) * MAX(nsend, 1));
+    for (int k = 0; k < nsend; k++)
+    {
+        send_nnz[k] = A_nnz[halo->send_rows[k]];
+    }
+    for (int r = 0; r < nRanks; r++)
+    {
+        if (recv_count[r] > 0)
+            MPI_Irecv(&A_nnz[extent + recv_displ[r]], recv_count[r], MPI_INT,
+                      r, 211, ccomm, &requests[nrequests++]);
+        if (send_count[r] > 0)
+            MPI_Isend(&send_nnz[send_displ[r]], send_count[r], MPI_INT, r,
+                      211, ccomm, &requests[nrequests++]);
+    }
+    MPI_Waitall(nrequests, requests, MPI_STATUSES_IGNORE);
+    nrequests = 0;
+
+    // pack the stored elements of the rows to send
+    int *send_ptr = bml_allocate_memory(sizeof(int) * (nsend + 1));
+    for (int k = 0; k < nsend; k++)
+    {
+        send_ptr[k + 1] = send_ptr[k] + send_nnz[k];
+    }
+    int *recv_ptr = bml_allocate_memory(sizeof(int) * (nghost + 1));
+    for (int k = 0; k < nghost; k++)
+    {
+        recv_ptr[k + 1] = recv_ptr[k] + A_nnz[extent + k];
+    }
+    int *send_index =
+        bml_noinit_allocate_memory(sizeof(int) * MAX(send_ptr[nsend], 1));
+    REAL_T *send_value =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(send_ptr[nsend], 1));
+    int *recv_index =
+        bml_noinit_allocate_memory(sizeof(int) * MAX(recv_ptr[nghost], 1));
+    REAL_T *recv_value =
+        bml_noinit_allocate_memory(sizeof(REAL_T) *
+                                   MAX(recv_ptr[nghost], 1));
+
+#pragma omp parallel for shared(send_ptr, send_nnz, send_index, send_value)
+    for (int k = 0; k < nsend; k++)
+    {
+        int i = halo->send_rows[k];
+        memcpy(&send_index[send_ptr[k]], &A_index[ROWMAJOR(i, 0, A->N, M)],
+               sizeof(int) * send_nnz[k]);
+        memcpy(&send_value[send_ptr[k]], &A_value[ROWMAJOR(i, 0, A->N, M)],
+               sizeof(REAL_T) * send_nnz[k]);
+    }
+
+    for (int r = 0; r < nRanks; r++)
+    {
+        if (recv_count[r] > 0)
+        {
+            int first = recv_ptr[recv_displ[r]];
+            int count = recv_ptr[recv_displ[r] + recv_count[r]] - first;
+            MPI_Irecv(&recv_index[first], count, MPI_INT, r, 212, ccomm,
+                      &requests[nrequests++]);
+            MPI_Irecv(&recv_value[first], count, MPI_T, r, 213, ccomm,
+                      &requests[nrequests++]);
+        }
+        if (send_count[r] > 0)
+        {
+            int first = send_ptr[send_displ[r]];
+            int count = send_ptr[send_displ[r] + send_count[r]] - first;
+            MPI_Isend(&send_index[first], count, MPI_INT, r, 212, ccomm,
+                      &requests[nrequests++]);
+            MPI_Isend(&send_value[first], count, MPI_T, r, 213, ccomm,
+                      &requests[nrequests++]);
+        }
+    }
+    MPI_Waitall(nrequests, requests, MPI_STATUSES_IGNORE);
+
+    // unpack into the padded ghost rows
+#pragma omp parallel for shared(recv_ptr, recv_index, recv_value)
+    for (int k = 0; k < nghost; k++)
+    {
+        int i = extent + k;
+        memcpy(&A_index[ROWMAJOR(i, 0, A->N, M)], &recv_index[recv_ptr[k]],
+               sizeof(int) * A_nnz[i]);
+        memcpy(&A_value[ROWMAJOR(i, 0, A->N, M)], &recv_value[recv_ptr[k]],
+               sizeof(REAL_T) * A_nnz[i]);
+    }
+
+    bml_free_memory(requests);
+    bml_free_memory(send_nnz);
+    bml_free_memory(send_ptr);
+    bml_free_memory(recv_ptr);
+    bml_free_memory(send_index);
+    bml_free_memory(send_value);
+    bml_free_memory(recv_index);
+    bml_free_memory(recv_value);
+#else
+    (void) A;
+    (void) halo;
+#endif
+}
+
+/** Owned rows of the matrix square of a row distributed matrix.
+ *
+ *  \f$ X2 \leftarrow X \, X \f$
+ *
+ *  The ghost rows of X have to be current. X2 receives the owned rows
+ *  only.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X The owned and ghost rows of X
+ *  \param X2 The owned rows of X^2
+ *  \param halo The halo of X
+ *  \param threshold Used for sparse multiply
+ *  \return The traces of X and X^2, summed over all ranks
+ */
+double *TYPED_FUNC(
+    bml_multiply_x2_halo_ellpack) (
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    bml_halo_ellpack_t * halo,
+    double threshold)
+{
+    int rowMin = halo->rowMin;
+    int extent = halo->rowMax - halo->rowMin;
+
+    int X_M = X->M;
+    int *X_index = X->index;
+    int *X_nnz = X->nnz;
+    REAL_T *X_value = (REAL_T *) X->value;
+
+    int X2_N = X2->N;
+    int X2_M = X2->M;
+    int *X2_index = X2->index;
+    int *X2_nnz = X2->nnz;
+    REAL_T *X2_value = (REAL_T *) X2->value;
+
+    if (X2_N < extent)
+    {
+        LOG_ERROR("X2 has %d rows, fewer than the %d owned rows\n", X2_N,
+                  extent);
+    }
+
+    double traceX = 0.0;
+    double traceX2 = 0.0;
+    double *trace = bml_allocate_memory(sizeof(double) * 2);
+
+#pragma omp parallel                                   \
+    shared(X_M, X_index, X_nnz, X_value)               \
+    shared(X2_N, X2_M, X2_index, X2_nnz, X2_value)     \
+    shared(rowMin, extent, halo)                       \
+    reduction(+: traceX, traceX2)
+    {
+        /* row accumulator over the global columns */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (halo->N, X2_M);
+
+#pragma omp for
+        for (int i = 0; i < extent; i++)
+        {
+            for (int jp = 0; jp < X_nnz[i]; jp++)
+            {
+                REAL_T a = X_value[ROWMAJOR(i, jp, X->N, X_M)];
+                int j = X_index[ROWMAJOR(i, jp, X->N, X_M)];
+                if (j == rowMin + i)
+                {
+                    traceX = traceX + REAL_PART(a);
+                }
+                int lj = TYPED_FUNC(bml_halo_local_row_ellpack) (halo, j);
+                if (lj < 0)
+                {
+                    LOG_ERROR("row %d is neither owned nor a ghost row\n", j);
+                }
+                TYPED_FUNC(bml_accumulator_add_row) (acc, X_nnz[lj],
+                                                     &X_index[ROWMAJOR
+                                                              (lj, 0, X->N,
+                                                               X_M)],
+                                                     &X_value[ROWMAJOR
+                                                              (lj, 0, X->N,
+                                                               X_M)], a);
+            }
+
+            // Check for number of non-zeroes per row exceeded
+            if (acc->size > X2_M)
+            {
+                LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+            }
+
+            int ll = TYPED_FUNC(bml_accumulator_extract) (acc, rowMin + i,
+                                                          threshold,
+                                                          &X2_index[ROWMAJOR
+                                                                    (i, 0,
+                                                                     X2_N,
+                                                                     X2_M)],
+                                                          &X2_value[ROWMAJOR
+                                                                    (i, 0,
+                                                                     X2_N,
+                                                                     X2_M)]);
+            for (int jp = 0; jp < ll; jp++)
+            {
+                if (X2_index[ROWMAJOR(i, jp, X2_N, X2_M)] == rowMin + i)
+                {
+                    traceX2 = traceX2 +
+                        REAL_PART(X2_value[ROWMAJOR(i, jp, X2_N, X2_M)]);
+                }
+            }
+            X2_nnz[i] = ll;
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+
+    // rows of X2 past the owned ones are not ghost rows of X2
+    for (int i = extent; i < X2_N; i++)
+    {
+        X2_nnz[i] = 0;
+    }
+
+    bml_sumRealReduce(&traceX);
+    bml_sumRealReduce(&traceX2);
+    trace[0] = traceX;
+    trace[1] = traceX2;
+
+    return trace;
+}
+
+/** Trace of a row distributed matrix.
+ *
+ *  \ingroup trace_group
+ *
+ *  \param A The owned rows
+ *  \param halo The halo of A
+ *  \return The trace, summed over all ranks
+ */
+double TYPED_FUNC(
+    bml_trace_halo_ellpack) (
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo)
+{
+    int M = A->M;
+    int *A_index = A->index;
+    int *A_nnz = A->nnz;
+    REAL_T *A_value = (REAL_T *) A->value;
+    int rowMin = halo->rowMin;
+    int extent = halo->rowMax - halo->rowMin;
+
+    double trace = 0.0;
+
+#pragma omp parallel for shared(A_index, A_nnz, A_value) reduction(+:trace)
+    for (int i = 0; i < extent; i++)
+    {
+        for (int jp = 0; jp < A_nnz[i]; jp++)
+        {
+            if (A_index[ROWMAJOR(i, jp, A->N, M)] == rowMin + i)
+            {
+                trace += REAL_PART(A_value[ROWMAJOR(i, jp, A->N, M)]);
+            }
+        }
+    }
+    bml_sumRealReduce(&trace);
+
+    return trace;
+}
+
+/** Frobenius norm of a row distributed matrix.
+ *
+ *  \ingroup norm_group
+ *
+ *  \param A The owned rows
+ *  \param halo The halo of A
+ *  \return The norm, summed over all ranks
+ */
+double TYPED_FUNC(
+    bml_fnorm_halo_ellpack) (
+    bml_matrix_ellpack_t * A,
+    bml_halo_ellpack_t * halo)
+{
+    int M = A->M;
+    int *A_nnz = A->nnz;
+    REAL_T *A_value = (REAL_T *) A->value;
+    int extent = halo->rowMax - halo->rowMin;
+
+    double sum = 0.0;
+
+#pragma omp parallel for shared(A_nnz, A_value) reduction(+:sum)
+    for (int i = 0; i < extent; i++)
+    {
+        for (int jp = 0; jp < A_nnz[i]; jp++)
+        {
+            REAL_T a = A_value[ROWMAJOR(i, jp, A->N, M)];
+            sum += ABS(a) * ABS(a);
+        }
+    }
+    bml_sumRealReduce(&sum);
+
+    return sqrt(sum);
+}
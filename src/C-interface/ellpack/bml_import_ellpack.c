@@ -60,3 +60,66 @@ bml_import_from_dense_ellpack(
     }
     return NULL;
 }
+
+/** Convert compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group
+ *
+ * \param matrix_precision The real precision
+ * \param N The number of rows/columns
+ * \param row_ptr The row pointers
+ * \param cols The column indices
+ * \param vals The values
+ * \param M The number of non-zeroes per row
+ * \return The bml matrix
+ */
+bml_matrix_ellpack_t *
+bml_import_from_compressed_rows_ellpack(
+    bml_matrix_precision_t matrix_precision,
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode)
+{
+    switch (matrix_precision)
+    {
+        case single_real:
+            return bml_import_from_compressed_rows_ellpack_single_real(N,
+                                                                       row_ptr,
+                                                                       cols,
+                                                                       vals, M,
+                                                                       distrib_mode);
+            break;
+        case double_real:
+            return bml_import_from_compressed_rows_ellpack_double_real(N,
+                                                                       row_ptr,
+                                                                       cols,
+                                                                       vals, M,
+                                                                       distrib_mode);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_import_from_compressed_rows_ellpack_single_complex(N,
+                                                                          row_ptr,
+                                                                          cols,
+                                                                          vals,
+                                                                          M,
+                                                                          distrib_mode);
+            break;
+        case double_complex:
+            return bml_import_from_compressed_rows_ellpack_double_complex(N,
+                                                                          row_ptr,
+                                                                          cols,
+                                                                          vals,
+                                                                          M,
+                                                                          distrib_mode);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
@@ -1,6 +1,9 @@
+#include "../../macros.h"
 #include "../bml_add.h"
+#include "../bml_allocate.h"
 #include "../bml_logger.h"
 #include "../bml_multiply.h"
+#include "../bml_parallel.h"
 #include "../bml_types.h"
 #include "bml_add_ellpack.h"
 #include "bml_multiply_ellpack.h"
@@ -174,3 +177,282 @@ bml_multiply_adjust_AB_ellpack(
             break;
     }
 }
+
+/** Build the sparsity plan of X * X.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param X Matrix X
+ *  \return The plan
+ */
+bml_multiply_plan_t *
+bml_multiply_plan_x2_ellpack(
+    bml_matrix_ellpack_t * X)
+{
+    int X_N = X->N;
+    int X_M = X->M;
+    int *X_index = X->index;
+    int *X_nnz = X->nnz;
+
+    int myRank = bml_getMyRank();
+
+    bml_multiply_plan_t *plan =
+        bml_allocate_memory(sizeof(bml_multiply_plan_t));
+    plan->N = X_N;
+    plan->rowMin = X->domain->localRowMin[myRank];
+    plan->rowMax = X->domain->localRowMax[myRank];
+
+    int rowMin = plan->rowMin;
+    int rowMax = plan->rowMax;
+    int *in_ptr = bml_allocate_memory(sizeof(int) * (X_N + 1));
+    int *row_ptr = bml_allocate_memory(sizeof(int) * (X_N + 1));
+    int *row_flops = bml_allocate_memory(sizeof(int) * X_N);
+
+    // the numeric pass reads the rows of the plan and the rows they
+    // reference, in distributed mode also rows outside [rowMin, rowMax)
+    char *is_read = bml_allocate_memory(sizeof(char) * X_N);
+    for (int i = rowMin; i < rowMax; i++)
+    {
+        is_read[i] = 1;
+        for (int jp = 0; jp < X_nnz[i]; jp++)
+        {
+            is_read[X_index[ROWMAJOR(i, jp, X_N, X_M)]] = 1;
+        }
+    }
+    int nread = 0;
+    for (int i = 0; i < X_N; i++)
+    {
+        nread += is_read[i];
+    }
+    int *read_rows = bml_noinit_allocate_memory(sizeof(int) *
+                                                MAX(nread, 1));
+    nread = 0;
+    for (int i = 0; i < X_N; i++)
+    {
+        if (is_read[i])
+        {
+            read_rows[nread++] = i;
+        }
+    }
+    bml_free_memory(is_read);
+
+    // copy the input pattern of the rows read
+    for (int r = 0; r < nread; r++)
+    {
+        in_ptr[read_rows[r] + 1] = X_nnz[read_rows[r]];
+    }
+    for (int i = 0; i < X_N; i++)
+    {
+        in_ptr[i + 1] += in_ptr[i];
+    }
+    int *in_cols = bml_noinit_allocate_memory(sizeof(int) *
+                                              MAX(in_ptr[X_N], 1));
+#pragma omp parallel for shared(X_index, X_nnz, in_ptr, in_cols, read_rows)
+    for (int r = 0; r < nread; r++)
+    {
+        int i = read_rows[r];
+        memcpy(&in_cols[in_ptr[i]], &X_index[ROWMAJOR(i, 0, X_N, X_M)],
+               X_nnz[i] * sizeof(int));
+    }
+
+    // count the output columns and multiply-adds per row
+#pragma omp parallel shared(X_index, X_nnz, row_ptr, row_flops)
+    {
+        int *mark = bml_noinit_allocate_memory(sizeof(int) * X_N);
+        for (int k = 0; k < X_N; k++)
+        {
+            mark[k] = -1;
+        }
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            int l = 0;
+            int flops = 0;
+            for (int jp = 0; jp < X_nnz[i]; jp++)
+            {
+                int j = X_index[ROWMAJOR(i, jp, X_N, X_M)];
+                flops += X_nnz[j];
+                for (int kp = 0; kp < X_nnz[j]; kp++)
+                {
+                    int k = X_index[ROWMAJOR(j, kp, X_N, X_M)];
+                    if (mark[k] != i)
+                    {
+                        mark[k] = i;
+                        l++;
+                    }
+                }
+            }
+            row_ptr[i + 1] = l;
+            row_flops[i] = flops;
+        }
+
+        bml_free_memory(mark);
+    }
+    for (int i = 0; i < X_N; i++)
+    {
+        row_ptr[i + 1] += row_ptr[i];
+    }
+
+    // fill in the output columns in the order the numeric pass finds them
+    int *cols = bml_noinit_allocate_memory(sizeof(int) *
+                                           MAX(row_ptr[X_N], 1));
+#pragma omp parallel shared(X_index, X_nnz, row_ptr, cols)
+    {
+        int *mark = bml_noinit_allocate_memory(sizeof(int) * X_N);
+        for (int k = 0; k < X_N; k++)
+        {
+            mark[k] = -1;
+        }
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            int l = row_ptr[i];
+            for (int jp = 0; jp < X_nnz[i]; jp++)
+            {
+                int j = X_index[ROWMAJOR(i, jp, X_N, X_M)];
+                for (int kp = 0; kp < X_nnz[j]; kp++)
+                {
+                    int k = X_index[ROWMAJOR(j, kp, X_N, X_M)];
+                    if (mark[k] != i)
+                    {
+                        mark[k] = i;
+                        cols[l] = k;
+                        l++;
+                    }
+                }
+            }
+        }
+
+        bml_free_memory(mark);
+    }
+
+    plan->in_ptr = in_ptr;
+    plan->in_cols = in_cols;
+    plan->nread = nread;
+    plan->read_rows = read_rows;
+    plan->row_ptr = row_ptr;
+    plan->cols = cols;
+    bml_multiply_plan_schedule(plan, row_flops);
+
+    bml_free_memory(row_flops);
+
+    return plan;
+}
+
+/** Check whether the pattern of X is covered by a sparsity plan.
+ *
+ *  All the rows the numeric pass reads are checked, also the ones
+ *  outside [rowMin, rowMax) in distributed mode.
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param plan The plan
+ *  \param X Matrix X
+ *  \return 1 if the plan is valid, 0 otherwise
+ */
+int
+bml_multiply_plan_is_valid_ellpack(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X)
+{
+    int X_N = X->N;
+    int X_M = X->M;
+    int *X_index = X->index;
+    int *X_nnz = X->nnz;
+
+    int myRank = bml_getMyRank();
+
+    if (plan->N != X_N || plan->rowMin != X->domain->localRowMin[myRank]
+        || plan->rowMax != X->domain->localRowMax[myRank])
+    {
+        return 0;
+    }
+
+    int *in_ptr = plan->in_ptr;
+    int *in_cols = plan->in_cols;
+    int *read_rows = plan->read_rows;
+    int missing = 0;
+
+#pragma omp parallel shared(X_index, X_nnz, in_ptr, in_cols, read_rows) \
+    reduction(+: missing)
+    {
+        int *mark = bml_noinit_allocate_memory(sizeof(int) * X_N);
+        for (int k = 0; k < X_N; k++)
+        {
+            mark[k] = -1;
+        }
+
+#pragma omp for
+        for (int r = 0; r < plan->nread; r++)
+        {
+            int i = read_rows[r];
+            for (int p = in_ptr[i]; p < in_ptr[i + 1]; p++)
+            {
+                mark[in_cols[p]] = i;
+            }
+            for (int jp = 0; jp < X_nnz[i]; jp++)
+            {
+                if (mark[X_index[ROWMAJOR(i, jp, X_N, X_M)]] != i)
+                {
+                    missing++;
+                }
+            }
+        }
+
+        bml_free_memory(mark);
+    }
+
+    return missing == 0;
+}
+
+/** Matrix multiply with a sparsity plan.
+ *
+ * X2 = X * X
+ *
+ * The plan has to be valid for X, see bml_multiply_plan_is_valid_ellpack().
+ *
+ *  \ingroup multiply_group
+ *
+ *  \param plan The sparsity plan
+ *  \param X Matrix X
+ *  \param X2 Matrix X2
+ *  \param threshold Used for sparse multiply
+ *  \return The traces of X and X2
+ */
+void *
+bml_multiply_x2_planned_ellpack(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold)
+{
+    switch (X->matrix_precision)
+    {
+        case single_real:
+            return bml_multiply_x2_planned_ellpack_single_real(plan, X, X2,
+                                                               threshold);
+            break;
+        case double_real:
+            return bml_multiply_x2_planned_ellpack_double_real(plan, X, X2,
+                                                               threshold);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            return bml_multiply_x2_planned_ellpack_single_complex(plan, X,
+                                                                  X2,
+                                                                  threshold);
+            break;
+        case double_complex:
+            return bml_multiply_x2_planned_ellpack_double_complex(plan, X,
+                                                                  X2,
+                                                                  threshold);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
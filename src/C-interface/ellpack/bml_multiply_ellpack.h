@@ -166,4 +166,42 @@ void bml_multiply_cusparse_ellpack_double_complex(
     double beta1,
     double threshold);
 #endif
+
+bml_multiply_plan_t *bml_multiply_plan_x2_ellpack(
+    bml_matrix_ellpack_t * X);
+
+int bml_multiply_plan_is_valid_ellpack(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X);
+
+void *bml_multiply_x2_planned_ellpack(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellpack_single_real(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellpack_double_real(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellpack_single_complex(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellpack_double_complex(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold);
+
 #endif
@@ -6,6 +6,7 @@
 #include "../bml_multiply.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
+#include "../../internal-blas/bml_accumulator.h"
 #include "bml_add_ellpack.h"
 #include "bml_allocate_ellpack.h"
 #include "bml_multiply_ellpack.h"
@@ -27,6 +28,117 @@
 #include <cusparse.h>
 #endif
 
+/** Fused matrix multiply and add.
+ *
+ * \f$ C \leftarrow \alpha A \, B + \beta C \f$
+ *
+ * Each row of C is accumulated from \f$ \beta C_{i,:} \f$ and
+ * \f$ \alpha A_{i,:} B \f$ in one row accumulator and written back in
+ * place, without a temporary product matrix. The threshold is applied
+ * once to the sum. C must not alias A or B.
+ *
+ * \param A Matrix A
+ * \param B Matrix B
+ * \param C Matrix C
+ * \param alpha Scalar factor multiplied by A * B
+ * \param beta Scalar factor multiplied by C
+ * \param threshold Threshold for the result
+ */
+static void TYPED_FUNC(
+    bml_multiply_fused_ellpack) (
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    bml_matrix_ellpack_t * C,
+    double alpha,
+    double beta,
+    double threshold)
+{
+    int A_M = A->M;
+    int *A_index = A->index;
+    int *A_nnz = A->nnz;
+
+    int B_M = B->M;
+    int *B_index = B->index;
+    int *B_nnz = B->nnz;
+
+    int C_N = C->N;
+    int C_M = C->M;
+    int *C_index = C->index;
+    int *C_nnz = C->nnz;
+
+    REAL_T *A_value = (REAL_T *) A->value;
+    REAL_T *B_value = (REAL_T *) B->value;
+    REAL_T *C_value = (REAL_T *) C->value;
+
+    int myRank = bml_getMyRank();
+    int rowMin = C->domain->localRowMin[myRank];
+    int rowMax = C->domain->localRowMax[myRank];
+
+    int use_alpha = (alpha > (double) 0.0 || alpha < (double) 0.0);
+    int use_beta = (beta > (double) 0.0 || beta < (double) 0.0);
+
+#pragma omp parallel                           \
+    shared(A_M, A_index, A_nnz, A_value)       \
+    shared(B_M, B_index, B_nnz, B_value)       \
+    shared(C_N, C_M, C_index, C_nnz, C_value)  \
+    shared(rowMin, rowMax)
+    {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (C_N, C_M);
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            if (use_beta)
+            {
+                TYPED_FUNC(bml_accumulator_add_row) (acc, C_nnz[i],
+                                                     &C_index[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)],
+                                                     &C_value[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)], beta);
+            }
+            if (use_alpha)
+            {
+                for (int jp = 0; jp < A_nnz[i]; jp++)
+                {
+                    REAL_T a = alpha * A_value[ROWMAJOR(i, jp, A->N, A_M)];
+                    int j = A_index[ROWMAJOR(i, jp, A->N, A_M)];
+
+                    TYPED_FUNC(bml_accumulator_add_row) (acc, B_nnz[j],
+                                                         &B_index[ROWMAJOR
+                                                                  (j, 0,
+                                                                   B->N,
+                                                                   B_M)],
+                                                         &B_value[ROWMAJOR
+                                                                  (j, 0,
+                                                                   B->N,
+                                                                   B_M)], a);
+                }
+            }
+
+            // Check for number of non-zeroes per row exceeded
+            if (acc->size > C_M)
+            {
+                LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+            }
+
+            C_nnz[i] =
+                TYPED_FUNC(bml_accumulator_extract) (acc, -1, threshold,
+                                                     &C_index[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)],
+                                                     &C_value[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)]);
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+}
+
 /** Matrix multiply.
  *
  * \f$ C \leftarrow \alpha A \, B + \beta C \f$
@@ -58,7 +170,21 @@ void TYPED_FUNC(
     {
         LOG_ERROR("Either matrix A or B are NULL\n");
     }
-// To Do: Direct implementation of (C = alpha*A*B + beta*C) to reduce data motion -DOK
+
+    // the fused kernel updates C in place, so C must not alias A or B;
+    // distributed matrices keep the gather of the temporary product
+#if defined(USE_OMP_OFFLOAD) || defined(BML_USE_CUSPARSE)
+    int fused = 0;
+#else
+    int fused = (C != A && C != B);
+#endif
+#ifdef DO_MPI
+    if (bml_getNRanks() > 1 && C->distribution_mode == distributed)
+    {
+        fused = 0;
+    }
+#endif
+
 //#if defined(BML_USE_CUSPARSE)
 //    TYPED_FUNC(bml_multiply_cusparse_ellpack) (A, B, C, alpha, beta,
 //                                               threshold);
@@ -68,6 +194,11 @@ void TYPED_FUNC(
     {
         trace = TYPED_FUNC(bml_multiply_x2_ellpack) (A, C, threshold);
     }
+    else if (fused)
+    {
+        TYPED_FUNC(bml_multiply_fused_ellpack) (A, B, C, alpha, beta,
+                                                threshold);
+    }
     else
     {
         bml_matrix_dimension_t matrix_dimension = { C->N, C->N, C->M };
@@ -151,7 +282,8 @@ void *TYPED_FUNC(
 
 #else
 
-#if !(defined(__IBMC__) || defined(__ibmxl__) || (defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK))))
+#if defined(USE_OMP_OFFLOAD)
+#if !(defined(__IBMC__) || defined(__ibmxl__) || defined(INTEL_SDK) || defined(CRAY_SDK))
     int ix[X_N], jx[X_N];
     REAL_T x[X_N];
 
@@ -160,7 +292,7 @@ void *TYPED_FUNC(
     memset(x, 0.0, X_N * sizeof(REAL_T));
 #endif
 
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
+#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
     int num_chunks = MIN(OFFLOAD_NUM_CHUNKS, rowMax - rowMin + 1);
 
     int *all_ix, *all_jx;
@@ -172,10 +304,6 @@ void *TYPED_FUNC(
 
 #pragma omp target map(to:all_ix[0:X_N*num_chunks],all_jx[0:X_N*num_chunks],all_x[0:X_N*num_chunks])
 
-#endif
-
-#if defined (USE_OMP_OFFLOAD)
-#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
 #pragma omp teams distribute parallel for	\
     shared(X_N, X_M, X_index, X_nnz, X_value)  \
     shared(X2_N, X2_M, X2_index, X2_nnz, X2_value)     \
@@ -190,6 +318,8 @@ void *TYPED_FUNC(
         jx = &all_jx[chunk * X_N];
         x = &all_x[chunk * X_N];
 
+        for (int i = rowMin + chunk; i < rowMax; i = i + num_chunks)
+        {
 #else
 #pragma omp target teams distribute parallel for                               \
     shared(X_N, X_M, X_index, X_nnz, X_value)  \
@@ -197,45 +327,8 @@ void *TYPED_FUNC(
     shared(rowMin, rowMax)                             \
     firstprivate(ix,jx, x)                             \
     reduction(+: traceX, traceX2)
-#endif
-#else
-#if defined(__IBMC__) || defined(__ibmxl__)
-#pragma omp parallel for                               \
-    shared(X_N, X_M, X_index, X_nnz, X_value)  \
-    shared(X2_N, X2_M, X2_index, X2_nnz, X2_value)     \
-    shared(rowMin, rowMax)                             \
-    reduction(+: traceX, traceX2)
-#else
-#if !(defined(CRAY_SDK) || defined(INTEL_SDK))
-#pragma vector aligned
-#endif
-#pragma omp parallel for                               \
-    shared(X_N, X_M, X_index, X_nnz, X_value)  \
-    shared(X2_N, X2_M, X2_index, X2_nnz, X2_value)     \
-    shared(rowMin, rowMax)                             \
-    firstprivate(ix,jx, x)                             \
-    reduction(+: traceX, traceX2)
-#endif
-#endif
-
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
-    for (int i = rowMin + chunk; i < rowMax; i = i + num_chunks)
-    {
-#else
     for (int i = rowMin; i < rowMax; i++)
     {
-
-#if defined(__IBMC__) || defined(__ibmxl__)
-        int ix[X_N], jx[X_N];
-        REAL_T x[X_N];
-
-        memset(ix, 0, X_N * sizeof(int));
-#endif
-#endif
-#ifdef INTEL_OPT
-        __assume_aligned(X_nnz, MALLOC_ALIGNMENT);
-        __assume_aligned(X_index, MALLOC_ALIGNMENT);
-        __assume_aligned(X_value, MALLOC_ALIGNMENT);
 #endif
         int l = 0;
         for (int jp = 0; jp < X_nnz[i]; jp++)
@@ -252,7 +345,6 @@ void *TYPED_FUNC(
                 if (ix[k] == 0)
                 {
                     x[k] = 0.0;
-                    //X2_index[ROWMAJOR(i, l, N, M)] = k;
                     jx[l] = k;
                     ix[k] = i + 1;
                     l++;
@@ -262,23 +354,9 @@ void *TYPED_FUNC(
             }
         }
 
-        // Check for number of non-zeroes per row exceeded
-        if (l > X2_M)
-        {
-#ifndef USE_OMP_OFFLOAD
-            LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
-#endif
-        }
-
-#ifdef INTEL_OPT
-        __assume_aligned(X2_nnz, MALLOC_ALIGNMENT);
-        __assume_aligned(X2_index, MALLOC_ALIGNMENT);
-        __assume_aligned(X2_value, MALLOC_ALIGNMENT);
-#endif
         int ll = 0;
         for (int j = 0; j < l; j++)
         {
-            //int jp = X2_index[ROWMAJOR(i, j, N, M)];
             int jp = jx[j];
             REAL_T xtmp = x[jp];
             if (jp == i)
@@ -299,11 +377,76 @@ void *TYPED_FUNC(
         }
         X2_nnz[i] = ll;
     }
-
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
+#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
 }
 #endif
 
+#else
+
+#pragma omp parallel                                   \
+    shared(X_N, X_M, X_index, X_nnz, X_value)          \
+    shared(X2_N, X2_M, X2_index, X2_nnz, X2_value)     \
+    shared(rowMin, rowMax)                             \
+    reduction(+: traceX, traceX2)
+    {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (X_N, X2_M);
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+#ifdef INTEL_OPT
+            __assume_aligned(X_nnz, MALLOC_ALIGNMENT);
+            __assume_aligned(X_index, MALLOC_ALIGNMENT);
+            __assume_aligned(X_value, MALLOC_ALIGNMENT);
+#endif
+            for (int jp = 0; jp < X_nnz[i]; jp++)
+            {
+                REAL_T a = X_value[ROWMAJOR(i, jp, X_N, X_M)];
+                int j = X_index[ROWMAJOR(i, jp, X_N, X_M)];
+                if (j == i)
+                {
+                    traceX = traceX + a;
+                }
+                TYPED_FUNC(bml_accumulator_add_row) (acc, X_nnz[j],
+                                                     &X_index[ROWMAJOR
+                                                              (j, 0, X_N,
+                                                               X_M)],
+                                                     &X_value[ROWMAJOR
+                                                              (j, 0, X_N,
+                                                               X_M)], a);
+            }
+
+            // Check for number of non-zeroes per row exceeded
+            if (acc->size > X2_M)
+            {
+                LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+            }
+
+            int ll = TYPED_FUNC(bml_accumulator_extract) (acc, i, threshold,
+                                                          &X2_index[ROWMAJOR
+                                                                    (i, 0,
+                                                                     X2_N,
+                                                                     X2_M)],
+                                                          &X2_value[ROWMAJOR
+                                                                    (i, 0,
+                                                                     X2_N,
+                                                                     X2_M)]);
+            for (int jp = 0; jp < ll; jp++)
+            {
+                if (X2_index[ROWMAJOR(i, jp, X2_N, X2_M)] == i)
+                {
+                    traceX2 = traceX2 + X2_value[ROWMAJOR(i, jp, X2_N, X2_M)];
+                }
+            }
+            X2_nnz[i] = ll;
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+#endif
+
 #endif // endif cusparse
 
 trace[0] = traceX;
@@ -312,6 +455,123 @@ trace[1] = traceX2;
 return trace;
 }
 
+/** Matrix multiply with a sparsity plan.
+ *
+ * \f$ X^{2} \leftarrow X \, X \f$
+ *
+ * Numeric pass only: the rows are accumulated in a row accumulator
+ * sized by the longest output row of the plan, so that it never grows,
+ * and processed in the flop balanced chunks of the plan. The plan has
+ * to be valid for X.
+ *
+ * \ingroup multiply_group
+ *
+ * \param plan The sparsity plan
+ * \param X Matrix X
+ * \param X2 Matrix X2
+ * \param threshold Used for sparse multiply
+ * \return The traces of X and X2
+ */
+void *TYPED_FUNC(
+    bml_multiply_x2_planned_ellpack) (
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellpack_t * X,
+    bml_matrix_ellpack_t * X2,
+    double threshold)
+{
+#if defined(USE_OMP_OFFLOAD) || defined(BML_USE_CUSPARSE)
+    // the matrices live on the device, the plan is only used on the host
+    return TYPED_FUNC(bml_multiply_x2_ellpack) (X, X2, threshold);
+#else
+    int X_N = X->N;
+    int X_M = X->M;
+    int *X_index = X->index;
+    int *X_nnz = X->nnz;
+
+    int X2_M = X2->M;
+    int *X2_index = X2->index;
+    int *X2_nnz = X2->nnz;
+
+    REAL_T traceX = 0.0;
+    REAL_T traceX2 = 0.0;
+    REAL_T *X_value = (REAL_T *) X->value;
+    REAL_T *X2_value = (REAL_T *) X2->value;
+
+    int max_row_nnz = plan->max_row_nnz;
+    int *chunk_ptr = plan->chunk_ptr;
+    int nchunks = plan->nchunks;
+
+    double *trace = bml_allocate_memory(sizeof(double) * 2);
+
+    if (max_row_nnz > X2_M)
+    {
+        LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+    }
+
+#pragma omp parallel                                 \
+  shared(X_N, X_M, X_index, X_nnz, X_value)          \
+  shared(X2_M, X2_index, X2_nnz, X2_value)           \
+  shared(max_row_nnz, chunk_ptr, nchunks)            \
+  reduction(+: traceX, traceX2)
+    {
+        /* row accumulator sized by the plan, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (X_N, max_row_nnz);
+
+#pragma omp for schedule(dynamic)
+        for (int c = 0; c < nchunks; c++)
+        {
+            for (int i = chunk_ptr[c]; i < chunk_ptr[c + 1]; i++)
+            {
+                for (int jp = 0; jp < X_nnz[i]; jp++)
+                {
+                    REAL_T a = X_value[ROWMAJOR(i, jp, X_N, X_M)];
+                    int j = X_index[ROWMAJOR(i, jp, X_N, X_M)];
+                    if (j == i)
+                    {
+                        traceX = traceX + a;
+                    }
+                    TYPED_FUNC(bml_accumulator_add_row) (acc, X_nnz[j],
+                                                         &X_index[ROWMAJOR
+                                                                  (j, 0, X_N,
+                                                                   X_M)],
+                                                         &X_value[ROWMAJOR
+                                                                  (j, 0, X_N,
+                                                                   X_M)], a);
+                }
+
+                int ll =
+                    TYPED_FUNC(bml_accumulator_extract) (acc, i, threshold,
+                                                         &X2_index[ROWMAJOR
+                                                                   (i, 0,
+                                                                    X2->N,
+                                                                    X2_M)],
+                                                         &X2_value[ROWMAJOR
+                                                                   (i, 0,
+                                                                    X2->N,
+                                                                    X2_M)]);
+                for (int kp = 0; kp < ll; kp++)
+                {
+                    if (X2_index[ROWMAJOR(i, kp, X2->N, X2_M)] == i)
+                    {
+                        traceX2 =
+                            traceX2 + X2_value[ROWMAJOR(i, kp, X2->N, X2_M)];
+                    }
+                }
+                X2_nnz[i] = ll;
+            }
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+
+    trace[0] = traceX;
+    trace[1] = traceX2;
+
+    return trace;
+#endif
+}
+
 /** Matrix multiply.
  *
  * \f$ C \leftarrow B \, A \f$
@@ -362,7 +622,8 @@ void TYPED_FUNC(
                                                threshold);
 #else
 
-#if !(defined(__IBMC__) || defined(__ibmxl__) || (defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK))))
+#if defined(USE_OMP_OFFLOAD)
+#if !(defined(__IBMC__) || defined(__ibmxl__) || defined(INTEL_SDK) || defined(CRAY_SDK))
     int ix[C->N], jx[C->N];
     REAL_T x[C->N];
 
@@ -371,7 +632,7 @@ void TYPED_FUNC(
     memset(x, 0.0, C->N * sizeof(REAL_T));
 #endif
 
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
+#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
     int num_chunks = MIN(OFFLOAD_NUM_CHUNKS, rowMax - rowMin + 1);
 
     int *all_ix, *all_jx;
@@ -383,10 +644,6 @@ void TYPED_FUNC(
 
 #pragma omp target map(to:all_ix[0:C_N*num_chunks],all_jx[0:C_N*num_chunks],all_x[0:C_N*num_chunks])
 
-#endif
-
-#if defined (USE_OMP_OFFLOAD)
-#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
 #pragma omp teams distribute parallel for \
     shared(A_N, A_M, A_nnz, A_index, A_value)  \
     shared(A_localRowMin, A_localRowMax)       \
@@ -401,6 +658,8 @@ void TYPED_FUNC(
         jx = &all_jx[chunk * C_N];
         x = &all_x[chunk * C_N];
 
+        for (int i = rowMin + chunk; i < rowMax; i = i + num_chunks)
+        {
 #else
 #pragma omp target teams distribute parallel for \
     shared(A_N, A_M, A_nnz, A_index, A_value)  \
@@ -408,36 +667,8 @@ void TYPED_FUNC(
     shared(B_N, B_M, B_nnz, B_index, B_value)  \
     shared(C_N, C_M, C_nnz, C_index, C_value)  \
     firstprivate(ix, jx, x)
-#endif
-#else
-#if defined(__IBMC__) || defined(__ibmxl__)
-#pragma omp parallel for                       \
-    shared(A_N, A_M, A_nnz, A_index, A_value)  \
-    shared(A_localRowMin, A_localRowMax)       \
-    shared(B_N, B_M, B_nnz, B_index, B_value)  \
-    shared(C_N, C_M, C_nnz, C_index, C_value)
-#else
-#pragma omp parallel for                       \
-    shared(A_N, A_M, A_nnz, A_index, A_value)  \
-    shared(A_localRowMin, A_localRowMax)       \
-    shared(B_N, B_M, B_nnz, B_index, B_value)  \
-    shared(C_N, C_M, C_nnz, C_index, C_value)  \
-    firstprivate(ix, jx, x)
-#endif
-#endif
-    //for (int i = 0; i < A_N; i++)
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
-    for (int i = rowMin + chunk; i < rowMax; i = i + num_chunks)
-    {
-#else
     for (int i = rowMin; i < rowMax; i++)
     {
-#if defined(__IBMC__) || defined(__ibmxl__)
-        int ix[C_N], jx[C_N];
-        REAL_T x[C_N];
-
-        memset(ix, 0, C_N * sizeof(int));
-#endif
 #endif
         int l = 0;
         for (int jp = 0; jp < A_nnz[i]; jp++)
@@ -451,7 +682,6 @@ void TYPED_FUNC(
                 if (ix[k] == 0)
                 {
                     x[k] = 0.0;
-                    //C_index[ROWMAJOR(i, l, N, M)] = k;
                     jx[l] = k;
                     ix[k] = i + 1;
                     l++;
@@ -461,18 +691,9 @@ void TYPED_FUNC(
             }
         }
 
-        // Check for number of non-zeroes per row exceeded
-        if (l > C_M)
-        {
-#ifndef USE_OMP_OFFLOAD
-            LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
-#endif
-        }
-
         int ll = 0;
         for (int j = 0; j < l; j++)
         {
-            //int jp = C_index[ROWMAJOR(i, j, N, M)];
             int jp = jx[j];
             REAL_T xtmp = x[jp];
             if (jp == i)
@@ -492,10 +713,58 @@ void TYPED_FUNC(
         }
         C_nnz[i] = ll;
     }
-#if defined(USE_OMP_OFFLOAD) && (defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__))
+#if defined(INTEL_SDK) || defined(CRAY_SDK) || defined(__IBMC__) || defined(__ibmxl__)
 }
 #endif
 
+#else
+
+#pragma omp parallel                           \
+    shared(A_N, A_M, A_nnz, A_index, A_value)  \
+    shared(B_N, B_M, B_nnz, B_index, B_value)  \
+    shared(C_N, C_M, C_nnz, C_index, C_value)
+    {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (C_N, C_M);
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            for (int jp = 0; jp < A_nnz[i]; jp++)
+            {
+                REAL_T a = A_value[ROWMAJOR(i, jp, A_N, A_M)];
+                int j = A_index[ROWMAJOR(i, jp, A_N, A_M)];
+
+                TYPED_FUNC(bml_accumulator_add_row) (acc, B_nnz[j],
+                                                     &B_index[ROWMAJOR
+                                                              (j, 0, B_N,
+                                                               B_M)],
+                                                     &B_value[ROWMAJOR
+                                                              (j, 0, B_N,
+                                                               B_M)], a);
+            }
+
+            // Check for number of non-zeroes per row exceeded
+            if (acc->size > C_M)
+            {
+                LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+            }
+
+            C_nnz[i] =
+                TYPED_FUNC(bml_accumulator_extract) (acc, i, threshold,
+                                                     &C_index[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)],
+                                                     &C_value[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)]);
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+#endif
+
 #endif // endif cusparse
 }
 
@@ -551,99 +820,63 @@ void TYPED_FUNC(
 #pragma omp target update from(B_nnz[:B_N], B_index[:B_N*B_M], B_value[:B_N*B_M])
 #endif
 
-#if !(defined(__IBMC__) || defined(__ibmxl__))
-    int ix[C->N], jx[C->N];
-    REAL_T x[C->N];
-
-    memset(ix, 0, C->N * sizeof(int));
-    memset(jx, 0, C->N * sizeof(int));
-    memset(x, 0.0, C->N * sizeof(REAL_T));
-#endif
-
     while (aflag > 0)
     {
         aflag = 0;
 
-#if defined(__IBMC__) || defined(__ibmxl__)
-#pragma omp parallel for                       \
-    shared(A_N, A_M, A_nnz, A_index, A_value)  \
-    shared(B_N, B_M, B_nnz, B_index, B_value)  \
-    shared(C_N, C_M, C_nnz, C_index, C_value)  \
-    shared(adjust_threshold)           \
-    reduction(+:aflag)
-#else
-#pragma omp parallel for                       \
+#pragma omp parallel                           \
     shared(A_N, A_M, A_nnz, A_index, A_value)  \
     shared(B_N, B_M, B_nnz, B_index, B_value)  \
     shared(C_N, C_M, C_nnz, C_index, C_value)  \
-    shared(adjust_threshold)           \
-    firstprivate(ix, jx, x)                    \
+    shared(adjust_threshold)                   \
     reduction(+:aflag)
-#endif
-
-        //for (int i = 0; i < A_N; i++)
-        for (int i = rowMin; i < rowMax; i++)
         {
+            /* row accumulator, allocated once per thread */
+            bml_accumulator_t *acc =
+                TYPED_FUNC(bml_accumulator_allocate) (C_N, C_M);
 
-#if defined(__IBMC__) || defined(__ibmxl__)
-            int ix[C_N], jx[C_N];
-            REAL_T x[C_N];
-
-            memset(ix, 0, C_N * sizeof(int));
-#endif
-
-            int l = 0;
-            for (int jp = 0; jp < A_nnz[i]; jp++)
+#pragma omp for
+            for (int i = rowMin; i < rowMax; i++)
             {
-                REAL_T a = A_value[ROWMAJOR(i, jp, A_N, A_M)];
-                int j = A_index[ROWMAJOR(i, jp, A_N, A_M)];
-
-                for (int kp = 0; kp < B_nnz[j]; kp++)
+                for (int jp = 0; jp < A_nnz[i]; jp++)
                 {
-                    int k = B_index[ROWMAJOR(j, kp, B_N, B_M)];
-                    if (ix[k] == 0)
-                    {
-                        x[k] = 0.0;
-                        jx[l] = k;
-                        ix[k] = i + 1;
-                        l++;
-                    }
-                    // TEMPORARY STORAGE VECTOR LENGTH FULL N
-                    x[k] = x[k] + a * B_value[ROWMAJOR(j, kp, B_N, B_M)];
+                    REAL_T a = A_value[ROWMAJOR(i, jp, A_N, A_M)];
+                    int j = A_index[ROWMAJOR(i, jp, A_N, A_M)];
+
+                    TYPED_FUNC(bml_accumulator_add_row) (acc, B_nnz[j],
+                                                         &B_index[ROWMAJOR
+                                                                  (j, 0, B_N,
+                                                                   B_M)],
+                                                         &B_value[ROWMAJOR
+                                                                  (j, 0, B_N,
+                                                                   B_M)], a);
                 }
-            }
-
-            // Check for number of non-zeroes per row exceeded
-            // Need to adjust threshold
-            // ** Shouldn't we break from this loop if aflag is 1?? --DOK
-            if (l > C_M)
-            {
-                aflag = 1;
-            }
 
-            int ll = 0;
-            for (int j = 0; j < l; j++)
-            {
-                //int jp = C_index[ROWMAJOR(i, j, N, M)];
-                int jp = jx[j];
-                REAL_T xtmp = x[jp];
-                // Diagonal elements are saved in first column
-                if (jp == i)
+                // Check for number of non-zeroes per row exceeded
+                // Need to adjust threshold, the row is redone
+                if (acc->size > C_M)
                 {
-                    C_value[ROWMAJOR(i, ll, C_N, C_M)] = xtmp;
-                    C_index[ROWMAJOR(i, ll, C_N, C_M)] = jp;
-                    ll++;
+                    aflag = 1;
+                    TYPED_FUNC(bml_accumulator_clear) (acc);
                 }
-                else if (is_above_threshold(xtmp, adjust_threshold))
+                else
                 {
-                    C_value[ROWMAJOR(i, ll, C_N, C_M)] = xtmp;
-                    C_index[ROWMAJOR(i, ll, C_N, C_M)] = jp;
-                    ll++;
+                    // Diagonal elements are always kept
+                    C_nnz[i] =
+                        TYPED_FUNC(bml_accumulator_extract) (acc, i,
+                                                             adjust_threshold,
+                                                             &C_index[ROWMAJOR
+                                                                      (i, 0,
+                                                                       C_N,
+                                                                       C_M)],
+                                                             &C_value[ROWMAJOR
+                                                                      (i, 0,
+                                                                       C_N,
+                                                                       C_M)]);
                 }
-                ix[jp] = 0;
-                x[jp] = 0.0;
             }
-            C_nnz[i] = ll;
+
+            TYPED_FUNC(bml_accumulator_deallocate) (acc);
         }
 
         adjust_threshold *= (REAL_T) 2.0;
@@ -125,6 +125,60 @@ bml_mpi_recv_ellpack(
     }
 }
 
+void
+bml_mpi_isend_ellpack(
+    bml_matrix_ellpack_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_ellpack_single_real(A, dst, comm);
+            break;
+        case double_real:
+            bml_mpi_isend_ellpack_double_real(A, dst, comm);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_ellpack_single_complex(A, dst, comm);
+            break;
+        case double_complex:
+            bml_mpi_isend_ellpack_double_complex(A, dst, comm);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+void
+bml_mpi_isend_complete_ellpack(
+    bml_matrix_ellpack_t * A)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_mpi_isend_complete_ellpack_single_real(A);
+            break;
+        case double_real:
+            bml_mpi_isend_complete_ellpack_double_real(A);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_mpi_isend_complete_ellpack_single_complex(A);
+            break;
+        case double_complex:
+            bml_mpi_isend_complete_ellpack_double_complex(A);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
 void
 bml_mpi_irecv_ellpack(
     bml_matrix_ellpack_t * A,
@@ -179,6 +233,20 @@ bml_mpi_irecv_complete_ellpack(
     }
 }
 
+/** Make progress on the nonblocking sends or receives of A.
+ *
+ *  \param A The matrix
+ *  \return Non-zero if they are done
+ */
+int
+bml_mpi_test_ellpack(
+    bml_matrix_ellpack_t * A)
+{
+    int flag;
+    MPI_Testall(3, A->req, &flag, MPI_STATUSES_IGNORE);
+    return flag;
+}
+
 bml_matrix_ellpack_t *
 bml_mpi_recv_matrix_ellpack(
     bml_matrix_precision_t matrix_precision,
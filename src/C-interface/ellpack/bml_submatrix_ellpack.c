@@ -1,4 +1,5 @@
 #include "../../macros.h"
+#include "../bml_allocate.h"
 #include "../bml_logger.h"
 #include "../bml_submatrix.h"
 #include "../bml_types.h"
@@ -349,27 +350,22 @@ bml_adjacency_ellpack(
     int *A_index = A->index;
 
     int j;
-    int check;
 
+    // Count the off-diagonal elements of each row, the diagonal is
+    // not an edge of the graph
     xadj[0] = 0;
-
-    // Check if diagonal elements are included
-    check = 0;
-    for (int i = 0; i < A_nnz[0]; i++)
+    for (int i = 0; i < A_N; i++)
     {
-        if (A_index[ROWMAJOR(0, i, A_N, A_M)] == 0)
+        int nedges = A_nnz[i];
+        for (int jj = 0; jj < A_nnz[i]; jj++)
         {
-            check = 1;
-            break;
+            if (A_index[ROWMAJOR(i, jj, A_N, A_M)] == i)
+            {
+                nedges--;
+                break;
+            }
         }
-    }
-
-    for (int i = 1; i < A_N + 1; i++)
-    {
-        if (check == 1)
-            xadj[i] = xadj[i - 1] + A_nnz[i - 1] - 1;
-        else
-            xadj[i] = xadj[i - 1] + A_nnz[i - 1];
+        xadj[i + 1] = xadj[i] + nedges;
     }
 
 #pragma omp parallel for                                \
@@ -584,3 +580,221 @@ bml_assign_submatrix_ellpack(
             break;
     }
 }
+
+/** Build the core+halo indices of all parts of a partition.
+ *
+ * Same index sets as bml_matrix2submatrix_index_ellpack, built in
+ * parallel over the parts with a marker array per thread.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Hamiltonian matrix A
+ * \param B Graph matrix B
+ * \param batch The batch to fill
+ * \param part_ptr Offsets of the parts into part_nodes
+ * \param part_nodes Nodes of all parts
+ * \param double_jump_flag Flag to use double jump (0=no, 1=yes)
+ */
+void
+bml_submatrix_batch_index_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    bml_submatrix_batch_t * batch,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag)
+{
+    int A_N = A->N;
+    int A_M = A->M;
+    int *A_nnz = A->nnz;
+    int *A_index = A->index;
+    int B_M = B->M;
+    int *B_nnz = B->nnz;
+    int *B_index = B->index;
+
+    int nparts = batch->nparts;
+    int *index_ptr = batch->index_ptr;
+    int *ncore = batch->ncore;
+    int **part_index = bml_noinit_allocate_memory(sizeof(int *) *
+                                                  (nparts + 1));
+
+#ifdef USE_OMP_OFFLOAD
+#pragma omp target update from(A_nnz[:A_N], A_index[:A_N*A_M])
+#pragma omp target update from(B_nnz[:B->N], B_index[:B->N*B_M])
+#endif
+
+#pragma omp parallel
+    {
+        int *ix = bml_allocate_memory(sizeof(int) * A_N);
+        int *list = bml_noinit_allocate_memory(sizeof(int) * A_N);
+
+#pragma omp for schedule(dynamic)
+        for (int p = 0; p < nparts; p++)
+        {
+            int *nodelist = part_nodes + part_ptr[p];
+            int nsize = part_ptr[p + 1] - part_ptr[p];
+            int l = 0;
+            int ll = 0;
+
+            // Cores are first followed by halos
+            for (int j = 0; j < nsize; j++)
+            {
+                int ii = nodelist[j];
+                if (ix[ii] == 0)
+                {
+                    ix[ii] = 1;
+                    list[l++] = ii;
+                    ll++;
+                }
+            }
+
+            // Collect halo indices from graph, then from H
+            for (int j = 0; j < nsize; j++)
+            {
+                int ii = nodelist[j];
+                for (int jp = 0; jp < B_nnz[ii]; jp++)
+                {
+                    int k = B_index[ROWMAJOR(ii, jp, B->N, B_M)];
+                    if (ix[k] == 0)
+                    {
+                        ix[k] = 1;
+                        list[l++] = k;
+                    }
+                }
+            }
+            for (int j = 0; j < nsize; j++)
+            {
+                int ii = nodelist[j];
+                for (int jp = 0; jp < A_nnz[ii]; jp++)
+                {
+                    int k = A_index[ROWMAJOR(ii, jp, A_N, A_M)];
+                    if (ix[k] == 0)
+                    {
+                        ix[k] = 1;
+                        list[l++] = k;
+                    }
+                }
+            }
+
+            // Double jump based on graph
+            if (double_jump_flag == 1)
+            {
+                int ls = l;
+                for (int j = 0; j < ls; j++)
+                {
+                    int ii = list[j];
+                    for (int jp = 0; jp < B_nnz[ii]; jp++)
+                    {
+                        int k = B_index[ROWMAJOR(ii, jp, B->N, B_M)];
+                        if (ix[k] == 0)
+                        {
+                            ix[k] = 1;
+                            list[l++] = k;
+                        }
+                    }
+                }
+            }
+
+            part_index[p] = bml_noinit_allocate_memory(sizeof(int) * (l + 1));
+            for (int j = 0; j < l; j++)
+            {
+                part_index[p][j] = list[j];
+                ix[list[j]] = 0;
+            }
+            index_ptr[p + 1] = l;
+            ncore[p] = ll;
+        }
+
+        bml_free_memory(ix);
+        bml_free_memory(list);
+    }
+
+    index_ptr[0] = 0;
+    for (int p = 0; p < nparts; p++)
+    {
+        index_ptr[p + 1] += index_ptr[p];
+    }
+    batch->core_halo_index =
+        bml_noinit_allocate_memory(sizeof(int) * (index_ptr[nparts] + 1));
+    for (int p = 0; p < nparts; p++)
+    {
+        memcpy(batch->core_halo_index + index_ptr[p], part_index[p],
+               sizeof(int) * (index_ptr[p + 1] - index_ptr[p]));
+        bml_free_memory(part_index[p]);
+    }
+    bml_free_memory(part_index);
+}
+
+/** Extract the dense submatrices of all parts of a batch.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param batch The batch
+ */
+void
+bml_submatrix_batch_extract_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_submatrix_batch_t * batch)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_submatrix_batch_extract_ellpack_single_real(A, batch);
+            break;
+        case double_real:
+            bml_submatrix_batch_extract_ellpack_double_real(A, batch);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_submatrix_batch_extract_ellpack_single_complex(A, batch);
+            break;
+        case double_complex:
+            bml_submatrix_batch_extract_ellpack_double_complex(A, batch);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+/** Assemble the core rows of all submatrices of a batch.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param batch The batch
+ * \param B Matrix B
+ * \param threshold Threshold for elements
+ */
+void
+bml_submatrix_batch_assemble_ellpack(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellpack_t * B,
+    double threshold)
+{
+    switch (B->matrix_precision)
+    {
+        case single_real:
+            bml_submatrix_batch_assemble_ellpack_single_real(batch, B,
+                                                             threshold);
+            break;
+        case double_real:
+            bml_submatrix_batch_assemble_ellpack_double_real(batch, B,
+                                                             threshold);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_submatrix_batch_assemble_ellpack_single_complex(batch, B,
+                                                                threshold);
+            break;
+        case double_complex:
+            bml_submatrix_batch_assemble_ellpack_double_complex(batch, B,
+                                                                threshold);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
@@ -300,4 +300,57 @@ void bml_assign_submatrix_ellpack_double_complex(
     int irow,
     int icol);
 
+void bml_submatrix_batch_index_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_matrix_ellpack_t * B,
+    bml_submatrix_batch_t * batch,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag);
+
+void bml_submatrix_batch_extract_ellpack(
+    bml_matrix_ellpack_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellpack_single_real(
+    bml_matrix_ellpack_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellpack_double_real(
+    bml_matrix_ellpack_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellpack_single_complex(
+    bml_matrix_ellpack_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellpack_double_complex(
+    bml_matrix_ellpack_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_assemble_ellpack(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellpack_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellpack_single_real(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellpack_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellpack_double_real(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellpack_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellpack_single_complex(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellpack_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellpack_double_complex(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellpack_t * B,
+    double threshold);
+
 #endif
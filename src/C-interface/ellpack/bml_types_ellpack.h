@@ -30,6 +30,10 @@ struct bml_matrix_ellpack_t
     bml_domain_t *domain;
     /** A copy of the domain decomposition. */
     bml_domain_t *domain2;
+    /** The binary file the arrays are mapped from, NULL if allocated. */
+    void *mapping;
+    /** The size of the mapping in bytes. */
+    size_t mapping_size;
 
 #if defined(BML_USE_CUSPARSE)
 /* need to ensure that this is sorted */
@@ -39,10 +43,43 @@ struct bml_matrix_ellpack_t
 #endif
 
 #ifdef DO_MPI
-    /** request field for MPI communications*/
-    MPI_Request req;
+    /** packed column indices of a pending send */
+    int *index_buffer;
+    /** packed values of a pending send */
+    void *buffer;
+    /** request fields for MPI communications*/
+    MPI_Request req[3];
 #endif
 };
 typedef struct bml_matrix_ellpack_t bml_matrix_ellpack_t;
 
+/** Ghost rows of a row distributed ELLPACK matrix.
+ *
+ * Each rank stores its owned rows [rowMin, rowMax) followed by the
+ * ghost rows it references, with global column indices.
+ */
+typedef struct
+{
+    /** The global number of rows. */
+    int N;
+    /** The first owned row. */
+    int rowMin;
+    /** One past the last owned row. */
+    int rowMax;
+    /** The number of ghost rows. */
+    int nghost;
+    /** The global index of each ghost row, sorted, so grouped by owner. */
+    int *ghost_rows;
+    /** The number of ghost rows received from each rank. */
+    int *recv_count;
+    /** The offset of the ghost rows of each rank in ghost_rows. */
+    int *recv_displ;
+    /** The number of owned rows sent to each rank. */
+    int *send_count;
+    /** The offset of the rows sent to each rank in send_rows. */
+    int *send_displ;
+    /** The local index of each owned row sent. */
+    int *send_rows;
+} bml_halo_ellpack_t;
+
 #endif
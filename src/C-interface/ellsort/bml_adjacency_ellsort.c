@@ -1,15 +0,0 @@
-#include "../bml_logger.h"
-#include "../bml_types.h"
-#include "bml_types_ellsort.h"
-
-#include <stdio.h>
-#include <stdlib.h>
-
-void
-bml_adjacency_ellsort(
-    bml_matrix_t * A,
-    int *xadj,
-    int *adjncy)
-{
-    LOG_ERROR("[FIXME]\n");
-}
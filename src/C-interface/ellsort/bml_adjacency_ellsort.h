@@ -1,12 +0,0 @@
-#ifndef __BML_ADJACENCY_ELLSORT_H
-#define __BML_ADJACENCY_ELLSORT_H
-
-#include "bml_types_ellsort.h"
-
-
-void bml_adjacency_ellsort(
-    bml_matrix_t * A,
-    int *xadj,
-    int *adjncy);
-
-#endif
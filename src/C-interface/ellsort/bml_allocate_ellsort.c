@@ -2,6 +2,7 @@
 #include "../bml_logger.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
+#include "../bml_utilities.h"
 #include "bml_allocate_ellsort.h"
 #include "bml_types_ellsort.h"
 
@@ -19,9 +20,16 @@ bml_deallocate_ellsort(
 {
     bml_deallocate_domain(A->domain);
     bml_deallocate_domain(A->domain2);
-    bml_free_memory(A->value);
-    bml_free_memory(A->index);
-    bml_free_memory(A->nnz);
+    if (A->mapping != NULL)
+    {
+        bml_unmap_binary_file(A->mapping, A->mapping_size);
+    }
+    else
+    {
+        bml_free_memory(A->value);
+        bml_free_memory(A->index);
+        bml_free_memory(A->nnz);
+    }
     bml_free_memory(A);
 }
 
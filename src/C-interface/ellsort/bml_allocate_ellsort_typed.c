@@ -63,6 +63,7 @@ bml_matrix_ellsort_t
     A->value = bml_noinit_allocate_memory(sizeof(REAL_T) * A->N * A->M);
     A->domain = bml_default_domain(A->N, A->M, distrib_mode);
     A->domain2 = bml_default_domain(A->N, A->M, distrib_mode);
+    A->mapping = NULL;
 
     return A;
 }
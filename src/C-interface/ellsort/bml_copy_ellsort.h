@@ -58,6 +58,51 @@ void bml_reorder_ellsort_double_complex(
     bml_matrix_ellsort_t * A,
     int *perm);
 
+void bml_copy_panel_ellsort(
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellsort_single_real(
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellsort_double_real(
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellsort_single_complex(
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
+void bml_copy_panel_ellsort_double_complex(
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    int i0,
+    int nrows,
+    int j0,
+    int ncols,
+    int l0);
+
 void bml_save_domain_ellsort(
     bml_matrix_ellsort_t * A);
 
@@ -23,4 +23,34 @@ void *bml_export_to_dense_ellsort_double_complex(
     bml_matrix_ellsort_t * A,
     bml_dense_order_t order);
 
+void bml_export_to_compressed_rows_ellsort(
+    bml_matrix_ellsort_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellsort_single_real(
+    bml_matrix_ellsort_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellsort_double_real(
+    bml_matrix_ellsort_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellsort_single_complex(
+    bml_matrix_ellsort_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
+void bml_export_to_compressed_rows_ellsort_double_complex(
+    bml_matrix_ellsort_t * A,
+    int **row_ptr,
+    int **cols,
+    void **vals);
+
 #endif
@@ -71,3 +71,51 @@ bml_matrix_ellsort_t
 
     return A_bml;
 }
+
+/** Convert compressed rows into a bml matrix.
+ *
+ * \ingroup convert_group
+ *
+ * \param N The number of rows/columns
+ * \param row_ptr The row pointers (N + 1)
+ * \param cols The column indices
+ * \param vals The values
+ * \param M The number of non-zeroes per row
+ * \param distrib_mode The distribution mode
+ * \return The bml matrix
+ */
+bml_matrix_ellsort_t *TYPED_FUNC(
+    bml_import_from_compressed_rows_ellsort) (
+    int N,
+    int *row_ptr,
+    int *cols,
+    void *vals,
+    int M,
+    bml_distribution_mode_t distrib_mode)
+{
+    bml_matrix_ellsort_t *A_bml =
+        TYPED_FUNC(bml_zero_matrix_ellsort) (N, M, distrib_mode);
+
+    int *A_nnz = A_bml->nnz;
+    int *A_index = A_bml->index;
+    REAL_T *A_value = A_bml->value;
+    REAL_T *A_vals = (REAL_T *) vals;
+
+#pragma omp parallel for shared(A_nnz, A_index, A_value, A_vals)
+    for (int i = 0; i < N; i++)
+    {
+        int nnz = row_ptr[i + 1] - row_ptr[i];
+        if (nnz > M)
+        {
+            LOG_ERROR("row %d has %d non-zeros, more than M = %d\n", i, nnz,
+                      M);
+        }
+        memcpy(&A_index[ROWMAJOR(i, 0, N, M)], &cols[row_ptr[i]],
+               sizeof(int) * nnz);
+        memcpy(&A_value[ROWMAJOR(i, 0, N, M)], &A_vals[row_ptr[i]],
+               sizeof(REAL_T) * nnz);
+        A_nnz[i] = nnz;
+    }
+
+    return A_bml;
+}
@@ -161,3 +161,37 @@ bml_get_sparsity_ellsort(
     }
     return -1;
 }
+
+/** Return the cost of every row of a matrix.
+ *
+ * \param A The bml matrix.
+ * \param balance What a row costs.
+ * \param cost The cost of each row (length N).
+ */
+void
+bml_get_row_costs_ellsort(
+    bml_matrix_ellsort_t * A,
+    bml_balance_t balance,
+    double *cost)
+{
+    int N = A->N;
+
+#pragma omp parallel for
+    for (int i = 0; i < N; i++)
+    {
+        switch (balance)
+        {
+            case balance_nnz:
+                cost[i] = A->nnz[i];
+                break;
+            case balance_multiply:
+                cost[i] = 0.;
+                for (int jp = 0; jp < A->nnz[i]; jp++)
+                    cost[i] += A->nnz[A->index[ROWMAJOR(i, jp, N, A->M)]];
+                break;
+            default:
+                cost[i] = 1.;
+                break;
+        }
+    }
+}
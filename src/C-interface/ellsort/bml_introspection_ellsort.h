@@ -19,6 +19,11 @@ int bml_get_row_bandwidth_ellsort(
     bml_matrix_ellsort_t * A,
     int i);
 
+void bml_get_row_costs_ellsort(
+    bml_matrix_ellsort_t * A,
+    bml_balance_t balance,
+    double *cost);
+
 int bml_get_bandwidth_ellsort(
     bml_matrix_ellsort_t * A);
 
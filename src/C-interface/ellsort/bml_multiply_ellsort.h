@@ -128,4 +128,41 @@ void bml_multiply_adjust_AB_ellsort_double_complex(
     bml_matrix_ellsort_t * C,
     double threshold);
 
+bml_multiply_plan_t *bml_multiply_plan_x2_ellsort(
+    bml_matrix_ellsort_t * X);
+
+int bml_multiply_plan_is_valid_ellsort(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X);
+
+void *bml_multiply_x2_planned_ellsort(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X,
+    bml_matrix_ellsort_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellsort_single_real(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X,
+    bml_matrix_ellsort_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellsort_double_real(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X,
+    bml_matrix_ellsort_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellsort_single_complex(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X,
+    bml_matrix_ellsort_t * X2,
+    double threshold);
+
+void *bml_multiply_x2_planned_ellsort_double_complex(
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X,
+    bml_matrix_ellsort_t * X2,
+    double threshold);
+
 #endif
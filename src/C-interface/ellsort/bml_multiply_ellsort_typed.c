@@ -6,6 +6,7 @@
 #include "../bml_multiply.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
+#include "../../internal-blas/bml_accumulator.h"
 #include "bml_add_ellsort.h"
 #include "bml_allocate_ellsort.h"
 #include "bml_multiply_ellsort.h"
@@ -21,6 +22,117 @@
 #include <omp.h>
 #endif
 
+/** Fused matrix multiply and add.
+ *
+ * \f$ C \leftarrow \alpha A \, B + \beta C \f$
+ *
+ * Each row of C is accumulated from \f$ \beta C_{i,:} \f$ and
+ * \f$ \alpha A_{i,:} B \f$ in one row accumulator and written back in
+ * place, without a temporary product matrix. The threshold is applied
+ * once to the sum. C must not alias A or B.
+ *
+ * \param A Matrix A
+ * \param B Matrix B
+ * \param C Matrix C
+ * \param alpha Scalar factor multiplied by A * B
+ * \param beta Scalar factor multiplied by C
+ * \param threshold Threshold for the result
+ */
+static void TYPED_FUNC(
+    bml_multiply_fused_ellsort) (
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    bml_matrix_ellsort_t * C,
+    double alpha,
+    double beta,
+    double threshold)
+{
+    int A_M = A->M;
+    int *A_index = A->index;
+    int *A_nnz = A->nnz;
+
+    int B_M = B->M;
+    int *B_index = B->index;
+    int *B_nnz = B->nnz;
+
+    int C_N = C->N;
+    int C_M = C->M;
+    int *C_index = C->index;
+    int *C_nnz = C->nnz;
+
+    REAL_T *A_value = (REAL_T *) A->value;
+    REAL_T *B_value = (REAL_T *) B->value;
+    REAL_T *C_value = (REAL_T *) C->value;
+
+    int myRank = bml_getMyRank();
+    int rowMin = C->domain->localRowMin[myRank];
+    int rowMax = C->domain->localRowMax[myRank];
+
+    int use_alpha = (alpha > (double) 0.0 || alpha < (double) 0.0);
+    int use_beta = (beta > (double) 0.0 || beta < (double) 0.0);
+
+#pragma omp parallel                           \
+    shared(A_M, A_index, A_nnz, A_value)       \
+    shared(B_M, B_index, B_nnz, B_value)       \
+    shared(C_N, C_M, C_index, C_nnz, C_value)  \
+    shared(rowMin, rowMax)
+    {
+        /* row accumulator, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (C_N, C_M);
+
+#pragma omp for
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            if (use_beta)
+            {
+                TYPED_FUNC(bml_accumulator_add_row) (acc, C_nnz[i],
+                                                     &C_index[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)],
+                                                     &C_value[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)], beta);
+            }
+            if (use_alpha)
+            {
+                for (int jp = 0; jp < A_nnz[i]; jp++)
+                {
+                    REAL_T a = alpha * A_value[ROWMAJOR(i, jp, A->N, A_M)];
+                    int j = A_index[ROWMAJOR(i, jp, A->N, A_M)];
+
+                    TYPED_FUNC(bml_accumulator_add_row) (acc, B_nnz[j],
+                                                         &B_index[ROWMAJOR
+                                                                  (j, 0,
+                                                                   B->N,
+                                                                   B_M)],
+                                                         &B_value[ROWMAJOR
+                                                                  (j, 0,
+                                                                   B->N,
+                                                                   B_M)], a);
+                }
+            }
+
+            // Check for number of non-zeroes per row exceeded
+            if (acc->size > C_M)
+            {
+                LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+            }
+
+            C_nnz[i] =
+                TYPED_FUNC(bml_accumulator_extract) (acc, -1, threshold,
+                                                     &C_index[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)],
+                                                     &C_value[ROWMAJOR
+                                                              (i, 0, C_N,
+                                                               C_M)]);
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+}
+
 /** Matrix multiply.
  *
  * \f$ C \leftarrow \alpha A \, B + \beta C \f$
@@ -53,10 +165,25 @@ void TYPED_FUNC(
         LOG_ERROR("Either matrix A or B are NULL\n");
     }
 
+    // the fused kernel updates C in place, so C must not alias A or B;
+    // distributed matrices keep the gather of the temporary product
+    int fused = (C != A && C != B);
+#ifdef DO_MPI
+    if (bml_getNRanks() > 1 && C->distribution_mode == distributed)
+    {
+        fused = 0;
+    }
+#endif
+
     if (A == B && alpha == ONE && beta == ZERO)
     {
         trace = TYPED_FUNC(bml_multiply_x2_ellsort) (A, C, threshold);
     }
+    else if (fused)
+    {
+        TYPED_FUNC(bml_multiply_fused_ellsort) (A, B, C, alpha, beta,
+                                                threshold);
+    }
     else
     {
         bml_matrix_dimension_t matrix_dimension = { C->N, C->N, C->M };
@@ -223,6 +350,118 @@ void *TYPED_FUNC(
     return trace;
 }
 
+/** Matrix multiply with a sparsity plan.
+ *
+ * \f$ X^{2} \leftarrow X \, X \f$
+ *
+ * Numeric pass only: the rows are accumulated in a row accumulator
+ * sized by the longest output row of the plan, so that it never grows,
+ * and processed in the flop balanced chunks of the plan. The plan has
+ * to be valid for X.
+ *
+ * \ingroup multiply_group
+ *
+ * \param plan The sparsity plan
+ * \param X Matrix X
+ * \param X2 Matrix X2
+ * \param threshold Used for sparse multiply
+ * \return The traces of X and X2
+ */
+void *TYPED_FUNC(
+    bml_multiply_x2_planned_ellsort) (
+    bml_multiply_plan_t * plan,
+    bml_matrix_ellsort_t * X,
+    bml_matrix_ellsort_t * X2,
+    double threshold)
+{
+    int X_N = X->N;
+    int X_M = X->M;
+    int *X_index = X->index;
+    int *X_nnz = X->nnz;
+
+    int X2_M = X2->M;
+    int *X2_index = X2->index;
+    int *X2_nnz = X2->nnz;
+
+    REAL_T traceX = 0.0;
+    REAL_T traceX2 = 0.0;
+    REAL_T *X_value = (REAL_T *) X->value;
+    REAL_T *X2_value = (REAL_T *) X2->value;
+
+    int max_row_nnz = plan->max_row_nnz;
+    int *chunk_ptr = plan->chunk_ptr;
+    int nchunks = plan->nchunks;
+
+    double *trace = bml_allocate_memory(sizeof(double) * 2);
+
+    if (max_row_nnz > X2_M)
+    {
+        LOG_ERROR("Number of non-zeroes per row > M, Increase M\n");
+    }
+
+#pragma omp parallel                                 \
+  shared(X_N, X_M, X_index, X_nnz, X_value)          \
+  shared(X2_M, X2_index, X2_nnz, X2_value)           \
+  shared(max_row_nnz, chunk_ptr, nchunks)            \
+  reduction(+: traceX, traceX2)
+    {
+        /* row accumulator sized by the plan, allocated once per thread */
+        bml_accumulator_t *acc =
+            TYPED_FUNC(bml_accumulator_allocate) (X_N, max_row_nnz);
+
+#pragma omp for schedule(dynamic)
+        for (int c = 0; c < nchunks; c++)
+        {
+            for (int i = chunk_ptr[c]; i < chunk_ptr[c + 1]; i++)
+            {
+                for (int jp = 0; jp < X_nnz[i]; jp++)
+                {
+                    REAL_T a = X_value[ROWMAJOR(i, jp, X_N, X_M)];
+                    int j = X_index[ROWMAJOR(i, jp, X_N, X_M)];
+                    if (j == i)
+                    {
+                        traceX = traceX + a;
+                    }
+                    TYPED_FUNC(bml_accumulator_add_row) (acc, X_nnz[j],
+                                                         &X_index[ROWMAJOR
+                                                                  (j, 0, X_N,
+                                                                   X_M)],
+                                                         &X_value[ROWMAJOR
+                                                                  (j, 0, X_N,
+                                                                   X_M)], a);
+                }
+
+                int ll =
+                    TYPED_FUNC(bml_accumulator_extract) (acc, i, threshold,
+                                                         &X2_index[ROWMAJOR
+                                                                   (i, 0,
+                                                                    X2->N,
+                                                                    X2_M)],
+                                                         &X2_value[ROWMAJOR
+                                                                   (i, 0,
+                                                                    X2->N,
+                                                                    X2_M)]);
+                for (int kp = 0; kp < ll; kp++)
+                {
+                    if (X2_index[ROWMAJOR(i, kp, X2->N, X2_M)] == i)
+                    {
+                        traceX2 =
+                            traceX2 + X2_value[ROWMAJOR(i, kp, X2->N, X2_M)];
+                    }
+                }
+                X2_nnz[i] = ll;
+            }
+        }
+
+        TYPED_FUNC(bml_accumulator_deallocate) (acc);
+    }
+
+    trace[0] = traceX;
+    trace[1] = traceX2;
+
+    return trace;
+}
+
 /** Matrix multiply.
  *
  * \f$ C \leftarrow B \, A \f$
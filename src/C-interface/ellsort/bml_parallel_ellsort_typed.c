@@ -1,5 +1,7 @@
 #include "../../macros.h"
 #include "../../typed.h"
+#include "../bml_allocate.h"
+#include "../bml_compress.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
 #include "bml_parallel_ellsort.h"
@@ -59,15 +61,70 @@ void TYPED_FUNC(
                    A_nnz, A_domain->localRowExtent,
                    A_domain->localRowMin, MPI_INT, ccomm);
 
-    // Indices
-    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
-                   A_index, A_domain->localElements, A_domain->localDispl,
-                   MPI_INT, ccomm);
-
-    // Values
-    MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
-                   A_value, A_domain->localElements, A_domain->localDispl,
-                   REAL_MPI_TYPE, ccomm);
+    if (bml_get_gather_mode() == gather_padded)
+    {
+        // Indices
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                       A_index, A_domain->localElements,
+                       A_domain->localDispl, MPI_INT, ccomm);
+
+        // Values
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                       A_value, A_domain->localElements,
+                       A_domain->localDispl, MPI_T, ccomm);
+    }
+    else
+    {
+        // Only ship the nnz[i] stored elements of each row
+        int *row_ptr = bml_allocate_memory(sizeof(int) * (N + 1));
+        int *counts = bml_allocate_memory(sizeof(int) * nRanks);
+        int *displs = bml_allocate_memory(sizeof(int) * nRanks);
+        bml_gather_row_layout(A_domain->localRowMin, A_domain->localRowMax,
+                              N, A_nnz, row_ptr, counts, displs);
+
+        int *index_buffer =
+            bml_noinit_allocate_memory(sizeof(int) * MAX(row_ptr[N], 1));
+        REAL_T *value_buffer =
+            bml_noinit_allocate_memory(sizeof(REAL_T) * MAX(row_ptr[N], 1));
+
+        int rowMin = A_domain->localRowMin[myRank];
+        int rowMax = A_domain->localRowMax[myRank];
+
+#pragma omp parallel for shared(row_ptr, index_buffer, value_buffer)
+        for (int i = rowMin; i < rowMax; i++)
+        {
+            memcpy(&index_buffer[row_ptr[i]], &A_index[ROWMAJOR(i, 0, N, M)],
+                   sizeof(int) * A_nnz[i]);
+            memcpy(&value_buffer[row_ptr[i]], &A_value[ROWMAJOR(i, 0, N, M)],
+                   sizeof(REAL_T) * A_nnz[i]);
+        }
+
+        // Indices
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                       index_buffer, counts, displs, MPI_INT, ccomm);
+
+        // Values
+        MPI_Allgatherv(MPI_IN_PLACE, 0, MPI_DATATYPE_NULL,
+                       value_buffer, counts, displs, MPI_T, ccomm);
+
+#pragma omp parallel for shared(row_ptr, index_buffer, value_buffer)
+        for (int i = 0; i < N; i++)
+        {
+            if (i < rowMin || i >= rowMax)
+            {
+                memcpy(&A_index[ROWMAJOR(i, 0, N, M)],
+                       &index_buffer[row_ptr[i]], sizeof(int) * A_nnz[i]);
+                memcpy(&A_value[ROWMAJOR(i, 0, N, M)],
+                       &value_buffer[row_ptr[i]], sizeof(REAL_T) * A_nnz[i]);
+            }
+        }
+
+        bml_free_memory(row_ptr);
+        bml_free_memory(counts);
+        bml_free_memory(displs);
+        bml_free_memory(index_buffer);
+        bml_free_memory(value_buffer);
+    }
 
 /*
     for (int i = 0; i < nRanks; i++)
@@ -118,19 +175,45 @@ void TYPED_FUNC(
         LOG_ERROR("MPI_Type_commit failed!");
 }
 
+/* Point to point messages only carry the stored elements: the
+ * non-zeros per row, then the column indices and the values of all
+ * rows back to back. The receiver gets the packed rows into index and
+ * value and spreads them out in place. Encoded column indices are
+ * decoded straight into their rows instead.
+ */
+static void TYPED_FUNC(
+    bml_mpi_unpack_ellsort) (
+    bml_matrix_ellsort_t * A,
+    int unpack_index)
+{
+    REAL_T *A_value = (REAL_T *) A->value;
+
+    int totnnz = 0;
+    for (int i = 0; i < A->N; i++)
+        totnnz += A->nnz[i];
+
+    // backwards, so that no packed row gets overwritten before it moved
+    for (int i = A->N - 1; i >= 0; i--)
+    {
+        totnnz -= A->nnz[i];
+        if (unpack_index)
+        {
+            memmove(&A->index[ROWMAJOR(i, 0, A->N, A->M)],
+                    &A->index[totnnz], A->nnz[i] * sizeof(int));
+        }
+        memmove(&A_value[ROWMAJOR(i, 0, A->N, A->M)], &A_value[totnnz],
+                A->nnz[i] * sizeof(REAL_T));
+    }
+}
+
 void TYPED_FUNC(
     bml_mpi_send_ellsort) (
     bml_matrix_ellsort_t * A,
     const int dst,
     MPI_Comm comm)
 {
-    // create MPI data type to avoid multiple messages
-    MPI_Datatype mpi_data_type;
-    bml_mpi_type_create_struct_ellsort(A, &mpi_data_type);
-
-    MPI_Send(A, 1, mpi_data_type, dst, 111, comm);
-
-    MPI_Type_free(&mpi_data_type);
+    TYPED_FUNC(bml_mpi_isend_ellsort) (A, dst, comm);
+    TYPED_FUNC(bml_mpi_isend_complete_ellsort) (A);
 }
 
 void TYPED_FUNC(
@@ -139,14 +222,75 @@ void TYPED_FUNC(
     const int src,
     MPI_Comm comm)
 {
-    // create MPI data type to avoid multiple messages
-    MPI_Datatype mpi_data_type;
-    bml_mpi_type_create_struct_ellsort(A, &mpi_data_type);
+    TYPED_FUNC(bml_mpi_irecv_ellsort) (A, src, comm);
+    TYPED_FUNC(bml_mpi_irecv_complete_ellsort) (A);
+}
+
+void TYPED_FUNC(
+    bml_mpi_isend_ellsort) (
+    bml_matrix_ellsort_t * A,
+    const int dst,
+    MPI_Comm comm)
+{
+    REAL_T *A_value = (REAL_T *) A->value;
+
+    int totnnz = 0;
+    for (int i = 0; i < A->N; i++)
+        totnnz += A->nnz[i];
 
-    MPI_Status status;
-    MPI_Recv(A, 1, mpi_data_type, src, 111, comm, &status);
+    int encoded = bml_get_mpi_index_encoding() == index_encoding_delta;
+
+    // pack the rows, the buffers live until the sends complete
+    A->buffer = bml_allocate_memory(sizeof(REAL_T) * totnnz);
+    if (encoded)
+    {
+        A->index_buffer =
+            bml_noinit_allocate_memory(bml_encode_index_bound(A->N, totnnz));
+    }
+    else
+    {
+        A->index_buffer = bml_allocate_memory(sizeof(int) * totnnz);
+    }
+    int *pindex = A->index_buffer;
+    REAL_T *pvalue = A->buffer;
+    for (int i = 0; i < A->N; i++)
+    {
+        if (!encoded)
+        {
+            memcpy(pindex, &A->index[ROWMAJOR(i, 0, A->N, A->M)],
+                   A->nnz[i] * sizeof(int));
+            pindex += A->nnz[i];
+        }
+        memcpy(pvalue, &A_value[ROWMAJOR(i, 0, A->N, A->M)],
+               A->nnz[i] * sizeof(REAL_T));
+        pvalue += A->nnz[i];
+    }
+
+    MPI_Isend(A->nnz, A->N, MPI_INT, dst, 111, comm, A->req);
+    if (encoded)
+    {
+        int nbytes = bml_encode_index(A->N, 0, A->nnz, A->index, A->M,
+                                      A->index_buffer);
+        MPI_Isend(A->index_buffer, nbytes, MPI_BYTE, dst, 112, comm,
+                  A->req + 1);
+    }
+    else
+    {
+        MPI_Isend(A->index_buffer, totnnz, MPI_INT, dst, 112, comm,
+                  A->req + 1);
+    }
+    MPI_Isend(A->buffer, totnnz, MPI_T, dst, 113, comm, A->req + 2);
+}
 
-    MPI_Type_free(&mpi_data_type);
+void TYPED_FUNC(
+    bml_mpi_isend_complete_ellsort) (
+    bml_matrix_ellsort_t * A)
+{
+    MPI_Waitall(3, A->req, MPI_STATUSES_IGNORE);
+    bml_free_memory(A->index_buffer);
+    bml_free_memory(A->buffer);
+    A->index_buffer = NULL;
+    A->buffer = NULL;
 }
 
 void TYPED_FUNC(
@@ -155,20 +299,36 @@ void TYPED_FUNC(
     const int src,
     MPI_Comm comm)
 {
-    // create MPI data type to avoid multiple messages
-    MPI_Datatype mpi_data_type;
-    bml_mpi_type_create_struct_ellsort(A, &mpi_data_type);
-
-    MPI_Irecv(A, 1, mpi_data_type, src, 111, comm, &A->req);
-
-    MPI_Type_free(&mpi_data_type);
+    MPI_Irecv(A->nnz, A->N, MPI_INT, src, 111, comm, A->req);
+    if (bml_get_mpi_index_encoding() == index_encoding_delta)
+    {
+        size_t bound = bml_encode_index_bound(A->N, (size_t) A->N * A->M);
+        A->index_buffer = bml_noinit_allocate_memory(bound);
+        MPI_Irecv(A->index_buffer, bound, MPI_BYTE, src, 112, comm,
+                  A->req + 1);
+    }
+    else
+    {
+        A->index_buffer = NULL;
+        MPI_Irecv(A->index, A->N * A->M, MPI_INT, src, 112, comm,
+                  A->req + 1);
+    }
+    MPI_Irecv(A->value, A->N * A->M, MPI_T, src, 113, comm, A->req + 2);
 }
 
 void TYPED_FUNC(
     bml_mpi_irecv_complete_ellsort) (
     bml_matrix_ellsort_t * A)
 {
-    MPI_Wait(&A->req, MPI_STATUS_IGNORE);
+    MPI_Waitall(3, A->req, MPI_STATUSES_IGNORE);
+    int encoded = A->index_buffer != NULL;
+    if (encoded)
+    {
+        bml_decode_index(A->N, 0, A->nnz, A->index_buffer, A->index, A->M);
+        bml_free_memory(A->index_buffer);
+        A->index_buffer = NULL;
+    }
+    TYPED_FUNC(bml_mpi_unpack_ellsort) (A, !encoded);
 }
 
 /*
@@ -299,4 +299,57 @@ void bml_assign_submatrix_ellsort_double_complex(
     bml_matrix_ellsort_t * B,
     int irow,
     int icol);
+void bml_submatrix_batch_index_ellsort(
+    bml_matrix_ellsort_t * A,
+    bml_matrix_ellsort_t * B,
+    bml_submatrix_batch_t * batch,
+    int *part_ptr,
+    int *part_nodes,
+    int double_jump_flag);
+
+void bml_submatrix_batch_extract_ellsort(
+    bml_matrix_ellsort_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellsort_single_real(
+    bml_matrix_ellsort_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellsort_double_real(
+    bml_matrix_ellsort_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellsort_single_complex(
+    bml_matrix_ellsort_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_extract_ellsort_double_complex(
+    bml_matrix_ellsort_t * A,
+    bml_submatrix_batch_t * batch);
+
+void bml_submatrix_batch_assemble_ellsort(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellsort_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellsort_single_real(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellsort_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellsort_double_real(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellsort_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellsort_single_complex(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellsort_t * B,
+    double threshold);
+
+void bml_submatrix_batch_assemble_ellsort_double_complex(
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellsort_t * B,
+    double threshold);
+
 #endif
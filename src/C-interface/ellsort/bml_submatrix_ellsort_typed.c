@@ -576,3 +576,140 @@ void TYPED_FUNC(
         }
     }
 }
+
+/** Extract the dense submatrices of all parts of a batch.
+ *
+ * Each block is filled from the rows of its core+halo indices, with a
+ * map from the columns of A to the block columns instead of a search
+ * per element.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param A Matrix A
+ * \param batch The batch
+ */
+void TYPED_FUNC(
+    bml_submatrix_batch_extract_ellsort) (
+    bml_matrix_ellsort_t * A,
+    bml_submatrix_batch_t * batch)
+{
+    int A_N = A->N;
+    int A_M = A->M;
+    int *A_nnz = A->nnz;
+    int *A_index = A->index;
+    REAL_T *A_value = A->value;
+
+    int nparts = batch->nparts;
+    int *order = batch->order;
+    int *index_ptr = batch->index_ptr;
+    int *core_halo_index = batch->core_halo_index;
+    size_t *value_ptr = batch->value_ptr;
+    REAL_T *values = batch->values;
+
+#pragma omp parallel
+    {
+        int *pos = bml_noinit_allocate_memory(sizeof(int) * A_N);
+
+        for (int i = 0; i < A_N; i++)
+        {
+            pos[i] = -1;
+        }
+
+#pragma omp for schedule(dynamic)
+        for (int k = 0; k < nparts; k++)
+        {
+            int p = order[k];
+            int lsize = index_ptr[p + 1] - index_ptr[p];
+            int *index = core_halo_index + index_ptr[p];
+            REAL_T *block = values + value_ptr[p];
+
+            memset(block, 0, sizeof(REAL_T) * lsize * lsize);
+            for (int j = 0; j < lsize; j++)
+            {
+                pos[index[j]] = j;
+            }
+            for (int jb = 0; jb < lsize; jb++)
+            {
+                int ii = index[jb];
+                for (int jp = 0; jp < A_nnz[ii]; jp++)
+                {
+                    int j = pos[A_index[ROWMAJOR(ii, jp, A_N, A_M)]];
+                    if (j >= 0)
+                    {
+                        block[ROWMAJOR(jb, j, lsize, lsize)] =
+                            A_value[ROWMAJOR(ii, jp, A_N, A_M)];
+                    }
+                }
+            }
+            for (int j = 0; j < lsize; j++)
+            {
+                pos[index[j]] = -1;
+            }
+        }
+
+        bml_free_memory(pos);
+    }
+}
+
+/** Assemble the core rows of all submatrices of a batch.
+ *
+ * The core rows of different parts are different rows of B, the parts
+ * are assembled in parallel.
+ *
+ * \ingroup submatrix_group_C
+ *
+ * \param batch The batch
+ * \param B Matrix B
+ * \param threshold Threshold for elements
+ */
+void TYPED_FUNC(
+    bml_submatrix_batch_assemble_ellsort) (
+    bml_submatrix_batch_t * batch,
+    bml_matrix_ellsort_t * B,
+    double threshold)
+{
+    int B_M = B->M;
+    int *B_nnz = B->nnz;
+    int *B_index = B->index;
+    REAL_T *B_value = B->value;
+
+    int nparts = batch->nparts;
+    int *order = batch->order;
+    int *index_ptr = batch->index_ptr;
+    int *ncore = batch->ncore;
+    int *core_halo_index = batch->core_halo_index;
+    size_t *value_ptr = batch->value_ptr;
+    REAL_T *values = batch->values;
+
+#pragma omp parallel for schedule(dynamic)
+    for (int k = 0; k < nparts; k++)
+    {
+        int p = order[k];
+        int lsize = index_ptr[p + 1] - index_ptr[p];
+        int *index = core_halo_index + index_ptr[p];
+        REAL_T *block = values + value_ptr[p];
+
+        for (int ja = 0; ja < ncore[p]; ja++)
+        {
+            int ii = index[ja];
+            int icol = 0;
+
+            for (int jb = 0; jb < lsize; jb++)
+            {
+                REAL_T a = block[ROWMAJOR(ja, jb, lsize, lsize)];
+                if (ABS(a) > threshold)
+                {
+                    if (icol == B_M)
+                    {
+                        LOG_ERROR
+                            ("Number of non-zeroes per row > M, Increase M\n");
+                    }
+                    B_index[ROWMAJOR(ii, icol, B->N, B_M)] = index[jb];
+                    B_value[ROWMAJOR(ii, icol, B->N, B_M)] = a;
+                    icol++;
+                }
+            }
+            B_nnz[ii] = icol;
+        }
+    }
+}
@@ -30,9 +30,17 @@ struct bml_matrix_ellsort_t
     bml_domain_t *domain;
     /** A copy of the domain decomposition. */
     bml_domain_t *domain2;
+    /** The binary file the arrays are mapped from, NULL if allocated. */
+    void *mapping;
+    /** The size of the mapping in bytes. */
+    size_t mapping_size;
 #ifdef DO_MPI
-    /** request field for MPI communications*/
-    MPI_Request req;
+    /** packed column indices of a pending send */
+    int *index_buffer;
+    /** packed values of a pending send */
+    void *buffer;
+    /** request fields for MPI communications*/
+    MPI_Request req[3];
 #endif
 };
 typedef struct bml_matrix_ellsort_t bml_matrix_ellsort_t;
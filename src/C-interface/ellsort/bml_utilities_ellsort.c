@@ -56,3 +56,69 @@ bml_write_bml_matrix_ellsort(
             break;
     }
 }
+
+void
+bml_write_bml_matrix_binary_ellsort(
+    bml_matrix_ellsort_t * A,
+    int fd)
+{
+    switch (A->matrix_precision)
+    {
+        case single_real:
+            bml_write_bml_matrix_binary_ellsort_single_real(A, fd);
+            break;
+        case double_real:
+            bml_write_bml_matrix_binary_ellsort_double_real(A, fd);
+            break;
+#ifdef BML_COMPLEX
+        case single_complex:
+            bml_write_bml_matrix_binary_ellsort_single_complex(A, fd);
+            break;
+        case double_complex:
+            bml_write_bml_matrix_binary_ellsort_double_complex(A, fd);
+            break;
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+}
+
+bml_matrix_ellsort_t *
+bml_read_bml_matrix_binary_ellsort(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy)
+{
+    bml_binary_header_t *header = mapping;
+
+    switch (header->matrix_precision)
+    {
+        case single_real:
+            return
+                bml_read_bml_matrix_binary_ellsort_single_real(mapping,
+                                                               mapping_size,
+                                                               zero_copy);
+        case double_real:
+            return
+                bml_read_bml_matrix_binary_ellsort_double_real(mapping,
+                                                               mapping_size,
+                                                               zero_copy);
+#ifdef BML_COMPLEX
+        case single_complex:
+            return
+                bml_read_bml_matrix_binary_ellsort_single_complex(mapping,
+                                                                  mapping_size,
+                                                                  zero_copy);
+        case double_complex:
+            return
+                bml_read_bml_matrix_binary_ellsort_double_complex(mapping,
+                                                                  mapping_size,
+                                                                  zero_copy);
+#endif
+        default:
+            LOG_ERROR("unknown precision\n");
+            break;
+    }
+    return NULL;
+}
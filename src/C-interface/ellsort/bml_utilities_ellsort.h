@@ -48,4 +48,49 @@ void bml_write_bml_matrix_ellsort_double_complex(
     bml_matrix_ellsort_t * A,
     char *filename);
 
+void bml_write_bml_matrix_binary_ellsort(
+    bml_matrix_ellsort_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellsort_single_real(
+    bml_matrix_ellsort_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellsort_double_real(
+    bml_matrix_ellsort_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellsort_single_complex(
+    bml_matrix_ellsort_t * A,
+    int fd);
+
+void bml_write_bml_matrix_binary_ellsort_double_complex(
+    bml_matrix_ellsort_t * A,
+    int fd);
+
+bml_matrix_ellsort_t *bml_read_bml_matrix_binary_ellsort(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellsort_t *bml_read_bml_matrix_binary_ellsort_single_real(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellsort_t *bml_read_bml_matrix_binary_ellsort_double_real(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellsort_t *bml_read_bml_matrix_binary_ellsort_single_complex(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
+bml_matrix_ellsort_t *bml_read_bml_matrix_binary_ellsort_double_complex(
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy);
+
 #endif
@@ -1,9 +1,12 @@
 #include "../../macros.h"
 #include "../../typed.h"
+#include "../bml_allocate.h"
+#include "../bml_compress.h"
 #include "../bml_logger.h"
 #include "../bml_parallel.h"
 #include "../bml_types.h"
 #include "../bml_utilities.h"
+#include "bml_allocate_ellsort.h"
 #include "bml_types_ellsort.h"
 #include "bml_utilities_ellsort.h"
 
@@ -24,100 +27,44 @@ void TYPED_FUNC(
     bml_matrix_ellsort_t * A,
     char *filename)
 {
-    FILE *hFile;
-    char header1[20], header2[20], header3[20], header4[20], header5[20];
-    int hdimx, nnz, irow, icol, ind;
-    double real_part, imaginary_part;
-    REAL_T value;
-
     int N = A->N;
     int M = A->M;
     REAL_T *A_value = (REAL_T *) A->value;
     int *A_index = A->index;
     int *A_nnz = A->nnz;
 
-    hFile = fopen(filename, "r");
-
-    // Read header
-    if (fscanf(hFile, "%s %s %s %s %s", header1, header2, header3, header4,
-               header5) != 5)
-    {
-        LOG_ERROR("read error on header\n");
-    }
-
-    int symflag = strcmp(header5, "symmetric");
-
-    // Read N, N, # of non-zeroes
-    if (fscanf(hFile, "%d %d %d", &hdimx, &hdimx, &nnz) != 3)
-    {
-        LOG_ERROR("read error\n");
-    }
+    int file_N;
+    int *row_ptr;
+    int *cols;
+    REAL_T *vals;
 
-    char *FMT;
-    switch (A->matrix_precision)
+    bml_read_compressed_rows(filename, A->matrix_precision, &file_N,
+                             &row_ptr, &cols, (void **) &vals);
+    if (file_N != N)
     {
-        case single_real:
-            FMT = "%d %d %g\n";
-            break;
-        case double_real:
-            FMT = "%d %d %lg\n";
-            break;
-#ifdef BML_COMPLEX
-        case single_complex:
-            FMT = "%d %d %g\n";
-            break;
-        case double_complex:
-            FMT = "%d %d %lg\n";
-            break;
-#endif
-        default:
-            LOG_ERROR("unknown precision\n");
-            break;
+        LOG_ERROR("%s holds a matrix of size %d, expected %d\n", filename,
+                  file_N, N);
     }
 
-    // Read in values
-    for (int i = 0; i < nnz; i++)
+#pragma omp parallel for shared(A_nnz, A_index, A_value)
+    for (int i = 0; i < N; i++)
     {
-#if defined(SINGLE_REAL)
-        if (fscanf(hFile, "%d %d %f\n", &irow, &icol, &value) != 3)
-        {
-            LOG_ERROR("read error\n");
-        }
-#elif defined(DOUBLE_REAL)
-        if (fscanf(hFile, "%d %d %lf\n", &irow, &icol, &value) != 3)
+        int nnz = row_ptr[i + 1] - row_ptr[i];
+        if (nnz > M)
         {
-            LOG_ERROR("read error\n");
-        }
-#elif defined(SINGLE_COMPLEX) || defined(DOUBLE_COMPLEX)
-        if (fscanf
-            (hFile, "%d %d %lf %lf\n", &irow, &icol, &real_part,
-             &imaginary_part) != 4)
-        {
-            LOG_ERROR("read error\n");
-        }
-        value = real_part + I * imaginary_part;
-#else
-        LOG_ERROR("unknown matrix precision\n");
-#endif
-
-        irow--;
-        icol--;
-        ind = A_nnz[irow];
-        A_index[ROWMAJOR(irow, ind, N, M)] = icol;
-        A_value[ROWMAJOR(irow, ind, N, M)] = value;
-        A_nnz[irow]++;
-
-        // Set symmetric value if necessary
-        if (symflag == 0 && icol != irow)
-        {
-            ind = A_nnz[icol];
-            A_index[ROWMAJOR(icol, ind, N, M)] = irow;
-            A_value[ROWMAJOR(icol, ind, N, M)] = value;
-            A_nnz[icol]++;
+            LOG_ERROR("row %d has %d non-zeros, more than M = %d\n", i, nnz,
+                      M);
         }
+        memcpy(&A_index[ROWMAJOR(i, 0, N, M)], &cols[row_ptr[i]],
+               sizeof(int) * nnz);
+        memcpy(&A_value[ROWMAJOR(i, 0, N, M)], &vals[row_ptr[i]],
+               sizeof(REAL_T) * nnz);
+        A_nnz[i] = nnz;
     }
 
-    fclose(hFile);
+    bml_free_memory(row_ptr);
+    bml_free_memory(cols);
+    bml_free_memory(vals);
 }
 
 /** Write a Matrix Market format file from a bml matrix.
@@ -184,3 +131,124 @@ void TYPED_FUNC(
 
     fclose(mFile);
 }
+
+/** Write a bml matrix to a binary file.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param A The matrix to be written
+ *  \param fd The file descriptor of the binary file
+ */
+void TYPED_FUNC(
+    bml_write_bml_matrix_binary_ellsort) (
+    bml_matrix_ellsort_t * A,
+    int fd)
+{
+    int N = A->N;
+    int M = A->M;
+    bml_binary_header_t header;
+
+    void *index = A->index;
+    size_t index_bytes = sizeof(int) * N * M;
+
+    bml_init_binary_header(&header, ellsort, A->matrix_precision, N, M);
+    header.nvalues = (int64_t) N * M;
+    if (bml_get_binary_index_encoding() == index_encoding_delta)
+    {
+        // Only the stored columns of each row are encoded
+        size_t bound = bml_encode_index_bound(N, (size_t) N * M);
+        index = bml_noinit_allocate_memory(bound);
+        index_bytes = bml_encode_index(N, 0, A->nnz, A->index, M, index);
+        header.index_encoding = index_encoding_delta;
+        header.index_bytes = index_bytes;
+    }
+    bml_write_binary_section(fd, &header, sizeof(bml_binary_header_t));
+    bml_write_binary_section(fd, A->nnz, sizeof(int) * N);
+    bml_write_binary_section(fd, index, index_bytes);
+    bml_write_binary_section(fd, A->value, sizeof(REAL_T) * N * M);
+
+    if (index != A->index)
+    {
+        bml_free_memory(index);
+    }
+}
+
+/** Read a bml matrix from a mapped binary file.
+ *
+ *  The matrix either keeps the mapping or the mapping is unmapped.
+ *
+ *  \ingroup utilities_group
+ *
+ *  \param mapping The mapped file
+ *  \param mapping_size The size of the file in bytes
+ *  \param zero_copy Whether to use the arrays of the mapping in place
+ *  \return The matrix
+ */
+bml_matrix_ellsort_t *TYPED_FUNC(
+    bml_read_bml_matrix_binary_ellsort) (
+    void *mapping,
+    size_t mapping_size,
+    int zero_copy)
+{
+    bml_binary_header_t *header = mapping;
+    int N = header->N;
+    int M = header->M;
+    size_t offset = 0;
+
+    bml_binary_section(mapping, mapping_size, &offset,
+                       sizeof(bml_binary_header_t));
+    int *nnz = bml_binary_section(mapping, mapping_size, &offset,
+                                  sizeof(int) * N);
+    int encoded = header->index_encoding == index_encoding_delta;
+    int *index = bml_binary_section(mapping, mapping_size, &offset,
+                                    encoded ? (size_t) header->index_bytes :
+                                    sizeof(int) * N * M);
+    REAL_T *value = bml_binary_section(mapping, mapping_size, &offset,
+                                       sizeof(REAL_T) * N * M);
+
+    if (zero_copy && !encoded)
+    {
+        bml_matrix_ellsort_t *A =
+            bml_allocate_memory(sizeof(bml_matrix_ellsort_t));
+        A->matrix_type = ellsort;
+        A->matrix_precision = MATRIX_PRECISION;
+        A->distribution_mode = sequential;
+        A->N = N;
+        A->M = M;
+        A->nnz = nnz;
+        A->index = index;
+        A->value = value;
+        A->domain = bml_default_domain(N, M, sequential);
+        A->domain2 = bml_default_domain(N, M, sequential);
+        A->mapping = mapping;
+        A->mapping_size = mapping_size;
+        return A;
+    }
+
+    bml_matrix_dimension_t matrix_dimension = { N, N, M, NULL, 0 };
+    bml_matrix_ellsort_t *A =
+        TYPED_FUNC(bml_noinit_matrix_ellsort) (matrix_dimension, sequential);
+    int *A_nnz = A->nnz;
+    int *A_index = A->index;
+    REAL_T *A_value = A->value;
+
+#pragma omp parallel for shared(A_nnz, A_index, A_value)
+    for (int i = 0; i < N; i++)
+    {
+        A_nnz[i] = nnz[i];
+        if (!encoded)
+        {
+            memcpy(&A_index[ROWMAJOR(i, 0, N, M)],
+                   &index[ROWMAJOR(i, 0, N, M)], sizeof(int) * M);
+        }
+        memcpy(&A_value[ROWMAJOR(i, 0, N, M)], &value[ROWMAJOR(i, 0, N, M)],
+               sizeof(REAL_T) * M);
+    }
+    if (encoded)
+    {
+        bml_decode_index(N, 0, nnz, index, A_index, M);
+    }
+
+    bml_unmap_binary_file(mapping, mapping_size);
+    return A;
+}
@@ -0,0 +1,263 @@
+#include "../macros.h"
+#include "../typed.h"
+#include "../C-interface/bml_allocate.h"
+#include "../C-interface/bml_logger.h"
+#include "../C-interface/bml_multiply.h"
+#include "bml_accumulator.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+
+/** Smallest number of slots of a hash accumulator. */
+#define ACCUMULATOR_MIN_CAPACITY 16
+
+/** Multiplicative (Fibonacci) hash of column k. */
+#define ACCUMULATOR_HASH(k, shift) \
+    ((int) (((unsigned int) (k) * 2654435761u) >> (shift)))
+
+/** Allocate a row accumulator.
+ *
+ * The accumulator type is taken from bml_get_multiply_accumulator().
+ * A hash accumulator starts out with twice the expected row fill and
+ * grows when it becomes half full.
+ *
+ * \param N The number of columns
+ * \param M The expected number of non-zeros per row
+ * \return The accumulator
+ */
+bml_accumulator_t *TYPED_FUNC(
+    bml_accumulator_allocate) (
+    int N,
+    int M)
+{
+    bml_accumulator_t *acc =
+        bml_noinit_allocate_memory(sizeof(bml_accumulator_t));
+    bml_accumulator_type_t type = bml_get_multiply_accumulator();
+
+    if (type == accumulator_auto)
+    {
+        type = (N <= BML_ACCUMULATOR_DENSE_MAX_N
+                || 2 * M >= N) ? accumulator_dense : accumulator_hash;
+    }
+
+    acc->type = type;
+    acc->N = N;
+    acc->size = 0;
+    acc->shift = 0;
+    if (type == accumulator_dense)
+    {
+        acc->capacity = N;
+    }
+    else
+    {
+        int log2_capacity = 4;
+        while ((1 << log2_capacity) < MAX(2 * M, ACCUMULATOR_MIN_CAPACITY))
+        {
+            log2_capacity++;
+        }
+        acc->capacity = 1 << log2_capacity;
+        acc->shift = 32 - log2_capacity;
+    }
+    acc->key = bml_noinit_allocate_memory(sizeof(int) * acc->capacity);
+    acc->order = bml_noinit_allocate_memory(sizeof(int) * acc->capacity);
+    acc->value = bml_noinit_allocate_memory(sizeof(REAL_T) * acc->capacity);
+    for (int s = 0; s < acc->capacity; s++)
+    {
+        acc->key[s] = -1;
+    }
+    return acc;
+}
+
+/** Deallocate a row accumulator.
+ *
+ * \param acc The accumulator
+ */
+void TYPED_FUNC(
+    bml_accumulator_deallocate) (
+    bml_accumulator_t * acc)
+{
+    bml_free_memory(acc->key);
+    bml_free_memory(acc->order);
+    bml_free_memory(acc->value);
+    bml_free_memory(acc);
+}
+
+/** Double the number of slots of a hash accumulator.
+ *
+ * The entries are reinserted in insertion order so that the order in
+ * which bml_accumulator_extract() returns them is preserved.
+ *
+ * \param acc The accumulator
+ */
+static void TYPED_FUNC(
+    bml_accumulator_grow) (
+    bml_accumulator_t * acc)
+{
+    int *old_key = acc->key;
+    int *old_order = acc->order;
+    REAL_T *old_value = (REAL_T *) acc->value;
+
+    acc->capacity *= 2;
+    acc->shift--;
+    acc->key = bml_noinit_allocate_memory(sizeof(int) * acc->capacity);
+    acc->order = bml_noinit_allocate_memory(sizeof(int) * acc->capacity);
+    acc->value = bml_noinit_allocate_memory(sizeof(REAL_T) * acc->capacity);
+
+    int *key = acc->key;
+    REAL_T *value = (REAL_T *) acc->value;
+    int mask = acc->capacity - 1;
+
+    for (int s = 0; s < acc->capacity; s++)
+    {
+        key[s] = -1;
+    }
+    for (int p = 0; p < acc->size; p++)
+    {
+        int k = old_key[old_order[p]];
+        int s = ACCUMULATOR_HASH(k, acc->shift);
+        while (key[s] >= 0)
+        {
+            s = (s + 1) & mask;
+        }
+        key[s] = k;
+        value[s] = old_value[old_order[p]];
+        acc->order[p] = s;
+    }
+
+    bml_free_memory(old_key);
+    bml_free_memory(old_order);
+    bml_free_memory(old_value);
+}
+
+/** Add a scaled sparse row to the accumulator.
+ *
+ * \f$ x_{cols[p]} \leftarrow x_{cols[p]} + \alpha \, vals[p] \f$
+ *
+ * \param acc The accumulator
+ * \param n The number of entries in the row
+ * \param cols The column indices of the row
+ * \param vals The values of the row
+ * \param alpha Scalar factor multiplied by the row
+ */
+void TYPED_FUNC(
+    bml_accumulator_add_row) (
+    bml_accumulator_t * acc,
+    const int n,
+    const int *cols,
+    const REAL_T * vals,
+    const REAL_T alpha)
+{
+    int *key = acc->key;
+    int *order = acc->order;
+    REAL_T *value = (REAL_T *) acc->value;
+
+    if (acc->type == accumulator_dense)
+    {
+        int size = acc->size;
+        for (int p = 0; p < n; p++)
+        {
+            int k = cols[p];
+            if (key[k] < 0)
+            {
+                key[k] = k;
+                value[k] = 0.0;
+                order[size] = k;
+                size++;
+            }
+            value[k] = value[k] + alpha * vals[p];
+        }
+        acc->size = size;
+        return;
+    }
+
+    int mask = acc->capacity - 1;
+    for (int p = 0; p < n; p++)
+    {
+        int k = cols[p];
+        int s = ACCUMULATOR_HASH(k, acc->shift);
+        while (key[s] != k && key[s] >= 0)
+        {
+            s = (s + 1) & mask;
+        }
+        if (key[s] < 0)
+        {
+            if (2 * (acc->size + 1) > acc->capacity)
+            {
+                TYPED_FUNC(bml_accumulator_grow) (acc);
+                key = acc->key;
+                order = acc->order;
+                value = (REAL_T *) acc->value;
+                mask = acc->capacity - 1;
+                s = ACCUMULATOR_HASH(k, acc->shift);
+                while (key[s] >= 0)
+                {
+                    s = (s + 1) & mask;
+                }
+            }
+            key[s] = k;
+            value[s] = 0.0;
+            order[acc->size] = s;
+            acc->size++;
+        }
+        value[s] = value[s] + alpha * vals[p];
+    }
+}
+
+/** Extract the accumulated row and reset the accumulator.
+ *
+ * Entries are returned in the order in which their columns were
+ * first added. Entries below the threshold are dropped, except for
+ * the one in column diag.
+ *
+ * \param acc The accumulator
+ * \param diag The column kept regardless of threshold (-1 for none)
+ * \param threshold The threshold
+ * \param cols The column indices of the row (at least acc->size long)
+ * \param vals The values of the row (at least acc->size long)
+ * \return The number of entries written
+ */
+int TYPED_FUNC(
+    bml_accumulator_extract) (
+    bml_accumulator_t * acc,
+    const int diag,
+    const double threshold,
+    int *cols,
+    REAL_T * vals)
+{
+    int *key = acc->key;
+    int *order = acc->order;
+    REAL_T *value = (REAL_T *) acc->value;
+
+    int ll = 0;
+    for (int p = 0; p < acc->size; p++)
+    {
+        int s = order[p];
+        int k = key[s];
+        REAL_T x = value[s];
+        if (k == diag || is_above_threshold(x, threshold))
+        {
+            cols[ll] = k;
+            vals[ll] = x;
+            ll++;
+        }
+        key[s] = -1;
+    }
+    acc->size = 0;
+    return ll;
+}
+
+/** Drop the accumulated row.
+ *
+ * \param acc The accumulator
+ */
+void TYPED_FUNC(
+    bml_accumulator_clear) (
+    bml_accumulator_t * acc)
+{
+    for (int p = 0; p < acc->size; p++)
+    {
+        acc->key[acc->order[p]] = -1;
+    }
+    acc->size = 0;
+}
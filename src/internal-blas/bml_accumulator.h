@@ -0,0 +1,137 @@
+#ifndef __BML_ACCUMULATOR_H
+#define __BML_ACCUMULATOR_H
+
+#include "../C-interface/bml_types.h"
+
+#include <complex.h>
+
+/** Largest N for which accumulator_auto picks the dense accumulator. */
+#ifndef BML_ACCUMULATOR_DENSE_MAX_N
+#define BML_ACCUMULATOR_DENSE_MAX_N 16384
+#endif
+
+/** Sparse row accumulator.
+ *
+ * Collects the scaled sparse rows that contribute to one row of a
+ * sparse product or sum. In dense mode the values are scattered into
+ * a vector of length N, in hash mode into an open-addressing hash
+ * table sized to the expected row fill. The table is grown on demand
+ * and is allocated once per thread and reused for all rows.
+ */
+typedef struct
+{
+    /** The accumulator type (dense or hash). */
+    bml_accumulator_type_t type;
+    /** The number of columns. */
+    int N;
+    /** The number of slots (N in dense mode, a power of 2 otherwise). */
+    int capacity;
+    /** The shift applied to the multiplicative hash. */
+    int shift;
+    /** The number of entries in the current row. */
+    int size;
+    /** The column stored in each slot, -1 if the slot is empty. */
+    int *key;
+    /** The occupied slots in insertion order. */
+    int *order;
+    /** The accumulated value of each slot. */
+    void *value;
+} bml_accumulator_t;
+
+bml_accumulator_t *bml_accumulator_allocate_single_real(
+    int N,
+    int M);
+
+bml_accumulator_t *bml_accumulator_allocate_double_real(
+    int N,
+    int M);
+
+bml_accumulator_t *bml_accumulator_allocate_single_complex(
+    int N,
+    int M);
+
+bml_accumulator_t *bml_accumulator_allocate_double_complex(
+    int N,
+    int M);
+
+void bml_accumulator_deallocate_single_real(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_deallocate_double_real(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_deallocate_single_complex(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_deallocate_double_complex(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_add_row_single_real(
+    bml_accumulator_t * acc,
+    const int n,
+    const int *cols,
+    const float *vals,
+    const float alpha);
+
+void bml_accumulator_add_row_double_real(
+    bml_accumulator_t * acc,
+    const int n,
+    const int *cols,
+    const double *vals,
+    const double alpha);
+
+void bml_accumulator_add_row_single_complex(
+    bml_accumulator_t * acc,
+    const int n,
+    const int *cols,
+    const float complex * vals,
+    const float complex alpha);
+
+void bml_accumulator_add_row_double_complex(
+    bml_accumulator_t * acc,
+    const int n,
+    const int *cols,
+    const double complex * vals,
+    const double complex alpha);
+
+int bml_accumulator_extract_single_real(
+    bml_accumulator_t * acc,
+    const int diag,
+    const double threshold,
+    int *cols,
+    float *vals);
+
+int bml_accumulator_extract_double_real(
+    bml_accumulator_t * acc,
+    const int diag,
+    const double threshold,
+    int *cols,
+    double *vals);
+
+int bml_accumulator_extract_single_complex(
+    bml_accumulator_t * acc,
+    const int diag,
+    const double threshold,
+    int *cols,
+    float complex * vals);
+
+int bml_accumulator_extract_double_complex(
+    bml_accumulator_t * acc,
+    const int diag,
+    const double threshold,
+    int *cols,
+    double complex * vals);
+
+void bml_accumulator_clear_single_real(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_clear_double_real(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_clear_single_complex(
+    bml_accumulator_t * acc);
+
+void bml_accumulator_clear_double_complex(
+    bml_accumulator_t * acc);
+
+#endif
@@ -1,10 +1,294 @@
 #include "../macros.h"
 #include "../typed.h"
 #include "../C-interface/blas.h"
+#include "../C-interface/bml_allocate.h"
 #include "../C-interface/bml_logger.h"
+#include "bml_gemm.h"
 
 #include <complex.h>
+#include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#endif
+
+/* Blocking of the internal GEMM (GotoBLAS layout).
+ *
+ * An MR x NR block of C is kept in registers by the micro-kernel, a
+ * packed MC x KC block of A is meant to stay in L2 and a packed
+ * KC x NC panel of B in L3. MC must be a multiple of MR and NC a
+ * multiple of NR.
+ */
+#ifndef BML_GEMM_MR
+#if defined(SINGLE_REAL) || defined(DOUBLE_REAL)
+#define BML_GEMM_MR 8
+#else
+#define BML_GEMM_MR 4
+#endif
+#endif
+
+#ifndef BML_GEMM_NR
+#define BML_GEMM_NR 4
+#endif
+
+#ifndef BML_GEMM_MC
+#define BML_GEMM_MC 128
+#endif
+
+#ifndef BML_GEMM_KC
+#define BML_GEMM_KC 256
+#endif
+
+#ifndef BML_GEMM_NC
+#define BML_GEMM_NC 2048
+#endif
+
+/** The real type underlying REAL_T. */
+#if defined(SINGLE_REAL) || defined(SINGLE_COMPLEX)
+#define REAL_PART_T float
+#else
+#define REAL_PART_T double
+#endif
+
+/** Number of multiply-adds below which the GEMM runs on one thread. */
+#ifndef BML_GEMM_PARALLEL_MIN_WORK
+#define BML_GEMM_PARALLEL_MIN_WORK (64 * 64 * 64)
+#endif
+
+/** Pack an mc x kc block of op(A) into MR wide row slivers.
+ *
+ * Sliver s holds rows s*MR to s*MR+MR-1 with the MR elements of each
+ * column stored contiguously (for complex types as MR real parts
+ * followed by MR imaginary parts). Rows beyond mc are padded with zeros.
+ *
+ * \param trans 'N', 'T' or 'C'
+ * \param mc The number of rows of the block
+ * \param kc The number of columns of the block
+ * \param a Pointer to element (0, 0) of the block of op(A)
+ * \param lda The leading dimension of A
+ * \param sliver The sliver to pack (in units of MR rows)
+ * \param ap The packed block
+ */
+static void TYPED_FUNC(
+    bml_gemm_pack_a) (
+    const char trans,
+    const int mc,
+    const int kc,
+    const REAL_T * a,
+    const int lda,
+    const int sliver,
+    REAL_T * ap)
+{
+    int i0 = sliver * BML_GEMM_MR;
+    int mr = MIN(BML_GEMM_MR, mc - i0);
+    REAL_T *dst = ap + (size_t) sliver * BML_GEMM_MR * kc;
+
+    for (int p = 0; p < kc; p++)
+    {
+        REAL_T col[BML_GEMM_MR];
+        for (int i = 0; i < mr; i++)
+        {
+            if (trans == 'N')
+            {
+                col[i] = a[COLMAJOR(i0 + i, p, lda, kc)];
+            }
+            else if (trans == 'T')
+            {
+                col[i] = a[COLMAJOR(p, i0 + i, lda, mc)];
+            }
+            else
+            {
+                col[i] = COMPLEX_CONJUGATE(a[COLMAJOR(p, i0 + i, lda, mc)]);
+            }
+        }
+        for (int i = mr; i < BML_GEMM_MR; i++)
+        {
+            col[i] = 0;
+        }
+#if defined(SINGLE_COMPLEX) || defined(DOUBLE_COMPLEX)
+        /* MR real parts followed by MR imaginary parts */
+        REAL_PART_T *dst_ri = (REAL_PART_T *) dst;
+        for (int i = 0; i < BML_GEMM_MR; i++)
+        {
+            dst_ri[i] = REAL_PART(col[i]);
+            dst_ri[BML_GEMM_MR + i] = IMAGINARY_PART(col[i]);
+        }
+#else
+        for (int i = 0; i < BML_GEMM_MR; i++)
+        {
+            dst[i] = col[i];
+        }
+#endif
+        dst += BML_GEMM_MR;
+    }
+}
+
+/** Pack a kc x nc panel of alpha op(B) into NR wide column slivers.
+ *
+ * Sliver s holds columns s*NR to s*NR+NR-1 with the NR elements of each
+ * row stored contiguously. Columns beyond nc are padded with zeros.
+ *
+ * \param trans 'N', 'T' or 'C'
+ * \param kc The number of rows of the panel
+ * \param nc The number of columns of the panel
+ * \param alpha Scalar factor folded into the packed panel
+ * \param b Pointer to element (0, 0) of the panel of op(B)
+ * \param ldb The leading dimension of B
+ * \param sliver The sliver to pack (in units of NR columns)
+ * \param bp The packed panel
+ */
+static void TYPED_FUNC(
+    bml_gemm_pack_b) (
+    const char trans,
+    const int kc,
+    const int nc,
+    const REAL_T alpha,
+    const REAL_T * b,
+    const int ldb,
+    const int sliver,
+    REAL_T * bp)
+{
+    int j0 = sliver * BML_GEMM_NR;
+    int nr = MIN(BML_GEMM_NR, nc - j0);
+    REAL_T *dst = bp + (size_t) sliver * BML_GEMM_NR * kc;
+
+    for (int p = 0; p < kc; p++)
+    {
+        for (int j = 0; j < nr; j++)
+        {
+            if (trans == 'N')
+            {
+                dst[j] = alpha * b[COLMAJOR(p, j0 + j, ldb, nc)];
+            }
+            else if (trans == 'T')
+            {
+                dst[j] = alpha * b[COLMAJOR(j0 + j, p, ldb, kc)];
+            }
+            else
+            {
+                dst[j] =
+                    alpha *
+                    COMPLEX_CONJUGATE(b[COLMAJOR(j0 + j, p, ldb, kc)]);
+            }
+        }
+        for (int j = nr; j < BML_GEMM_NR; j++)
+        {
+            dst[j] = 0;
+        }
+        dst += BML_GEMM_NR;
+    }
+}
+
+/** Micro-kernel: C(0:mr, 0:nr) += Ap * Bp.
+ *
+ * The MR x NR product of a packed A sliver and a packed B sliver is
+ * accumulated in a local block that the compiler keeps in vector
+ * registers, and then added to C. mr and nr are only smaller than MR
+ * and NR at the edges of C.
+ *
+ * \param kc The inner dimension
+ * \param ap The packed A sliver
+ * \param bp The packed B sliver
+ * \param c Pointer to element (0, 0) of the block of C
+ * \param ldc The leading dimension of C
+ * \param mr The number of rows of C to update
+ * \param nr The number of columns of C to update
+ */
+static void TYPED_FUNC(
+    bml_gemm_micro_kernel) (
+    const int kc,
+    const REAL_T * restrict ap,
+    const REAL_T * restrict bp,
+    REAL_T * restrict c,
+    const int ldc,
+    const int mr,
+    const int nr)
+{
+#if defined(SINGLE_COMPLEX) || defined(DOUBLE_COMPLEX)
+    /* Real and imaginary parts are accumulated separately, a complex
+     * multiply in C would go through the C99 Annex G library call. */
+    const REAL_PART_T *a_ri = (const REAL_PART_T *) ap;
+    const REAL_PART_T *b_ri = (const REAL_PART_T *) bp;
+    REAL_PART_T ab_re[BML_GEMM_NR][BML_GEMM_MR];
+    REAL_PART_T ab_im[BML_GEMM_NR][BML_GEMM_MR];
+
+    for (int j = 0; j < BML_GEMM_NR; j++)
+    {
+        for (int i = 0; i < BML_GEMM_MR; i++)
+        {
+            ab_re[j][i] = 0;
+            ab_im[j][i] = 0;
+        }
+    }
+
+    for (int p = 0; p < kc; p++)
+    {
+        for (int j = 0; j < BML_GEMM_NR; j++)
+        {
+            REAL_PART_T b_re = b_ri[2 * j];
+            REAL_PART_T b_im = b_ri[2 * j + 1];
+            for (int i = 0; i < BML_GEMM_MR; i++)
+            {
+                ab_re[j][i] += a_ri[i] * b_re - a_ri[BML_GEMM_MR + i] * b_im;
+                ab_im[j][i] += a_ri[i] * b_im + a_ri[BML_GEMM_MR + i] * b_re;
+            }
+        }
+        a_ri += 2 * BML_GEMM_MR;
+        b_ri += 2 * BML_GEMM_NR;
+    }
+
+    for (int j = 0; j < nr; j++)
+    {
+        for (int i = 0; i < mr; i++)
+        {
+            c[COLMAJOR(i, j, ldc, nr)] += ab_re[j][i] + ab_im[j][i] * I;
+        }
+    }
+#else
+    REAL_T ab[BML_GEMM_NR][BML_GEMM_MR];
+
+    for (int j = 0; j < BML_GEMM_NR; j++)
+    {
+        for (int i = 0; i < BML_GEMM_MR; i++)
+        {
+            ab[j][i] = 0;
+        }
+    }
+
+    for (int p = 0; p < kc; p++)
+    {
+        for (int j = 0; j < BML_GEMM_NR; j++)
+        {
+            REAL_T bj = bp[j];
+            for (int i = 0; i < BML_GEMM_MR; i++)
+            {
+                ab[j][i] += ap[i] * bj;
+            }
+        }
+        ap += BML_GEMM_MR;
+        bp += BML_GEMM_NR;
+    }
+
+    for (int j = 0; j < nr; j++)
+    {
+        for (int i = 0; i < mr; i++)
+        {
+            c[COLMAJOR(i, j, ldc, nr)] += ab[j][i];
+        }
+    }
+#endif
+}
+
+/** Internal matrix multiply.
+ *
+ * \f$ C \leftarrow \alpha \, op(A) \, op(B) + \beta C \f$
+ *
+ * Same interface as the BLAS xGEMM (column major, op is 'N', 'T' or
+ * 'C'). Blocked GotoBLAS style: for every KC x NC panel of op(B) the
+ * panel and the matching columns of op(A) are packed into contiguous
+ * slivers, and the MC x NR tiles of C are distributed over the OpenMP
+ * threads and updated by a register blocked micro-kernel.
+ */
 void TYPED_FUNC(
     bml_gemm_internal) (
     const char *transa,
@@ -21,23 +305,16 @@ void TYPED_FUNC(
     REAL_T * c,
     const int *ldc)
 {
-    /* Reference implementation from
-     * http://www.netlib.org/lapack/explore-html/d1/d54/group__double__blas__level3_gaeda3cbd99c8fb834a60a6412878226e1.html
-     */
-
     int N_rows_A;
     int N_rows_B;
-    int N_cols_A;
 
     if (*transa == 'N')
     {
         N_rows_A = *m;
-        N_cols_A = *k;
     }
     else
     {
         N_rows_A = *k;
-        N_cols_A = *m;
     }
 
     if (*transb == 'N')
@@ -96,161 +373,124 @@ void TYPED_FUNC(
         return;
     }
 
-    if (*alpha == 0)
+    /* C := beta*C, set explicitly to zero for beta = 0 so that NaNs in
+     * C do not propagate. */
+    if (*beta != 1.0)
     {
-        if (*beta == 0)
+#pragma omp parallel for if(*m * *n > BML_GEMM_PARALLEL_MIN_WORK / 64)
+        for (int j = 0; j < *n; j++)
         {
-            for (int j = 0; j < *n; j++)
+            for (int i = 0; i < *m; i++)
             {
-                for (int i = 0; i < *m; i++)
+                if (*beta == 0)
                 {
-                    c[COLMAJOR(i, j, *m, *n)] = 0;
+                    c[COLMAJOR(i, j, *ldc, *n)] = 0;
                 }
-            }
-        }
-        else
-        {
-            for (int j = 0; j < *n; j++)
-            {
-                for (int i = 0; i < *m; i++)
+                else
                 {
-                    c[COLMAJOR(i, j, *m, *n)] =
-                        *beta * c[COLMAJOR(i, j, *m, *n)];
+                    c[COLMAJOR(i, j, *ldc, *n)] *= *beta;
                 }
             }
         }
-        return;
     }
 
-    if (*transb == 'N')
+    if (*alpha == 0 || *k == 0)
     {
-        if (*transa == 'N')
-        {
-            /* C := alpha*A*B + beta*C
-             */
+        return;
+    }
 
-            for (int j = 0; j < *n; j++)
-            {
-                if (*beta == 0)
-                {
-                    for (int i = 0; i < *m; i++)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] = 0;
-                    }
-                }
-                else if (*beta != 1.0)
-                {
-                    for (int i = 0; i < *m; i++)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] *= *beta;
-                    }
-                }
+    const char ta = *transa;
+    const char tb = *transb;
+    const int M = *m;
+    const int N = *n;
+    const int K = *k;
+    const int LDA = *lda;
+    const int LDB = *ldb;
+    const int LDC = *ldc;
+    const REAL_T ALPHA = *alpha;
 
-                for (int l = 0; l < *k; l++)
-                {
-                    REAL_T temp = *alpha * b[COLMAJOR(l, j, *k, *n)];
-                    for (int i = 0; i < *m; i++)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] +=
-                            temp * a[COLMAJOR(i, l, *m, *k)];
-                    }
-                }
-            }
-        }
-        else
-        {
-            /* C := alpha*A**T*B + beta*C
-             */
+    const int m_slivers = (M + BML_GEMM_MR - 1) / BML_GEMM_MR;
+    const int m_blocks = (M + BML_GEMM_MC - 1) / BML_GEMM_MC;
+    const int kc_max = MIN(K, BML_GEMM_KC);
+    const int nc_max = MIN(N, BML_GEMM_NC);
 
-            for (int j = 0; j < *n; j++)
-            {
-                for (int i = 0; i < *m; i++)
-                {
-                    REAL_T temp = 0;
-                    for (int l = 0; l < *k; l++)
-                    {
-                        temp +=
-                            a[COLMAJOR(l, i, *k, *m)] *
-                            b[COLMAJOR(l, j, *k, *n)];
-                    }
-                    if (*beta == 0)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] = *alpha * temp;
-                    }
-                    else
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] =
-                            *alpha * temp + *beta * c[COLMAJOR(i, j, *m, *n)];
-                    }
-                }
-            }
-        }
-    }
-    else
+    REAL_T *ap =
+        bml_noinit_allocate_memory(sizeof(REAL_T) * m_slivers *
+                                   BML_GEMM_MR * kc_max);
+    REAL_T *bp =
+        bml_noinit_allocate_memory(sizeof(REAL_T) *
+                                   ((nc_max + BML_GEMM_NR - 1) /
+                                    BML_GEMM_NR) * BML_GEMM_NR * kc_max);
+
+    double work = (double) M * (double) N * (double) K;
+
+#pragma omp parallel if(work > BML_GEMM_PARALLEL_MIN_WORK)
+    for (int jc = 0; jc < N; jc += BML_GEMM_NC)
     {
-        if (*transa == 'N')
+        int nc = MIN(BML_GEMM_NC, N - jc);
+        int n_slivers = (nc + BML_GEMM_NR - 1) / BML_GEMM_NR;
+
+        for (int pc = 0; pc < K; pc += BML_GEMM_KC)
         {
-            /* C := alpha*A*B**T + beta*C
-             */
+            int kc = MIN(BML_GEMM_KC, K - pc);
+
+            const REAL_T *b_panel = (tb == 'N'
+                                     ? &b[COLMAJOR(pc, jc, LDB, N)]
+                                     : &b[COLMAJOR(jc, pc, LDB, K)]);
+            const REAL_T *a_panel = (ta == 'N'
+                                     ? &a[COLMAJOR(0, pc, LDA, K)]
+                                     : &a[COLMAJOR(pc, 0, LDA, M)]);
 
-            for (int j = 0; j < *n; ++j)
+#pragma omp for
+            for (int s = 0; s < n_slivers; s++)
             {
-                if (*beta == 0)
-                {
-                    for (int i = 0; i < *m; i++)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] = 0;
-                    }
-                }
-                else if (*beta != 1.0)
-                {
-                    for (int i = 0; i < *m; i++)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] *= *beta;
-                    }
-                }
+                TYPED_FUNC(bml_gemm_pack_b) (tb, kc, nc, ALPHA, b_panel,
+                                             LDB, s, bp);
+            }
 
-                for (int l = 0; l < *k; l++)
-                {
-                    REAL_T temp = *alpha * b[COLMAJOR(j, l, *n, *k)];
-                    for (int i = 0; i < *m; i++)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] +=
-                            temp * a[COLMAJOR(i, l, *m, *k)];
-                    }
-                }
+#pragma omp for
+            for (int s = 0; s < m_slivers; s++)
+            {
+                TYPED_FUNC(bml_gemm_pack_a) (ta, M, kc, a_panel, LDA, s,
+                                             ap);
             }
-        }
-        else
-        {
-            /* C := alpha*A**T*B**T + beta*C
-             */
 
-            for (int j = 0; j < *n; j++)
+#pragma omp for collapse(2) schedule(static)
+            for (int ib = 0; ib < m_blocks; ib++)
             {
-                for (int i = 0; i < *m; i++)
+                for (int jr = 0; jr < n_slivers; jr++)
                 {
-                    REAL_T temp = 0;
-                    for (int l = 0; l < *k; l++)
-                    {
-                        temp +=
-                            a[COLMAJOR(l, i, *k, *m)] *
-                            b[COLMAJOR(j, l, *n, *k)];
-                    }
+                    int j0 = jr * BML_GEMM_NR;
+                    int nr = MIN(BML_GEMM_NR, nc - j0);
+                    int s_end =
+                        MIN(m_slivers,
+                            (ib + 1) * (BML_GEMM_MC / BML_GEMM_MR));
 
-                    if (*beta == 0)
-                    {
-                        c[COLMAJOR(i, j, *m, *n)] = *alpha * temp;
-                    }
-                    else
+                    for (int s = ib * (BML_GEMM_MC / BML_GEMM_MR);
+                         s < s_end; s++)
                     {
-                        c[COLMAJOR(i, j, *m, *n)] =
-                            *alpha * temp + *beta * c[COLMAJOR(i, j, *m, *n)];
+                        int i0 = s * BML_GEMM_MR;
+                        int mr = MIN(BML_GEMM_MR, M - i0);
+
+                        TYPED_FUNC(bml_gemm_micro_kernel) (kc,
+                                                           &ap[(size_t) s *
+                                                               BML_GEMM_MR *
+                                                               kc],
+                                                           &bp[(size_t) jr *
+                                                               BML_GEMM_NR *
+                                                               kc],
+                                                           &c[COLMAJOR
+                                                              (i0, jc + j0,
+                                                               LDC, N)], LDC,
+                                                           mr, nr);
                     }
                 }
             }
         }
     }
+
+    bml_free_memory(ap);
+    bml_free_memory(bp);
 }
 
 void TYPED_FUNC(
@@ -21,13 +21,6 @@ int TYPED_FUNC(
     bml_matrix_t *A = NULL;
     REAL_T *A_dense = NULL;
 
-    if (matrix_type == dense || matrix_type == ellsort
-        || matrix_type == ellblock || matrix_type == csr)
-    {
-        LOG_INFO("adjacency matrix test not available\n");
-        return 0;
-    }
-
     A_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
     for (int i = 0; i < N; i++)
     {
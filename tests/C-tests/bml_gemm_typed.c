@@ -9,6 +9,12 @@
 #include <stdio.h>
 #include <string.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include <time.h>
+#endif
+
 static void TYPED_FUNC(
     ref_multiply) (
     const int N,
@@ -115,6 +121,95 @@ static int TYPED_FUNC(
     return 0;
 }
 
+/** Wall clock time in seconds.
+ */
+static double TYPED_FUNC(
+    wall_time) (
+    void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+/** Benchmark the internal GEMM against bml_gemm.
+ *
+ * Uses sizes that are not multiples of the blocking and leading
+ * dimensions larger than the matrices, and checks that both agree.
+ */
+static int TYPED_FUNC(
+    bench_bml_gemm) (
+    const int N)
+{
+    const int m = N + 3;
+    const int n = N - 5;
+    const int k = N + 7;
+    const int lda = m + 2;
+    const int ldb = k + 1;
+    const int ldc = m + 4;
+
+    REAL_T alpha = 0.7;
+    REAL_T beta = 0.3;
+
+    REAL_T *A = calloc(sizeof(REAL_T), lda * k);
+    REAL_T *B = calloc(sizeof(REAL_T), ldb * n);
+    REAL_T *C = calloc(sizeof(REAL_T), ldc * n);
+    REAL_T *C_ref = calloc(sizeof(REAL_T), ldc * n);
+
+    for (int i = 0; i < lda * k; i++)
+    {
+        A[i] = (REAL_T) (rand() / (double) RAND_MAX - 0.5);
+    }
+    for (int i = 0; i < ldb * n; i++)
+    {
+        B[i] = (REAL_T) (rand() / (double) RAND_MAX - 0.5);
+    }
+    for (int i = 0; i < ldc * n; i++)
+    {
+        C[i] = (REAL_T) (rand() / (double) RAND_MAX - 0.5);
+    }
+    memcpy(C_ref, C, sizeof(REAL_T) * ldc * n);
+
+    double flops = 2.0 * m * n * k;
+
+    double t0 = TYPED_FUNC(wall_time) ();
+    TYPED_FUNC(bml_gemm) ("N", "N", &m, &n, &k, &alpha, A, &lda, B, &ldb,
+                          &beta, C_ref, &ldc);
+    double t1 = TYPED_FUNC(wall_time) ();
+    TYPED_FUNC(bml_gemm_internal) ("N", "N", &m, &n, &k, &alpha, A, &lda, B,
+                                   &ldb, &beta, C, &ldc);
+    double t2 = TYPED_FUNC(wall_time) ();
+
+    LOG_INFO("gemm %d x %d x %d: bml_gemm %1.3e s (%1.2f GFLOP/s)\n", m, n,
+             k, t1 - t0, flops / MAX(t1 - t0, 1e-9) * 1e-9);
+    LOG_INFO("gemm %d x %d x %d: internal %1.3e s (%1.2f GFLOP/s)\n", m, n,
+             k, t2 - t1, flops / MAX(t2 - t1, 1e-9) * 1e-9);
+
+    int status = 0;
+    for (int j = 0; j < n; j++)
+    {
+        for (int i = 0; i < m; i++)
+        {
+            if (ABS(C[COLMAJOR(i, j, ldc, n)] - C_ref[COLMAJOR(i, j, ldc, n)])
+                > ABS_TOL * k)
+            {
+                LOG_INFO("element (%d, %d) outside %1.2e\n", i, j,
+                         ABS_TOL * k);
+                status = 1;
+            }
+        }
+    }
+
+    free(A);
+    free(B);
+    free(C);
+    free(C_ref);
+
+    return status;
+}
+
 int TYPED_FUNC(
     test_bml_gemm) (
     const int N,
@@ -128,12 +223,15 @@ int TYPED_FUNC(
     char *transa[] = { "N", "T" };
     char *transb[] = { "N", "T" };
 
+    const int N_bench = 256;
+
     REAL_T *A = calloc(sizeof(REAL_T), N * N);
     REAL_T *A_input = calloc(sizeof(REAL_T), N * N);
     REAL_T *B = calloc(sizeof(REAL_T), N * N);
     REAL_T *B_input = calloc(sizeof(REAL_T), N * N);
     REAL_T *C = calloc(sizeof(REAL_T), N * N);
     REAL_T *C_ref = calloc(sizeof(REAL_T), N * N);
+    REAL_T *C_internal = calloc(sizeof(REAL_T), N * N);
 
     for (int i = 0; i < 2; i++)
     {
@@ -164,6 +262,7 @@ int TYPED_FUNC(
             }
             TYPED_FUNC(ref_random_matrix) (N, C);
             TYPED_FUNC(copy_matrix) (N, C, C_ref);
+            TYPED_FUNC(copy_matrix) (N, C, C_internal);
 
             LOG_INFO("A:\n");
             bml_print_dense_matrix(N, matrix_precision, dense_column_major,
@@ -193,8 +292,24 @@ int TYPED_FUNC(
                 LOG_ERROR("matrix product incorrect\n");
                 return -1;
             }
+
+            TYPED_FUNC(bml_gemm_internal) (transa[i], transb[j], &N, &N, &N,
+                                           &alpha, A, &N, B, &N, &beta,
+                                           C_internal, &N);
+            if (TYPED_FUNC(compare_matrix)
+                (N, matrix_precision, C_internal, C_ref) != 0)
+            {
+                LOG_ERROR("internal matrix product incorrect\n");
+                return -1;
+            }
         }
     }
+
+    if (TYPED_FUNC(bench_bml_gemm) (N_bench) != 0)
+    {
+        LOG_ERROR("internal matrix product incorrect\n");
+        return -1;
+    }
     LOG_INFO("test_bml_gemm passed\n");
 
     free(A);
@@ -203,6 +318,7 @@ int TYPED_FUNC(
     free(B_input);
     free(C);
     free(C_ref);
+    free(C_internal);
 
     return 0;
 }
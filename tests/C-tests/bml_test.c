@@ -9,9 +9,9 @@
 #include "bml_test.h"
 
 #ifdef DO_MPI
-const int NUM_TESTS = 31;
+const int NUM_TESTS = 32;
 #else
-const int NUM_TESTS = 30;
+const int NUM_TESTS = 31;
 #endif
 
 typedef struct
@@ -46,6 +46,7 @@ const char *test_name[] = {
     "multiply_x2",
     "norm",
     "normalize",
+    "partition",
     "print",
     "scale",
     "set_element",
@@ -82,6 +83,7 @@ const char *test_description[] = {
     "Multiply two identical matrices",
     "Norm of bml matrix",
     "Normalize bml matrices",
+    "Partition the graph of a bml matrix",
     "Print bml matrix to stdout",
     "Scale bml matrices",
     "Set a single element of a bml matrix",
@@ -118,6 +120,7 @@ const test_function_t testers[] = {
     test_multiply_x2,
     test_norm,
     test_normalize,
+    test_partition,
     test_print,
     test_scale,
     test_set_element,
@@ -184,7 +187,8 @@ main(
     char **argv)
 {
 #ifdef DO_MPI
-    MPI_Init(&argc, &argv);
+    int provided;
+    MPI_Init_thread(&argc, &argv, MPI_THREAD_SERIALIZED, &provided);
     bml_init(MPI_COMM_WORLD);
     printf("with MPI\n");
     int N = 14;
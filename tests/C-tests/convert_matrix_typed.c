@@ -1,10 +1,50 @@
 #include "bml.h"
 #include "../typed.h"
+#include "ellblock/bml_allocate_ellblock.h"
 
 #include <complex.h>
 #include <math.h>
 #include <stdlib.h>
 
+#ifdef _OPENMP
+#include <omp.h>
+#else
+#include <time.h>
+#endif
+
+static double TYPED_FUNC(
+    wall_time) (
+    void)
+{
+#ifdef _OPENMP
+    return omp_get_wtime();
+#else
+    return (double) clock() / CLOCKS_PER_SEC;
+#endif
+}
+
+static int TYPED_FUNC(
+    compare_dense) (
+    const int N,
+    REAL_T * A_dense,
+    bml_matrix_t * B)
+{
+    REAL_T *B_dense = bml_export_to_dense(B, dense_row_major);
+    int result = 0;
+    for (int i = 0; i < N * N; i++)
+    {
+        if (ABS(A_dense[i] - B_dense[i]) > 1e-12)
+        {
+            LOG_INFO("matrix element mismatch A[%d] = %e, B[%d] = %e\n",
+                     i, A_dense[i], i, B_dense[i]);
+            result = -1;
+            break;
+        }
+    }
+    bml_free_memory(B_dense);
+    return result;
+}
+
 int TYPED_FUNC(
     test_convert) (
     const int N,
@@ -26,10 +66,56 @@ int TYPED_FUNC(
     }
 #endif
 
+    // find the ellblock block sizes of atoms in a chain, each coupled to
+    // its neighbours, before any block sizes are set
+    if (matrix_type == ellblock && distrib_mode == sequential)
+    {
+        int atom_size[] = { 1, 4, 4, 1, N - 10 };
+        int natoms = sizeof(atom_size) / sizeof(atom_size[0]);
+        int atom[N];
+        for (int a = 0, i = 0; a < natoms; a++)
+            for (int k = 0; k < atom_size[a]; k++)
+                atom[i++] = a;
+
+        REAL_T *P_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
+        for (int i = 0; i < N; i++)
+            for (int j = 0; j < N; j++)
+                if (abs(atom[i] - atom[j]) <= 1)
+                    P_dense[i * N + j] = 1.0 + rand() / (double) RAND_MAX;
+
+        bml_set_block_size_discovery(1);
+        bml_matrix_t *P =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, P_dense, 0,
+                                  distrib_mode);
+        int *bsize = bml_get_block_sizes(N, M);
+        int nb = bml_get_nb();
+        LOG_INFO("found %d blocks, fill efficiency %f\n", nb,
+                 bml_get_block_fill_efficiency());
+        if (nb != natoms || bml_get_block_fill_efficiency() != 1.0
+            || TYPED_FUNC(compare_dense) (N, P_dense, P) != 0)
+        {
+            LOG_ERROR("block size discovery incorrect\n");
+            return -1;
+        }
+        for (int a = 0; a < natoms; a++)
+        {
+            if (bsize[a] != atom_size[a])
+            {
+                LOG_ERROR("block %d has size %d instead of %d\n", a,
+                          bsize[a], atom_size[a]);
+                return -1;
+            }
+        }
+        bml_deallocate(&P);
+        bml_free_memory(P_dense);
+    }
+
     A_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
     for (int i = 0; i < N * N; i++)
     {
-        A_dense[i] = rand() / (double) RAND_MAX;
+        // leave some zeros for the sparse formats to skip
+        A_dense[i] = (i % 3 == 0) ? 0 : rand() / (double) RAND_MAX;
     }
 
     A = bml_import_from_dense(matrix_type, matrix_precision, dense_row_major,
@@ -55,6 +141,36 @@ int TYPED_FUNC(
         }
         bml_free_memory(B_dense);
     }
+
+    // convert to every other format and back
+    if (distrib_mode == sequential)
+    {
+        bml_matrix_type_t types[] = { dense, ellpack, ellsort, ellblock, csr };
+        int ntypes = sizeof(types) / sizeof(types[0]);
+        for (int t = 0; t < ntypes; t++)
+        {
+            double t0 = TYPED_FUNC(wall_time) ();
+            bml_matrix_t *C =
+                bml_convert(A, types[t], matrix_precision, M, distrib_mode);
+            double t1 = TYPED_FUNC(wall_time) ();
+            bml_matrix_t *D =
+                bml_convert(C, matrix_type, matrix_precision, M,
+                            distrib_mode);
+            double t2 = TYPED_FUNC(wall_time) ();
+            LOG_INFO("convert to type %d in %e s, back in %e s\n", types[t],
+                     t1 - t0, t2 - t1);
+
+            if (bml_get_type(C) != types[t]
+                || TYPED_FUNC(compare_dense) (N, A_dense, C) != 0
+                || TYPED_FUNC(compare_dense) (N, A_dense, D) != 0)
+            {
+                LOG_ERROR("conversion to type %d incorrect\n", types[t]);
+                return -1;
+            }
+            bml_deallocate(&C);
+            bml_deallocate(&D);
+        }
+    }
     bml_free_memory(A_dense);
     bml_deallocate(&A);
     bml_deallocate(&B);
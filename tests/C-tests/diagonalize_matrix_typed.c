@@ -15,6 +15,100 @@
 #define REL_TOL 1e-11
 #endif
 
+#define NBATCH 4
+
+// Diagonalize a batch of matrices of different sizes and compare with
+// bml_diagonalize one matrix at a time
+static int TYPED_FUNC(
+    test_diagonalize_batched) (
+    const int N,
+    const bml_matrix_precision_t matrix_precision)
+{
+    int sizes[NBATCH] = { N / 2 + 1, N, 1, 3 };
+    bml_matrix_t *A[NBATCH];
+    bml_matrix_t *eigenvectors[NBATCH];
+    void *eigenvalues[NBATCH];
+
+    for (int k = 0; k < NBATCH; k++)
+    {
+        bml_matrix_t *B = bml_random_matrix(dense, matrix_precision,
+                                            sizes[k], sizes[k], sequential);
+        bml_matrix_t *B_t = bml_transpose_new(B);
+        bml_add(B, B_t, 0.5, 0.5, 0.0);
+        A[k] = B;
+        eigenvectors[k] = bml_zero_matrix(dense, matrix_precision, sizes[k],
+                                          sizes[k], sequential);
+        eigenvalues[k] = bml_allocate_memory(sizes[k] * sizeof(REAL_T));
+        bml_deallocate(&B_t);
+    }
+
+    // Once one matrix per thread, once all of them but the smallest
+    // with all threads
+    int cutoff = bml_get_diagonalize_batched_cutoff();
+    for (int pass = 0; pass < 2; pass++)
+    {
+        bml_set_diagonalize_batched_cutoff(pass == 0 ? cutoff : 1);
+        double rate =
+            bml_diagonalize_batched(NBATCH, A, eigenvalues, eigenvectors);
+        LOG_INFO("batched diagonalization: %e matrices/s\n", rate);
+
+        for (int k = 0; k < NBATCH; k++)
+        {
+            int n = sizes[k];
+            REAL_T *values = eigenvalues[k];
+            REAL_T *ref_values = bml_allocate_memory(n * sizeof(REAL_T));
+            bml_matrix_t *ref_vectors =
+                bml_zero_matrix(dense, matrix_precision, n, n, sequential);
+            bml_matrix_t *ct = bml_transpose_new(eigenvectors[k]);
+            bml_matrix_t *D =
+                bml_zero_matrix(dense, matrix_precision, n, n, sequential);
+            bml_matrix_t *aux =
+                bml_zero_matrix(dense, matrix_precision, n, n, sequential);
+            bml_matrix_t *aux2 =
+                bml_zero_matrix(dense, matrix_precision, n, n, sequential);
+
+            bml_diagonalize(A[k], ref_values, ref_vectors);
+            for (int i = 0; i < n; i++)
+            {
+                if (ABS(values[i] - ref_values[i]) > n * REL_TOL)
+                {
+                    LOG_ERROR("batched eigenvalue %d of matrix %d differs\n",
+                              i, k);
+                    return -1;
+                }
+            }
+
+            bml_set_diagonal(D, values, 0.0);
+            bml_multiply(D, ct, aux2, 1.0, 0.0, 0.0);
+            bml_multiply(eigenvectors[k], aux2, aux, 1.0, 0.0, 0.0);
+            bml_add(aux, A[k], 1.0, -1.0, 0.0);
+            double fnorm = bml_fnorm(aux);
+            if (fnorm > n * REL_TOL || fnorm != fnorm)
+            {
+                LOG_ERROR("batched matrix %d: fnorm(CDC^t-A) = %e\n", k,
+                          fnorm);
+                return -1;
+            }
+
+            bml_free_memory(ref_values);
+            bml_deallocate(&ref_vectors);
+            bml_deallocate(&ct);
+            bml_deallocate(&D);
+            bml_deallocate(&aux);
+            bml_deallocate(&aux2);
+        }
+    }
+    bml_set_diagonalize_batched_cutoff(cutoff);
+
+    for (int k = 0; k < NBATCH; k++)
+    {
+        bml_deallocate(&A[k]);
+        bml_deallocate(&eigenvectors[k]);
+        bml_free_memory(eigenvalues[k]);
+    }
+    return 0;
+}
+
 int TYPED_FUNC(
     test_diagonalize) (
     const int N,
@@ -225,6 +319,12 @@ int TYPED_FUNC(
     bml_deallocate(&id);
     bml_free_memory(eigenvalues);
 
+    if (matrix_type == dense && distrib_mode == sequential
+        && TYPED_FUNC(test_diagonalize_batched) (N, matrix_precision) != 0)
+    {
+        return -1;
+    }
+
     LOG_INFO("diagonalize matrix test passed\n");
 
     return 0;
@@ -3,6 +3,7 @@
 #include "bml.h"
 #include "bml_test.h"
 
+#include "../macros.h"
 #include "../typed.h"
 #include <complex.h>
 #include <math.h>
@@ -87,8 +88,138 @@ int TYPED_FUNC(
         bml_free_memory(A_dense);
         bml_free_memory(B_dense);
     }
-    bml_deallocate(&A);
     bml_deallocate(&B);
+
+    // Binary round trip, copying the arrays and using them in place
+    if (bml_getNRanks() == 1)
+    {
+        matrix_filename = strdup("ctest_matrix_XXXXXX");
+        mktemp(matrix_filename);
+        A_dense = bml_export_to_dense(A, dense_row_major);
+        for (int pass = 0; pass < 3; pass++)
+        {
+            // The last pass writes compressed column indices
+            int zero_copy = pass == 1;
+            bml_set_binary_index_encoding(pass == 2 ? index_encoding_delta :
+                                          index_encoding_none);
+            bml_write_bml_matrix_binary(A, matrix_filename);
+            B = bml_read_bml_matrix_binary(matrix_filename, zero_copy);
+            if (bml_get_type(B) != matrix_type
+                || bml_get_precision(B) != matrix_precision)
+            {
+                LOG_ERROR("wrong type or precision of binary matrix\n");
+                return -1;
+            }
+            B_dense = bml_export_to_dense(B, dense_row_major);
+            for (int i = 0; i < N * N; i++)
+            {
+                diff = ABS(A_dense[i] - B_dense[i]);
+                if (diff > 0)
+                {
+                    LOG_ERROR("binary matrix differs; A[%d] = %e, "
+                              "B[%d] = %e\n", i, A_dense[i], i,
+                              B_dense[i]);
+                    return -1;
+                }
+            }
+            // Changing the matrix must leave the file alone
+            REAL_T scale = 2.0;
+            bml_scale_inplace(&scale, B);
+            bml_free_memory(B_dense);
+            bml_deallocate(&B);
+        }
+        bml_set_binary_index_encoding(index_encoding_none);
+        remove(matrix_filename);
+        free(matrix_filename);
+        bml_free_memory(A_dense);
+    }
+    bml_deallocate(&A);
+
+    // Unsorted rows, empty rows and long jumps between columns
+    {
+        int nnz[4] = { 4, 0, 10, 3 };
+        int index[17] = { 5, 3, 100000, 7, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11,
+            1 << 30, 0, 1 << 30
+        };
+        int decoded[17];
+        char *buffer = malloc(bml_encode_index_bound(4, 17));
+        size_t nbytes = bml_encode_index(4, 0, nnz, index, 0, buffer);
+        if (bml_decode_index(4, 0, nnz, buffer, decoded, 0) != nbytes
+            || memcmp(index, decoded, sizeof(index)) != 0)
+        {
+            LOG_ERROR("index encoding round trip failed\n");
+            return -1;
+        }
+        free(buffer);
+    }
+
+    // A file with only the lower triangle of a tridiagonal matrix, the
+    // reader mirrors the off-diagonal elements
+    if (bml_getNRanks() == 1)
+    {
+        matrix_filename = strdup("ctest_matrix_XXXXXX");
+        mktemp(matrix_filename);
+        FILE *fout = fopen(matrix_filename, "w");
+#if defined(SINGLE_COMPLEX) || defined(DOUBLE_COMPLEX)
+        REAL_T offdiag = 0.5 + 0.25 * I;
+        fprintf(fout,
+                "%%%%MatrixMarket matrix coordinate complex hermitian\n");
+        fprintf(fout, "%% lower triangle only\n");
+        fprintf(fout, "%d %d %d\n", N, N, 2 * N - 1);
+        for (int i = 0; i < N; i++)
+        {
+            fprintf(fout, "%d %d %e %e\n", i + 1, i + 1, i + 1.0, 0.0);
+            if (i > 0)
+            {
+                fprintf(fout, "%d %d %e %e\n", i + 1, i, creal(offdiag),
+                        cimag(offdiag));
+            }
+        }
+#else
+        REAL_T offdiag = 0.5;
+        fprintf(fout, "%%%%MatrixMarket matrix coordinate real symmetric\n");
+        fprintf(fout, "%% lower triangle only\n");
+        fprintf(fout, "%d %d %d\n", N, N, 2 * N - 1);
+        for (int i = 0; i < N; i++)
+        {
+            fprintf(fout, "%d %d %e\n", i + 1, i + 1, i + 1.0);
+            if (i > 0)
+            {
+                fprintf(fout, "%d %d %e\n", i + 1, i, offdiag);
+            }
+        }
+#endif
+        fclose(fout);
+
+        B = bml_zero_matrix(matrix_type, matrix_precision, N, M,
+                            sequential);
+        bml_read_bml_matrix(B, matrix_filename);
+        B_dense = bml_export_to_dense(B, dense_row_major);
+        for (int i = 0; i < N; i++)
+        {
+            for (int j = 0; j < N; j++)
+            {
+                REAL_T expected = 0;
+                if (i == j)
+                    expected = i + 1.0;
+                else if (i == j + 1)
+                    expected = offdiag;
+                else if (j == i + 1)
+                    expected = conj(offdiag);
+                diff = ABS(B_dense[ROWMAJOR(i, j, N, N)] - expected);
+                if (diff > tol)
+                {
+                    LOG_ERROR("wrong mirrored element B[%d][%d]\n", i, j);
+                    return -1;
+                }
+            }
+        }
+        remove(matrix_filename);
+        free(matrix_filename);
+        bml_free_memory(B_dense);
+        bml_deallocate(&B);
+    }
+
     if (bml_getMyRank() == 0)
         LOG_INFO("io matrix test passed\n");
     return 0;
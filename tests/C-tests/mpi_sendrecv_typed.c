@@ -1,10 +1,13 @@
 #include "bml.h"
 #include "../typed.h"
 #include "bml_parallel.h"
+#include "ellblock/bml_allocate_ellblock.h"
+#include "ellpack/bml_halo_ellpack.h"
 
 #include <complex.h>
 #include <math.h>
 #include <stdlib.h>
+#include <string.h>
 
 #ifdef DO_MPI
 
@@ -46,8 +49,12 @@ int TYPED_FUNC(
     if (myrank == 0)
         bml_print_bml_matrix(A, 0, N, 0, N);
 
-    // test point-to-point communications
+    // test point-to-point communications, with plain and encoded indices
+    bml_index_encoding_t encodings[2] =
+        { index_encoding_none, index_encoding_delta };
+    for (int e = 0; e < 2; e++)
     {
+        bml_set_mpi_index_encoding(encodings[e]);
         REAL_T *A_dense = bml_export_to_dense(A, dense_row_major);
 
         if (myrank % 2 == 1)
@@ -89,6 +96,7 @@ int TYPED_FUNC(
         if (myrank == 0)
             bml_free_memory(A_dense);
     }
+    bml_set_mpi_index_encoding(index_encoding_none);
 
     // test collective communications
     {
@@ -109,6 +117,320 @@ int TYPED_FUNC(
         bml_free_memory(A_dense);
     }
 
+    // test gather of rows computed on each rank
+    {
+        int nranks;
+        MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+        // rows owned by this rank, split evenly
+        int nrows = N;
+        int *bsize = NULL;
+        if (matrix_type == ellblock)
+        {
+            // ellblock splits block rows
+            bsize = bml_get_block_sizes(N, M);
+            nrows = bml_get_nb();
+        }
+        int *localPartMin = bml_allocate_memory(sizeof(int) * nranks);
+        int *localPartMax = bml_allocate_memory(sizeof(int) * nranks);
+        int *nnodesInPart = bml_allocate_memory(sizeof(int) * nranks);
+        int rowMin = 0;
+        int rowMax = 0;
+        for (int r = 0; r < nranks; r++)
+        {
+            localPartMin[r] = r + 1;
+            localPartMax[r] = r + 1;
+            nnodesInPart[r] = nrows / nranks + (r < nrows % nranks ? 1 : 0);
+            if (r < myrank)
+                rowMin += nnodesInPart[r];
+        }
+        rowMax = rowMin + nnodesInPart[myrank];
+        if (matrix_type == ellblock)
+        {
+            int offset = 0;
+            for (int ib = 0; ib < rowMax; ib++)
+            {
+                if (ib == rowMin)
+                    rowMin = offset;
+                offset += bsize[ib];
+            }
+            rowMax = offset;
+        }
+
+        REAL_T *A_dense = bml_export_to_dense(A, dense_row_major);
+
+        // rows owned by other ranks hold stale values
+        REAL_T *B_dense = bml_export_to_dense(A, dense_row_major);
+        for (int i = 0; i < N; i++)
+        {
+            if (i < rowMin || i >= rowMax)
+            {
+                for (int j = 0; j < N; j++)
+                    B_dense[i * N + j] *= 2.0;
+            }
+        }
+
+        bml_gather_mode_t modes[] = { gather_padded, gather_compressed };
+        for (int m = 0; m < 2; m++)
+        {
+            bml_matrix_t *B =
+                bml_import_from_dense(matrix_type, matrix_precision,
+                                      dense_row_major, N, M, B_dense, 0.0,
+                                      sequential);
+            if (matrix_type == dense || matrix_type == ellpack
+                || matrix_type == ellsort)
+            {
+                bml_update_domain(B, localPartMin, localPartMax,
+                                  nnodesInPart);
+            }
+
+            bml_set_gather_mode(modes[m]);
+            bml_allGatherVParallel(B);
+
+            REAL_T *C_dense = bml_export_to_dense(B, dense_row_major);
+            int ret =
+                TYPED_FUNC(compare_matrices) (N, A_dense, C_dense, 1.e-12);
+            if (ret != 0)
+                return ret;
+            bml_free_memory(C_dense);
+            bml_deallocate(&B);
+        }
+        bml_set_gather_mode(gather_compressed);
+
+        LOG_INFO("allgatherv test passed\n");
+        bml_free_memory(localPartMin);
+        bml_free_memory(localPartMax);
+        bml_free_memory(nnodesInPart);
+        bml_free_memory(A_dense);
+        bml_free_memory(B_dense);
+    }
+
+    // test domain balancing the non-zeros per row
+    if (matrix_type == ellpack || matrix_type == ellsort
+        || matrix_type == csr)
+    {
+        int nranks;
+        MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+
+        // full rows at the top, only the diagonal below
+        REAL_T *A_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
+        for (int i = 0; i < N; i++)
+        {
+            for (int j = 0; j < N; j++)
+            {
+                if (i == j || (i < N / 4 && j < M))
+                    A_dense[i * N + j] = (i + j + 1.0) / N;
+            }
+        }
+
+        double *row_cost = bml_allocate_memory(sizeof(double) * N);
+        bml_matrix_t *B =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, A_dense, 0.0,
+                                  sequential);
+        bml_get_row_costs(B, balance_nnz, row_cost);
+        bml_deallocate(&B);
+
+        bml_domain_t *even = bml_default_domain(N, M, distributed);
+        bml_domain_t *balanced = bml_balanced_domain(N, M, row_cost);
+        double total = 0.;
+        double max_row = 0.;
+        for (int i = 0; i < N; i++)
+        {
+            total += row_cost[i];
+            max_row = fmax(max_row, row_cost[i]);
+        }
+        for (int r = 0; r < nranks; r++)
+        {
+            double rank_cost = 0.;
+            for (int i = balanced->localRowMin[r];
+                 i < balanced->localRowMax[r]; i++)
+                rank_cost += row_cost[i];
+            if (rank_cost > total / nranks + max_row)
+            {
+                LOG_ERROR("rank %d gets cost %e of %e\n", r, rank_cost,
+                          total);
+                return -1;
+            }
+        }
+        if (bml_domain_imbalance(balanced, row_cost) >
+            bml_domain_imbalance(even, row_cost))
+        {
+            LOG_ERROR("balanced domain worse than even split\n");
+            return -1;
+        }
+
+        // rows owned by other ranks of the even split are stale and
+        // hold only their diagonal, so that only the rank owning the
+        // full rows sees the imbalance in its local copy
+        REAL_T *B_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
+        for (int i = 0; i < N * N; i++)
+            B_dense[i] = A_dense[i];
+        for (int i = 0; i < N; i++)
+        {
+            if (i < even->localRowMin[myrank]
+                || i >= even->localRowMax[myrank])
+            {
+                for (int j = 0; j < N; j++)
+                {
+                    if (i != j)
+                        B_dense[i * N + j] = 0.0;
+                }
+            }
+        }
+        B = bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, B_dense, 0.0,
+                                  sequential);
+        if (matrix_type != csr)
+        {
+            int *localPartMin = bml_allocate_memory(sizeof(int) * nranks);
+            int *localPartMax = bml_allocate_memory(sizeof(int) * nranks);
+            for (int r = 0; r < nranks; r++)
+            {
+                localPartMin[r] = r + 1;
+                localPartMax[r] = r + 1;
+            }
+            bml_update_domain(B, localPartMin, localPartMax,
+                              even->localRowExtent);
+            bml_free_memory(localPartMin);
+            bml_free_memory(localPartMax);
+        }
+        if (bml_rebalance_domain(B, balance_nnz, 0.5) != (nranks > 1))
+        {
+            LOG_ERROR("imbalanced domain not rebalanced\n");
+            return -1;
+        }
+        REAL_T *C_dense = bml_export_to_dense(B, dense_row_major);
+        int ret = TYPED_FUNC(compare_matrices) (N, A_dense, C_dense, 1.e-12);
+        if (ret != 0)
+            return ret;
+        LOG_INFO("balanced domain test passed, imbalance %f instead of %f\n",
+                 bml_domain_imbalance(balanced, row_cost),
+                 bml_domain_imbalance(even, row_cost));
+
+        bml_free_memory(C_dense);
+        bml_free_memory(B_dense);
+        bml_free_memory(A_dense);
+        bml_free_memory(row_cost);
+        bml_deallocate_domain(even);
+        bml_deallocate_domain(balanced);
+        bml_deallocate(&B);
+    }
+
+    // test row distributed ELLPACK with ghost rows
+    if (matrix_type == ellpack)
+    {
+        int nranks;
+        MPI_Comm_size(MPI_COMM_WORLD, &nranks);
+        int rowMin = 0;
+        for (int r = 0; r < myrank; r++)
+            rowMin += N / nranks + (r < N % nranks ? 1 : 0);
+        int rowMax = rowMin + N / nranks + (myrank < N % nranks ? 1 : 0);
+        int extent = rowMax - rowMin;
+
+        // banded, so that only the neighbouring rows are ghost rows
+        bml_matrix_t *B =
+            bml_banded_matrix(ellpack, matrix_precision, N, 5, sequential);
+        bml_mpi_bcast_matrix(B, 0, MPI_COMM_WORLD);
+
+        // the owned rows as compressed rows, built without a full matrix
+        bml_matrix_ellpack_t *B_ellpack = (bml_matrix_ellpack_t *) B;
+        int *row_ptr = bml_allocate_memory(sizeof(int) * (extent + 1));
+        int *cols = bml_allocate_memory(sizeof(int) * extent * M + 1);
+        REAL_T *vals = bml_allocate_memory(sizeof(REAL_T) * extent * M + 1);
+        for (int i = 0; i < extent; i++)
+        {
+            int nnz = B_ellpack->nnz[rowMin + i];
+            for (int jp = 0; jp < nnz; jp++)
+            {
+                cols[row_ptr[i] + jp] =
+                    B_ellpack->index[(rowMin + i) * B_ellpack->M + jp];
+                vals[row_ptr[i] + jp] =
+                    ((REAL_T *) B_ellpack->value)[(rowMin + i) *
+                                                  B_ellpack->M + jp];
+            }
+            row_ptr[i + 1] = row_ptr[i] + nnz;
+        }
+        bml_matrix_ellpack_t *X =
+            bml_local_rows_compressed_ellpack(matrix_precision, M, rowMin,
+                                              rowMax, row_ptr, cols, vals);
+        bml_matrix_ellpack_t *X_copy =
+            bml_local_rows_ellpack(B, rowMin, rowMax);
+        for (int i = 0; i < extent; i++)
+        {
+            if (X->nnz[i] != X_copy->nnz[i]
+                || memcmp(&X->index[i * M], &X_copy->index[i * X_copy->M],
+                          sizeof(int) * X->nnz[i]) != 0
+                || memcmp(&((REAL_T *) X->value)[i * M],
+                          &((REAL_T *) X_copy->value)[i * X_copy->M],
+                          sizeof(REAL_T) * X->nnz[i]) != 0)
+            {
+                LOG_ERROR("owned row %d built from compressed rows "
+                          "incorrect\n", rowMin + i);
+                return -1;
+            }
+        }
+        bml_free_memory(row_ptr);
+        bml_free_memory(cols);
+        bml_free_memory(vals);
+        bml_deallocate((bml_matrix_t **) & X_copy);
+
+        bml_halo_ellpack_t *halo =
+            bml_halo_create_ellpack(X, N, rowMin, rowMax);
+        bml_halo_exchange_ellpack(X, halo);
+
+        bml_matrix_ellpack_t *X2 =
+            bml_zero_matrix(ellpack, matrix_precision, extent, M, sequential);
+        double *trace = bml_multiply_x2_halo_ellpack(X, X2, halo, 0.0);
+
+        // reference from the full matrix on every rank
+        bml_matrix_t *Y2 =
+            bml_zero_matrix(ellpack, matrix_precision, N, M, sequential);
+        double *trace_ref = bml_multiply_x2(B, Y2, 0.0);
+        REAL_T *Y2_dense = bml_export_to_dense(Y2, dense_row_major);
+
+        // owned rows from the distributed product, others from Y2
+        REAL_T *X2_dense = bml_export_to_dense(Y2, dense_row_major);
+        for (int i = 0; i < extent; i++)
+        {
+            for (int j = 0; j < N; j++)
+                X2_dense[(rowMin + i) * N + j] = 0.0;
+            for (int jp = 0; jp < X2->nnz[i]; jp++)
+                X2_dense[(rowMin + i) * N + X2->index[i * X2->M + jp]] =
+                    ((REAL_T *) X2->value)[i * X2->M + jp];
+        }
+
+#if defined(SINGLE_REAL) || defined(SINGLE_COMPLEX)
+        double tol = 1e-4;
+#else
+        double tol = 1e-10;
+#endif
+        int ret = TYPED_FUNC(compare_matrices) (N, Y2_dense, X2_dense, tol);
+        if (ret != 0)
+            return ret;
+        if (fabs(trace[0] - trace_ref[0]) > tol * N
+            || fabs(trace[1] - trace_ref[1]) > tol * N
+            || fabs(bml_trace_halo_ellpack(X2, halo) - bml_trace(Y2)) >
+            tol * N
+            || fabs(bml_fnorm_halo_ellpack(X2, halo) - bml_fnorm(Y2)) >
+            tol * N)
+        {
+            LOG_ERROR("traces or norm of distributed matrix incorrect\n");
+            return -1;
+        }
+        LOG_INFO("ghost row test passed with %d ghost rows\n", halo->nghost);
+
+        bml_free_memory(trace);
+        bml_free_memory(trace_ref);
+        bml_free_memory(X2_dense);
+        bml_free_memory(Y2_dense);
+        bml_deallocate_halo_ellpack(&halo);
+        bml_deallocate((bml_matrix_t **) & X);
+        bml_deallocate((bml_matrix_t **) & X2);
+        bml_deallocate(&Y2);
+        bml_deallocate(&B);
+    }
+
     bml_clear(A);
     bml_deallocate(&A);
 
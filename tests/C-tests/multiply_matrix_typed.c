@@ -1,8 +1,12 @@
 #include "bml.h"
 #include "../macros.h"
 #include "../typed.h"
+#include "csr/bml_allocate_csr.h"
 #include "ellblock/bml_allocate_ellblock.h"
 #include "bml_utilities.h"
+#ifdef DO_MPI
+#include "distributed2d/bml_allocate_distributed2d.h"
+#endif
 
 #include <complex.h>
 #include <math.h>
@@ -84,6 +88,58 @@ static int TYPED_FUNC(
     return 0;
 }
 
+#ifdef DO_MPI
+/* Multiply random distributed matrices on the current process grid and
+ * compare with the reference product on task 0. With in_place the
+ * product goes into A.
+ */
+static int TYPED_FUNC(
+    check_distributed_multiply) (
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int N,
+    const int M,
+    const double alpha,
+    const double beta,
+    const double threshold,
+    const int in_place)
+{
+    int status = 0;
+
+    // the same random matrices are generated on all copies of the grid
+    bml_matrix_t *A =
+        bml_random_matrix(matrix_type, matrix_precision, N, M, distributed);
+    bml_matrix_t *B =
+        bml_random_matrix(matrix_type, matrix_precision, N, M, distributed);
+    bml_matrix_t *C = in_place ? A :
+        bml_random_matrix(matrix_type, matrix_precision, N, M, distributed);
+    REAL_T *A_dense = bml_export_to_dense(A, dense_row_major);
+    REAL_T *B_dense = bml_export_to_dense(B, dense_row_major);
+    REAL_T *D_dense = bml_export_to_dense(C, dense_row_major);
+
+    bml_multiply(A, B, C, alpha, beta, threshold);
+
+    REAL_T *F_dense = bml_export_to_dense(C, dense_row_major);
+    if (bml_getMyRank() == 0)
+    {
+        TYPED_FUNC(ref_multiply) (N, A_dense, B_dense, D_dense, alpha, beta,
+                                  threshold);
+        status = TYPED_FUNC(compare_matrix) (N, matrix_precision, D_dense,
+                                             F_dense);
+    }
+    bml_free_memory(A_dense);
+    bml_free_memory(B_dense);
+    bml_free_memory(D_dense);
+    bml_free_memory(F_dense);
+    if (!in_place)
+        bml_deallocate(&C);
+    bml_deallocate(&A);
+    bml_deallocate(&B);
+
+    return status;
+}
+#endif
+
 void TYPED_FUNC(
     setup_bsizes) (
     const int N,
@@ -200,10 +256,289 @@ int TYPED_FUNC(
         LOG_INFO("multiply matrix test passed\n");
     }
 
+    // repeat with the hash row accumulator of the sparse formats
+    if (distrib_mode == sequential)
+    {
+        bml_matrix_t *C2 =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, C_dense, 0.0,
+                                  distrib_mode);
+
+        bml_set_multiply_accumulator(accumulator_hash);
+        bml_multiply(A, B, C2, alpha, beta, threshold);
+        bml_set_multiply_accumulator(accumulator_auto);
+
+        REAL_T *F_dense = bml_export_to_dense(C2, dense_row_major);
+        if (TYPED_FUNC(compare_matrix) (N, matrix_precision, D_dense, F_dense)
+            != 0)
+        {
+            LOG_ERROR("matrix product with hash accumulator incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test with hash accumulator passed\n");
+        bml_free_memory(F_dense);
+        bml_deallocate(&C2);
+    }
+
+    // norm screened multiply of a matrix with decaying elements
+    if (matrix_type == ellblock && distrib_mode == sequential)
+    {
+        const double screen_threshold = 1e-12;
+        const double screening = 1e9;
+
+        REAL_T *G_dense = bml_allocate_memory(N * N * sizeof(REAL_T));
+        for (int i = 0; i < N; i++)
+        {
+            for (int j = 0; j < N; j++)
+            {
+                G_dense[ROWMAJOR(i, j, N, N)] =
+                    A_dense[ROWMAJOR(i, j, N, N)] * exp(-2.0 * abs(i - j));
+            }
+        }
+        bml_matrix_t *G =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, G_dense, 0.0,
+                                  distrib_mode);
+        bml_matrix_t *C_ref =
+            bml_zero_matrix(matrix_type, matrix_precision, N, M,
+                            distrib_mode);
+        bml_matrix_t *C_screened =
+            bml_zero_matrix(matrix_type, matrix_precision, N, M,
+                            distrib_mode);
+        bml_multiply(G, G, C_ref, 1.0, 0.0, screen_threshold);
+        REAL_T *R_dense = bml_export_to_dense(C_ref, dense_row_major);
+
+        // without screening all the block products are computed
+        bml_screening_stats_t stats;
+        bml_multiply_screened(G, G, C_screened, 1.0, 0.0, screen_threshold,
+                              0.0, &stats);
+        REAL_T *F_dense = bml_export_to_dense(C_screened, dense_row_major);
+        if (stats.skipped != 0 || stats.computed == 0
+            || TYPED_FUNC(compare_matrix) (N, matrix_precision, R_dense,
+                                           F_dense) != 0)
+        {
+            LOG_ERROR("matrix product without screening incorrect\n");
+            return -1;
+        }
+        int64_t nproducts = stats.computed;
+        bml_free_memory(F_dense);
+
+        // start from an empty C, the add reuses the blocks of C in place
+        bml_deallocate(&C_screened);
+        C_screened =
+            bml_zero_matrix(matrix_type, matrix_precision, N, M,
+                            distrib_mode);
+        bml_multiply_screened(G, G, C_screened, 1.0, 0.0, screen_threshold,
+                              screening, &stats);
+        F_dense = bml_export_to_dense(C_screened, dense_row_major);
+        double error = 0.0;
+        for (int i = 0; i < N * N; i++)
+        {
+            double diff = ABS(F_dense[i] - R_dense[i]);
+            error += diff * diff;
+        }
+        error = sqrt(error);
+        LOG_INFO("screening skipped %ld of %ld block products, error %e, "
+                 "bound %e\n", (long) stats.skipped, (long) nproducts,
+                 error, stats.error_bound);
+        if (stats.skipped == 0
+            || stats.computed + stats.skipped != nproducts
+            || error > stats.error_bound + N * ABS_TOL)
+        {
+            LOG_ERROR("norm screened matrix product incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test with norm screening passed\n");
+
+        bml_free_memory(F_dense);
+        bml_free_memory(R_dense);
+        bml_free_memory(G_dense);
+        bml_deallocate(&G);
+        bml_deallocate(&C_ref);
+        bml_deallocate(&C_screened);
+    }
+
+    // repeat with the rows of A, B, and C stored contiguously; the
+    // product expands C again
+    if (matrix_type == csr && distrib_mode == sequential)
+    {
+        bml_matrix_t *C2 =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, C_dense, 0.0,
+                                  distrib_mode);
+
+        double trace = bml_trace(A);
+        double fnorm = bml_fnorm(A);
+        bml_compact_csr(A);
+        bml_compact_csr(B);
+        bml_compact_csr(C2);
+        if (bml_trace(A) != trace || bml_fnorm(A) != fnorm)
+        {
+            LOG_ERROR("trace or norm of compact matrix incorrect\n");
+            return -1;
+        }
+
+        bml_multiply(A, B, C2, alpha, beta, threshold);
+
+        REAL_T *F_dense = bml_export_to_dense(C2, dense_row_major);
+        if (TYPED_FUNC(compare_matrix) (N, matrix_precision, D_dense, F_dense)
+            != 0)
+        {
+            LOG_ERROR("matrix product of compact matrices incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test with compact matrices passed\n");
+        bml_expand_csr(A);
+        bml_expand_csr(B);
+        bml_free_memory(F_dense);
+        bml_deallocate(&C2);
+    }
+
+    // repeat with SUMMA
+    if (distrib_mode == distributed)
+    {
+        bml_matrix_t *C2 =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, C_dense, 0.0,
+                                  distrib_mode);
+
+        bml_set_distributed_multiply(distributed_multiply_summa);
+        bml_multiply(A, B, C2, alpha, beta, threshold);
+        bml_set_distributed_multiply(distributed_multiply_cannon);
+
+        REAL_T *F_dense = bml_export_to_dense(C2, dense_row_major);
+        if (bml_getMyRank() == 0)
+        {
+            if (TYPED_FUNC(compare_matrix)
+                (N, matrix_precision, D_dense, F_dense) != 0)
+            {
+                LOG_ERROR("matrix product with SUMMA incorrect\n");
+                return -1;
+            }
+            LOG_INFO("multiply matrix test with SUMMA passed\n");
+            bml_free_memory(F_dense);
+        }
+        bml_deallocate(&C2);
+    }
+
+    // the off-diagonal blocks of the identity are empty
+    if (distrib_mode == distributed)
+    {
+        bml_matrix_t *Id =
+            bml_identity_matrix(matrix_type, matrix_precision, N, M,
+                                distrib_mode);
+        bml_matrix_t *C2 =
+            bml_random_matrix(matrix_type, matrix_precision, N, M,
+                              distrib_mode);
+        bml_multiply(Id, A, C2, 1.0, 0.0, threshold);
+
+        REAL_T *F_dense = bml_export_to_dense(C2, dense_row_major);
+        if (bml_getMyRank() == 0)
+        {
+            if (TYPED_FUNC(compare_matrix)
+                (N, matrix_precision, A_dense, F_dense) != 0)
+            {
+                LOG_ERROR("matrix product with identity incorrect\n");
+                return -1;
+            }
+            LOG_INFO("multiply matrix test with identity passed\n");
+            bml_free_memory(F_dense);
+        }
+        bml_deallocate(&Id);
+        bml_deallocate(&C2);
+    }
+
+    // the grid of A, B, and C is released when the grid is changed
     bml_deallocate(&A);
     bml_deallocate(&B);
     bml_deallocate(&C);
 
+#ifdef DO_MPI
+    // repeat with the shifts driven by a progress thread
+    if (distrib_mode == distributed)
+    {
+        bml_set_multiply_progress_thread(1);
+
+        if (TYPED_FUNC(check_distributed_multiply)
+            (matrix_type, matrix_precision, N, M, alpha, beta,
+             threshold, 0) != 0)
+        {
+            LOG_ERROR("matrix product with progress thread incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test with progress thread passed\n");
+
+        bml_set_multiply_progress_thread(0);
+    }
+
+    // repeat with SUMMA into one of the operands
+    if (distrib_mode == distributed)
+    {
+        bml_set_distributed_multiply(distributed_multiply_summa);
+
+        if (TYPED_FUNC(check_distributed_multiply)
+            (matrix_type, matrix_precision, N, M, alpha, beta,
+             threshold, 1) != 0)
+        {
+            LOG_ERROR("matrix product in place with SUMMA incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test in place with SUMMA passed\n");
+
+        bml_set_distributed_multiply(distributed_multiply_cannon);
+    }
+
+    // repeat on two copies of the grid, e.g. of a 2 x 2 grid on 8 tasks,
+    // every one doing a share of the steps (ellblock block sizes are set
+    // up for the 2D grid)
+    if (distrib_mode == distributed && matrix_type != ellblock
+        && bml_getNRanks() % 2 == 0)
+    {
+        bml_set_replication_distributed2d(2);
+
+        if (TYPED_FUNC(check_distributed_multiply)
+            (matrix_type, matrix_precision, N, M, alpha, beta,
+             threshold, 0) != 0)
+        {
+            LOG_ERROR("matrix product on replicated grid incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test on replicated grid passed\n");
+
+        bml_set_replication_distributed2d(1);
+    }
+
+    // repeat on a 2 x 3 grid, whose blocks are not square, with SUMMA
+    // panels narrower than the blocks
+    if (distrib_mode == distributed && matrix_type != ellblock
+        && bml_getNRanks() == 6 && N % 6 == 0)
+    {
+        bml_set_grid_distributed2d(2, 3);
+        bml_set_summa_panel_width(3);
+
+        if (TYPED_FUNC(check_distributed_multiply)
+            (matrix_type, matrix_precision, N, M, alpha, beta,
+             threshold, 0) != 0)
+        {
+            LOG_ERROR("matrix product on 2 x 3 grid incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test on 2 x 3 grid passed\n");
+
+        if (TYPED_FUNC(check_distributed_multiply)
+            (matrix_type, matrix_precision, N, M, alpha, beta,
+             threshold, 1) != 0)
+        {
+            LOG_ERROR("matrix product in place on 2 x 3 grid incorrect\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test in place on 2 x 3 grid passed\n");
+
+        bml_set_summa_panel_width(0);
+        bml_set_grid_distributed2d(0, 0);
+    }
+#endif
+
     if (bml_getMyRank() == 0)
     {
         bml_free_memory(A_dense);
@@ -35,6 +35,9 @@ static void TYPED_FUNC(
 
 #if defined(SINGLE_REAL) || defined(SINGLE_COMPLEX)
 #define ABS_TOL 2e-6
+#elif defined(BML_MPTC)
+// X^2 from single precision slices
+#define ABS_TOL 1e-7
 #else
 #define ABS_TOL 1e-12
 #endif
@@ -89,7 +92,9 @@ int TYPED_FUNC(
         int nb = 0;
         for (int i = 0; i < N; i++)
         {
-            int bsize = (5 + i) % 6 + 1;
+            // mix block sizes beyond 6 with small ones so that
+            // square and rectangular block products are exercised
+            int bsize = (i % 2 == 0) ? 9 : 2;
             count += bsize;
             if (count > N)
             {
@@ -163,6 +168,141 @@ int TYPED_FUNC(
     }
     LOG_INFO("multiply matrix test passed\n");
 
+    // repeat with the hash row accumulator of the sparse formats
+    bml_set_multiply_accumulator(accumulator_hash);
+    double *trace_hash = bml_multiply_x2(A, C, threshold);
+    bml_set_multiply_accumulator(accumulator_auto);
+
+    bml_free_memory(E_dense);
+    E_dense = bml_export_to_dense(C, dense_row_major);
+    if (TYPED_FUNC(compare_matrix) (N, matrix_precision, D_dense, E_dense) !=
+        0)
+    {
+        LOG_ERROR("matrix product with hash accumulator incorrect\n");
+        return -1;
+    }
+    if (fabs(trace_hash[1] - ((double *) trace)[1]) > ABS_TOL * N)
+    {
+        LOG_ERROR("trace of matrix product with hash accumulator incorrect\n");
+        return -1;
+    }
+    LOG_INFO("multiply matrix test with hash accumulator passed\n");
+    bml_free_memory(trace_hash);
+
+    // repeat with a sparsity plan, twice so that the plan gets reused
+    bml_multiply_plan_t *plan = NULL;
+    for (int iter = 0; iter < 2; iter++)
+    {
+        double *trace_plan = bml_multiply_x2_planned(&plan, A, C, threshold);
+
+        bml_free_memory(E_dense);
+        E_dense = bml_export_to_dense(C, dense_row_major);
+        if (TYPED_FUNC(compare_matrix) (N, matrix_precision, D_dense, E_dense)
+            != 0)
+        {
+            LOG_ERROR("matrix product with sparsity plan incorrect\n");
+            return -1;
+        }
+        if (fabs(trace_plan[1] - ((double *) trace)[1]) > ABS_TOL * N)
+        {
+            LOG_ERROR("trace of product with sparsity plan incorrect\n");
+            return -1;
+        }
+        bml_free_memory(trace_plan);
+    }
+    if ((matrix_type == ellpack || matrix_type == ellsort)
+        && !bml_multiply_plan_is_valid(plan, A))
+    {
+        LOG_ERROR("sparsity plan not valid for its own matrix\n");
+        return -1;
+    }
+    LOG_INFO("multiply matrix test with sparsity plan passed\n");
+
+    // a new element outside the planned pattern makes the plan stale, the
+    // other matrix types keep no plan
+    if (matrix_type == ellpack || matrix_type == ellsort)
+    {
+        REAL_T *S_dense = bml_allocate_memory(sizeof(REAL_T) * N * N);
+        for (int i = 0; i < N; i++)
+        {
+            for (int j = MAX(i - 1, 0); j < MIN(i + 2, N); j++)
+            {
+                S_dense[ROWMAJOR(i, j, N, N)] = 1.0 / (1 + i + j);
+            }
+        }
+        bml_matrix_t *S =
+            bml_import_from_dense(matrix_type, matrix_precision,
+                                  dense_row_major, N, M, S_dense, 0.0,
+                                  sequential);
+        bml_deallocate_multiply_plan(&plan);
+        bml_free_memory(bml_multiply_x2_planned(&plan, S, C, threshold));
+
+        REAL_T corner = 0.5;
+        bml_set_element_new(S, 0, N - 1, &corner);
+        S_dense[ROWMAJOR(0, N - 1, N, N)] = corner;
+        if (bml_multiply_plan_is_valid(plan, S))
+        {
+            LOG_ERROR("sparsity plan not detected as stale\n");
+            return -1;
+        }
+
+        double *trace_plan = bml_multiply_x2_planned(&plan, S, C, threshold);
+        TYPED_FUNC(ref_multiply) (N, S_dense, S_dense, D_dense, alpha, beta,
+                                  threshold);
+        bml_free_memory(E_dense);
+        E_dense = bml_export_to_dense(C, dense_row_major);
+        if (TYPED_FUNC(compare_matrix) (N, matrix_precision, D_dense,
+                                        E_dense) != 0)
+        {
+            LOG_ERROR("matrix product with stale sparsity plan incorrect\n");
+            return -1;
+        }
+        if (!bml_multiply_plan_is_valid(plan, S))
+        {
+            LOG_ERROR("stale sparsity plan not rebuilt\n");
+            return -1;
+        }
+        LOG_INFO("multiply matrix test with stale sparsity plan passed\n");
+        bml_free_memory(trace_plan);
+
+        // as in distributed mode, the plan only covers the first half of the
+        // rows but also goes stale with a new element in a row they read
+        if (bml_getNRanks() == 1)
+        {
+            int part = 1;
+            int half = N / 2;
+            bml_update_domain(S, &part, &part, &half);
+            bml_deallocate_multiply_plan(&plan);
+            plan = bml_multiply_plan_x2(S);
+
+            REAL_T ghost = 0.25;
+            bml_set_element_new(S, half, N - 1, &ghost);
+            if (bml_multiply_plan_is_valid(plan, S))
+            {
+                LOG_ERROR("partial sparsity plan not detected as stale\n");
+                return -1;
+            }
+            LOG_INFO("multiply matrix test with partial plan passed\n");
+        }
+        bml_free_memory(S_dense);
+        bml_deallocate(&S);
+    }
+    bml_deallocate_multiply_plan(&plan);
+
+    // accuracy report of the split precision square
+    if (matrix_type == dense)
+    {
+        double error_3 = bml_multiply_x2_split_error(A, 3);
+        double error_7 = bml_multiply_x2_split_error(A, 7);
+        LOG_INFO("split precision error with 3 slices %e, 7 slices %e\n",
+                 error_3, error_7);
+        if (error_3 > 1e-7 || error_7 > 1e-14)
+        {
+            LOG_ERROR("split precision matrix square inaccurate\n");
+            return -1;
+        }
+    }
+
     bml_deallocate(&A);
     bml_deallocate(&B);
     bml_deallocate(&C);
@@ -0,0 +1,36 @@
+#ifndef __PARTITION_H
+#define __PARTITION_H
+
+#include <bml.h>
+
+int test_partition(
+    const int N,
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int M);
+
+int test_partition_single_real(
+    const int N,
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int M);
+
+int test_partition_double_real(
+    const int N,
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int M);
+
+int test_partition_single_complex(
+    const int N,
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int M);
+
+int test_partition_double_complex(
+    const int N,
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int M);
+
+#endif
@@ -0,0 +1,136 @@
+#include "bml.h"
+#include "../typed.h"
+
+#include <complex.h>
+#include <math.h>
+#include <stdlib.h>
+#include <stdio.h>
+
+#define NPARTS 4
+
+int TYPED_FUNC(
+    test_partition) (
+    const int N,
+    const bml_matrix_type_t matrix_type,
+    const bml_matrix_precision_t matrix_precision,
+    const int M)
+{
+    // 2D grid of N x N points, numbered in scrambled order so that
+    // index ranges are poor parts
+    int n = N * N;
+    int stride = 5;
+    while (n % stride == 0)
+    {
+        stride++;
+    }
+    REAL_T *A_dense = bml_allocate_memory(sizeof(REAL_T) * n * n);
+    for (int x = 0; x < N; x++)
+    {
+        for (int y = 0; y < N; y++)
+        {
+            int i = (stride * (x * N + y)) % n;
+            A_dense[i * n + i] = 4.0;
+            if (x > 0)
+            {
+                int j = (stride * ((x - 1) * N + y)) % n;
+                A_dense[i * n + j] = A_dense[j * n + i] = -1.0;
+            }
+            if (y > 0)
+            {
+                int j = (stride * (x * N + y - 1)) % n;
+                A_dense[i * n + j] = A_dense[j * n + i] = -1.0;
+            }
+        }
+    }
+    // The scrambled numbering spreads the blocks of ellblock over the
+    // whole row, leave room for all of them rather than M
+    (void) M;
+    bml_matrix_t *A =
+        bml_import_from_dense(matrix_type, matrix_precision, dense_row_major,
+                              n, n, A_dense, 0, sequential);
+    bml_free_memory(A_dense);
+
+    int *xadj = malloc(sizeof(int) * (n + 1));
+    int *adjncy = malloc(sizeof(int) * (n * 4));
+    int *part = malloc(sizeof(int) * n);
+    bml_adjacency(A, xadj, adjncy, 0);
+    if (xadj[n] != 4 * N * (N - 1))
+    {
+        LOG_ERROR("wrong number of edges %d, expected %d\n", xadj[n],
+                  4 * N * (N - 1));
+        return -1;
+    }
+
+    bml_partition_graph(n, xadj, adjncy, NPARTS, part);
+
+    int psize[NPARTS] = { 0 };
+    for (int i = 0; i < n; i++)
+    {
+        if (part[i] < 0 || part[i] >= NPARTS)
+        {
+            LOG_ERROR("node %d in part %d\n", i, part[i]);
+            return -1;
+        }
+        psize[part[i]]++;
+    }
+    int max_psize = (int) ceil(1.03 * n / NPARTS);
+    for (int p = 0; p < NPARTS; p++)
+    {
+        LOG_INFO("part %d has %d nodes\n", p, psize[p]);
+        if (psize[p] == 0 || psize[p] > max_psize)
+        {
+            LOG_ERROR("part %d unbalanced\n", p);
+            return -1;
+        }
+    }
+
+    // Quadrants cut 2 N edges, index ranges about 3/4 of them
+    int cut = bml_partition_edgecut(n, xadj, adjncy, part);
+    LOG_INFO("edge cut %d\n", cut);
+    if (cut > 3 * N)
+    {
+        LOG_ERROR("edge cut %d too large\n", cut);
+        return -1;
+    }
+
+    // The core nodes come first in the submatrix indices, followed by
+    // a halo of the nodes next to the part
+    if (matrix_type == ellpack || matrix_type == ellsort)
+    {
+        int *nodelist = malloc(sizeof(int) * n);
+        int *core_halo_index = malloc(sizeof(int) * n);
+        int vsize[2];
+        for (int p = 0; p < NPARTS; p++)
+        {
+            int nsize = bml_partition_nodelist(n, part, p, nodelist);
+            bml_matrix2submatrix_index(A, A, nodelist, nsize,
+                                       core_halo_index, vsize, 0);
+            LOG_INFO("part %d core %d halo %d\n", p, vsize[1],
+                     vsize[0] - vsize[1]);
+            if (vsize[1] != psize[p] || vsize[0] - vsize[1] > cut)
+            {
+                LOG_ERROR("wrong submatrix size for part %d\n", p);
+                return -1;
+            }
+            for (int k = 0; k < nsize; k++)
+            {
+                if (part[core_halo_index[k]] != p)
+                {
+                    LOG_ERROR("wrong core of part %d\n", p);
+                    return -1;
+                }
+            }
+        }
+        free(nodelist);
+        free(core_halo_index);
+    }
+
+    free(xadj);
+    free(adjncy);
+    free(part);
+    bml_deallocate(&A);
+
+    LOG_INFO("partition matrix test passed\n");
+
+    return 0;
+}
@@ -11,6 +11,75 @@
 #define REL_TOL 1e-12
 #endif
 
+#define PART_SIZE 3
+
+static void TYPED_FUNC(
+    scale_block) (
+    int ipart,
+    int lsize,
+    int llsize,
+    void *block,
+    void *data)
+{
+    REAL_T *b = block;
+    double *factor = data;
+
+    (void) ipart;
+    (void) llsize;
+
+    for (int i = 0; i < lsize * lsize; i++)
+    {
+        b[i] *= *factor;
+    }
+}
+
+// Compare cached core+halo indices with the ones of
+// bml_matrix2submatrix_index, the halos may come in a different order
+static int
+compare_indices(
+    bml_submatrix_index_cache_t * cache,
+    bml_matrix_t * A,
+    bml_matrix_t * B,
+    int *part_ptr,
+    int *part_nodes,
+    int N)
+{
+    int chlist[N];
+    int mark[N];
+    int vsize[2];
+    int cache_vsize[2];
+
+    for (int p = 0; p < cache->nparts; p++)
+    {
+        bml_matrix2submatrix_index(A, B, part_nodes + part_ptr[p],
+                                   part_ptr[p + 1] - part_ptr[p], chlist,
+                                   vsize, 0);
+        int *index = bml_submatrix_index_cache_get(cache, p, cache_vsize);
+        if (vsize[0] != cache_vsize[0] || vsize[1] != cache_vsize[1])
+        {
+            LOG_ERROR("wrong number of cached indices in part %d\n", p);
+            return -1;
+        }
+        for (int j = 0; j < N; j++)
+        {
+            mark[j] = 0;
+        }
+        for (int j = 0; j < vsize[0]; j++)
+        {
+            mark[chlist[j]] = 1;
+        }
+        for (int j = 0; j < vsize[0]; j++)
+        {
+            if (!mark[index[j]] || (j < vsize[1] && index[j] != chlist[j]))
+            {
+                LOG_ERROR("wrong cached index %d in part %d\n", j, p);
+                return -1;
+            }
+        }
+    }
+    return 0;
+}
+
 int TYPED_FUNC(
     test_submatrix) (
     const int N,
@@ -115,6 +184,93 @@ int TYPED_FUNC(
         }
     }
 
+    // Same submatrices for parts of a few rows, all at once
+    int nparts = (N + PART_SIZE - 1) / PART_SIZE;
+    int *part_ptr = malloc(sizeof(int) * (nparts + 1));
+    int *part_nodes = malloc(sizeof(int) * N);
+    for (int p = 0; p <= nparts; p++)
+    {
+        part_ptr[p] = p * PART_SIZE < N ? p * PART_SIZE : N;
+    }
+    for (int i = 0; i < N; i++)
+    {
+        part_nodes[i] = i;
+    }
+    bml_submatrix_batch_t *batch =
+        bml_submatrix_batch_new(B, A, nparts, part_ptr, part_nodes, 0);
+    for (int p = 0; p < nparts; p++)
+    {
+        if (batch->ncore[p] != part_ptr[p + 1] - part_ptr[p])
+        {
+            LOG_ERROR("wrong number of cores in part %d\n", p);
+            return -1;
+        }
+    }
+    bml_submatrix_batch_extract(A, batch);
+    double factor = 2.0;
+    bml_submatrix_batch_apply(batch, TYPED_FUNC(scale_block), &factor);
+    bml_deallocate(&D);
+    D = bml_zero_matrix(matrix_type, matrix_precision, N, M, sequential);
+    bml_submatrix_batch_assemble(batch, D, threshold);
+    bml_deallocate_submatrix_batch(&batch);
+
+    bml_free_memory(D_dense);
+    D_dense = bml_export_to_dense(D, dense_row_major);
+    for (int i = 0; i < N * N; i++)
+    {
+        if (ABS(2 * A_dense[i] - D_dense[i]) > REL_TOL)
+        {
+            LOG_ERROR("batched submatrices wrong 2 A[%d] = %e D[%d] = %e\n",
+                      i, 2.0 * A_dense[i], i, D_dense[i]);
+            return -1;
+        }
+    }
+
+    // Cached indices, updated after adding an edge to the graph
+    bml_submatrix_index_cache_t *cache =
+        bml_submatrix_index_cache_new(B, A, nparts, part_ptr, part_nodes, 0);
+    if (cache->ndirty != nparts
+        || compare_indices(cache, B, A, part_ptr, part_nodes, N) != 0)
+    {
+        LOG_ERROR("wrong cached indices\n");
+        return -1;
+    }
+    if (bml_submatrix_index_cache_update(cache, B, A) != 0)
+    {
+        LOG_ERROR("unchanged graph gives dirty parts\n");
+        return -1;
+    }
+    for (int i = 0; i < N * N; i++)
+    {
+        if (i / N != i % N && ABS(A_dense[i]) == 0.0)
+        {
+            REAL_T one = 1.0;
+            bml_set_element_new(A, i / N, i % N, &one);
+            int ndirty = bml_submatrix_index_cache_update(cache, B, A);
+            LOG_INFO("edge %d-%d makes %d parts dirty\n", i / N, i % N,
+                     ndirty);
+            for (int p = 0; p < nparts; p++)
+            {
+                if (cache->dirty[p] && p != (i / N) / PART_SIZE)
+                {
+                    LOG_ERROR("part %d should not be dirty\n", p);
+                    return -1;
+                }
+            }
+            if (ndirty > 1
+                || compare_indices(cache, B, A, part_ptr, part_nodes,
+                                   N) != 0)
+            {
+                LOG_ERROR("wrong updated indices\n");
+                return -1;
+            }
+            break;
+        }
+    }
+    bml_deallocate_submatrix_index_cache(&cache);
+    free(part_ptr);
+    free(part_nodes);
+
     LOG_INFO("submatrix matrix test passed\n");
     bml_free_memory(A_dense);
     bml_free_memory(B_dense);
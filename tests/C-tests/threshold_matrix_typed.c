@@ -1,6 +1,7 @@
 #include "bml.h"
 #include "../typed.h"
 #include "../macros.h"
+#include "ellblock/bml_allocate_ellblock.h"
 
 #include <complex.h>
 #include <math.h>
@@ -116,6 +117,31 @@ int TYPED_FUNC(
         bml_free_memory(A_dense);
         bml_free_memory(B_dense);
     }
+
+    // the blocks dropped by bml_threshold() leave at most half of the
+    // block memory in holes, and bml_clear() releases all of it
+    if (bml_get_type(A) == ellblock)
+    {
+        bml_ellblock_memory_stats_t stats;
+        bml_get_memory_stats_ellblock(A, &stats);
+        LOG_INFO("blocks: live %zu, reserved %zu, peak %zu, "
+                 "fragmentation %f\n", stats.live, stats.reserved,
+                 stats.peak, stats.fragmentation);
+        if (stats.live < N * sizeof(REAL_T) || stats.live > stats.allocated
+            || stats.allocated > stats.reserved
+            || stats.reserved > stats.peak || stats.fragmentation > 0.5)
+        {
+            LOG_ERROR("inconsistent block memory statistics\n");
+            return -1;
+        }
+        bml_clear(A);
+        bml_get_memory_stats_ellblock(A, &stats);
+        if (stats.live != 0 || stats.allocated != 0)
+        {
+            LOG_ERROR("blocks not released by bml_clear\n");
+            return -1;
+        }
+    }
     bml_deallocate(&A);
     bml_deallocate(&B);
 